@@ -0,0 +1,92 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""Benchmark of the fused self attention operator on CPU.
+
+Times forward and backward of mx.nd.contrib.interleaved_selfatt over sequence
+lengths from 128 to 4096, next to the unfused chain of
+interleaved_matmul_selfatt_qk, softmax and interleaved_matmul_selfatt_valatt,
+which materializes the (batch * heads, seq, seq) attention maps. The unfused
+chain is skipped when those maps would exceed --max-att-elements.
+"""
+
+import argparse
+import time
+import mxnet as mx
+
+
+def unfused(qkv, heads):
+    att = mx.nd.contrib.interleaved_matmul_selfatt_qk(qkv, heads=heads)
+    att = mx.nd.softmax(att, axis=-1)
+    return mx.nd.contrib.interleaved_matmul_selfatt_valatt(qkv, att, heads=heads)
+
+
+def fused(qkv, heads):
+    return mx.nd.contrib.interleaved_selfatt(qkv, heads=heads)
+
+
+def measure(f, qkv, heads, ograd, repeat):
+    qkv.attach_grad()
+
+    def run():
+        with mx.autograd.record():
+            start = time.time()
+            out = f(qkv, heads)
+            out.wait_to_read()
+            fwd = time.time() - start
+        start = time.time()
+        out.backward(ograd)
+        qkv.grad.wait_to_read()
+        return fwd, time.time() - start
+
+    run()
+    times = [run() for _ in range(repeat)]
+    return (sum(t[0] for t in times) / repeat, sum(t[1] for t in times) / repeat)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark fused self attention on CPU')
+    parser.add_argument('--seq-lengths', type=str, default='128,256,512,1024,2048,4096',
+                        help='comma separated sequence lengths')
+    parser.add_argument('--batch', type=int, default=4)
+    parser.add_argument('--heads', type=int, default=8)
+    parser.add_argument('--head-dim', type=int, default=64)
+    parser.add_argument('--max-att-elements', type=int, default=1 << 28,
+                        help='skip the unfused chain for larger attention maps')
+    parser.add_argument('--repeat', type=int, default=5)
+    args = parser.parse_args()
+
+    print('{:>6} {:>12} {:>12} {:>14} {:>14}'.format(
+        'seq', 'fused fwd', 'fused bwd', 'unfused fwd', 'unfused bwd'))
+    for seq_len in [int(l) for l in args.seq_lengths.split(',')]:
+        shape = (seq_len, args.batch, 3 * args.heads * args.head_dim)
+        qkv = mx.nd.random.uniform(-1, 1, shape, ctx=mx.cpu())
+        ograd = mx.nd.random.uniform(-1, 1, (seq_len, args.batch, args.heads * args.head_dim),
+                                     ctx=mx.cpu())
+        fwd, bwd = measure(fused, qkv, args.heads, ograd, args.repeat)
+        if args.batch * args.heads * seq_len * seq_len <= args.max_att_elements:
+            ufwd, ubwd = measure(unfused, qkv, args.heads, ograd, args.repeat)
+            unfused_times = '{:>14.2f} {:>14.2f}'.format(ufwd * 1e3, ubwd * 1e3)
+        else:
+            unfused_times = '{:>14} {:>14}'.format('-', '-')
+        print('{:>6} {:>12.2f} {:>12.2f} {}'.format(seq_len, fwd * 1e3, bwd * 1e3, unfused_times))
+    print('times in ms')
+
+
+if __name__ == '__main__':
+    main()
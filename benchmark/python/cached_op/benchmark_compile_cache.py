@@ -0,0 +1,154 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of the CachedOp compile cache (MXNET_CACHED_OP_CACHE_DIR).
+
+Measures the first inference call of hybridized ResNet-50 and BERT-base
+(encoder only) in fresh processes:
+  - without the cache,
+  - with an empty cache, which stores the entry,
+  - with the cache filled by the previous process.
+The time of the first call includes graph optimization, shape, type and
+storage type inference, memory planning, memory allocation, creation of the
+operator executors and the computation itself. The second call shows the
+steady state time of the computation.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+import mxnet as mx
+from mxnet.gluon import nn
+
+
+class EncoderLayer(nn.HybridBlock):
+    def __init__(self, units, hidden_size, num_heads, **kwargs):
+        super(EncoderLayer, self).__init__(**kwargs)
+        self._units = units
+        self._num_heads = num_heads
+        self.qkv = nn.Dense(3 * units, flatten=False)
+        self.proj = nn.Dense(units, flatten=False)
+        self.ln1 = nn.LayerNorm()
+        self.ffn1 = nn.Dense(hidden_size, flatten=False)
+        self.ffn2 = nn.Dense(units, flatten=False)
+        self.ln2 = nn.LayerNorm()
+
+    def hybrid_forward(self, F, x):
+        heads = self._num_heads
+        q, k, v = F.split(self.qkv(x), num_outputs=3, axis=-1)
+        # (B, T, C) -> (B * heads, T, C / heads)
+        q, k, v = [F.reshape(F.transpose(F.reshape(t, shape=(0, 0, -4, heads, -1)),
+                                         axes=(0, 2, 1, 3)), shape=(-3, 0, 0))
+                   for t in (q, k, v)]
+        scale = 1.0 / ((self._units // heads) ** 0.5)
+        att = F.softmax(F.batch_dot(q, k, transpose_b=True) * scale, axis=-1)
+        out = F.batch_dot(att, v)
+        out = F.reshape(F.transpose(F.reshape(out, shape=(-4, -1, heads, 0, 0)),
+                                    axes=(0, 2, 1, 3)), shape=(0, 0, -3))
+        x = self.ln1(x + self.proj(out))
+        return self.ln2(x + self.ffn2(F.LeakyReLU(self.ffn1(x), act_type='gelu')))
+
+
+class BertEncoder(nn.HybridBlock):
+    def __init__(self, vocab_size=30522, units=768, hidden_size=3072, num_heads=12,
+                 num_layers=12, **kwargs):
+        super(BertEncoder, self).__init__(**kwargs)
+        self.embed = nn.Embedding(vocab_size, units)
+        self.layers = nn.HybridSequential()
+        for _ in range(num_layers):
+            self.layers.add(EncoderLayer(units, hidden_size, num_heads))
+
+    def hybrid_forward(self, F, tokens):
+        return self.layers(self.embed(tokens))
+
+
+def build(model, batch_size, seq_length):
+    if model == 'resnet50':
+        net = mx.gluon.model_zoo.vision.resnet50_v1()
+        data = mx.nd.random.uniform(shape=(batch_size, 3, 224, 224))
+    else:
+        net = BertEncoder()
+        data = mx.nd.random.randint(0, 30522, shape=(batch_size, seq_length)).astype('float32')
+    net.initialize()
+    net.hybridize(static_alloc=True, static_shape=True)
+    return net, data
+
+
+def run_worker(args):
+    net, data = build(args.model, args.batch_size, args.seq_length)
+    # initialize the deferred parameters with an imperative call first,
+    # so that the timed calls only measure the CachedOp
+    with mx.autograd.pause():
+        net.hybridize(active=False)
+        net(data).wait_to_read()
+        net.hybridize(static_alloc=True, static_shape=True)
+    times = []
+    for _ in range(2):
+        start = time.time()
+        net(data).wait_to_read()
+        times.append(time.time() - start)
+    print(json.dumps({'first': times[0], 'second': times[1]}))
+
+
+def measure(args, model, cache_dir):
+    env = dict(os.environ)
+    env.pop('MXNET_CACHED_OP_CACHE_DIR', None)
+    if cache_dir is not None:
+        env['MXNET_CACHED_OP_CACHE_DIR'] = cache_dir
+    cmd = [sys.executable, os.path.abspath(__file__), '--worker', '--model', model,
+           '--batch-size', str(args.batch_size), '--seq-length', str(args.seq_length)]
+    out = subprocess.check_output(cmd, env=env).decode()
+    return json.loads(out.strip().splitlines()[-1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark the CachedOp compile cache')
+    parser.add_argument('--models', type=str, default='resnet50,bert_base',
+                        help='comma separated models: resnet50, bert_base')
+    parser.add_argument('--batch-size', type=int, default=1)
+    parser.add_argument('--seq-length', type=int, default=128)
+    parser.add_argument('--model', type=str, help=argparse.SUPPRESS)
+    parser.add_argument('--worker', action='store_true', help=argparse.SUPPRESS)
+    args = parser.parse_args()
+    if args.worker:
+        run_worker(args)
+        return
+
+    print('{:>10} {:>12} {:>16} {:>16} {:>16}'.format(
+        'model', 'cache', 'first call(ms)', 'second call(ms)', 'speedup(first)'))
+    for model in args.models.split(','):
+        cache_dir = tempfile.mkdtemp(prefix='mxnet_cachedop_')
+        try:
+            baseline = measure(args, model, None)
+            runs = [('none', baseline),
+                    ('cold', measure(args, model, cache_dir)),
+                    ('warm', measure(args, model, cache_dir))]
+        finally:
+            shutil.rmtree(cache_dir)
+        for name, res in runs:
+            print('{:>10} {:>12} {:>16.2f} {:>16.2f} {:>16.2f}'.format(
+                model, name, res['first'] * 1e3, res['second'] * 1e3,
+                baseline['first'] / res['first']))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,126 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of the memory planners of CachedOp (MXNET_MEMORY_PLANNER).
+
+Reports the memory planned for the intermediate arrays of hybridized
+ResNet-50, MobileNet-v2 and BERT-base (encoder only) by the greedy planner
+and by the offset planner, which packs the lifetimes of the arrays into a
+single allocation, for inference and for training (forward and backward
+graphs), together with the peak resident memory of the process and the time
+per iteration.
+"""
+
+import argparse
+import json
+import os
+import re
+import resource
+import subprocess
+import sys
+import time
+import mxnet as mx
+from benchmark_compile_cache import BertEncoder
+
+PLAN_LOG = re.compile(r'Memory plan \((\w+)\): (\d+) KB')
+
+
+def build(model, batch_size, seq_length):
+    if model == 'resnet50':
+        net = mx.gluon.model_zoo.vision.resnet50_v1()
+        data = mx.nd.random.uniform(shape=(batch_size, 3, 224, 224))
+    elif model == 'mobilenetv2':
+        net = mx.gluon.model_zoo.vision.mobilenet_v2_1_0()
+        data = mx.nd.random.uniform(shape=(batch_size, 3, 224, 224))
+    else:
+        net = BertEncoder()
+        data = mx.nd.random.randint(0, 30522, shape=(batch_size, seq_length)).astype('float32')
+    net.initialize()
+    return net, data
+
+
+def run_worker(args):
+    net, data = build(args.model, args.batch_size, args.seq_length)
+    with mx.autograd.pause():
+        net(data).wait_to_read()
+    net.hybridize(static_alloc=True, memory_planner=args.planner)
+    start = None
+    for i in range(args.iterations + 1):
+        if i == 1:
+            start = time.time()
+        if args.train:
+            with mx.autograd.record():
+                out = net(data)
+            out.backward()
+        else:
+            out = net(data)
+        mx.nd.waitall()
+    elapsed = (time.time() - start) / args.iterations
+    # ru_maxrss is in KB on Linux
+    peak_kb = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    print(json.dumps({'time': elapsed, 'peak_kb': peak_kb}))
+
+
+def measure(args, model, planner, train):
+    env = dict(os.environ)
+    env['MXNET_MEM_PLAN_VERBOSE_LOGGING'] = '1'
+    cmd = [sys.executable, os.path.abspath(__file__), '--worker', '--model', model,
+           '--planner', planner, '--batch-size', str(args.batch_size),
+           '--seq-length', str(args.seq_length), '--iterations', str(args.iterations)]
+    if train:
+        cmd.append('--train')
+    proc = subprocess.run(cmd, env=env, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                          check=True)
+    res = json.loads(proc.stdout.decode().strip().splitlines()[-1])
+    # one plan per graph: forward, or forward and backward when training
+    plans = [int(m.group(2)) for m in PLAN_LOG.finditer(proc.stderr.decode())
+             if m.group(1) == planner]
+    res['kb'] = sum(plans[-2:] if train else plans[-1:])
+    return res
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark the CachedOp memory planners')
+    parser.add_argument('--models', type=str, default='resnet50,mobilenetv2,bert_base',
+                        help='comma separated models: resnet50, mobilenetv2, bert_base')
+    parser.add_argument('--batch-size', type=int, default=32)
+    parser.add_argument('--seq-length', type=int, default=128)
+    parser.add_argument('--iterations', type=int, default=10)
+    parser.add_argument('--model', type=str, help=argparse.SUPPRESS)
+    parser.add_argument('--planner', type=str, help=argparse.SUPPRESS)
+    parser.add_argument('--train', action='store_true', help=argparse.SUPPRESS)
+    parser.add_argument('--worker', action='store_true', help=argparse.SUPPRESS)
+    args = parser.parse_args()
+    if args.worker:
+        run_worker(args)
+        return
+
+    print('{:>12} {:>6} {:>8} {:>14} {:>10} {:>10} {:>10}'.format(
+        'model', 'mode', 'planner', 'planned(MB)', 'saving', 'peak(MB)', 'time(ms)'))
+    for model in args.models.split(','):
+        for train in [False, True]:
+            greedy = measure(args, model, 'greedy', train)
+            for planner, res in [('greedy', greedy),
+                                 ('offset', measure(args, model, 'offset', train))]:
+                print('{:>12} {:>6} {:>8} {:>14.1f} {:>9.1f}% {:>10.1f} {:>10.2f}'.format(
+                    model, 'train' if train else 'infer', planner, res['kb'] / 1024.0,
+                    100.0 * (1 - float(res['kb']) / max(greedy['kb'], 1)),
+                    res['peak_kb'] / 1024.0, res['time'] * 1e3))
+
+
+if __name__ == '__main__':
+    main()
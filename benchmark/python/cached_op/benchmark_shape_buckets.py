@@ -0,0 +1,97 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of the static allocation of CachedOp for inputs of varying length.
+
+Runs a BERT-base style encoder on requests, the sequence lengths of which
+follow a log-normal distribution similar to the one of question answering
+and classification traffic, with:
+  - static_alloc: one memory plan and allocation, replaced at each change of length
+  - pad_to_max: every request padded to the maximal length
+  - buckets: power of two buckets of the length, with the memory plans and the
+    static allocations of the last `--max-shapes` buckets kept
+  - dynamic: no static allocation
+and reports the throughput and the latency percentiles.
+"""
+
+import argparse
+import time
+import numpy as np
+import mxnet as mx
+from benchmark_compile_cache import BertEncoder
+
+
+def sample_lengths(num, max_length, seed):
+    rng = np.random.RandomState(seed)
+    lengths = rng.lognormal(mean=np.log(48), sigma=0.7, size=num).astype(int)
+    return np.clip(lengths, 4, max_length)
+
+
+def run(mode, args, lengths):
+    mx.random.seed(0)
+    net = BertEncoder(num_layers=args.num_layers)
+    net.initialize()
+    net(mx.nd.zeros((args.batch_size, 8)))
+    if mode == 'static_alloc':
+        net.hybridize(static_alloc=True)
+    elif mode == 'buckets':
+        net.hybridize(static_alloc=True, max_static_alloc_shapes=args.max_shapes,
+                      bucket_axis=1, bucket_output_axes=[1])
+    elif mode == 'pad_to_max':
+        net.hybridize(static_alloc=True, static_shape=True, bucket_axis=1,
+                      bucket_sizes=[args.max_length], bucket_output_axes=[1])
+    else:
+        net.hybridize()
+    requests = [mx.nd.random.randint(0, 30522, shape=(args.batch_size, int(l))).astype('float32')
+                for l in lengths]
+    # warm up with the first requests
+    for x in requests[:args.warmup]:
+        net(x).wait_to_read()
+    latencies = []
+    start = time.time()
+    for x in requests[args.warmup:]:
+        t = time.time()
+        net(x).wait_to_read()
+        latencies.append(time.time() - t)
+    elapsed = time.time() - start
+    return len(latencies) / elapsed, np.percentile(latencies, [50, 99]) * 1e3
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark CachedOp shape buckets')
+    parser.add_argument('--requests', type=int, default=500)
+    parser.add_argument('--warmup', type=int, default=50)
+    parser.add_argument('--batch-size', type=int, default=1)
+    parser.add_argument('--max-length', type=int, default=512)
+    parser.add_argument('--max-shapes', type=int, default=8,
+                        help='number of kept shapes of the bucket mode')
+    parser.add_argument('--num-layers', type=int, default=12)
+    parser.add_argument('--modes', type=str, default='static_alloc,pad_to_max,buckets,dynamic')
+    args = parser.parse_args()
+
+    lengths = sample_lengths(args.requests + args.warmup, args.max_length, seed=0)
+    print('lengths: mean {:.1f}, p50 {:.0f}, p99 {:.0f}, distinct {}'.format(
+        lengths.mean(), np.percentile(lengths, 50), np.percentile(lengths, 99),
+        len(np.unique(lengths))))
+    print('{:>14} {:>14} {:>10} {:>10}'.format('mode', 'requests/sec', 'p50(ms)', 'p99(ms)'))
+    for mode in args.modes.split(','):
+        throughput, (p50, p99) = run(mode, args, lengths)
+        print('{:>14} {:>14.2f} {:>10.2f} {:>10.2f}'.format(mode, throughput, p50, p99))
+
+
+if __name__ == '__main__':
+    main()
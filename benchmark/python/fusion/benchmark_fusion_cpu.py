@@ -0,0 +1,91 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of pointwise fusion on CPU.
+
+Runs chains of elementwise operators of increasing length with
+MXNET_USE_FUSION=0 and MXNET_USE_FUSION=1 and reports time per call
+together with the effective memory bandwidth. The unfused graph reads
+and writes every intermediate result from main memory, while the fused
+operator only reads the inputs and writes the output once.
+"""
+
+import argparse
+import time
+import mxnet as mx
+from mxnet.test_utils import environment
+
+
+class ElemwiseChain(mx.gluon.HybridBlock):
+    def __init__(self, length, **kwargs):
+        super(ElemwiseChain, self).__init__(**kwargs)
+        self._length = length
+
+    def hybrid_forward(self, F, x, y):
+        ops = [lambda t: t + y,
+               F.relu,
+               lambda t: t * y,
+               lambda t: F.cast(F.cast(t, dtype='float16'), dtype='float32')]
+        out = x
+        for i in range(self._length):
+            out = ops[i % len(ops)](out)
+        return out
+
+
+def measure(length, size, fusion, repeat):
+    with environment('MXNET_USE_FUSION', '1' if fusion else '0'):
+        net = ElemwiseChain(length)
+        net.hybridize(static_alloc=True, static_shape=True)
+        x = mx.nd.random.uniform(shape=(size,))
+        y = mx.nd.random.uniform(shape=(size,))
+        # warm up, also builds the cached graph
+        for _ in range(3):
+            net(x, y)
+        mx.nd.waitall()
+        start = time.time()
+        for _ in range(repeat):
+            out = net(x, y)
+        out.wait_to_read()
+        return (time.time() - start) / repeat
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark pointwise fusion on CPU')
+    parser.add_argument('--size', type=int, default=1 << 24,
+                        help='number of elements in each input')
+    parser.add_argument('--repeat', type=int, default=20)
+    parser.add_argument('--lengths', type=str, default='2,4,8,16',
+                        help='comma separated lengths of the elementwise chains')
+    args = parser.parse_args()
+
+    bytes_per_elem = 4
+    print('{:>6} {:>12} {:>12} {:>8} {:>14} {:>14}'.format(
+        'length', 'unfused(ms)', 'fused(ms)', 'speedup', 'unfused(GB/s)', 'fused(GB/s)'))
+    for length in [int(l) for l in args.lengths.split(',')]:
+        unfused = measure(length, args.size, False, args.repeat)
+        fused = measure(length, args.size, True, args.repeat)
+        # Unfused: every op reads its inputs and writes its output.
+        # Fused: inputs x, y are read once and the output is written once.
+        traffic_unfused = args.size * bytes_per_elem * 3 * length
+        traffic_fused = args.size * bytes_per_elem * 3
+        print('{:>6} {:>12.3f} {:>12.3f} {:>8.2f} {:>14.2f} {:>14.2f}'.format(
+            length, unfused * 1e3, fused * 1e3, unfused / fused,
+            traffic_unfused / unfused / 1e9, traffic_fused / fused / 1e9))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,147 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of the gradient compression types of the dist kvstore.
+
+For each compression type a local dist_sync job is started with tools/launch.py.
+The workers push random gradients of a few big keys and pull their sum, and
+worker 0 reports:
+
+- the compression ratio, i.e. the size of the float32 gradient over the size
+  of what is pushed,
+- the push/pull throughput in gradient values per second,
+- the relative error of the pulled sum against the exact sum of the gradients,
+  for the last step, which includes the residual carried over from the
+  previous steps.
+
+The servers run without optimizer, so that they store the sum of the pushes.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+LAUNCHER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        '..', '..', '..', 'tools', 'launch.py')
+
+COMPRESSIONS = {
+    'none': None,
+    '2bit': {'type': '2bit', 'threshold': 0.5},
+    '1bit': {'type': '1bit', 'threshold': 0.5},
+    'topk': {'type': 'topk', 'ratio': 0.01},
+    'randomk': {'type': 'randomk', 'ratio': 0.01},
+}
+
+
+def compression_ratio(params):
+    if params is None:
+        return 1
+    if params['type'] == '2bit':
+        return 16
+    if params['type'] == '1bit':
+        return 32
+    # one float out of the smallest power of two group holding 1 / ratio values
+    group = 1
+    while group * params['ratio'] < 1:
+        group *= 2
+    return group
+
+
+def gradient(rank, step, shape):
+    return np.random.RandomState(rank * 100003 + step).normal(size=shape).astype(np.float32)
+
+
+def run_worker(args):
+    import mxnet as mx
+    kv = mx.kv.create('dist_sync')
+    params = COMPRESSIONS[args.compression]
+    if params is not None:
+        kv.set_gradient_compression(params)
+    keys = list(range(args.num_keys))
+    shape = (args.key_size,)
+    kv.init(keys, [mx.nd.zeros(shape) for _ in keys])
+    outs = [mx.nd.zeros(shape) for _ in keys]
+
+    def step(i):
+        grads = [mx.nd.array(gradient(kv.rank, i, shape)) for _ in keys]
+        mx.nd.waitall()
+        start = time.time()
+        kv.push(keys, grads)
+        kv.pull(keys, out=outs)
+        mx.nd.waitall()
+        return time.time() - start
+
+    for i in range(args.warmup):
+        step(i)
+    kv._barrier()
+    elapsed = sum(step(args.warmup + i) for i in range(args.repeat))
+    kv._barrier()
+    if kv.rank == 0:
+        last = args.warmup + args.repeat - 1
+        exact = sum(gradient(r, last, shape) for r in range(kv.num_workers))
+        error = np.linalg.norm(outs[0].asnumpy() - exact) / np.linalg.norm(exact)
+        values = args.num_keys * args.key_size * args.repeat
+        print('result {:.1f} {:.4f}'.format(values / elapsed / 1e6, error))
+        sys.stdout.flush()
+
+
+def run_job(compression, args):
+    cmd = [sys.executable, LAUNCHER, '-n', str(args.num_workers), '-s', str(args.num_servers),
+           '--launcher', 'local',
+           sys.executable, os.path.abspath(__file__), '--worker',
+           '--compression', compression,
+           '--num-keys', str(args.num_keys), '--key-size', str(args.key_size),
+           '--warmup', str(args.warmup), '--repeat', str(args.repeat)]
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, universal_newlines=True, check=True)
+    throughput, error = proc.stdout.split('result')[-1].split()[:2]
+    return float(throughput), float(error)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark gradient compression')
+    parser.add_argument('--num-workers', type=int, default=4)
+    parser.add_argument('--num-servers', type=int, default=1)
+    parser.add_argument('--num-keys', type=int, default=8)
+    parser.add_argument('--key-size', type=int, default=1 << 22)
+    parser.add_argument('--warmup', type=int, default=3)
+    parser.add_argument('--repeat', type=int, default=10)
+    parser.add_argument('--compressions', type=str, default=','.join(COMPRESSIONS),
+                        help='comma separated compression types among ' +
+                        ', '.join(COMPRESSIONS))
+    parser.add_argument('--compression', type=str, help=argparse.SUPPRESS)
+    parser.add_argument('--worker', action='store_true', help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.worker:
+        run_worker(args)
+        return
+
+    print('{} workers, {} servers, {} keys of {} floats'.format(
+        args.num_workers, args.num_servers, args.num_keys, args.key_size))
+    print('{:>12} {:>8} {:>16} {:>16}'.format('compression', 'ratio', 'Mvalues/sec', 'rel. error'))
+    for compression in args.compressions.split(','):
+        throughput, error = run_job(compression, args)
+        print('{:>12} {:>8} {:>16.1f} {:>16.4f}'.format(
+            compression, compression_ratio(COMPRESSIONS[compression]), throughput, error))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,192 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Timeline benchmark of the overlap of communication with the backward pass.
+
+A local dist_sync job is started with tools/launch.py, once with the default
+kvstore and once with the priority based P3 kvstore (--p3). The workers train
+an MLP whose back layers are much bigger than the front layers, and profile
+a few iterations. The chrome trace of worker 0 is written to the output
+directory, and summarized as:
+
+- the time per iteration,
+- the time per iteration spent in communication (kvstore push/pull operators),
+- the share of this communication which runs while backward operators run,
+  i.e. which is hidden behind compute.
+
+Open the traces in chrome://tracing to see the timeline.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+LAUNCHER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        '..', '..', '..', 'tools', 'launch.py')
+
+
+def build_net(args):
+    from mxnet import gluon
+    net = gluon.nn.HybridSequential()
+    # small front layers, big back layers as in typical convolutional networks
+    for i in range(args.num_layers):
+        net.add(gluon.nn.Dense(args.hidden * (i + 1), activation='relu'))
+    net.add(gluon.nn.Dense(10))
+    return net
+
+
+def run_worker(args):
+    import mxnet as mx
+    from mxnet import autograd, gluon
+    kv = mx.kv.create('dist_sync')
+    net = build_net(args)
+    net.initialize(mx.init.Xavier())
+    net.hybridize(static_alloc=True)
+    trainer = gluon.Trainer(net.collect_params(), 'sgd', {'learning_rate': 0.01},
+                            kvstore=kv, update_on_kvstore=False)
+    loss_fn = gluon.loss.SoftmaxCrossEntropyLoss()
+    data = mx.nd.random.uniform(shape=(args.batch_size, args.hidden))
+    label = mx.nd.random.randint(0, 10, shape=(args.batch_size,)).astype('float32')
+
+    def step():
+        with autograd.record():
+            loss = loss_fn(net(data), label)
+        loss.backward()
+        trainer.step(args.batch_size)
+        mx.nd.waitall()
+
+    for _ in range(args.warmup):
+        step()
+    kv._barrier()
+    mx.profiler.set_config(profile_all=True, aggregate_stats=False,
+                           filename=os.path.join(args.output, 'trace_{}.json'.format(kv.rank)))
+    mx.profiler.set_state('run')
+    start = time.time()
+    for _ in range(args.repeat):
+        step()
+    elapsed = time.time() - start
+    mx.profiler.set_state('stop')
+    mx.profiler.dump()
+    kv._barrier()
+    if kv.rank == 0:
+        print('ms_per_iter {:.3f}'.format(elapsed * 1000 / args.repeat))
+        sys.stdout.flush()
+
+
+def intervals(trace, match):
+    """[begin, end) in us of the profiled operators whose name matches"""
+    begins = {}
+    result = []
+    for ev in trace['traceEvents']:
+        if ev.get('ph') not in ('B', 'E') or not match(ev.get('name', '')):
+            continue
+        key = (ev['name'], ev['pid'], ev['tid'])
+        if ev['ph'] == 'B':
+            begins.setdefault(key, []).append(ev['ts'])
+        elif begins.get(key):
+            result.append((begins[key].pop(), ev['ts']))
+    return sorted(result)
+
+
+def union(ivs):
+    merged = []
+    for b, e in ivs:
+        if merged and b <= merged[-1][1]:
+            merged[-1][1] = max(merged[-1][1], e)
+        else:
+            merged.append([b, e])
+    return merged
+
+
+def length(ivs):
+    return sum(e - b for b, e in ivs)
+
+
+def intersection(a, b):
+    result = []
+    i = j = 0
+    while i < len(a) and j < len(b):
+        lo = max(a[i][0], b[j][0])
+        hi = min(a[i][1], b[j][1])
+        if lo < hi:
+            result.append((lo, hi))
+        if a[i][1] < b[j][1]:
+            i += 1
+        else:
+            j += 1
+    return result
+
+
+def summarize(path):
+    with open(path) as f:
+        trace = json.load(f)
+    backward = union(intervals(trace, lambda name: name.startswith('_backward')))
+    comm = union(intervals(trace, lambda name: 'Push' in name or 'Pull' in name))
+    hidden = length(intersection(backward, comm))
+    return hidden / max(length(comm), 1), length(comm)
+
+
+def run_job(p3, args):
+    output = os.path.abspath(os.path.join(args.output, 'p3' if p3 else 'default'))
+    os.makedirs(output, exist_ok=True)
+    cmd = [sys.executable, LAUNCHER, '-n', str(args.num_workers), '-s', str(args.num_servers),
+           '--launcher', 'local']
+    if p3:
+        cmd += ['--p3']
+    cmd += [sys.executable, os.path.abspath(__file__), '--worker', '--output', output,
+            '--num-layers', str(args.num_layers), '--hidden', str(args.hidden),
+            '--batch-size', str(args.batch_size),
+            '--warmup', str(args.warmup), '--repeat', str(args.repeat)]
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, universal_newlines=True, check=True)
+    ms = float(proc.stdout.split('ms_per_iter')[-1].split()[0])
+    trace = os.path.join(output, 'trace_0.json')
+    overlap, comm_us = summarize(trace)
+    return ms, overlap, comm_us / 1000 / args.repeat, trace
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Timeline of the P3 kvstore')
+    parser.add_argument('--num-workers', type=int, default=2)
+    parser.add_argument('--num-servers', type=int, default=2)
+    parser.add_argument('--num-layers', type=int, default=6)
+    parser.add_argument('--hidden', type=int, default=512)
+    parser.add_argument('--batch-size', type=int, default=64)
+    parser.add_argument('--warmup', type=int, default=5)
+    parser.add_argument('--repeat', type=int, default=10)
+    parser.add_argument('--output', type=str, default='p3_timeline')
+    parser.add_argument('--worker', action='store_true', help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.worker:
+        run_worker(args)
+        return
+
+    print('{} workers, {} servers, {} layers'.format(
+        args.num_workers, args.num_servers, args.num_layers))
+    print('{:>8} {:>12} {:>16} {:>20}   {}'.format(
+        'kvstore', 'ms/iter', 'comm ms/iter', 'hidden by backward', 'trace'))
+    for p3 in (False, True):
+        ms, overlap, comm_ms, trace = run_job(p3, args)
+        print('{:>8} {:>12.2f} {:>16.2f} {:>19.1f}%   {}'.format(
+            'p3' if p3 else 'default', ms, comm_ms, overlap * 100, trace))
+
+
+if __name__ == '__main__':
+    main()
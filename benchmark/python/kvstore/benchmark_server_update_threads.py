@@ -0,0 +1,100 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of the parameter server throughput with key-sharded update threads.
+
+For each value of MXNET_KVSTORE_SERVER_UPDATE_THREADS a local dist_sync job is
+started with tools/launch.py. The workers push and pull many small keys every
+iteration, so that the servers are bound by the handling of the requests.
+The servers run without optimizer, i.e. they aggregate the pushed values and
+copy them into the store, which does not need the Python updater.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+LAUNCHER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        '..', '..', '..', 'tools', 'launch.py')
+
+
+def run_worker(args):
+    import mxnet as mx
+    kv = mx.kv.create('dist_sync')
+    keys = list(range(args.num_keys))
+    shape = (args.key_size,)
+    kv.init(keys, [mx.nd.zeros(shape) for _ in keys])
+    grads = [mx.nd.ones(shape) for _ in keys]
+    outs = [mx.nd.zeros(shape) for _ in keys]
+
+    def step():
+        kv.push(keys, grads)
+        kv.pull(keys, out=outs)
+        mx.nd.waitall()
+
+    for _ in range(args.warmup):
+        step()
+    kv._barrier()
+    start = time.time()
+    for _ in range(args.repeat):
+        step()
+    elapsed = time.time() - start
+    kv._barrier()
+    if kv.rank == 0:
+        print('updates_per_sec {:.1f}'.format(args.num_keys * args.repeat / elapsed))
+        sys.stdout.flush()
+
+
+def run_job(threads, args):
+    cmd = [sys.executable, LAUNCHER, '-n', str(args.num_workers), '-s', str(args.num_servers),
+           '--launcher', 'local',
+           '--env-server', 'MXNET_KVSTORE_SERVER_UPDATE_THREADS:{}'.format(threads),
+           sys.executable, os.path.abspath(__file__), '--worker',
+           '--num-keys', str(args.num_keys), '--key-size', str(args.key_size),
+           '--warmup', str(args.warmup), '--repeat', str(args.repeat)]
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, universal_newlines=True, check=True)
+    return float(proc.stdout.split('updates_per_sec')[-1].split()[0])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark parameter server update threads')
+    parser.add_argument('--num-workers', type=int, default=4)
+    parser.add_argument('--num-servers', type=int, default=1)
+    parser.add_argument('--num-keys', type=int, default=512)
+    parser.add_argument('--key-size', type=int, default=4096)
+    parser.add_argument('--warmup', type=int, default=5)
+    parser.add_argument('--repeat', type=int, default=50)
+    parser.add_argument('--threads', type=str, default='0,1,2,4,8',
+                        help='comma separated values of MXNET_KVSTORE_SERVER_UPDATE_THREADS')
+    parser.add_argument('--worker', action='store_true', help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.worker:
+        run_worker(args)
+        return
+
+    print('{} workers, {} servers, {} keys of {} floats'.format(
+        args.num_workers, args.num_servers, args.num_keys, args.key_size))
+    print('{:>16} {:>16}'.format('update threads', 'updates/sec'))
+    for threads in args.threads.split(','):
+        print('{:>16} {:>16.1f}'.format(threads, run_job(int(threads), args)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,98 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of LayerNorm on CPU.
+
+Normalizing the last axis runs the fused CPU kernels: a single Welford pass
+for the moments plus one pass for the output in forward, and one kernel for
+the data, gamma and beta gradients in backward. Normalizing another axis of
+the same data still runs the general implementation built from broadcast and
+reduce operators, which this script uses as the baseline. Reports time per
+call for forward and forward+backward over a range of hidden sizes.
+"""
+
+import argparse
+import time
+import numpy as np
+import mxnet as mx
+from mxnet import autograd
+
+bfloat16 = np.dtype([('bfloat16', np.uint16)])
+
+
+def make_array(shape, dtype):
+    x = mx.nd.random.normal(shape=shape)
+    if dtype == 'bfloat16':
+        return mx.nd.amp_cast(x, dtype=bfloat16)
+    return x.astype(dtype)
+
+
+def measure(batch, hidden, dtype, fused, backward, repeat):
+    if fused:
+        shape, axis = (batch, hidden), -1
+    else:
+        shape, axis = (hidden, batch), 0
+    x = make_array(shape, dtype)
+    gamma = make_array((hidden,), dtype)
+    beta = make_array((hidden,), dtype)
+    if backward:
+        for arr in (x, gamma, beta):
+            arr.attach_grad()
+
+    def run():
+        if not backward:
+            return mx.nd.LayerNorm(x, gamma, beta, axis=axis)
+        with autograd.record():
+            out = mx.nd.LayerNorm(x, gamma, beta, axis=axis)
+        out.backward()
+        return x.grad
+
+    # warm up
+    for _ in range(3):
+        run()
+    mx.nd.waitall()
+    start = time.time()
+    for _ in range(repeat):
+        out = run()
+    out.wait_to_read()
+    return (time.time() - start) / repeat
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark LayerNorm on CPU')
+    parser.add_argument('--batch', type=int, default=1024,
+                        help='number of normalized rows, e.g. batch size * sequence length')
+    parser.add_argument('--hidden', type=str, default='256,512,1024,2048,4096,8192',
+                        help='comma separated hidden sizes')
+    parser.add_argument('--dtypes', type=str, default='float32,float16,bfloat16')
+    parser.add_argument('--repeat', type=int, default=50)
+    args = parser.parse_args()
+
+    print('{:>9} {:>7} {:>8} {:>12} {:>12} {:>8}'.format(
+        'dtype', 'hidden', 'pass', 'general(ms)', 'fused(ms)', 'speedup'))
+    for dtype in args.dtypes.split(','):
+        for hidden in [int(h) for h in args.hidden.split(',')]:
+            for backward in (False, True):
+                general = measure(args.batch, hidden, dtype, False, backward, args.repeat)
+                fused = measure(args.batch, hidden, dtype, True, backward, args.repeat)
+                print('{:>9} {:>7} {:>8} {:>12.3f} {:>12.3f} {:>8.2f}'.format(
+                    dtype, hidden, 'fwd+bwd' if backward else 'fwd',
+                    general * 1e3, fused * 1e3, general / fused))
+
+
+if __name__ == '__main__':
+    main()
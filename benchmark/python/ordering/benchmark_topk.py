@@ -0,0 +1,84 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of topk on CPU.
+
+Times mx.nd.topk for combinations of row length N, number of selected
+elements K and batch size, and reports the time per call next to a numpy
+argpartition + argsort reference. Small batches of long rows exercise the
+split of a row across threads, large K relative to N the full sort.
+"""
+
+import argparse
+import time
+import numpy as np
+import mxnet as mx
+
+
+def measure_mx(data, k, ret_typ, repeat):
+    mx.nd.topk(data, k=k, ret_typ=ret_typ).wait_to_read()
+    start = time.time()
+    for _ in range(repeat):
+        out = mx.nd.topk(data, k=k, ret_typ=ret_typ)
+    mx.nd.waitall()
+    return (time.time() - start) / repeat
+
+
+def measure_np(data, k, repeat):
+    start = time.time()
+    for _ in range(repeat):
+        part = np.argpartition(-data, k - 1, axis=-1)[:, :k]
+        vals = np.take_along_axis(data, part, axis=-1)
+        order = np.argsort(-vals, axis=-1)
+        np.take_along_axis(part, order, axis=-1)
+    return (time.time() - start) / repeat
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark topk on CPU')
+    parser.add_argument('--lengths', type=str, default='10000,1000000,5000000',
+                        help='comma separated row lengths N')
+    parser.add_argument('--ks', type=str, default='1,10,100,1000',
+                        help='comma separated numbers of selected elements K')
+    parser.add_argument('--batches', type=str, default='1,8,64',
+                        help='comma separated batch sizes')
+    parser.add_argument('--ret-typ', type=str, default='both',
+                        choices=['value', 'indices', 'mask', 'both'])
+    parser.add_argument('--max-elements', type=int, default=1 << 26,
+                        help='skip combinations with more input elements than this')
+    parser.add_argument('--repeat', type=int, default=10)
+    args = parser.parse_args()
+
+    print('{:>6} {:>9} {:>6} {:>10} {:>10} {:>14}'.format(
+        'batch', 'N', 'K', 'mx(ms)', 'numpy(ms)', 'mx(Melem/s)'))
+    for batch in [int(b) for b in args.batches.split(',')]:
+        for n in [int(l) for l in args.lengths.split(',')]:
+            if batch * n > args.max_elements:
+                continue
+            data_np = np.random.uniform(size=(batch, n)).astype(np.float32)
+            data = mx.nd.array(data_np)
+            for k in [int(k) for k in args.ks.split(',')]:
+                if k > n:
+                    continue
+                t_mx = measure_mx(data, k, args.ret_typ, args.repeat)
+                t_np = measure_np(data_np, k, args.repeat)
+                print('{:>6} {:>9} {:>6} {:>10.3f} {:>10.3f} {:>14.1f}'.format(
+                    batch, n, k, t_mx * 1e3, t_np * 1e3, batch * n / t_mx / 1e6))
+
+
+if __name__ == '__main__':
+    main()
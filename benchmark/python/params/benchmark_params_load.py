@@ -0,0 +1,99 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of loading a subset of the parameters of a large checkpoint.
+
+Writes a checkpoint of the given total size (5 GB by default) in the
+sequential format and in the indexed format, then measures the time to
+load a few of its parameters by name, and to load the whole file both by
+reading and by memory-mapping it. The page cache is dropped between the
+runs when the benchmark is allowed to do so (root), otherwise the numbers
+are for a warm cache.
+"""
+
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+import mxnet as mx
+
+
+def drop_caches():
+    try:
+        subprocess.run(['sync'], check=True)
+        with open('/proc/sys/vm/drop_caches', 'w') as f:
+            f.write('3\n')
+        return True
+    except (OSError, subprocess.CalledProcessError):
+        return False
+
+
+def timed(fn):
+    cold = drop_caches()
+    start = time.time()
+    out = fn()
+    mx.nd.waitall()
+    return time.time() - start, cold, out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark loading of the parameter files')
+    parser.add_argument('--total-gb', type=float, default=5.0,
+                        help='total size of the checkpoint in GB')
+    parser.add_argument('--num-params', type=int, default=200)
+    parser.add_argument('--num-keys', type=int, default=5,
+                        help='number of parameters loaded by name')
+    parser.add_argument('--dir', type=str, default=None,
+                        help='directory for the checkpoint files')
+    args = parser.parse_args()
+
+    elems = int(args.total_gb * 1e9 / 4 / args.num_params)
+    params = {'param_%d' % i: mx.nd.ones((elems,)) * i for i in range(args.num_params)}
+    step = max(1, args.num_params // args.num_keys)
+    keys = ['param_%d' % i for i in range(0, args.num_params, step)][:args.num_keys]
+
+    tmpdir = tempfile.mkdtemp(dir=args.dir)
+    files = {'sequential': os.path.join(tmpdir, 'sequential.params'),
+             'indexed': os.path.join(tmpdir, 'indexed.params')}
+    mx.nd.save(files['sequential'], params)
+    mx.nd.save(files['indexed'], params, indexed=True)
+    del params
+
+    print('{} parameters, {:.2f} GB, loading {} of them by name'.format(
+        args.num_params, elems * 4 * args.num_params / 1e9, len(keys)))
+    print('{:>12} {:>16} {:>16} {:>16} {:>6}'.format(
+        'format', 'subset (s)', 'full read (s)', 'full mmap (s)', 'cold'))
+    for fmt, fname in files.items():
+        subset, cold, out = timed(lambda: mx.nd.load(fname, keys=keys))
+        for i, k in enumerate(keys):
+            assert out[k][0].asscalar() == int(k.split('_')[1]), i
+        del out
+        full, _, out = timed(lambda: mx.nd.load(fname))
+        del out
+        mapped, _, out = timed(lambda: mx.nd.load(fname, mmap=True))
+        del out
+        print('{:>12} {:>16.3f} {:>16.3f} {:>16.3f} {:>6}'.format(
+            fmt, subset, full, mapped, 'yes' if cold else 'no'))
+
+    for fname in files.values():
+        os.remove(fname)
+    os.rmdir(tmpdir)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,85 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""Benchmark of the row sparse embedding gradient on CPU.
+
+Times the backward pass of mx.nd.Embedding with sparse_grad=True for
+Zipf-distributed indices over vocabularies of up to tens of millions of
+rows, and reports it next to the dense gradient for the vocabularies small
+enough to materialize it. The Zipf exponent controls how often the most
+frequent rows are repeated within a batch.
+"""
+
+import argparse
+import time
+import numpy as np
+import mxnet as mx
+
+
+def measure_backward(data, weight, ograd, sparse_grad, repeat):
+    in_dim, out_dim = weight.shape
+    weight.attach_grad(stype='row_sparse' if sparse_grad else 'default')
+
+    def run():
+        with mx.autograd.record():
+            out = mx.nd.Embedding(data, weight, input_dim=in_dim, output_dim=out_dim,
+                                  sparse_grad=sparse_grad)
+        out.backward(ograd)
+        weight.grad.wait_to_read()
+
+    run()
+    start = time.time()
+    for _ in range(repeat):
+        run()
+    return (time.time() - start) / repeat
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark the row sparse embedding gradient')
+    parser.add_argument('--vocabs', type=str, default='100000,1000000,10000000',
+                        help='comma separated vocabulary sizes')
+    parser.add_argument('--batches', type=str, default='4096,65536,524288',
+                        help='comma separated numbers of indices per batch')
+    parser.add_argument('--dim', type=int, default=64, help='embedding dimension')
+    parser.add_argument('--zipf', type=float, default=1.1, help='Zipf exponent of the indices')
+    parser.add_argument('--max-dense-elements', type=int, default=1 << 27,
+                        help='skip the dense gradient for larger weights')
+    parser.add_argument('--repeat', type=int, default=10)
+    args = parser.parse_args()
+
+    print('{:>10} {:>8} {:>9} {:>12} {:>12} {:>12}'.format(
+        'vocab', 'batch', 'unique', 'sparse(ms)', 'dense(ms)', 'Mrows/s'))
+    for vocab in [int(v) for v in args.vocabs.split(',')]:
+        weight = mx.nd.random.uniform(shape=(vocab, args.dim))
+        for batch in [int(b) for b in args.batches.split(',')]:
+            np_data = (np.random.zipf(args.zipf, size=batch) - 1) % vocab
+            data = mx.nd.array(np_data)
+            ograd = mx.nd.random.uniform(shape=(batch, args.dim))
+            t_sparse = measure_backward(data, weight, ograd, True, args.repeat)
+            if vocab * args.dim <= args.max_dense_elements:
+                dense = '{:>12.3f}'.format(
+                    measure_backward(data, weight, ograd, False, args.repeat) * 1e3)
+            else:
+                dense = '{:>12}'.format('-')
+            print('{:>10} {:>8} {:>9} {:>12.3f} {} {:>12.2f}'.format(
+                vocab, batch, len(np.unique(np_data)), t_sparse * 1e3, dense,
+                batch / t_sparse / 1e6))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,111 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Benchmark of the huge-page backed CPU memory pool on FullyConnected.
+
+Each configuration of MXNET_CPU_MEM_POOL_HUGE_PAGES is run in its own
+process, since the memory pool reads its settings once. The latency of
+FullyConnected with large weights is reported and, when `perf` is
+available, the dTLB load misses of the whole run as well.
+
+Explicit huge pages need to be reserved beforehand, for example:
+    echo 2048 | sudo tee /proc/sys/vm/nr_hugepages
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+MODES = ['None', 'Transparent', 'Explicit']
+HUGE_PAGE_SIZE = 2 * 1024 * 1024
+
+
+def run_fc(args):
+    import mxnet as mx
+    data = mx.nd.random.uniform(shape=(args.batch, args.in_units))
+    weight = mx.nd.random.uniform(shape=(args.hidden, args.in_units))
+    bias = mx.nd.random.uniform(shape=(args.hidden,))
+    for _ in range(3):
+        out = mx.nd.FullyConnected(data, weight, bias, num_hidden=args.hidden)
+    mx.nd.waitall()
+    start = time.time()
+    for _ in range(args.repeat):
+        out = mx.nd.FullyConnected(data, weight, bias, num_hidden=args.hidden)
+    out.wait_to_read()
+    print('latency_ms {:.4f}'.format((time.time() - start) / args.repeat * 1e3))
+
+
+def run_child(mode, args):
+    env = dict(os.environ)
+    env['MXNET_CPU_MEM_POOL_HUGE_PAGES'] = mode
+    if mode == 'Explicit':
+        # makes every chunk of the pool a multiple of the huge page size
+        env['MXNET_CPU_POOL_PAGE_SIZE'] = str(HUGE_PAGE_SIZE)
+    cmd = [sys.executable, __file__, '--child',
+           '--batch', str(args.batch), '--in-units', str(args.in_units),
+           '--hidden', str(args.hidden), '--repeat', str(args.repeat)]
+    use_perf = not args.no_perf and shutil.which('perf') is not None
+    if use_perf:
+        cmd = ['perf', 'stat', '-x', ',', '-e', 'dTLB-load-misses,dTLB-loads'] + cmd
+    proc = subprocess.run(cmd, env=env, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                          universal_newlines=True, check=True)
+    latency = float(proc.stdout.split('latency_ms')[-1].split()[0])
+    misses, loads = None, None
+    if use_perf:
+        for line in proc.stderr.splitlines():
+            fields = line.split(',')
+            if len(fields) > 2 and fields[0].isdigit():
+                if fields[2].startswith('dTLB-load-misses'):
+                    misses = int(fields[0])
+                elif fields[2].startswith('dTLB-loads'):
+                    loads = int(fields[0])
+    return latency, misses, loads
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark huge-page backed CPU memory pool')
+    parser.add_argument('--batch', type=int, default=64)
+    parser.add_argument('--in-units', type=int, default=8192)
+    parser.add_argument('--hidden', type=int, default=8192)
+    parser.add_argument('--repeat', type=int, default=50)
+    parser.add_argument('--modes', type=str, default=','.join(MODES),
+                        help='comma separated values of MXNET_CPU_MEM_POOL_HUGE_PAGES')
+    parser.add_argument('--no-perf', action='store_true',
+                        help='do not collect the dTLB statistics with perf')
+    parser.add_argument('--child', action='store_true', help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.child:
+        run_fc(args)
+        return
+
+    print('FullyConnected data ({}, {}), weight ({}, {})'.format(
+        args.batch, args.in_units, args.hidden, args.in_units))
+    print('{:>12} {:>12} {:>16} {:>12}'.format('huge pages', 'latency(ms)',
+                                              'dTLB misses', 'miss rate'))
+    for mode in args.modes.split(','):
+        latency, misses, loads = run_child(mode, args)
+        miss_str = str(misses) if misses is not None else 'n/a'
+        rate_str = '{:.4%}'.format(misses / loads) if misses is not None and loads else 'n/a'
+        print('{:>12} {:>12.3f} {:>16} {:>12}'.format(mode, latency, miss_str, rate_str))
+
+
+if __name__ == '__main__':
+    main()
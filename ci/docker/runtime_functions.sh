@@ -922,6 +922,12 @@ integrationtest_ubuntu_cpu_dist_kvstore() {
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --no-multiprecision
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_cpu
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_cpu --no-multiprecision
+    python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_1bit_cpu
+    python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_topk_cpu
+    python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_randomk_cpu
+    python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore_host_aggregation.py
+    python3 ../../tools/launch.py -n 3 --launcher local --p3 python3 dist_p3_kvstore.py
+    python3 ../../tools/launch.py -n 3 --launcher local --p3 python3 dist_p3_kvstore.py --type=compressed
     python3 ../../tools/launch.py -n 3 --launcher local python3 test_server_profiling.py
     popd
 }
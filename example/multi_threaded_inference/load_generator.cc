@@ -0,0 +1,215 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file load_generator.cc
+ * \brief Closed loop load generator for the thread safe CachedOp, which reports
+ *  the latency percentiles and the throughput versus the number of concurrent
+ *  clients, with and without the dynamic batching of the concurrent calls.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mxnet/ndarray.h>
+#include "mxnet-cpp/MxNetCpp.h"
+
+struct LoadResult {
+  double throughput;
+  double p50_ms;
+  double p99_ms;
+};
+
+double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t i = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+  return sorted[i];
+}
+
+class Model {
+ public:
+  Model(const std::string& model_name, const mxnet::cpp::Context& ctx)
+      : sym_(mxnet::cpp::Symbol::Load(model_name + "-symbol.json")), ctx_(ctx) {
+    std::map<std::string, mxnet::cpp::NDArray> parameters;
+    mxnet::cpp::NDArray::Load(model_name + "-0000.params", 0, &parameters);
+    input_names_ = sym_.ListInputs();
+    for (size_t i = 0; i < input_names_.size(); ++i) {
+      const std::string& name = input_names_[i];
+      if (parameters.count("arg:" + name)) {
+        params_[i] = parameters["arg:" + name].Copy(ctx_);
+      } else if (parameters.count("aux:" + name)) {
+        params_[i] = parameters["aux:" + name].Copy(ctx_);
+      } else {
+        data_indices_.push_back(i);
+      }
+    }
+    mxnet::cpp::NDArray::WaitAll();
+  }
+
+  CachedOpHandle Create(int max_batch_size, int batch_timeout_us) {
+    std::ostringstream data_indices, param_indices;
+    data_indices << "[";
+    param_indices << "[";
+    for (size_t i = 0; i < input_names_.size(); ++i) {
+      (params_.count(i) ? param_indices : data_indices) << i << ", ";
+    }
+    data_indices << "]";
+    param_indices << "]";
+    std::vector<std::string> keys{"data_indices", "param_indices", "static_alloc",
+                                  "static_shape", "max_batch_size", "batch_timeout_us"};
+    std::vector<std::string> vals{data_indices.str(), param_indices.str(), "true", "true",
+                                  std::to_string(max_batch_size),
+                                  std::to_string(batch_timeout_us)};
+    std::vector<const char*> key_cstrs, val_cstrs;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      key_cstrs.push_back(keys[i].c_str());
+      val_cstrs.push_back(vals[i].c_str());
+    }
+    CachedOpHandle hdl = CachedOpHandle();
+    if (MXCreateCachedOp(sym_.GetHandle(), keys.size(), key_cstrs.data(),
+                         val_cstrs.data(), &hdl, true) < 0) {
+      LOG(FATAL) << MXGetLastError();
+    }
+    return hdl;
+  }
+
+  // inputs of a client: random data of batch size 1 and shared parameters
+  std::vector<mxnet::cpp::NDArray> Inputs(const mxnet::cpp::Shape& data_shape) const {
+    std::vector<mxnet::cpp::NDArray> inputs(input_names_.size());
+    for (size_t i = 0; i < input_names_.size(); ++i) {
+      if (params_.count(i)) {
+        inputs[i] = params_.at(i);
+      } else if (i == data_indices_[0]) {
+        inputs[i] = mxnet::cpp::NDArray(data_shape, ctx_, false);
+        mxnet::cpp::Operator("_random_uniform")(0, 1).Invoke(inputs[i]);
+      } else {
+        // labels of the loss layer
+        inputs[i] = mxnet::cpp::NDArray(mxnet::cpp::Shape(data_shape[0]), ctx_, false);
+        inputs[i] = 0;
+      }
+    }
+    mxnet::cpp::NDArray::WaitAll();
+    return inputs;
+  }
+
+ private:
+  mxnet::cpp::Symbol sym_;
+  mxnet::cpp::Context ctx_;
+  std::vector<std::string> input_names_;
+  std::vector<size_t> data_indices_;
+  std::map<size_t, mxnet::cpp::NDArray> params_;
+};
+
+LoadResult RunLoad(Model* model, CachedOpHandle hdl, int dev_type,
+                   const mxnet::cpp::Shape& data_shape, int concurrency, double duration) {
+  std::vector<std::vector<double> > latencies(concurrency);
+  std::atomic<bool> stop(false);
+  std::vector<std::vector<mxnet::cpp::NDArray> > inputs;
+  for (int i = 0; i < concurrency; ++i) inputs.push_back(model->Inputs(data_shape));
+
+  auto client = [&](int id) {
+    std::vector<NDArrayHandle> handles;
+    for (auto& arr : inputs[id]) handles.push_back(arr.GetHandle());
+    while (!stop.load()) {
+      auto start = std::chrono::steady_clock::now();
+      int num_outputs = 0;
+      NDArrayHandle* outputs = nullptr;
+      const int* stypes;
+      if (MXInvokeCachedOp(hdl, handles.size(), handles.data(), dev_type, 0,
+                           &num_outputs, &outputs, &stypes) < 0) {
+        LOG(FATAL) << MXGetLastError();
+      }
+      std::vector<NDArrayHandle> results(outputs, outputs + num_outputs);
+      for (auto result : results) {
+        static_cast<mxnet::NDArray*>(result)->WaitToRead();
+        MXNDArrayFree(result);
+      }
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      latencies[id].push_back(elapsed.count());
+    }
+  };
+
+  std::vector<std::thread> clients;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < concurrency; ++i) clients.emplace_back(client, i);
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+  stop = true;
+  for (auto& t : clients) t.join();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::vector<double> all;
+  for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  return {all.size() * data_shape[0] / elapsed.count(),
+          Percentile(all, 0.5), Percentile(all, 0.99)};
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cout << "Usage: ./load_generator [model_name] [is_gpu] [max_batch_size] "
+              << "[batch_timeout_us] [duration_s] [concurrency,...]" << std::endl
+              << "Example: ./load_generator imagenet1k-resnet-18 0 32 1000 5 1,2,4,8,16,32"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string model_name = argv[1];
+  bool is_gpu = std::atoi(argv[2]);
+  int max_batch_size = argc > 3 ? std::atoi(argv[3]) : 32;
+  int batch_timeout_us = argc > 4 ? std::atoi(argv[4]) : 1000;
+  double duration = argc > 5 ? std::atof(argv[5]) : 5;
+  std::vector<int> concurrencies;
+  std::stringstream levels(argc > 6 ? argv[6] : "1,2,4,8,16,32");
+  for (std::string level; std::getline(levels, level, ',');) {
+    concurrencies.push_back(std::atoi(level.c_str()));
+  }
+
+  mxnet::cpp::Context ctx = is_gpu ? mxnet::cpp::Context::gpu(0) : mxnet::cpp::Context::cpu(0);
+  int dev_type = is_gpu ? mxnet::gpu::kDevMask : mxnet::cpu::kDevMask;
+  mxnet::cpp::Shape data_shape(1, 3, 224, 224);
+  Model model(model_name, ctx);
+
+  std::printf("%12s %12s %16s %10s %10s\n", "concurrency", "batching", "throughput(/s)",
+              "p50(ms)", "p99(ms)");
+  for (int concurrency : concurrencies) {
+    for (int batch : {0, max_batch_size}) {
+      CachedOpHandle hdl = model.Create(batch, batch_timeout_us);
+      // warm up, which also plans the memory of the batch sizes seen first
+      RunLoad(&model, hdl, dev_type, data_shape, concurrency, 0.5);
+      LoadResult res = RunLoad(&model, hdl, dev_type, data_shape, concurrency, duration);
+      std::printf("%12d %12s %16.1f %10.2f %10.2f\n", concurrency,
+                  batch > 1 ? std::to_string(batch).c_str() : "off",
+                  res.throughput, res.p50_ms, res.p99_ms);
+      if (MXFreeCachedOp(hdl) < 0) {
+        LOG(FATAL) << MXGetLastError();
+      }
+    }
+  }
+  mxnet::cpp::NDArray::WaitAll();
+  return 0;
+}
@@ -716,6 +716,19 @@ MXNET_DLL int MXNDArraySave(const char* fname,
                             uint32_t num_args,
                             NDArrayHandle* args,
                             const char** keys);
+/*!
+ * \brief Save list of narray into the file in the indexed format, in which the
+ * payloads are aligned to 64 bytes and can be loaded by name or memory-mapped.
+ * \param fname name of the file.
+ * \param num_args number of arguments to save.
+ * \param args the array of NDArrayHandles to be saved.
+ * \param keys the name of the NDArray, optional, can be NULL
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveIndexed(const char* fname,
+                                   uint32_t num_args,
+                                   NDArrayHandle* args,
+                                   const char** keys);
 /*!
  * \brief Load list of narray from the file.
  * \param fname name of the file.
@@ -752,6 +765,44 @@ MXNET_DLL int MXNDArrayLoadFromBuffer(const void *ndarray_buffer,
                                       uint32_t *out_name_size,
                                       const char*** out_names);
 
+/*!
+ * \brief Load list / dictionary of narrays from the memory-mapped file.
+ * This will load a list of ndarrays in a similar manner to MXNDArrayLoad,
+ * however, the dense CPU arrays, whose data are suitably aligned in the file,
+ * are not copied: they use the private mapping of the file, so their memory
+ * is shared between the processes, which load the same file, until written to.
+ * The other arrays are copied. When the file cannot be mapped, it is loaded
+ * as by MXNDArrayLoad.
+ * \param fname name of the file.
+ * \param out_size number of narray loaded.
+ * \param out_arr head of the returning narray handles.
+ * \param out_name_size size of output name arrray.
+ * \param out_names the names of returning NDArrays, can be NULL
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayLoadMapped(const char* fname,
+                                  uint32_t *out_size,
+                                  NDArrayHandle** out_arr,
+                                  uint32_t *out_name_size,
+                                  const char*** out_names);
+
+/*!
+ * \brief Load the narrays with the given names from the file.
+ * Only the requested arrays are read from the files saved by MXNDArraySaveIndexed,
+ * the files in the other formats are loaded completely.
+ * \param fname name of the file.
+ * \param num_names number of the names.
+ * \param names the names of the NDArrays to load.
+ * \param out_size number of narray loaded.
+ * \param out_arr head of the returning narray handles, in the order of the names.
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayLoadByName(const char* fname,
+                                  uint32_t num_names,
+                                  const char** names,
+                                  uint32_t *out_size,
+                                  NDArrayHandle** out_arr);
+
 /*!
  * \brief Perform a synchronize copy from a contiguous CPU memory region.
  *
@@ -401,6 +401,13 @@ class NDArray {
   inline Engine::VarHandle var() const {
     return ptr_->var;
   }
+  /*!
+   * \return the variables of the arrays, which use the memory of the ndarray at other
+   *  times. The operators writing the ndarray also write them, see InitFromArena.
+   */
+  inline const std::vector<Engine::VarHandle>& memory_vars() const {
+    return ptr_->memory_vars;
+  }
   /*! \return byte offset in chunk of the ndarray*/
   inline size_t byte_offset() const {
     return byte_offset_;
@@ -602,6 +609,26 @@ class NDArray {
     reuse_ = true;
   }
 
+  /*!
+   * \brief Initialize as an array carved out of the memory of the arena, starting at
+   *  byte_offset. Unlike the views of the arena, the array has its own engine variable,
+   *  so that the operators of the different arrays of the arena run in parallel.
+   *  The arena is kept alive by the array.
+   * \param arena the array that owns the memory, it is allocated here if still delayed.
+   * \param byte_offset offset of the array in the arena in bytes.
+   * \param size size of the memory of the array in bytes.
+   * \param shape shape of the array.
+   * \param dtype data type of the array.
+   */
+  void InitFromArena(const NDArray &arena, size_t byte_offset, size_t size,
+                     const mxnet::TShape &shape, int dtype);
+  /*!
+   * \brief Order the writes of the array, carved out of an arena, after the operators
+   *  of another array of the arena, which uses the same memory at another time.
+   * \param other the array of the same arena sharing some of the memory.
+   */
+  void AddMemoryDependency(const NDArray &other);
+
   /*!
    * \brief Create a reference view of NDArray that
    *  represents as DLManagedTensor.
@@ -842,6 +869,51 @@ class NDArray {
   static void Load(dmlc::Stream* fi,
                    std::vector<NDArray>* data,
                    std::vector<std::string>* keys);
+  /*!
+   * \brief Save list of ndarray into the Stream in the indexed format.
+   *  The file starts with the index of the arrays (name, storage type, dtype,
+   *  shape and offsets of the payloads), followed by the payloads aligned to
+   *  64 bytes, so that the arrays can be loaded by name or memory-mapped.
+   * \param fo The stream of output.
+   * \param data the NDArrays to be saved.
+   * \param names the name of the NDArray, optional, can be zero length.
+   */
+  static void SaveIndexed(dmlc::Stream* fo,
+                          const std::vector<NDArray>& data,
+                          const std::vector<std::string>& names);
+  /*!
+   * \brief Load list of ndarray saved in the indexed format.
+   *  Called by Load, when it detects the magic number of the indexed format.
+   * \param fi The stream of the input file, positioned after the magic number.
+   * \param data the NDArrays to be loaded
+   * \param keys the name of the NDArray, if saved in the file.
+   */
+  static void LoadIndexed(dmlc::Stream* fi,
+                          std::vector<NDArray>* data,
+                          std::vector<std::string>* keys);
+  /*!
+   * \brief Load the ndarrays with the given names from the file.
+   *  Only the requested payloads are read from the files in the indexed format,
+   *  the files in the other formats are loaded completely.
+   * \param fname The name of the file.
+   * \param names the names of the NDArrays to be loaded
+   * \param data the NDArrays in the order of the names
+   */
+  static void LoadByName(const std::string& fname,
+                         const std::vector<std::string>& names,
+                         std::vector<NDArray>* data);
+  /*!
+   * \brief Load list of ndarray from the memory-mapped file.
+   *  The dense CPU arrays with suitably aligned data are created directly on
+   *  the top of the private mapping of the file, so the pages are shared between
+   *  the processes until written to. Other arrays are copied as by Load.
+   * \param fname The name of the file.
+   * \param data the NDArrays to be loaded
+   * \param keys the name of the NDArray, if saved in the file.
+   */
+  static void LoadMapped(const std::string& fname,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* keys);
 
  private:
   friend class Imperative;
@@ -893,6 +965,15 @@ class NDArray {
     std::shared_ptr<Storage> storage_ref_;
     /*! \brief Reference to the engine to ensure we cleanup without calling a destructed engine */
     std::weak_ptr<Engine> engine_ref_;
+    /*! \brief the arena this chunk is carved out of, see InitFromArena */
+    std::shared_ptr<Chunk> arena;
+    /*!
+     * \brief variables of the chunks carved out of the same arena, which use the memory
+     *  of this chunk at other times. They are deleted with the arena.
+     */
+    std::vector<Engine::VarHandle> memory_vars;
+    /*! \brief variables of the chunks carved out of this arena */
+    std::vector<Engine::VarHandle> carved_vars;
 
 
     /*! \brief default constructor */
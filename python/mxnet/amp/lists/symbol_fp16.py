@@ -591,6 +591,7 @@ FP32_FUNCS = [
     '_npx_deformable_convolution',
     '_npx_modulated_deformable_convolution',
     '_contrib_DeformablePSROIPooling',
+    '_contrib_interleaved_selfatt',
     ]
 
 if Features().is_enabled('MKLDNN'):
@@ -908,6 +908,7 @@ class HybridBlock(Block):
         self._called_infer_shape_already = False
         self._active = False
         self._flags = []
+        self._bucketing = None
         self._callback = None
         self._monitor_all = False
         self._backend = None
@@ -1126,13 +1127,70 @@ class HybridBlock(Block):
                                  .format(fmt, self._in_format))
 
         args_without_none = [ele for ele in args if ele is not None]
+        length, bucket_length = None, None
+        if self._bucketing is not None:
+            args_without_none, length, bucket_length = self._pad_to_bucket(args_without_none)
         cargs = [args_without_none[i] if is_arg else i.data()
                  for is_arg, name, i in self._cached_op_args]
         out = self._cached_op(*cargs)
         if isinstance(out, NDArray):
             out = [out]
+        if length != bucket_length:
+            out = self._slice_from_bucket(out, length, bucket_length)
         return _regroup(out, self._out_format)
 
+    def _pad_to_bucket(self, args):
+        """Pads the inputs, which have the length of the first input along the bucket
+        axis, up to the bucket size. Returns the inputs, the length and the bucket size."""
+        axis, sizes, pad_value, _ = self._bucketing
+        arrays = [a for a in args if isinstance(a, NDArray) and a.ndim > axis]
+        if not arrays:
+            return args, None, None
+        length = arrays[0].shape[axis]
+        if sizes is None:
+            bucket_length = 1 << max(length - 1, 0).bit_length()
+        else:
+            bucket_length = next((b for b in sizes if b >= length), length)
+        if bucket_length == length:
+            return args, length, length
+        padded = []
+        for a in args:
+            if isinstance(a, NDArray) and a.ndim > axis and a.shape[axis] == length:
+                pad_shape = list(a.shape)
+                pad_shape[axis] = bucket_length - length
+                is_np = isinstance(a, _mx_np.ndarray)
+                pad = ndarray.full(tuple(pad_shape), pad_value, ctx=a.context, dtype=a.dtype)
+                out = ndarray.concat(a.as_nd_ndarray() if is_np else a, pad, dim=axis)
+                a = out.as_np_ndarray() if is_np else out
+            padded.append(a)
+        return padded, length, bucket_length
+
+    def _slice_from_bucket(self, out, length, bucket_length):
+        """Slices the outputs declared in `bucket_output_axes` back to the length."""
+        output_axes = self._bucketing[3]
+        if output_axes is None:
+            return out
+        if len(output_axes) != len(out):
+            raise ValueError("bucket_output_axes has %d entries, but the block has %d outputs"
+                             % (len(output_axes), len(out)))
+        sliced = []
+        for i, (o, axis) in enumerate(zip(out, output_axes)):
+            if axis is not None:
+                if o.ndim <= axis or o.shape[axis] != bucket_length:
+                    raise ValueError("Output %d of shape %s does not have the bucket size %d "
+                                     "along the axis %d of bucket_output_axes"
+                                     % (i, str(o.shape), bucket_length, axis))
+                o = self._slice_axis(o, axis, length)
+            sliced.append(o)
+        return sliced
+
+    @staticmethod
+    def _slice_axis(array, axis, length):
+        is_np = isinstance(array, _mx_np.ndarray)
+        out = ndarray.slice_axis(array.as_nd_ndarray() if is_np else array,
+                                 axis=axis, begin=0, end=length)
+        return out.as_np_ndarray() if is_np else out
+
     def optimize_for(self, x, *args, backend=None, backend_opts=None, clear=True, **kwargs):
         """Partitions the current HybridBlock and optimizes it for a given backend
         without executing a forward pass. Modifies the HybridBlock in-place.
@@ -1234,6 +1292,33 @@ class HybridBlock(Block):
             Optimize for invariant input shapes between iterations. Must also
             set static_alloc to True. Change of input shapes is still allowed
             but slower.
+        max_static_alloc_shapes : int, default 1
+            Number of input shapes, for which the memory plans and the statically
+            allocated memory are kept, when static_alloc is True. A new input shape
+            replaces the least recently used one.
+        memory_planner : str, default None
+            'greedy' reuses the memory of the released arrays of a similar size.
+            'offset' packs the intermediate arrays into a single allocation by their
+            lifetimes, which usually needs less memory. Defaults to the environment variable
+            MXNET_MEMORY_PLANNER.
+        bucket_axis : int, default None
+            Pad the inputs along this axis up to the next bucket size, so that inputs
+            of varying length (e.g. sequence length) share the memory plans and the
+            statically allocated memory of a few shapes. All the inputs, which have the
+            length of the first input along the axis, are padded with `bucket_pad_value`.
+            Inputs like the valid length of the sequences, which a model uses to mask out
+            the padding, are passed unchanged. The outputs are sliced back to the original
+            length as declared by `bucket_output_axes`.
+        bucket_sizes : list of int, default None
+            Sorted bucket sizes along `bucket_axis`. Powers of two if None. Inputs
+            longer than the last bucket size are not padded.
+        bucket_pad_value : float, default 0
+            Value of the padding.
+        bucket_output_axes : list of int or None, default None
+            For each output, in the order of the flattened outputs, the axis along which
+            the output has the length of the inputs and is sliced back to it, or None for
+            an output which is returned as computed on the padded inputs. None returns
+            all the outputs as computed on the padded inputs.
         """
 
         self._backend = backend
@@ -1243,6 +1328,17 @@ class HybridBlock(Block):
             self._backend_opts = backend_opts
 
         self._active = active
+        bucket_axis = kwargs.pop('bucket_axis', None)
+        bucket_sizes = kwargs.pop('bucket_sizes', None)
+        bucket_pad_value = kwargs.pop('bucket_pad_value', 0)
+        bucket_output_axes = kwargs.pop('bucket_output_axes', None)
+        if bucket_axis is not None:
+            if bucket_sizes is not None:
+                bucket_sizes = sorted(bucket_sizes)
+            self._bucketing = (bucket_axis, bucket_sizes, bucket_pad_value,
+                               bucket_output_axes)
+        else:
+            self._bucketing = None
         self._flags = list(kwargs.items())
         if clear:
             self._clear_cached_op()
@@ -773,10 +773,13 @@ class _MXThreadedDataLoader(object):
         but will consume more shared_memory. Using smaller number may forfeit the purpose of using
         multiple worker processes, try reduce `num_workers` in this case.
         By default it defaults to `num_workers * 2`, maximum prefetch size is `16`.
+    prefetch_depth : int, default 0
+        The number of batches loaded and batchified ahead by a background worker of the
+        C++ loader, into a ring of reused batch buffers. 0 loads each batch on demand.
     """
     def __init__(self, dataset, batch_sampler, batchify_fn,
                  num_workers=0, pin_memory=False, pin_device_id=0,
-                 prefetch=4):
+                 prefetch=4, prefetch_depth=0):
         from ._internal import MXDataset, MXSampler, MXBatchifyFunction
         from ...io.io import ThreadedDataLoader
         assert isinstance(dataset, MXDataset)
@@ -794,7 +797,7 @@ class _MXThreadedDataLoader(object):
         self._iter = ThreadedDataLoader(num_workers=num_workers, dataset=dataset,
                                         sampler=batch_sampler, batchify_fn=batchify_fn,
                                         prefetch_buffer=prefetch, ctx=ctx,
-                                        device_id=pin_device_id)
+                                        device_id=pin_device_id, prefetch_depth=prefetch_depth)
 
     def __iter__(self):
         while self._iter.iter_next():
@@ -46,7 +46,8 @@ def _get_kvstore_server_command_type(command):
                      'kStopServer': 2,
                      'kSyncMode': 3,
                      'kSetGradientCompression': 4,
-                     'kSetProfilerParams': 5}
+                     'kSetProfilerParams': 5,
+                     'kSetHostGroup': 6}
     assert (command in command_types), "Unknown command type to send to server"
     return command_types[command]
 
@@ -535,13 +536,24 @@ class KVStore(KVStoreBase):
         a dictionary which includes `threshold` like:
         {'type': '2bit', 'threshold': 0.5}
 
+        1bit Gradient Compression sends the sign of every value, which is dequantized
+        to `threshold` or `-threshold`, and keeps the difference as residual
+        (error feedback). Every 32 float values are sent as one float:
+        {'type': '1bit', 'threshold': 0.5}
+
+        topk and randomk Gradient Compression send one value out of every group of
+        values, respectively the value of the largest magnitude and a value picked
+        at random. The group size is the smallest power of two which is at least
+        1 / `ratio`, the values which are not sent accumulate in the residual:
+        {'type': 'topk', 'ratio': 0.01}
+
         Parameters
         ----------
         compression_params : dict
             A dictionary specifying the type and parameters for gradient compression.
             The key `type` in this dictionary is a
             required string argument and specifies the type of gradient compression.
-            Currently `type` can be only `2bit`
+            Currently `type` can be `2bit`, `1bit`, `topk` or `randomk`
             Other keys in this dictionary are optional and specific to the type
             of gradient compression.
         """
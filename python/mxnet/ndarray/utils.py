@@ -146,7 +146,7 @@ def array(source_array, ctx=None, dtype=None):
         return _array(source_array, ctx=ctx, dtype=dtype)
 
 
-def load(fname):
+def load(fname, mmap=False, keys=None):
     """Loads an array from file.
 
     See more details in ``save``.
@@ -155,6 +155,17 @@ def load(fname):
     ----------
     fname : str
         The filename.
+    mmap : bool, default False
+        Whether to memory-map the file instead of reading it. Dense CPU arrays,
+        whose data are suitably aligned in the file, are then backed directly by
+        the copy-on-write mapping of the file: no copy is made on load and the
+        memory is shared between the processes, which load the same file, until
+        the arrays are written to. Other arrays are copied as usual, and so
+        are all the arrays on Windows and on big-endian hosts.
+    keys : list of str, optional
+        Names of the arrays to load. Only these arrays are read from the files
+        saved with ``indexed=True``; the files in the other formats are read
+        completely. A dict of the requested arrays is returned.
 
     Returns
     -------
@@ -168,11 +179,21 @@ def load(fname):
     out_name_size = mx_uint()
     handles = ctypes.POINTER(NDArrayHandle)()
     names = ctypes.POINTER(ctypes.c_char_p)()
-    check_call(_LIB.MXNDArrayLoad(c_str(fname),
-                                  ctypes.byref(out_size),
-                                  ctypes.byref(handles),
-                                  ctypes.byref(out_name_size),
-                                  ctypes.byref(names)))
+    if keys is not None:
+        if mmap:
+            raise ValueError('mmap and keys cannot be used together')
+        check_call(_LIB.MXNDArrayLoadByName(c_str(fname),
+                                            mx_uint(len(keys)),
+                                            c_str_array(keys),
+                                            ctypes.byref(out_size),
+                                            ctypes.byref(handles)))
+        return dict((k, _ndarray_cls(NDArrayHandle(handles[i]))) for i, k in enumerate(keys))
+    load_fn = _LIB.MXNDArrayLoadMapped if mmap else _LIB.MXNDArrayLoad
+    check_call(load_fn(c_str(fname),
+                       ctypes.byref(out_size),
+                       ctypes.byref(handles),
+                       ctypes.byref(out_name_size),
+                       ctypes.byref(names)))
     if out_name_size.value == 0:
         return [_ndarray_cls(NDArrayHandle(handles[i])) for i in range(out_size.value)]
     else:
@@ -219,7 +240,7 @@ def load_frombuffer(buf):
             for i in range(out_size.value))
 
 
-def save(fname, data):
+def save(fname, data, indexed=False):
     """Saves a list of arrays or a dict of str->array to file.
 
     Examples of filenames:
@@ -236,6 +257,12 @@ def save(fname, data):
            or list of NDArray, RowSparseNDArray or CSRNDArray, \
            or dict of str to NDArray, RowSparseNDArray or CSRNDArray
         The data to save.
+    indexed : bool, default False
+        Whether to save the arrays in the indexed format. The file then starts with
+        an index of the arrays and the data of each array are aligned to 64 bytes,
+        so that single arrays can be loaded with ``load(fname, keys=...)`` and the
+        arrays can be memory-mapped with ``load(fname, mmap=True)``.
+        Such files cannot be loaded by the older versions of MXNet.
 
     Examples
     --------
@@ -274,7 +301,8 @@ def save(fname, data):
     else:
         raise ValueError("data needs to either be a NDArray, dict of str, NDArray pairs "
                          "or a list of NDarrays.")
-    check_call(_LIB.MXNDArraySave(c_str(fname),
-                                  mx_uint(len(handles)),
-                                  handles,
-                                  keys))
+    save_fn = _LIB.MXNDArraySaveIndexed if indexed else _LIB.MXNDArraySave
+    check_call(save_fn(c_str(fname),
+                       mx_uint(len(handles)),
+                       handles,
+                       keys))
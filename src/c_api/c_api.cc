@@ -1879,6 +1879,29 @@ int MXNDArraySave(const char* fname,
   API_END();
 }
 
+int MXNDArraySaveIndexed(const char* fname,
+                         uint32_t num_args,
+                         NDArrayHandle* args,
+                         const char** keys) {
+  API_BEGIN();
+  std::vector<NDArray> data(num_args);
+  std::vector<std::string> names;
+  for (uint32_t i = 0; i < num_args; ++i) {
+    data[i] = *static_cast<NDArray*>(args[i]);
+  }
+  if (keys != nullptr) {
+    names.resize(num_args);
+    for (uint32_t i = 0; i < num_args; ++i) {
+      names[i] = keys[i];
+    }
+  }
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname, "w"));
+    mxnet::NDArray::SaveIndexed(fo.get(), data, names);
+  }
+  API_END();
+}
+
 int MXNDArrayLoad(const char* fname,
                   uint32_t *out_size,
                   NDArrayHandle** out_arr,
@@ -1944,6 +1967,55 @@ int MXNDArrayLoadFromBuffer(const void *ndarray_buffer,
   API_END();
 }
 
+int MXNDArrayLoadMapped(const char* fname,
+                        uint32_t *out_size,
+                        NDArrayHandle** out_arr,
+                        uint32_t *out_name_size,
+                        const char*** out_names) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  ret->ret_vec_str.clear();
+  API_BEGIN();
+  std::vector<NDArray> data;
+  std::vector<std::string> &names = ret->ret_vec_str;
+  mxnet::NDArray::LoadMapped(fname, &data, &names);
+  ret->ret_handles.resize(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    NDArray *ptr = new NDArray();
+    *ptr = data[i];
+    ret->ret_handles[i] = ptr;
+  }
+  ret->ret_vec_charp.resize(names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    ret->ret_vec_charp[i] = names[i].c_str();
+  }
+  *out_size = static_cast<uint32_t>(data.size());
+  *out_arr = dmlc::BeginPtr(ret->ret_handles);
+  *out_name_size = static_cast<uint32_t>(names.size());
+  *out_names = dmlc::BeginPtr(ret->ret_vec_charp);
+  API_END();
+}
+
+int MXNDArrayLoadByName(const char* fname,
+                        uint32_t num_names,
+                        const char** names,
+                        uint32_t *out_size,
+                        NDArrayHandle** out_arr) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  API_BEGIN();
+  std::vector<NDArray> data;
+  std::vector<std::string> keys(names, names + num_names);
+  mxnet::NDArray::LoadByName(fname, keys, &data);
+  ret->ret_handles.resize(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    NDArray *ptr = new NDArray();
+    *ptr = data[i];
+    ret->ret_handles[i] = ptr;
+  }
+  *out_size = static_cast<uint32_t>(data.size());
+  *out_arr = dmlc::BeginPtr(ret->ret_handles);
+  API_END();
+}
+
 int MXNDArrayFree(NDArrayHandle handle) {
   API_BEGIN();
   delete static_cast<NDArray*>(handle);
@@ -49,16 +49,37 @@ ThreadedVar::ThreadedVar(VersionedVarBlock* head) : head_{head} {
 }
 
 inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
-  std::lock_guard<std::mutex> lock{mutex_};
-  if (pending_write_ == nullptr) {
+  // Fast path: without a pending write the read can run right away,
+  // which only needs the number of pending reads to be incremented.
+  uint64_t state = state_.load(std::memory_order_acquire);
+  while (!HasPendingWrite(state)) {
     // invariant: is_ready_to_read()
-    CHECK_GE(num_pending_reads_, 0);
+    CHECK_GE(NumPendingReads(state), 0);
     // STATE CHANGE
-    ++num_pending_reads_;
-    // decrease wait counter
-    opr_block->decr_wait();
-  } else {
-    auto&& new_var_block = VersionedVarBlock::New();
+    if (state_.compare_exchange_weak(state, state + 1,
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      // decrease wait counter
+      opr_block->decr_wait();
+      return;
+    }
+  }
+  auto&& new_var_block = VersionedVarBlock::New();
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    // The pending write bit is only cleared with the lock held,
+    // so check again whether the write completed in the meantime.
+    state = state_.load(std::memory_order_acquire);
+    while (!HasPendingWrite(state)) {
+      CHECK_GE(NumPendingReads(state), 0);
+      if (state_.compare_exchange_weak(state, state + 1,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        opr_block->decr_wait();
+        VersionedVarBlock::Delete(new_var_block);
+        return;
+      }
+    }
     assert(head_->next == nullptr);
     assert(head_->trigger == nullptr);
     assert(head_->write == false);
@@ -82,17 +103,30 @@ inline void ThreadedVar::AppendWriteDependency(OprBlock* opr_block) {
   head_->write = true;
 
   // check if it is ready to write
-  if (pending_write_ == nullptr) {
+  uint64_t state = state_.load(std::memory_order_acquire);
+  if (!HasPendingWrite(state)) {
     // invariant: is_ready_to_read()
+    // pending_write_ needs to be visible before the bit is set,
+    // the last completing read uses it to trigger the write.
     pending_write_ = head_;
-    CHECK_GE(num_pending_reads_, 0);
-    if (num_pending_reads_ == 0) {
-      // STATE CHANGE
-      opr_block->decr_wait();
-      num_pending_reads_ = kWriteTriggered;
+    // reads may still be granted or completed concurrently
+    while (true) {
+      const int num_pending_reads = NumPendingReads(state);
+      CHECK_GE(num_pending_reads, 0);
+      const uint64_t new_state = MakeState(true, num_pending_reads == 0 ?
+                                                 kWriteTriggered : num_pending_reads);
+      if (state_.compare_exchange_weak(state, new_state,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        if (num_pending_reads == 0) {
+          // STATE CHANGE
+          opr_block->decr_wait();
+        }
+        break;
+      }
     }
   } else {
-    CHECK_NE(num_pending_reads_, 0);
+    CHECK_NE(NumPendingReads(state), 0);
   }
   head_ = new_var_block;
 }
@@ -100,17 +134,21 @@ inline void ThreadedVar::AppendWriteDependency(OprBlock* opr_block) {
 template <typename Dispatcher>
 inline void ThreadedVar::CompleteReadDependency(Dispatcher dispatcher) {
   OprBlock *trigger = nullptr;
-  {
-    // this is lock scope
-    std::lock_guard<std::mutex> lock{mutex_};
-    CHECK_GT(num_pending_reads_, 0);
-
-    if (--num_pending_reads_ == 0) {
-      if (pending_write_ != nullptr) {
+  uint64_t state = state_.load(std::memory_order_acquire);
+  while (true) {
+    const int num_pending_reads = NumPendingReads(state);
+    CHECK_GT(num_pending_reads, 0);
+    const bool trigger_write = HasPendingWrite(state) && num_pending_reads == 1;
+    const uint64_t new_state = trigger_write ? MakeState(true, kWriteTriggered) : state - 1;
+    if (state_.compare_exchange_weak(state, new_state,
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      if (trigger_write) {
         // STATE CHANGE
+        // pending_write_ cannot change until the write we trigger completes
         trigger = pending_write_->trigger;
-        num_pending_reads_ = kWriteTriggered;
       }
+      break;
     }
   }
   if (trigger != nullptr && trigger->decr_wait() == 0) {
@@ -128,7 +166,9 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
     // invariants
     assert(head_->next == nullptr);
     assert(pending_write_ != nullptr);
-    CHECK_EQ(num_pending_reads_, kWriteTriggered);
+    // While the write is triggered no read is running and new reads
+    // are queued with the lock held, so the state cannot change here.
+    CHECK_EQ(NumPendingReads(state_.load(std::memory_order_acquire)), kWriteTriggered);
 
     // increment version number
     ++version_;
@@ -146,27 +186,29 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
     // search for chains to trigger
     end_of_read_chain = old_pending_write->next;
     // reset to 0 pending reads
-    num_pending_reads_ = 0;
+    int num_pending_reads = 0;
     while (end_of_read_chain != head_ &&
            end_of_read_chain->write == false) {
-      ++num_pending_reads_;
+      ++num_pending_reads;
       end_of_read_chain = end_of_read_chain->next;
     }
     if (end_of_read_chain == head_) {
       pending_write_ = nullptr;
+      state_.store(MakeState(false, num_pending_reads), std::memory_order_release);
     } else {
       // check if there is pending reads, if not trigger write
       assert(end_of_read_chain->write == true);
       pending_write_ = end_of_read_chain;
-      if (num_pending_reads_ == 0) {
+      if (num_pending_reads == 0) {
         // mark write as already activated in this var
-        num_pending_reads_ = kWriteTriggered;
+        num_pending_reads = kWriteTriggered;
         trigger_write = end_of_read_chain->trigger;
       }
+      state_.store(MakeState(true, num_pending_reads), std::memory_order_release);
     }
   }
   // This is outside of lock scope
-  // Be very carful, pending_write_ and num_pending_reads_
+  // Be very carful, pending_write_ and state_
   // can change now, do not rely on these two variables.
   // The linked list \in [old_pending_write, end_of_read_chain)
   // is already detached from this Var.
@@ -195,7 +237,6 @@ inline void ThreadedVar::SetToDelete() {
 }
 
 inline bool ThreadedVar::ready_to_read() {
-  std::lock_guard<std::mutex> lock{mutex_};
   return this->is_ready_to_read();
 }
 
@@ -287,7 +328,11 @@ void ThreadedEngine::DeleteOperator(OprHandle op) {
 
 void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool profiling) {
   BulkFlush();
-  ThreadedOpr* threaded_opr = ThreadedOpr::CastFromBase(op);
+  PushOperator(ThreadedOpr::CastFromBase(op), exec_ctx, priority, profiling);
+}
+
+void ThreadedEngine::PushOperator(ThreadedOpr* threaded_opr, Context exec_ctx,
+                                  int priority, bool profiling) {
   if (profiling) {
     threaded_opr->opr_name =
         profiler::CustomOpProfiler::Get()->GenerateDisplayName(threaded_opr->opr_name.c_str());
@@ -322,6 +367,15 @@ void ThreadedEngine::PushAsync(AsyncFn fn, Context exec_ctx,
                                int priority,
                                const char* opr_name,
                                bool wait) {
+  CheckDevice(exec_ctx);
+  const bool profiling = profiler_->IsProfiling(profiler::Profiler::kImperative);
+  ThreadedOpr *opr = NewOperator(std::move(fn), const_vars, mutable_vars,
+                                 prop, opr_name, wait);
+  opr->temporary = true;
+  Push(opr, exec_ctx, priority, profiling);
+}
+
+void ThreadedEngine::CheckDevice(Context exec_ctx) {
 #if MXNET_USE_CUDA
   if (exec_ctx.dev_mask() == gpu::kDevMask) {
     if (device_count_ < 0) {
@@ -336,11 +390,6 @@ void ThreadedEngine::PushAsync(AsyncFn fn, Context exec_ctx,
         << device_count_;
   }
 #endif
-  const bool profiling = profiler_->IsProfiling(profiler::Profiler::kImperative);
-  ThreadedOpr *opr = NewOperator(std::move(fn), const_vars, mutable_vars,
-                                 prop, opr_name, wait);
-  opr->temporary = true;
-  Push(opr, exec_ctx, priority, profiling);
 }
 
 void ThreadedEngine::PushSync(SyncFn exec_fn, Context exec_ctx,
@@ -349,7 +398,9 @@ void ThreadedEngine::PushSync(SyncFn exec_fn, Context exec_ctx,
                               FnProperty prop,
                               int priority,
                               const char* opr_name) {
-  if (!bulk_size() || prop != FnProperty::kNormal || priority) {
+  const int explicit_bulk_size = bulk_size();
+  const bool automatic = !explicit_bulk_size && AutoBulk(exec_ctx);
+  if ((!explicit_bulk_size && !automatic) || prop != FnProperty::kNormal || priority) {
     this->PushAsync([exec_fn](RunContext ctx, CallbackOnComplete on_complete) {
         exec_fn(ctx);
         on_complete();
@@ -357,15 +408,42 @@ void ThreadedEngine::PushSync(SyncFn exec_fn, Context exec_ctx,
     return;
   }
 
-  const BulkStatus& bulk_status = *BulkStatusStore::Get();
-  if (bulk_status.count && exec_ctx != bulk_status.ctx) BulkFlush();
-  BulkAppend(exec_fn, exec_ctx, const_vars, mutable_vars);
+  if (automatic) RegisterAutoBulk();
+  BulkStatus& bulk_status = ThreadBulkStatus();
+  bool opened;
+  {
+    std::lock_guard<std::mutex> lock(bulk_status.mutex);
+    if (bulk_status.count && exec_ctx != bulk_status.ctx) BulkFlush(&bulk_status);
+    // an automatic bulk only grows with the operators depending on it,
+    // independent operators start a new bulk to keep them parallel
+    if (automatic && bulk_status.count &&
+        (!ChainedToBulk(bulk_status, const_vars, mutable_vars) ||
+         dmlc::GetTime() - bulk_status.start_time > auto_bulk_time_)) {
+      BulkFlush(&bulk_status);
+    }
+    opened = BulkAppend(&bulk_status, exec_fn, exec_ctx, const_vars, mutable_vars,
+                        automatic ? auto_bulk_size_ : explicit_bulk_size, automatic);
+  }
+  if (opened) NotifyAutoBulkFlusher();
 }
 
 void ThreadedEngine::DeleteVariable(SyncFn delete_fn,
                                     Context exec_ctx,
                                     VarHandle var) {
   ThreadedVar* threaded_var = ThreadedVar::CastFromBase(var);
+  {
+    BulkStatus& bulk_status = ThreadBulkStatus();
+    std::lock_guard<std::mutex> lock(bulk_status.mutex);
+    if (bulk_status.count && bulk_status.automatic && exec_ctx == bulk_status.ctx) {
+      // delete the temporaries of an imperative loop in the automatic bulk,
+      // instead of flushing it for every deleted array
+      BulkAppend(&bulk_status, [delete_fn, threaded_var](RunContext ctx) {
+          threaded_var->SetToDelete();
+          delete_fn(ctx);
+        }, exec_ctx, {}, {var}, auto_bulk_size_, true);
+      return;
+    }
+  }
   this->PushAsync([delete_fn, threaded_var](RunContext ctx, CallbackOnComplete on_complete) {
       // Mark variable as orphan,
       // so during `ThreadedEngine::OnComplete` it could be recycled.
@@ -378,6 +456,7 @@ void ThreadedEngine::DeleteVariable(SyncFn delete_fn,
 
 void ThreadedEngine::WaitForVar(VarHandle var) {
   BulkFlush();
+  FlushAutoBulks();
   ThreadedVar* threaded_var = ThreadedVar::CastFromBase(var);
   if (threaded_var->ready_to_read()) {
     ThrowException(threaded_var);
@@ -415,6 +494,7 @@ void ThreadedEngine::WaitForVar(VarHandle var) {
 
 void ThreadedEngine::WaitForAll() {
   BulkFlush();
+  FlushAutoBulks();
   std::unique_lock<std::mutex> lock{finished_m_};
   finished_cv_.wait(lock, [this]() {
       return pending_.load() == 0 || kill_.load();
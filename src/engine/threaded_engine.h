@@ -30,11 +30,17 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <dmlc/omp.h>
+#include <dmlc/timer.h>
 #include <mxnet/storage.h>
+#include <algorithm>
 #include <vector>
 #include <functional>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <utility>
 #include <mutex>
 #include <string>
@@ -116,6 +122,12 @@ struct VersionedVarBlock
 /*!
  * \brief Variable implementation.
  *  Each ThreadedVar is a linked list(queue) of operations to be performed.
+ *
+ *  The scheduling state (number of running reads and whether a write is
+ *  pending) is kept in a single atomic word. While no write is pending,
+ *  reads are granted and completed with a CAS on that word only, without
+ *  taking the mutex. The mutex only protects the queue of waiting
+ *  operations, which is needed once a write is pending.
  */
 class ThreadedVar final
     : public Var, public common::ObjectPoolAllocatable<ThreadedVar> {
@@ -191,13 +203,17 @@ class ThreadedVar final
  private:
   // TODO(hotpxl) change this to spinlock for faster runtime
   // TODO(hotpxl) consider rename head
-  /*! \brief internal mutex of the ThreadedVar */
+  /*! \brief internal mutex of the ThreadedVar, protects the queue */
   std::mutex mutex_;
   /*!
-   * \brief number of pending reads operation in the variable.
+   * \brief scheduling state of the variable.
+   *  Lower 32 bits: number of pending reads operation in the variable,
    *  will be marked as -1 when there is a already triggered pending write.
+   *  Bit kPendingWriteBit: set when pending_write_ != nullptr.
+   *  While the bit is set, the state is only modified with mutex_ held,
+   *  except for the completion of the reads running before the pending write.
    */
-  int num_pending_reads_{0};
+  std::atomic<uint64_t> state_{0};
   /*!
    * \brief Points to the last VersionedVarBlock in the queue.
    *  head_ always points to a empty VersionedVarBlock.
@@ -217,14 +233,29 @@ class ThreadedVar final
    * \brief If true, delete after operation completes.
    */
   bool to_delete_{false};
-  /*! \brief special const on num_pending_reads_ to mark write being triggered */
+  /*! \brief special const on number of pending reads to mark write being triggered */
   static constexpr int kWriteTriggered = -1;
+  /*! \brief bit of state_ marking a pending write */
+  static constexpr uint64_t kPendingWriteBit = 1ULL << 32;
+  /*! \return number of pending reads stored in the state */
+  static inline int NumPendingReads(uint64_t state) {
+    return static_cast<int32_t>(static_cast<uint32_t>(state));
+  }
+  /*! \return whether the state has a pending write */
+  static inline bool HasPendingWrite(uint64_t state) {
+    return (state & kPendingWriteBit) != 0;
+  }
+  /*! \return state with the given number of pending reads and pending write bit */
+  static inline uint64_t MakeState(bool pending_write, int num_pending_reads) {
+    return (pending_write ? kPendingWriteBit : 0) |
+           static_cast<uint32_t>(num_pending_reads);
+  }
   /*!
    * \brief derived invariant of ready to ready, without lock.
    * \return whether the current variable is ready to read.
    */
   inline bool is_ready_to_read() const {
-    return pending_write_ == nullptr;
+    return !HasPendingWrite(state_.load(std::memory_order_acquire));
   }
 };  // struct ThreadedVar
 
@@ -314,6 +345,8 @@ class ThreadedEngine : public Engine {
 
   ThreadedEngine() {
     engine_info_ = dmlc::GetEnv("MXNET_ENGINE_INFO", false);
+    auto_bulk_size_ = dmlc::GetEnv("MXNET_ENGINE_AUTO_BULK_SIZE", 0);
+    auto_bulk_time_ = dmlc::GetEnv("MXNET_ENGINE_AUTO_BULK_TIME_US", 200) * 1e-6;
 
     objpool_opr_ref_    = common::ObjectPool<ThreadedOpr>::_GetSharedRef();
     objpool_blk_ref_    = common::ObjectPool<OprBlock>::_GetSharedRef();
@@ -413,13 +446,16 @@ class ThreadedEngine : public Engine {
 
   int bulk_size() const override {
     const profiler::Profiler *prof = profiler::Profiler::Get();
-    return (prof && prof->AggregateRunning()) ? 0 :  BulkStatusStore::Get()->bulk_size;
+    return (prof && prof->AggregateRunning()) ? 0 :  ThreadBulkStatus().bulk_size;
   }
 
   int set_bulk_size(int bulk_size) override {
-    BulkStatus& bulk_status = *BulkStatusStore::Get();
+    BulkStatus& bulk_status = ThreadBulkStatus();
+    std::lock_guard<std::mutex> lock(bulk_status.mutex);
     std::swap(bulk_status.bulk_size, bulk_size);
-    if (bulk_status.count >= bulk_status.bulk_size) BulkFlush();
+    if (bulk_status.count >= bulk_status.bulk_size || bulk_status.automatic) {
+      BulkFlush(&bulk_status);
+    }
     if (!bulk_status.functions) {
       bulk_status.functions.reset(new std::vector<SyncFn>());
     }
@@ -434,6 +470,10 @@ class ThreadedEngine : public Engine {
     int bulk_size = 0;
     /*! \brief current number of ops in bulk */
     int count = 0;
+    /*! \brief whether the current bulk was started by automatic bulking */
+    bool automatic = false;
+    /*! \brief time the current bulk was started, in seconds */
+    double start_time = 0;
     /*! \brief context of current ops */
     Context ctx;
     /*! \brief current op functions */
@@ -442,9 +482,27 @@ class ThreadedEngine : public Engine {
     std::vector<VarHandle> const_vars;
     /*! \brief mutable variables */
     std::vector<VarHandle> mutable_vars;
+    /*!
+     * \brief protects the bulk, since an automatic bulk is also flushed
+     *  by the waits of the other threads and by the automatic bulk flusher
+     */
+    std::mutex mutex;
+  };
+  /*!
+   * \brief bulk of a thread, shared with the registry of the automatic bulks,
+   *  so that an automatic bulk left open by an exited thread is still flushed
+   */
+  struct BulkStatusRef {
+    std::shared_ptr<BulkStatus> status{std::make_shared<BulkStatus>()};
+    /*! \brief id of the engine, whose registry of the automatic bulks has the status */
+    uint64_t registered_with = 0;
   };
   /*! thread local store for bulk */
-  typedef dmlc::ThreadLocalStore<BulkStatus> BulkStatusStore;
+  typedef dmlc::ThreadLocalStore<BulkStatusRef> BulkStatusStore;
+  /*! \brief bulk of the calling thread */
+  static BulkStatus& ThreadBulkStatus() {
+    return *BulkStatusStore::Get()->status;
+  }
 
   /*!
    * \brief check if thee is duplication in const_vars and mutable_vars.
@@ -491,6 +549,10 @@ class ThreadedEngine : public Engine {
 
   static void OnCompleteStatic(Engine *engine, void *threaded_opr,
                                const dmlc::Error* error);
+  /*! \brief check the device of the context, before an operator is pushed to it */
+  void CheckDevice(Context exec_ctx);
+  /*! \brief push the operator, without flushing the bulk of the calling thread */
+  void PushOperator(ThreadedOpr* threaded_opr, Context exec_ctx, int priority, bool profiling);
   /*!
    * \brief find exception in global_exception_refs and add it if missing
    * \param opr_exception the exception to be added to global_exception_refs
@@ -503,35 +565,76 @@ class ThreadedEngine : public Engine {
     }
     return;
   }
-  /*! \brief append an operator to bulk */
-  inline void BulkAppend(SyncFn exec_fn, Context exec_ctx,
+  /*!
+   * \brief whether operators pushed to exec_ctx without an explicit bulk size
+   *  are bulked automatically
+   */
+  inline bool AutoBulk(Context exec_ctx) const {
+    if (auto_bulk_size_ <= 1 || exec_ctx.dev_type != Context::kCPU) return false;
+    // keep the operators apart for the profiler
+    const profiler::Profiler *prof = profiler::Profiler::Get();
+    return !(prof && (prof->AggregateRunning() ||
+                      prof->IsProfiling(profiler::Profiler::kImperative)));
+  }
+  /*!
+   * \brief whether an operator reads or writes a variable written by the bulk,
+   *  or writes a variable read by the bulk
+   */
+  inline bool ChainedToBulk(const BulkStatus& bulk_status,
+                            std::vector<VarHandle> const& const_vars,
+                            std::vector<VarHandle> const& mutable_vars) const {
+    auto contains = [](std::vector<VarHandle> const& vars, VarHandle var) {
+      return std::find(vars.begin(), vars.end(), var) != vars.end();
+    };
+    for (auto var : const_vars) {
+      if (contains(bulk_status.mutable_vars, var)) return true;
+    }
+    for (auto var : mutable_vars) {
+      if (contains(bulk_status.mutable_vars, var) ||
+          contains(bulk_status.const_vars, var)) return true;
+    }
+    return false;
+  }
+  /*!
+   * \brief append an operator to the bulk, the caller holds the mutex of the bulk
+   * \return whether the operator opened an automatic bulk
+   */
+  inline bool BulkAppend(BulkStatus* bulk_status, SyncFn exec_fn, Context exec_ctx,
                          std::vector<VarHandle> const& const_vars,
-                         std::vector<VarHandle> const& mutable_vars) {
-    BulkStatus& bulk_status = *BulkStatusStore::Get();
-    if (!bulk_status.functions) {
-      bulk_status.functions.reset(new std::vector<SyncFn>());
+                         std::vector<VarHandle> const& mutable_vars,
+                         int bulk_size, bool automatic = false) {
+    if (!bulk_status->functions) {
+      bulk_status->functions.reset(new std::vector<SyncFn>());
     }
-    bulk_status.functions->push_back(exec_fn);
-    if (!bulk_status.count) {
-      bulk_status.ctx = exec_ctx;
+    bulk_status->functions->push_back(exec_fn);
+    const bool opened = !bulk_status->count && automatic;
+    if (!bulk_status->count) {
+      bulk_status->ctx = exec_ctx;
+      bulk_status->automatic = automatic;
+      if (automatic) {
+        bulk_status->start_time = dmlc::GetTime();
+        ++open_auto_bulks_;
+      }
     }
 
-    ++bulk_status.count;
-    bulk_status.const_vars.insert(
-        bulk_status.const_vars.end(), const_vars.begin(), const_vars.end());
-    bulk_status.mutable_vars.insert(
-        bulk_status.mutable_vars.end(), mutable_vars.begin(), mutable_vars.end());
+    ++bulk_status->count;
+    bulk_status->const_vars.insert(
+        bulk_status->const_vars.end(), const_vars.begin(), const_vars.end());
+    bulk_status->mutable_vars.insert(
+        bulk_status->mutable_vars.end(), mutable_vars.begin(), mutable_vars.end());
 
-    if (bulk_status.count >= bulk_status.bulk_size) BulkFlush();
+    if (bulk_status->count >= bulk_size) BulkFlush(bulk_status);
+    return opened;
   }
-  /*! \brief flush current bulk to execution */
-  inline void BulkFlush() {
-    BulkStatus& bulk_status = *BulkStatusStore::Get();
-    if (!bulk_status.count) return;
-    bulk_status.count = 0;
-    DeduplicateVarHandle(&bulk_status.const_vars, &bulk_status.mutable_vars);
-    auto functions = bulk_status.functions;
-    this->PushAsync([functions](RunContext ctx, CallbackOnComplete on_complete) {
+  /*! \brief flush the bulk to execution, the caller holds the mutex of the bulk */
+  inline void BulkFlush(BulkStatus* bulk_status) {
+    if (!bulk_status->count) return;
+    bulk_status->count = 0;
+    if (bulk_status->automatic) --open_auto_bulks_;
+    DeduplicateVarHandle(&bulk_status->const_vars, &bulk_status->mutable_vars);
+    auto functions = bulk_status->functions;
+    CheckDevice(bulk_status->ctx);
+    ThreadedOpr* opr = NewOperator([functions](RunContext ctx, CallbackOnComplete on_complete) {
         ctx.is_bulk = true;
         for (auto& fn : *functions) {
           fn(ctx);
@@ -542,14 +645,117 @@ class ThreadedEngine : public Engine {
           ctx.get_stream<gpu>()->Wait();
         }
         on_complete();
-      }, bulk_status.ctx, bulk_status.const_vars, bulk_status.mutable_vars,
-      FnProperty::kNormal, 0, "ImperativeBulk");
+      }, bulk_status->const_vars, bulk_status->mutable_vars,
+      FnProperty::kNormal, "ImperativeBulk");
+    opr->temporary = true;
+    // the bulk of another thread may be flushed here, so the bulk of the
+    // calling thread is left alone
+    PushOperator(opr, bulk_status->ctx, 0,
+                 profiler_->IsProfiling(profiler::Profiler::kImperative));
+
+    bulk_status->functions.reset(new std::vector<SyncFn>());
+    bulk_status->functions->reserve(bulk_status->bulk_size);
+    bulk_status->const_vars.clear();
+    bulk_status->mutable_vars.clear();
+  }
+  /*! \brief flush the bulk of the calling thread to execution */
+  inline void BulkFlush() {
+    BulkStatus& bulk_status = ThreadBulkStatus();
+    std::lock_guard<std::mutex> lock(bulk_status.mutex);
+    BulkFlush(&bulk_status);
+  }
+  static uint64_t NewEngineId() {
+    static std::atomic<uint64_t> last_id{0};
+    return ++last_id;
+  }
+  /*!
+   * \brief put the bulk of the calling thread into the registry of the automatic bulks,
+   *  the caller does not hold the mutex of the bulk
+   */
+  inline void RegisterAutoBulk() {
+    BulkStatusRef* ref = BulkStatusStore::Get();
+    if (ref->registered_with == engine_id_) return;
+    std::lock_guard<std::mutex> lock(auto_bulk_mutex_);
+    auto_bulks_.push_back(ref->status);
+    ref->registered_with = engine_id_;
+  }
+  /*!
+   * \brief wake up the automatic bulk flusher for a newly opened automatic bulk,
+   *  the caller does not hold the mutex of the bulk
+   */
+  inline void NotifyAutoBulkFlusher() {
+    std::lock_guard<std::mutex> lock(auto_bulk_mutex_);
+    if (!auto_bulk_flusher_.joinable() && !auto_bulk_flusher_stop_) {
+      auto_bulk_flusher_ = std::thread([this]() { AutoBulkFlusher(); });
+    }
+    auto_bulk_cv_.notify_one();
+  }
+  /*!
+   * \brief flush the automatic bulks of all the threads, which were started before the time,
+   *  the caller holds auto_bulk_mutex_
+   */
+  inline void FlushAutoBulksLocked(double started_before) {
+    for (auto it = auto_bulks_.begin(); it != auto_bulks_.end();) {
+      BulkStatus* bulk_status = it->get();
+      std::unique_lock<std::mutex> lock(bulk_status->mutex);
+      if (bulk_status->count && bulk_status->automatic &&
+          bulk_status->start_time <= started_before) {
+        BulkFlush(bulk_status);
+      }
+      // the thread of the bulk exited and the bulk is flushed
+      if (it->use_count() == 1 && !bulk_status->count) {
+        lock.unlock();
+        it = auto_bulks_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  /*!
+   * \brief flush the automatic bulks of all the threads, so that a wait on one thread
+   *  does not miss the operators still bulked by another thread
+   */
+  inline void FlushAutoBulks() {
+    if (auto_bulk_size_ <= 1) return;
+    std::lock_guard<std::mutex> lock(auto_bulk_mutex_);
+    FlushAutoBulksLocked(std::numeric_limits<double>::infinity());
+  }
+  /*!
+   * \brief body of the thread flushing the automatic bulks, which are open for longer
+   *  than MXNET_ENGINE_AUTO_BULK_TIME_US, also when their thread does not push any more
+   */
+  void AutoBulkFlusher() {
+    std::unique_lock<std::mutex> lock(auto_bulk_mutex_);
+    while (!auto_bulk_flusher_stop_) {
+      if (!open_auto_bulks_.load()) {
+        auto_bulk_cv_.wait(lock);
+        continue;
+      }
+      auto_bulk_cv_.wait_for(lock, std::chrono::duration<double>(auto_bulk_time_));
+      if (auto_bulk_flusher_stop_) break;
+      FlushAutoBulksLocked(dmlc::GetTime() - auto_bulk_time_);
+    }
+  }
 
-    bulk_status.functions.reset(new std::vector<SyncFn>());
-    bulk_status.functions->reserve(bulk_status.bulk_size);
-    bulk_status.const_vars.clear();
-    bulk_status.mutable_vars.clear();
+ protected:
+  /*!
+   * \brief stop the automatic bulk flusher, before the workers are stopped,
+   *  it is started again by the next automatic bulk
+   */
+  void StopAutoBulkFlusher() {
+    std::thread flusher;
+    {
+      std::lock_guard<std::mutex> lock(auto_bulk_mutex_);
+      auto_bulk_flusher_stop_ = true;
+      auto_bulk_cv_.notify_all();
+      std::swap(flusher, auto_bulk_flusher_);
+    }
+    if (flusher.joinable()) flusher.join();
+    std::lock_guard<std::mutex> lock(auto_bulk_mutex_);
+    auto_bulk_flusher_stop_ = false;
   }
+
+ private:
   /*!
    * \brief Number of pending operations.
    */
@@ -560,6 +766,27 @@ class ThreadedEngine : public Engine {
   std::atomic<bool> shutdown_phase_{false};
   /*!\brief show more information from engine actions */
   bool engine_info_{false};
+  /*!
+   * \brief maximum number of chained CPU operators bulked automatically,
+   *  when no bulk size is set. 0 or 1 disables automatic bulking.
+   */
+  int auto_bulk_size_{0};
+  /*! \brief an automatic bulk is flushed after this time, in seconds */
+  double auto_bulk_time_{0};
+  /*! \brief unique id of the engine, the engines of the tests may reuse an address */
+  const uint64_t engine_id_ = NewEngineId();
+  /*! \brief number of the open automatic bulks of all the threads */
+  std::atomic<int> open_auto_bulks_{0};
+  /*!
+   * \brief bulks of the threads, which used automatic bulking. The mutex is taken
+   *  before the mutex of any bulk, never while the mutex of a bulk is held.
+   */
+  std::vector<std::shared_ptr<BulkStatus>> auto_bulks_;
+  std::mutex auto_bulk_mutex_;
+  std::condition_variable auto_bulk_cv_;
+  /*! \brief thread flushing the automatic bulks after MXNET_ENGINE_AUTO_BULK_TIME_US */
+  std::thread auto_bulk_flusher_;
+  bool auto_bulk_flusher_stop_{false};
   /*! \brief debug information about wait for var. */
   std::atomic<ThreadedVar*> debug_wait_var_{nullptr};
   /*! \brief debug information about wait for var. */
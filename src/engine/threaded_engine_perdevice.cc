@@ -33,6 +33,7 @@
 #include "../initialize.h"
 #include "./threaded_engine.h"
 #include "./thread_pool.h"
+#include "./work_stealing_queue.h"
 #include "../common/lazy_alloc_array.h"
 #include "../common/utils.h"
 
@@ -45,6 +46,7 @@ namespace engine {
  *  - Use fixed amount of threads for each device.
  *  - Use special threads for copy operations.
  *  - Each stream is allocated and bound to each of the thread.
+ *  - Optionally, CPU workers of a device use per-thread queues with work stealing.
  */
 class ThreadedEnginePerDevice : public ThreadedEngine {
  public:
@@ -54,7 +56,8 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   static auto constexpr kPriorityQueue = kPriority;
   static auto constexpr kWorkerQueue = kFIFO;
 
-  ThreadedEnginePerDevice() noexcept(false) {
+  explicit ThreadedEnginePerDevice(bool cpu_work_stealing = false) noexcept(false)
+      : cpu_work_stealing_(cpu_work_stealing) {
     this->Start();
   }
   ~ThreadedEnginePerDevice() noexcept(false) override {
@@ -62,11 +65,13 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   }
 
   void StopNoWait() {
+    StopAutoBulkFlusher();
     SignalQueuesForKill();
     gpu_normal_workers_.Clear();
     gpu_priority_workers_.Clear();
     gpu_copy_workers_.Clear();
     cpu_normal_workers_.Clear();
+    cpu_stealing_workers_.Clear();
     cpu_priority_worker_.reset(nullptr);
   }
 
@@ -109,6 +114,22 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
         // CPU execution.
         if (opr_block->opr->prop == FnProperty::kCPUPrioritized) {
           cpu_priority_worker_->task_queue.Push(opr_block, opr_block->priority);
+        } else if (cpu_work_stealing_) {
+          int dev_id = ctx.dev_id;
+          int nthread = cpu_worker_nthreads_;
+          auto ptr =
+          cpu_stealing_workers_.Get(dev_id, [this, ctx, nthread]() {
+              auto blk = new WorkStealingWorkerBlock(nthread);
+              blk->pool = std::make_unique<ThreadPool>(nthread,
+                  [this, ctx, blk](std::shared_ptr<dmlc::ManualEvent> ready_event) {
+                    this->CPUWorker(ctx, blk, ready_event);
+                  }, true);
+            return blk;
+          });
+          if (ptr) {
+            ptr->task_queue.Push(opr_block,
+                                 opr_block->opr->prop == FnProperty::kDeleteVar);
+          }
         } else {
           int dev_id = ctx.dev_id;
           int nthread = cpu_worker_nthreads_;
@@ -215,9 +236,22 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     // destructor
     ~ThreadWorkerBlock() = default;
   };
+  // working unit for CPU workers sharing work through work stealing
+  struct WorkStealingWorkerBlock {
+    // task queue with one deque per worker
+    WorkStealingQueue<OprBlock*> task_queue;
+    // thread pool that works on this task
+    std::unique_ptr<ThreadPool> pool;
+    // constructor
+    explicit WorkStealingWorkerBlock(size_t nthread) : task_queue(nthread) {}
+    // destructor
+    ~WorkStealingWorkerBlock() = default;
+  };
 
   /*! \brief whether this is a worker thread. */
   static MX_THREAD_LOCAL bool is_worker_;
+  /*! \brief whether CPU workers use work stealing queues */
+  const bool cpu_work_stealing_;
   /*! \brief number of concurrent thread cpu worker uses */
   size_t cpu_worker_nthreads_;
   /*! \brief number of concurrent thread each gpu worker uses */
@@ -226,6 +260,8 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   size_t gpu_copy_nthreads_;
   // cpu worker
   common::LazyAllocArray<ThreadWorkerBlock<kWorkerQueue> > cpu_normal_workers_;
+  // cpu workers with work stealing
+  common::LazyAllocArray<WorkStealingWorkerBlock> cpu_stealing_workers_;
   // cpu priority worker
   std::unique_ptr<ThreadWorkerBlock<kPriorityQueue> > cpu_priority_worker_;
   // workers doing normal works on GPU
@@ -300,6 +336,29 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
       this->ExecuteOprBlock(run_ctx, opr_block);
     }
   }
+  /*!
+   * \brief CPU worker that takes its tasks from a work stealing queue.
+   * \param block The task block of the worker.
+   */
+  inline void CPUWorker(Context ctx,
+                        WorkStealingWorkerBlock *block,
+                        const std::shared_ptr<dmlc::ManualEvent>& ready_event) {
+    this->is_worker_ = true;
+    auto* task_queue = &(block->task_queue);
+    task_queue->RegisterWorker();
+    RunContext run_ctx{ctx, nullptr, nullptr, false};
+
+    // execute task
+    OprBlock* opr_block;
+    ready_event->signal();
+
+    // Set default number of threads for OMP parallel regions initiated by this thread
+    OpenMP::Get()->on_start_worker_thread(true);
+
+    while (task_queue->Pop(&opr_block)) {
+      this->ExecuteOprBlock(run_ctx, opr_block);
+    }
+  }
 
   /*!
    * \brief Get number of cores this engine should reserve for its own use
@@ -336,6 +395,7 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     SignalQueueForKill(&gpu_normal_workers_);
     SignalQueueForKill(&gpu_copy_workers_);
     SignalQueueForKill(&cpu_normal_workers_);
+    SignalQueueForKill(&cpu_stealing_workers_);
     if (cpu_priority_worker_) {
       cpu_priority_worker_->task_queue.SignalForKill();
     }
@@ -346,6 +406,10 @@ Engine *CreateThreadedEnginePerDevice() {
   return new ThreadedEnginePerDevice();
 }
 
+Engine *CreateThreadedEngineWorkStealing() {
+  return new ThreadedEnginePerDevice(true);
+}
+
 MX_THREAD_LOCAL bool ThreadedEnginePerDevice::is_worker_ = false;
 
 }  // namespace engine
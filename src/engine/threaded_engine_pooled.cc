@@ -56,6 +56,7 @@ class ThreadedEnginePooled : public ThreadedEngine {
   }
 
   void StopNoWait() {
+    StopAutoBulkFlusher();
     streams_->Finalize();
     task_queue_->SignalForKill();
     io_task_queue_->SignalForKill();
@@ -0,0 +1,205 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file work_stealing_queue.h
+ * \brief Task queue with one deque per worker thread and work stealing.
+ */
+#ifndef MXNET_ENGINE_WORK_STEALING_QUEUE_H_
+#define MXNET_ENGINE_WORK_STEALING_QUEUE_H_
+
+#include <dmlc/base.h>
+#include <dmlc/logging.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "mxnet/base.h"
+
+namespace mxnet {
+namespace engine {
+
+/*!
+ * \brief Blocking task queue for a fixed set of worker threads.
+ *
+ * Every worker owns a deque guarded by its own lock. A worker pushing a task
+ * (e.g. an operation that became ready when the worker completed its
+ * dependency) puts it at the back of its own deque and pops from the back
+ * again (LIFO), so dependency chains stay on one thread with warm caches.
+ * Tasks pushed from other threads are distributed round-robin and put at
+ * the front, so the owner runs them in FIFO order. A worker with an empty
+ * deque steals from the front of the other workers' deques, the end opposite
+ * to the one their owners pop from, before going to sleep. This replaces the single queue lock that all the
+ * workers contend on with mostly uncontended per-worker locks.
+ *
+ * \tparam T type of the task.
+ */
+template<typename T>
+class WorkStealingQueue {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param num_workers number of worker threads that will pop from this queue.
+   */
+  explicit WorkStealingQueue(size_t num_workers) {
+    CHECK_GT(num_workers, 0);
+    deques_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+      deques_.emplace_back(new WorkerDeque());
+    }
+  }
+  /*!
+   * \brief Register the calling thread as one of the workers.
+   *  Needs to be called by every worker thread before the first Pop.
+   * \return id of the worker.
+   */
+  size_t RegisterWorker() {
+    const size_t id = num_registered_.fetch_add(1);
+    CHECK_LT(id, deques_.size()) << "Too many workers registered to the queue";
+    owner_ = this;
+    worker_id_ = id;
+    return id;
+  }
+  /*!
+   * \brief Push a task to the queue.
+   * \param item the task.
+   * \param front whether the task should be executed before the other
+   *        tasks of the worker it is assigned to.
+   */
+  void Push(T item, bool front = false) {
+    const bool local = owner_ == this;
+    const size_t id = local ? worker_id_ : next_worker_.fetch_add(1) % deques_.size();
+    WorkerDeque* deque = deques_[id].get();
+    {
+      std::lock_guard<std::mutex> lock(deque->mutex);
+      // Counted before the task is visible, so that a pop of the task, which
+      // decrements the counter, cannot make it wrap around.
+      pending_.fetch_add(1);
+      // The owner pops from the back, thieves steal from the front. Tasks from
+      // other threads go to the front, so that the owner runs them in FIFO order.
+      if (local || front) {
+        deque->items.push_back(item);
+      } else {
+        deque->items.push_front(item);
+      }
+    }
+    if (num_sleeping_.load() > 0) {
+      { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+      sleep_cv_.notify_one();
+    }
+  }
+  /*!
+   * \brief Pop a task, blocking until one is available.
+   *  Must be called from a registered worker thread.
+   * \param item pointer to store the task.
+   * \return false if the queue was signaled for kill.
+   */
+  bool Pop(T* item) {
+    CHECK(owner_ == this) << "Pop called from a thread that is not a registered worker";
+    const size_t num_workers = deques_.size();
+    while (true) {
+      if (exit_now_.load()) return false;
+      // Local LIFO pop
+      if (PopBack(deques_[worker_id_].get(), item)) return true;
+      // FIFO steal from the other workers
+      for (size_t i = 1; i < num_workers; ++i) {
+        if (PopFront(deques_[(worker_id_ + i) % num_workers].get(), item)) return true;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      num_sleeping_.fetch_add(1);
+      sleep_cv_.wait(lock, [this] {
+        return pending_.load() > 0 || exit_now_.load();
+      });
+      num_sleeping_.fetch_sub(1);
+    }
+  }
+  /*!
+   * \brief Wake up all the workers and make Pop return false.
+   */
+  void SignalForKill() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      exit_now_.store(true);
+    }
+    sleep_cv_.notify_all();
+  }
+  /*!
+   * \return number of tasks in the queue.
+   */
+  size_t Size() const {
+    return pending_.load();
+  }
+
+ private:
+  /*! \brief per-worker deque, padded to avoid false sharing of the locks */
+  struct alignas(64) WorkerDeque {
+    std::mutex mutex;
+    std::deque<T> items;
+  };
+
+  bool PopBack(WorkerDeque* deque, T* item) {
+    std::lock_guard<std::mutex> lock(deque->mutex);
+    if (deque->items.empty()) return false;
+    *item = deque->items.back();
+    deque->items.pop_back();
+    pending_.fetch_sub(1);
+    return true;
+  }
+
+  bool PopFront(WorkerDeque* deque, T* item) {
+    std::lock_guard<std::mutex> lock(deque->mutex);
+    if (deque->items.empty()) return false;
+    *item = deque->items.front();
+    deque->items.pop_front();
+    pending_.fetch_sub(1);
+    return true;
+  }
+
+  /*! \brief deques of the workers */
+  std::vector<std::unique_ptr<WorkerDeque>> deques_;
+  /*! \brief number of workers that called RegisterWorker */
+  std::atomic<size_t> num_registered_{0};
+  /*! \brief round-robin counter for tasks pushed by non-worker threads */
+  std::atomic<size_t> next_worker_{0};
+  /*! \brief number of tasks in all the deques */
+  std::atomic<size_t> pending_{0};
+  /*! \brief number of workers waiting for tasks */
+  std::atomic<int> num_sleeping_{0};
+  /*! \brief whether the queue was signaled for kill */
+  std::atomic<bool> exit_now_{false};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  /*! \brief queue the calling thread works for, if any */
+  static thread_local WorkStealingQueue* owner_;
+  /*! \brief id of the calling thread in owner_ */
+  static thread_local size_t worker_id_;
+};
+
+template<typename T>
+thread_local WorkStealingQueue<T>* WorkStealingQueue<T>::owner_ = nullptr;
+template<typename T>
+thread_local size_t WorkStealingQueue<T>::worker_id_ = 0;
+
+}  // namespace engine
+}  // namespace mxnet
+#endif  // MXNET_ENGINE_WORK_STEALING_QUEUE_H_
@@ -21,6 +21,7 @@
 #include <iostream>
 #include "./imperative_utils.h"
 #include "./cached_op.h"
+#include "./cached_op_cache.h"
 #include "./exec_pass.h"
 #include "../profiler/profiler.h"
 #include "../operator/operator_common.h"
@@ -146,6 +147,12 @@ bool CachedOp::CheckDynamicShapeExists(const Context& default_ctx,
   auto state_ptr = GetCachedOpState(default_ctx);
   auto& state = state_ptr.get_state<CachedOpState>();
 
+  // Graphs in the compile cache have no dynamic shape
+  uint64_t key;
+  if (LoadCompiledForwardGraph(default_ctx, &state.info, inputs, &key)) {
+    return false;
+  }
+
   nnvm::Graph& g = state.info.fwd_graph;
   ShapeVector shape_inputs(inputs.size());
   for (size_t i = 0; i < inputs.size(); ++i) {
@@ -165,6 +172,40 @@ bool CachedOp::CheckDynamicShapeExists(const Context& default_ctx,
   return contain_dynamic_shape;
 }
 
+bool CachedOp::LoadCompiledForwardGraph(
+    const Context& default_ctx,
+    GraphInfo* info,
+    const std::vector<NDArray*>& inputs,
+    uint64_t* key) {
+  using namespace imperative;
+  auto compile_cache = CachedOpCompileCache::Get();
+  nnvm::Graph& g = info->fwd_graph;
+  *key = 0;
+  if (!compile_cache->enabled() || Imperative::Get()->is_recording()) return false;
+  CachedOpCompileCache::Signature signature;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    signature.shapes.push_back(inputs[info->input_map[i]]->shape());
+    signature.dtypes.push_back(inputs[info->input_map[i]]->dtype());
+    signature.stypes.push_back(inputs[info->input_map[i]]->storage_type());
+  }
+  // Graphs, which are already planned for these inputs, are not looked up
+  if (g.attrs.count(AddPrefix(FORWARD, MEM_PLAN)) && g.attrs.count("shape_inputs") &&
+      g.attrs.count("dtype_inputs") && g.attrs.count("storage_type_inputs") &&
+      g.GetAttr<mxnet::ShapeVector>("shape_inputs") == signature.shapes &&
+      g.GetAttr<nnvm::DTypeVector>("dtype_inputs") == signature.dtypes &&
+      g.GetAttr<StorageTypeVector>("storage_type_inputs") == signature.stypes) {
+    return false;
+  }
+  *key = CachedOpCompileCache::Key(g, default_ctx, signature, flags_);
+  if (!compile_cache->Load(*key, signature, AddPrefix(FORWARD, MEM_PLAN),
+                           AddPrefix(FORWARD, STORAGE_PLAN), &g)) {
+    return false;
+  }
+  g.attrs["dev_mask"] = std::make_shared<dmlc::any>(
+      exec::DevMaskVector(g.indexed_graph().num_nodes(), default_ctx.dev_mask()));
+  return true;
+}
+
 bool CachedOp::SetForwardGraph(
     const Context& default_ctx,
     GraphInfo* info,
@@ -175,6 +216,13 @@ bool CachedOp::SetForwardGraph(
   CHECK_EQ(inputs.size(), num_inputs());
   nnvm::Graph& g = info->fwd_graph;
 
+  // the key is not 0, when the graph was looked up in the compile cache and not found
+  uint64_t cache_key;
+  if (LoadCompiledForwardGraph(default_ctx, info, inputs, &cache_key)) {
+    g.attrs.erase(AddPrefix(FULL, MEM_PLAN));
+    return false;
+  }
+
   ShapeVector shape_inputs(inputs.size());
   DTypeVector dtype_inputs(inputs.size());
   StorageTypeVector storage_type_inputs(inputs.size());
@@ -222,11 +270,16 @@ bool CachedOp::SetForwardGraph(
     storage[idx.entry_id(idx.outputs()[i])] = exec::kExternalStorageID;
   }
 
+  g.attrs["memory_planner"] = std::make_shared<dmlc::any>(config_.memory_planner);
   auto mem_plan = MXPlanMemory(
       &g, std::move(storage), g.GetAttr<std::vector<uint32_t> >(AddPrefix(prefix, REF_COUNT)),
       AddPrefix(prefix, STORAGE_PLAN));
   g.attrs[AddPrefix(prefix, MEM_PLAN)] =
       std::make_shared<dmlc::any>(std::move(mem_plan));
+  if (cache_key != 0 && prefix == FORWARD) {
+    CachedOpCompileCache::Get()->Save(cache_key, AddPrefix(FORWARD, MEM_PLAN),
+                                      AddPrefix(FORWARD, STORAGE_PLAN), g);
+  }
 
   return false;
 }
@@ -351,6 +404,7 @@ bool CachedOp::SetBackwardGraph(
   for (const auto i : idx.input_nodes()) storage[idx.entry_id(i, 0)] = exec::kExternalStorageID;
   for (const auto i : idx.outputs()) storage[idx.entry_id(i)] = exec::kExternalStorageID;
 
+  g.attrs["memory_planner"] = std::make_shared<dmlc::any>(config_.memory_planner);
   auto mem_plan = MXPlanMemory(
       &g, std::move(storage),
       g.GetAttr<std::vector<uint32_t> >(AddPrefix(BACKWARD, REF_COUNT)),
@@ -379,6 +433,48 @@ OpStatePtr CachedOp::GetCachedOpState(
   return state_ptr;
 }
 
+OpStatePtr CachedOp::GetCachedOpState(
+    const Context& ctx, const std::vector<NDArray*>& inputs) {
+  if (!config_.static_alloc || config_.max_static_alloc_shapes <= 1) {
+    return GetCachedOpState(ctx);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& states = cached_op_states_[ctx];
+  // Prefer the state planned and allocated for the shapes of the inputs,
+  // then the least recently used one, when all the shapes are taken
+  const OpStatePtr* lru = nullptr;
+  for (const auto& i : states) {
+    if (!i.unique()) continue;
+    auto& state = i.get_state<CachedOpState>();
+    const auto& attrs = state.info.fwd_graph.attrs;
+    if (attrs.count("shape_inputs") && attrs.count("dtype_inputs")) {
+      const auto& shapes = state.info.fwd_graph.GetAttr<mxnet::ShapeVector>("shape_inputs");
+      const auto& dtypes = state.info.fwd_graph.GetAttr<nnvm::DTypeVector>("dtype_inputs");
+      bool match = shapes.size() == inputs.size();
+      for (size_t j = 0; match && j < inputs.size(); ++j) {
+        const NDArray* input = inputs[state.info.input_map[j]];
+        match = shapes[j] == input->shape() && dtypes[j] == input->dtype();
+      }
+      if (match) {
+        state.last_use = ++num_state_uses_;
+        return i;
+      }
+    }
+    if (lru == nullptr || state.last_use < lru->get_state<CachedOpState>().last_use) {
+      lru = &i;
+    }
+  }
+  if (lru != nullptr && states.size() >= config_.max_static_alloc_shapes) {
+    lru->get_state<CachedOpState>().last_use = ++num_state_uses_;
+    return *lru;
+  }
+  auto state_ptr = OpStatePtr::Create<CachedOpState>(ctx, fwd_graph_, full_graph_,
+                                                     inlining_);
+  state_ptr.get_state<CachedOpState>().last_use = ++num_state_uses_;
+  states.push_back(state_ptr);
+  return state_ptr;
+}
+
 void CachedOp::StaticAllocMemory(
     const OpStatePtr& state_ptr,
     bool recording,
@@ -647,7 +743,7 @@ OpStatePtr CachedOp::StaticForward(
   using namespace imperative;
 
   bool recording = Imperative::Get()->is_recording();
-  auto state_ptr = GetCachedOpState(default_ctx);
+  auto state_ptr = GetCachedOpState(default_ctx, inputs);
   auto& state = state_ptr.get_state<CachedOpState>();
 
   // Need to lock the mutex on the state, this allows
@@ -331,14 +331,19 @@ void OptimizeGraph(nnvm::Graph* full_graph, nnvm::Graph* fwd_graph, nnvm::Graph*
   input_map->resize(full_graph->indexed_graph().input_nodes().size());
   std::iota(input_map->begin(), input_map->end(), 0);
 #if MXNET_USE_CUDA && !defined(_WIN32)
-  if (context.dev_mask() == kGPU &&
+  const bool fusion_supported = true;
+#else
+  const bool fusion_supported = context.dev_mask() == kCPU;
+#endif  // MXNET_USE_CUDA && !defined(_WIN32)
+  // Fusion is enabled by default on GPU, on CPU it needs to be requested explicitly
+  if (fusion_supported &&
       !inlining &&
-      dmlc::GetEnv("MXNET_USE_FUSION", true)) {
+      dmlc::GetEnv("MXNET_USE_FUSION", context.dev_mask() == kGPU)) {
     nnvm::Graph unoptimized_graph;
     common::CopyGraph(&unoptimized_graph, *full_graph, false);
 
     if (common::CheckForInputNameDuplicates(unoptimized_graph.indexed_graph())) {
-      *full_graph = exec::FusePointwise(*full_graph, num_forward_outputs);
+      *full_graph = exec::FusePointwise(*full_graph, num_forward_outputs, context);
       // Fill in input_map - mapping from the new to the original input indices.
       const auto &original_inputs = unoptimized_graph.indexed_graph().input_nodes();
       const auto &new_inputs = full_graph->indexed_graph().input_nodes();
@@ -365,14 +370,11 @@ void OptimizeGraph(nnvm::Graph* full_graph, nnvm::Graph* fwd_graph, nnvm::Graph*
       LOG(WARNING)
         << "Graph contains duplicate names for some of its inputs - fusion is NOT enabled!";
      }
-  }
-#else
-  // Only warn user if MXNET_USE_FUSION env var is explicitly set
-  if (context.dev_mask() == kGPU && !inlining &&
-      dmlc::GetEnv("MXNET_USE_FUSION", false)) {
+  } else if (!fusion_supported && !inlining &&
+             dmlc::GetEnv("MXNET_USE_FUSION", false)) {
+    // Only warn user if MXNET_USE_FUSION env var is explicitly set
     exec::WarnFusionNotSupported();
   }
-#endif  // MXNET_USE_CUDA && !defined(_WIN32)
 
   *fwd_graph = nnvm::Graph();
   fwd_graph->outputs = std::vector<nnvm::NodeEntry>(full_graph->outputs.begin(),
@@ -416,9 +418,11 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
   bool static_alloc;
   bool static_shape;
   bool is_dynamic;
+  uint32_t max_static_alloc_shapes;
   mxnet::Tuple<uint32_t> data_indices;
   mxnet::Tuple<uint32_t> param_indices;
   std::string subgraph;
+  std::string memory_planner;
   DMLC_DECLARE_PARAMETER(CachedOpConfig) {
     DMLC_DECLARE_FIELD(static_alloc)
     .set_default(false)
@@ -429,6 +433,12 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
     .describe("Optimize for invariant input shapes between iterations. "
               "Must also set static_alloc to True. "
               "Change of input shapes is still allowed but slower.");
+    DMLC_DECLARE_FIELD(max_static_alloc_shapes)
+    .set_default(1)
+    .describe("Maximum number of input shapes, for which the memory plans and "
+              "the statically allocated memory are kept on each context, when "
+              "static_alloc is True. The least recently used one is replaced "
+              "by a new input shape.");
     DMLC_DECLARE_FIELD(inline_limit)
     .set_default(2)
     .describe("Maximum number of operators that can be inlined.");
@@ -447,6 +457,11 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
     DMLC_DECLARE_FIELD(subgraph)
     .set_default(std::string(""))
     .describe("JSON string of a subgraph.");
+    DMLC_DECLARE_FIELD(memory_planner)
+    .set_default(std::string(""))
+    .describe("Memory planner of the graph, greedy or offset. The offset planner "
+              "packs the intermediate arrays into a single allocation. "
+              "Defaults to MXNET_MEMORY_PLANNER.");
     DMLC_DECLARE_FIELD(is_dynamic)
     .set_default(false)
     .describe("Whether the graph contains dynamic shape operators.");
@@ -571,6 +586,8 @@ class CachedOp {
     std::mutex mutex;
     Context context;
     GraphInfo info;
+    // the last call using the state, to replace the least recently used one
+    uint64_t last_use = 0;
 
     bool recording = false;
     bool fwd_alloc = false;
@@ -593,6 +610,7 @@ class CachedOp {
   };
 
   OpStatePtr GetCachedOpState(const Context& ctx);
+  OpStatePtr GetCachedOpState(const Context& ctx, const std::vector<NDArray*>& inputs);
   bool SetForwardGraph(
       const Context& default_ctx,
       GraphInfo* info,
@@ -607,6 +625,17 @@ class CachedOp {
       const Context& default_ctx,
       const std::vector<NDArray*>& inputs,
       bool erase_result);
+  /*!
+   * \brief Restore the inferred attributes and the forward memory plan of the graph
+   *        for the inputs from the compile cache.
+   * \param key set to the key of the graph, if it was looked up in the cache, to 0 otherwise
+   * \return whether the graph was restored
+   */
+  bool LoadCompiledForwardGraph(
+      const Context& default_ctx,
+      GraphInfo* info,
+      const std::vector<NDArray*>& inputs,
+      uint64_t* key);
   void StaticAllocMemory(
       const OpStatePtr& state_ptr,
       bool recording,
@@ -663,6 +692,7 @@ class CachedOp {
 
   std::mutex mutex_;
   std::unordered_map<Context, std::vector<OpStatePtr> > cached_op_states_;
+  uint64_t num_state_uses_ = 0;
 
   friend class ::mxnet::io::LazyTransformDataset;
   nnvm::Symbol sym_;
@@ -0,0 +1,289 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file cached_op_cache.cc
+ * \brief On-disk cache of the inferred attributes and memory plans of CachedOp graphs.
+ */
+#include "./cached_op_cache.h"
+
+#include <dmlc/io.h>
+#include <dmlc/parameter.h>
+#include <mxnet/libinfo.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <sstream>
+#include "./imperative_utils.h"
+
+namespace mxnet {
+namespace imperative {
+
+namespace {
+
+constexpr uint64_t kCacheMagic = 0x3145484341434f43;  // "COCACHE1"
+constexpr uint32_t kCacheVersion = 3;
+
+/*! \brief environment variables, which change the result of the passes */
+const char* const kCacheEnvVars[] = {
+  "MXNET_EXEC_ENABLE_INPLACE",
+  "NNVM_EXEC_MATCH_RANGE",
+  "MXNET_MEMORY_OPT",
+  "MXNET_MEMORY_PLANNER",
+  "MXNET_MKLDNN_ENABLED",
+  "MXNET_USE_FUSION",
+  "MXNET_SUBGRAPH_BACKEND",
+};
+
+// 64 bit FNV-1a
+uint64_t HashString(const std::string& s) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : s) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/*!
+ * \brief Writes the nodes, the attributes and the edges of the graph, and those of the
+ *  subgraphs of its nodes, which the partitioning by a subgraph backend creates.
+ */
+void WriteGraph(const nnvm::Graph& g, std::ostream* os) {
+  const auto& idx = g.indexed_graph();
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& node = idx[nid];
+    *os << (node.source->is_variable() ? "null" : node.source->op()->name)
+        << ' ' << node.source->num_outputs();
+    // the order of the attributes in the dictionary is not fixed
+    std::map<std::string, std::string> dict(node.source->attrs.dict.begin(),
+                                            node.source->attrs.dict.end());
+    for (const auto& kv : dict) *os << ' ' << kv.first << '=' << kv.second;
+    for (const auto& e : node.inputs) {
+      *os << " i" << e.node_id << ':' << e.index << ':' << e.version;
+    }
+    for (uint32_t dep : node.control_deps) *os << " c" << dep;
+    *os << '\n';
+    for (const auto& subgraph : node.source->attrs.subgraphs) {
+      nnvm::Graph sub;
+      sub.outputs = subgraph->outputs;
+      *os << "{\n";
+      WriteGraph(sub, os);
+      *os << "}\n";
+    }
+  }
+  for (const auto& e : idx.outputs()) *os << " o" << e.node_id << ':' << e.index;
+  *os << '\n';
+}
+
+template<typename T>
+void WriteVector(dmlc::Stream* strm, const std::vector<T>& v) {
+  const uint64_t size = v.size();
+  strm->Write(&size, sizeof(size));
+  if (size) strm->Write(v.data(), sizeof(T) * size);
+}
+
+template<typename T>
+bool ReadVector(dmlc::Stream* strm, size_t expected_size, std::vector<T>* v) {
+  uint64_t size = 0;
+  if (strm->Read(&size, sizeof(size)) != sizeof(size) || size != expected_size) return false;
+  v->resize(size);
+  return size == 0 || strm->Read(v->data(), sizeof(T) * size) == sizeof(T) * size;
+}
+
+void WriteShapes(dmlc::Stream* strm, const mxnet::ShapeVector& shapes) {
+  const uint64_t size = shapes.size();
+  strm->Write(&size, sizeof(size));
+  for (const auto& s : shapes) s.Save(strm);
+}
+
+bool ReadShapes(dmlc::Stream* strm, size_t expected_size, mxnet::ShapeVector* shapes) {
+  uint64_t size = 0;
+  if (strm->Read(&size, sizeof(size)) != sizeof(size) || size != expected_size) return false;
+  shapes->resize(size);
+  for (auto& s : *shapes) {
+    if (!s.Load(strm) || !mxnet::shape_is_known(s)) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+CachedOpCompileCache* CachedOpCompileCache::Get() {
+  static CachedOpCompileCache inst;
+  return &inst;
+}
+
+CachedOpCompileCache::CachedOpCompileCache() {
+  dir_ = dmlc::GetEnv("MXNET_CACHED_OP_CACHE_DIR", std::string());
+}
+
+std::string CachedOpCompileCache::Path(uint64_t key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.cache", static_cast<unsigned long long>(key));  // NOLINT(*)
+  return dir_ + "/" + name;
+}
+
+uint64_t CachedOpCompileCache::Key(
+    const nnvm::Graph& g, const Context& ctx, const Signature& inputs,
+    const std::vector<std::pair<std::string, std::string> >& flags) {
+  std::ostringstream os;
+  os << kCacheVersion << ' ' << MXNET_VERSION << ' ' << ctx.dev_type << '\n';
+  // the features compiled into the library, e.g. MKLDNN, change the passes
+  for (const auto& feature : features::LibInfo::getInstance()->getFeatures()) {
+    os << (feature.enabled ? '1' : '0');
+  }
+  os << '\n';
+  WriteGraph(g, &os);
+  for (size_t i = 0; i < inputs.shapes.size(); ++i) {
+    os << inputs.shapes[i] << ' ' << inputs.dtypes[i] << ' ' << inputs.stypes[i] << '\n';
+  }
+  std::map<std::string, std::string> sorted_flags(flags.begin(), flags.end());
+  for (const auto& kv : sorted_flags) os << kv.first << '=' << kv.second << '\n';
+  for (const char* var : kCacheEnvVars) {
+    const char* value = getenv(var);
+    os << var << '=' << (value ? value : "") << '\n';
+  }
+  // 0 is left for the graphs, which are not looked up
+  const uint64_t key = HashString(os.str());
+  return key ? key : 1;
+}
+
+bool CachedOpCompileCache::Load(uint64_t key, const Signature& inputs,
+                                const std::string& mem_plan, const std::string& storage_plan,
+                                nnvm::Graph* g) const {
+  std::unique_ptr<dmlc::Stream> strm(dmlc::Stream::Create(Path(key).c_str(), "r", true));
+  if (!strm) return false;
+  const auto& idx = g->indexed_graph();
+  const size_t num_nodes = idx.num_nodes();
+  const size_t num_entries = idx.num_node_entries();
+  const size_t num_inputs = inputs.shapes.size();
+
+  uint64_t magic = 0, stored_key = 0;
+  uint32_t version = 0;
+  if (strm->Read(&magic, sizeof(magic)) != sizeof(magic) || magic != kCacheMagic ||
+      strm->Read(&version, sizeof(version)) != sizeof(version) || version != kCacheVersion ||
+      strm->Read(&stored_key, sizeof(stored_key)) != sizeof(stored_key) || stored_key != key) {
+    return false;
+  }
+  Signature stored_inputs;
+  mxnet::ShapeVector shapes;
+  nnvm::DTypeVector dtypes;
+  StorageTypeVector stypes;
+  DispatchModeVector dispatch_modes;
+  std::vector<int> storage_inplace;
+  std::vector<int> plan_ids;
+  std::vector<uint32_t> plan_roots;
+  std::vector<uint64_t> plan_sizes;
+  std::vector<uint8_t> plan_inplace;
+  std::vector<uint64_t> plan_offsets;
+  // the inputs are compared as well, in case of a collision of the keys
+  if (!ReadShapes(strm.get(), num_inputs, &stored_inputs.shapes) ||
+      stored_inputs.shapes != inputs.shapes ||
+      !ReadVector(strm.get(), num_inputs, &stored_inputs.dtypes) ||
+      stored_inputs.dtypes != inputs.dtypes ||
+      !ReadVector(strm.get(), num_inputs, &stored_inputs.stypes) ||
+      stored_inputs.stypes != inputs.stypes ||
+      !ReadShapes(strm.get(), num_entries, &shapes) ||
+      !ReadVector(strm.get(), num_entries, &dtypes) ||
+      !ReadVector(strm.get(), num_entries, &stypes) ||
+      !ReadVector(strm.get(), num_nodes, &dispatch_modes) ||
+      !ReadVector(strm.get(), num_entries, &storage_inplace) ||
+      !ReadVector(strm.get(), num_entries, &plan_ids) ||
+      !ReadVector(strm.get(), num_entries, &plan_roots) ||
+      !ReadVector(strm.get(), num_entries, &plan_sizes) ||
+      !ReadVector(strm.get(), num_entries, &plan_inplace) ||
+      !ReadVector(strm.get(), num_entries, &plan_offsets)) {
+    LOG(WARNING) << "Ignoring the CachedOp compile cache entry " << Path(key)
+                 << ", which does not match the graph";
+    return false;
+  }
+  MemoryPlanVector plan(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    plan[i] = {plan_ids[i], plan_roots[i], static_cast<size_t>(plan_sizes[i]),
+               plan_inplace[i] != 0, static_cast<size_t>(plan_offsets[i])};
+  }
+
+  g->attrs["shape_inputs"] = std::make_shared<dmlc::any>(std::move(stored_inputs.shapes));
+  g->attrs["dtype_inputs"] = std::make_shared<dmlc::any>(std::move(stored_inputs.dtypes));
+  g->attrs["storage_type_inputs"] = std::make_shared<dmlc::any>(std::move(stored_inputs.stypes));
+  g->attrs["shape"] = std::make_shared<dmlc::any>(std::move(shapes));
+  g->attrs["dtype"] = std::make_shared<dmlc::any>(std::move(dtypes));
+  g->attrs["storage_type"] = std::make_shared<dmlc::any>(std::move(stypes));
+  g->attrs["dispatch_mode"] = std::make_shared<dmlc::any>(std::move(dispatch_modes));
+  g->attrs[storage_plan] = std::make_shared<dmlc::any>(std::move(storage_inplace));
+  g->attrs[mem_plan] = std::make_shared<dmlc::any>(std::move(plan));
+  return true;
+}
+
+void CachedOpCompileCache::Save(uint64_t key, const std::string& mem_plan,
+                                const std::string& storage_plan,
+                                const nnvm::Graph& g) const {
+  const auto& plan = g.GetAttr<MemoryPlanVector>(mem_plan);
+  std::vector<int> plan_ids(plan.size());
+  std::vector<uint32_t> plan_roots(plan.size());
+  std::vector<uint64_t> plan_sizes(plan.size());
+  std::vector<uint8_t> plan_inplace(plan.size());
+  std::vector<uint64_t> plan_offsets(plan.size());
+  for (size_t i = 0; i < plan.size(); ++i) {
+    plan_ids[i] = plan[i].storage_id;
+    plan_roots[i] = plan[i].root;
+    plan_sizes[i] = plan[i].size;
+    plan_inplace[i] = plan[i].inplace;
+    plan_offsets[i] = plan[i].offset;
+  }
+  const std::string path = Path(key);
+  const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+  try {
+    {
+      std::unique_ptr<dmlc::Stream> strm(dmlc::Stream::Create(tmp_path.c_str(), "w"));
+      strm->Write(&kCacheMagic, sizeof(kCacheMagic));
+      strm->Write(&kCacheVersion, sizeof(kCacheVersion));
+      strm->Write(&key, sizeof(key));
+      WriteShapes(strm.get(), g.GetAttr<mxnet::ShapeVector>("shape_inputs"));
+      WriteVector(strm.get(), g.GetAttr<nnvm::DTypeVector>("dtype_inputs"));
+      WriteVector(strm.get(), g.GetAttr<StorageTypeVector>("storage_type_inputs"));
+      WriteShapes(strm.get(), g.GetAttr<mxnet::ShapeVector>("shape"));
+      WriteVector(strm.get(), g.GetAttr<nnvm::DTypeVector>("dtype"));
+      WriteVector(strm.get(), g.GetAttr<StorageTypeVector>("storage_type"));
+      WriteVector(strm.get(), g.GetAttr<DispatchModeVector>("dispatch_mode"));
+      WriteVector(strm.get(), g.GetAttr<std::vector<int> >(storage_plan));
+      WriteVector(strm.get(), plan_ids);
+      WriteVector(strm.get(), plan_roots);
+      WriteVector(strm.get(), plan_sizes);
+      WriteVector(strm.get(), plan_inplace);
+      WriteVector(strm.get(), plan_offsets);
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      std::remove(tmp_path.c_str());
+      LOG(WARNING) << "Failed to write the CachedOp compile cache entry " << path;
+    }
+  } catch (const dmlc::Error& e) {
+    std::remove(tmp_path.c_str());
+    LOG(WARNING) << "Failed to write the CachedOp compile cache entry " << path
+                 << ": " << e.what();
+  }
+}
+
+}  // namespace imperative
+}  // namespace mxnet
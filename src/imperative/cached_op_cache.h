@@ -0,0 +1,101 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file cached_op_cache.h
+ * \brief On-disk cache of the inferred attributes and memory plans of CachedOp graphs.
+ */
+#ifndef MXNET_IMPERATIVE_CACHED_OP_CACHE_H_
+#define MXNET_IMPERATIVE_CACHED_OP_CACHE_H_
+
+#include <mxnet/base.h>
+#include <mxnet/graph_attr_types.h>
+#include <nnvm/graph.h>
+#include <nnvm/graph_attr_types.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace imperative {
+
+/*!
+ * \brief Cache of the forward graph compilation of CachedOp, shared by all processes
+ *        using the same directory (MXNET_CACHED_OP_CACHE_DIR).
+ *
+ * An entry holds what shape, type and storage type inference and memory planning
+ * attach to the graph: the shapes, types, storage types and dispatch modes of all
+ * entries, and the memory plan. It is keyed by a hash of the graph structure, the
+ * context, the shapes, types and storage types of the inputs, the CachedOp flags
+ * and the environment variables which change the passes. A process creating the
+ * same CachedOp restores the entry at the first call instead of running the passes.
+ */
+class CachedOpCompileCache {
+ public:
+  /*! \brief input signature of a graph: the shapes, types and storage types of the inputs */
+  struct Signature {
+    mxnet::ShapeVector shapes;
+    nnvm::DTypeVector dtypes;
+    StorageTypeVector stypes;
+  };
+
+  static CachedOpCompileCache* Get();
+
+  /*! \brief whether the cache directory is set */
+  bool enabled() const {
+    return !dir_.empty();
+  }
+
+  /*! \brief key of the (optimized) graph g run on ctx with the given inputs and flags */
+  static uint64_t Key(const nnvm::Graph& g, const Context& ctx, const Signature& inputs,
+                      const std::vector<std::pair<std::string, std::string> >& flags);
+
+  /*!
+   * \brief Restore the attributes and the memory plan of the cached entry to g.
+   * \param key key of the graph
+   * \param inputs input signature of the graph, checked against the one of the entry
+   * \param mem_plan name of the memory plan attribute
+   * \param storage_plan name of the storage plan attribute
+   * \return whether the entry exists and matches the graph
+   */
+  bool Load(uint64_t key, const Signature& inputs, const std::string& mem_plan,
+            const std::string& storage_plan, nnvm::Graph* g) const;
+
+  /*!
+   * \brief Store the attributes and the memory plan of g, on which the passes ran.
+   *        The entry is written to a temporary file and renamed, so that concurrent
+   *        processes never see a partial entry.
+   */
+  void Save(uint64_t key, const std::string& mem_plan, const std::string& storage_plan,
+            const nnvm::Graph& g) const;
+
+ private:
+  CachedOpCompileCache();
+  /*! \brief file of the entry */
+  std::string Path(uint64_t key) const;
+
+  /*! \brief directory of the cache, empty if the cache is disabled */
+  std::string dir_;
+};
+
+}  // namespace imperative
+}  // namespace mxnet
+
+#endif  // MXNET_IMPERATIVE_CACHED_OP_CACHE_H_
@@ -19,6 +19,8 @@
 
 #include <unordered_set>
 #include <iostream>
+#include <chrono>
+#include <exception>
 #include "./imperative_utils.h"
 #include "./exec_pass.h"
 #include "./cached_op_threadsafe.h"
@@ -39,6 +41,35 @@ struct CachedOpThreadSafe::DynamicRuntime {
   std::vector<OpStatePtr> op_states;
 };
 
+struct CachedOpThreadSafe::Batch {
+  Context ctx;
+  // inputs, outputs and batch size of the calls, in the order of arrival
+  std::vector<const std::vector<NDArray*>*> inputs;
+  std::vector<const std::vector<NDArray*>*> outputs;
+  std::vector<size_t> sizes;
+  size_t total = 0;
+  // no more calls are accepted
+  bool closed = false;
+  // the outputs of all the calls are set
+  bool done = false;
+  OpStatePtr state;
+  std::exception_ptr error;
+};
+
+namespace {
+// the flags of the batching are not known to CachedOp
+std::vector<std::pair<std::string, std::string> > CachedOpFlags(
+    const std::vector<std::pair<std::string, std::string> >& flags) {
+  std::vector<std::pair<std::string, std::string> > ret;
+  for (const auto& flag : flags) {
+    if (flag.first != "max_batch_size" && flag.first != "batch_timeout_us") {
+      ret.push_back(flag);
+    }
+  }
+  return ret;
+}
+}  // namespace
+
 OpStatePtr CachedOpThreadSafe::GetCachedOpState(
     const Context& ctx) {
 
@@ -58,7 +89,8 @@ OpStatePtr CachedOpThreadSafe::GetCachedOpState(
 
 CachedOpThreadSafe::CachedOpThreadSafe(const nnvm::Symbol& sym,
                                        const std::vector<std::pair<std::string,
-                                       std::string> >& flags) : CachedOp(sym, flags) {
+                                       std::string> >& flags)
+    : CachedOp(sym, CachedOpFlags(flags)) {
   using namespace nnvm;
   using namespace imperative;
   static const std::vector<const Op *> zero_ops{Op::Get("zeros_like"),
@@ -149,6 +181,155 @@ OpStatePtr CachedOpThreadSafe::Forward(const std::shared_ptr<CachedOp>& op_ptr,
                                        const std::vector<NDArray*>& inputs,
                                        const std::vector<NDArray*>& outputs,
                                        const Context& default_ctx) {
+  if (config_.max_batch_size > 1) {
+    return BatchedForward(inputs, outputs, default_ctx);
+  }
+  return ForwardImpl(inputs, outputs, default_ctx);
+}
+
+size_t CachedOpThreadSafe::CallBatchSize(const std::vector<NDArray*>& inputs) const {
+  size_t size = 0;
+  for (const auto i : config_.data_indices) {
+    const NDArray& data = *inputs[i];
+    if (data.storage_type() != kDefaultStorage || data.shape().ndim() < 1 ||
+        !mxnet::shape_is_known(data.shape())) {
+      return 0;
+    }
+    const size_t batch = data.shape()[0];
+    if (size != 0 && size != batch) return 0;
+    size = batch;
+  }
+  return size;
+}
+
+bool CachedOpThreadSafe::Stackable(const Batch& batch,
+                                   const std::vector<NDArray*>& inputs,
+                                   const Context& default_ctx) const {
+  if (batch.ctx != default_ctx) return false;
+  const std::vector<NDArray*>& first = *batch.inputs[0];
+  std::vector<bool> is_data(inputs.size(), false);
+  for (const auto i : config_.data_indices) is_data[i] = true;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const NDArray& a = *first[i];
+    const NDArray& b = *inputs[i];
+    if (!is_data[i]) {
+      // the calls share the parameters
+      if (!a.IsSame(b)) return false;
+      continue;
+    }
+    if (a.dtype() != b.dtype() || a.shape().ndim() != b.shape().ndim()) return false;
+    for (int j = 1; j < a.shape().ndim(); ++j) {
+      if (a.shape()[j] != b.shape()[j]) return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * \brief Stacks the concurrent calls arriving within batch_timeout_us.
+ * The first call of a batch waits for the others and executes the whole batch,
+ * the others wait until their outputs are set.
+ */
+OpStatePtr CachedOpThreadSafe::BatchedForward(const std::vector<NDArray*>& inputs,
+                                              const std::vector<NDArray*>& outputs,
+                                              const Context& default_ctx) {
+  const size_t size = CallBatchSize(inputs);
+  if (size == 0 || size >= config_.max_batch_size) {
+    return ForwardImpl(inputs, outputs, default_ctx);
+  }
+  std::unique_lock<std::mutex> lock(batch_mutex_);
+  std::shared_ptr<Batch> batch = open_batch_;
+  if (batch != nullptr && (batch->total + size > config_.max_batch_size ||
+                           !Stackable(*batch, inputs, default_ctx))) {
+    // execute the open batch right away, this call starts a new one
+    batch->closed = true;
+    open_batch_.reset();
+    batch_cv_.notify_all();
+    batch = nullptr;
+  }
+  const bool first = batch == nullptr;
+  if (first) {
+    batch = std::make_shared<Batch>();
+    batch->ctx = default_ctx;
+    open_batch_ = batch;
+  }
+  batch->inputs.push_back(&inputs);
+  batch->outputs.push_back(&outputs);
+  batch->sizes.push_back(size);
+  batch->total += size;
+  if (batch->total == config_.max_batch_size) {
+    batch->closed = true;
+    open_batch_.reset();
+    batch_cv_.notify_all();
+  }
+  if (!first) {
+    batch_cv_.wait(lock, [&batch]() { return batch->done; });
+  } else {
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::microseconds(config_.batch_timeout_us);
+    batch_cv_.wait_until(lock, deadline, [&batch]() { return batch->closed; });
+    batch->closed = true;
+    if (open_batch_ == batch) open_batch_.reset();
+    lock.unlock();
+    try {
+      batch->state = RunBatch(*batch);
+    } catch (...) {
+      batch->error = std::current_exception();
+    }
+    lock.lock();
+    batch->done = true;
+    batch_cv_.notify_all();
+  }
+  if (batch->error) std::rethrow_exception(batch->error);
+  return batch->state;
+}
+
+OpStatePtr CachedOpThreadSafe::RunBatch(const Batch& batch) {
+  if (batch.inputs.size() == 1) {
+    return ForwardImpl(*batch.inputs[0], *batch.outputs[0], batch.ctx);
+  }
+  const std::vector<NDArray*>& first = *batch.inputs[0];
+  std::vector<NDArray> stacked(first.size());
+  std::vector<NDArray*> inputs(first.begin(), first.end());
+  for (const auto i : config_.data_indices) {
+    mxnet::TShape shape = first[i]->shape();
+    shape[0] = batch.total;
+    stacked[i] = NDArray(shape, batch.ctx, false, first[i]->dtype());
+    size_t begin = 0;
+    for (size_t c = 0; c < batch.inputs.size(); ++c) {
+      CopyFromTo(*(*batch.inputs[c])[i], stacked[i].Slice(begin, begin + batch.sizes[c]));
+      begin += batch.sizes[c];
+    }
+    inputs[i] = &stacked[i];
+  }
+  std::vector<NDArray> results(num_outputs());
+  std::vector<NDArray*> outputs(results.size());
+  for (size_t i = 0; i < results.size(); ++i) outputs[i] = &results[i];
+  OpStatePtr state = ForwardImpl(inputs, outputs, batch.ctx);
+  // split the outputs, which have the batch axis, back to the calls
+  size_t begin = 0;
+  for (size_t c = 0; c < batch.outputs.size(); ++c) {
+    for (size_t i = 0; i < results.size(); ++i) {
+      const NDArray& result = results[i];
+      const bool batched = result.storage_type() == kDefaultStorage &&
+                           result.shape().ndim() > 0 &&
+                           static_cast<size_t>(result.shape()[0]) == batch.total;
+      NDArray part = batched ? result.Slice(begin, begin + batch.sizes[c]) : result;
+      NDArray* out = (*batch.outputs[c])[i];
+      if (out->is_none()) {
+        *out = part;
+      } else {
+        CopyFromTo(part, *out);
+      }
+    }
+    begin += batch.sizes[c];
+  }
+  return state;
+}
+
+OpStatePtr CachedOpThreadSafe::ForwardImpl(const std::vector<NDArray*>& inputs,
+                                           const std::vector<NDArray*>& outputs,
+                                           const Context& default_ctx) {
   // Acquiring lock on the mutex in forward
   // Without this there are issues with static_forward,
   // specifically with static_shape=True and dynamic_forward.
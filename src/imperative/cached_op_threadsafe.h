@@ -25,6 +25,9 @@
 #include <mxnet/imperative.h>
 #include <vector>
 #include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <utility>
 #include <string>
 #include <unordered_map>
@@ -47,6 +50,10 @@ struct CachedOpThreadSafeConfig
   uint32_t forward_bulk_size;
   bool static_alloc;
   bool static_shape;
+  // maximum total batch size of the concurrent calls executed at once
+  uint32_t max_batch_size;
+  // time the first call of a batch waits for the other calls
+  uint32_t batch_timeout_us;
   DMLC_DECLARE_PARAMETER(CachedOpThreadSafeConfig) {
     DMLC_DECLARE_FIELD(static_alloc)
     .set_default(false)
@@ -66,6 +73,22 @@ struct CachedOpThreadSafeConfig
             DMLC_DECLARE_FIELD(param_indices)
         .set_default(mxnet::Tuple<uint32_t>())
         .describe("Position of parameters.");
+    DMLC_DECLARE_FIELD(max_batch_size)
+        .set_default(0)
+        .describe("Maximum total batch size of concurrent calls, which are stacked "
+                  "along the first axis of the data inputs, executed once and split "
+                  "back to the callers. Calls are batched when they have the same "
+                  "parameters and context, and data inputs of the same type and shape "
+                  "except the first axis. Every output whose first axis equals the "
+                  "total batch size is sliced back to the callers, so the graph must "
+                  "keep the batch as the first axis of its outputs; any other output "
+                  "is returned whole and, unless the caller provides its own output, "
+                  "shared by all the calls of the batch. "
+                  "Batching is disabled when it is 0 or 1.");
+    DMLC_DECLARE_FIELD(batch_timeout_us)
+        .set_default(1000)
+        .describe("Maximum time in microseconds the first call of a batch waits "
+                  "for other calls, when max_batch_size is larger than 1.");
   }
 };
 
@@ -116,9 +139,23 @@ class CachedOpThreadSafe : public CachedOp {
   struct GraphInfo;
  private:
   struct DynamicRuntime;
+  struct Batch;
 
   OpStatePtr GetCachedOpState(const Context& ctx);
 
+  OpStatePtr ForwardImpl(const std::vector<NDArray*>& inputs,
+                         const std::vector<NDArray*>& outputs,
+                         const Context& default_ctx);
+  // batch size of a call, 0 if it can not be batched
+  size_t CallBatchSize(const std::vector<NDArray*>& inputs) const;
+  // whether a call can be stacked with the calls of the batch
+  bool Stackable(const Batch& batch, const std::vector<NDArray*>& inputs,
+                 const Context& default_ctx) const;
+  OpStatePtr BatchedForward(const std::vector<NDArray*>& inputs,
+                            const std::vector<NDArray*>& outputs,
+                            const Context& default_ctx);
+  OpStatePtr RunBatch(const Batch& batch);
+
   OpStatePtr DynamicForward(const Context& default_ctx,
                             const std::vector<NDArray*>& inputs,
                             const std::vector<NDArray*>& outputs);
@@ -127,6 +164,10 @@ class CachedOpThreadSafe : public CachedOp {
   nnvm::Graph fwd_graph_;
   std::mutex mutex_;
   std::unordered_map<Context, std::vector<OpStatePtr>> cached_op_states_;
+  // the batch, which accepts new calls
+  std::shared_ptr<Batch> open_batch_;
+  std::mutex batch_mutex_;
+  std::condition_variable batch_cv_;
 };
 
 using CachedOpThreadSafePtr = std::shared_ptr<CachedOpThreadSafe>;
@@ -208,10 +208,12 @@ Graph EliminateCommonExpr(Graph && g);
  *
  * \param g input graph (needs to be entire graph, not just forward part)
  * \param num_forward_outputs number of outputs in the graph produced by the forward pass
+ * \param context context on which the fused graph will be executed
  *
  * \return copy of the graph with fused pointwise operations
  */
-Graph FusePointwise(const Graph& g, const size_t num_forward_outputs);
+Graph FusePointwise(const Graph& g, const size_t num_forward_outputs,
+                    const Context& context);
 
 /*!
  * \brief Issue a one-time warning that fusion is not possible for this platform or build.
@@ -21,6 +21,7 @@
 #include <nnvm/pass_functions.h>
 #include <utility>
 #include <algorithm>
+#include <limits>
 #include <vector>
 #include <map>
 #include <string>
@@ -103,11 +104,16 @@ namespace {
   }
 }
 
+/*! \brief offset of the roots that are not placed in an arena */
+constexpr size_t kNoArenaOffset = std::numeric_limits<size_t>::max();
+
 struct MemoryPlanInfo {
   int storage_id;
   uint32_t root;
   size_t size;
   bool inplace;
+  /*! \brief byte offset of the root in the arena of the graph, set by the offset planner */
+  size_t offset = kNoArenaOffset;
 };
 
 struct EngineOprDeleter {
@@ -381,6 +387,7 @@ inline void SetDependency(const nnvm::NodeAttrs& attrs,
   write_vars.reserve(outputs.size() + mutate_idx.size());
   for (auto& i : outputs) {
     write_vars.push_back(i->var());
+    write_vars.insert(write_vars.end(), i->memory_vars().begin(), i->memory_vars().end());
   }
   for (auto & i : mutate_idx) {
     write_vars.push_back(inputs[i]->var());
@@ -1051,6 +1058,12 @@ inline MemoryPlanVector MXPlanMemory(
   const auto& storage_inplace = g.GetAttr<std::vector<int> >("storage_inplace_index");
   g.attrs[storage_plan] = std::make_shared<any>(storage_inplace);
   const auto& storage_ids = g.GetAttr<StorageVector>("storage_id");
+  const std::vector<size_t>* storage_offset = g.attrs.count("storage_offset") ?
+      &g.GetAttr<std::vector<size_t> >("storage_offset") : nullptr;
+  if (dmlc::GetEnv("MXNET_MEM_PLAN_VERBOSE_LOGGING", false)) {
+    LOG(INFO) << "Memory plan (" << g.GetAttr<std::string>("memory_planner") << "): "
+              << g.GetAttr<size_t>("storage_allocated_bytes") / 1024 << " KB";
+  }
   uint32_t entry_start = entry_range.first;
   uint32_t entry_end =
       entry_range.second > entry_start ? entry_range.second : idx.num_node_entries();
@@ -1066,6 +1079,10 @@ inline MemoryPlanVector MXPlanMemory(
       mem_plan[i] = {storage_ids[i], i,
                      mshadow::mshadow_sizeof(dtypes[i]) * shapes[i].Size(),
                      false};
+      if (storage_offset != nullptr &&
+          static_cast<size_t>(storage_ids[i]) < storage_offset->size()) {
+        mem_plan[i].offset = (*storage_offset)[storage_ids[i]];
+      }
     } else {
       uint32_t root = sid_to_root[storage_ids[i]];
       mem_plan[i] = {storage_ids[i], root, 0, storage_inplace[i] >= 0};
@@ -1108,6 +1125,24 @@ inline std::multimap<size_t, NDArray> AllocateMemory(
     }
   }
 
+  // the roots placed by the offset planner are carved out of a single allocation.
+  // It is not reused from the pool, since the operators of the arrays carved out
+  // of it before may still be running.
+  size_t arena_bytes = 0;
+  for (uint32_t i = entry_start; i < entry_end; ++i) {
+    const auto &plan = mem_plan[i];
+    if (plan.storage_id >= 0 && plan.root == i && plan.offset != kNoArenaOffset) {
+      arena_bytes = std::max(arena_bytes, plan.offset + plan.size);
+    }
+  }
+  NDArray arena;
+  if (arena_bytes > 0) {
+    arena = NDArray(mxnet::TShape({static_cast<nnvm::dim_t>(arena_bytes)}),
+                    default_ctx, true, mshadow::kUint8);
+    arena.AssignStorageInfo(MXNET_STORAGE_DEFAULT_PROFILER_SCOPE_CSTR, "memory_arena");
+  }
+  std::vector<uint32_t> carved;
+
   const NDArray *pntr;
   for (uint32_t i = entry_start; i < entry_end; ++i) {
     const auto &plan = mem_plan[i];
@@ -1121,6 +1156,11 @@ inline std::multimap<size_t, NDArray> AllocateMemory(
       continue;
     }
     CHECK_EQ(stypes[i], kDefaultStorage);
+    if (plan.root == i && plan.offset != kNoArenaOffset && arena_bytes > 0) {
+      arrays[i]->InitFromArena(arena, plan.offset, plan.size, shapes[i], dtypes[i]);
+      carved.push_back(i);
+      continue;
+    }
     if (plan.root == i) {
       auto iter = pool.lower_bound(plan.size);
       if (iter != pool.end()) {
@@ -1142,6 +1182,23 @@ inline std::multimap<size_t, NDArray> AllocateMemory(
     arrays[i]->InitAsArray(*pntr, shapes[i], dtypes[i]);
   }
 
+  // The carved arrays sharing memory have disjoint lifetimes, but without a common
+  // engine variable the operators of the later array could overwrite the memory
+  // while the earlier one is still read. Their writes are ordered after each other,
+  // in both directions, since the arrays of a static graph are used again by the
+  // next run.
+  std::sort(carved.begin(), carved.end(), [&](uint32_t a, uint32_t b) {
+      return mem_plan[a].offset < mem_plan[b].offset;
+    });
+  for (size_t a = 0; a < carved.size(); ++a) {
+    const auto &plan_a = mem_plan[carved[a]];
+    for (size_t b = a + 1; b < carved.size() &&
+         mem_plan[carved[b]].offset < plan_a.offset + plan_a.size; ++b) {
+      arrays[carved[a]]->AddMemoryDependency(*arrays[carved[b]]);
+      arrays[carved[b]]->AddMemoryDependency(*arrays[carved[a]]);
+    }
+  }
+
   return new_pool;
 }
 
@@ -1189,6 +1246,7 @@ inline Engine::OprHandle CreateEngineOp(
     }
     for (auto& nd : exec->out_array) {
       mutate_vars.push_back(nd.var());
+      mutate_vars.insert(mutate_vars.end(), nd.memory_vars().begin(), nd.memory_vars().end());
     }
     if (exec->var() != nullptr) {
       mutate_vars.push_back(exec->var());
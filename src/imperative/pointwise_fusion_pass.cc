@@ -55,8 +55,6 @@ void WarnFusionNotSupported() {
   }
 }
 
-#if MXNET_USE_CUDA
-
 namespace {
 
 bool IsFusionCompatible(const nnvm::Node* n) {
@@ -110,6 +108,27 @@ bool IsInputsOnlyCompatible(const nnvm::Node* n) {
   return false;
 }
 
+/* \brief The CPU implementation of the fused op runs the FCompute<cpu>
+ *        of every node on tiles of the data, so the node needs to provide
+ *        a plain FCompute<cpu> and must not need any extra resources.
+ */
+bool IsCPUFusionCompatible(const nnvm::Node* n) {
+  static auto& fcompute_cpu = Op::GetAttr<FCompute>("FCompute<cpu>");
+  static auto& fresource = Op::GetAttr<FResourceRequest>("FResourceRequest");
+  static auto& fresource_ex = Op::GetAttr<FResourceRequestEx>("FResourceRequestEx");
+  if (!IsFusionCompatible(n))
+    return false;
+  const Op* op = n->op();
+  return fcompute_cpu.count(op) &&
+         !fresource.count(op) &&
+         !fresource_ex.count(op);
+}
+
+bool IsCPUInputsOnlyCompatible(const nnvm::Node* n) {
+  // Slices change the size of the data, which would prevent tiling
+  return false;
+}
+
 void CreateSubgraphNode(const nnvm::Graph& subgraph,
                         size_t inputs_size,
                         nnvm::Node* subgraph_node) {
@@ -359,11 +378,13 @@ Graph CopyAndReplaceSubgraphs(const Graph& g,
   return ret;
 }
 
-Graph FusePointwise(const Graph &g, const size_t num_forward_outputs) {
+Graph FusePointwise(const Graph &g, const size_t num_forward_outputs,
+                    const Context& context) {
   auto start = std::chrono::steady_clock::now();
+  const bool cpu = context.dev_mask() == kCPU;
   auto [subset_assignment, num_subsets] = GetCompatibleSubsets(g, num_forward_outputs,  // NOLINT(*)
-                                                               IsFusionCompatible,
-                                                               IsInputsOnlyCompatible);
+      cpu ? IsCPUFusionCompatible : IsFusionCompatible,
+      cpu ? IsCPUInputsOnlyCompatible : IsInputsOnlyCompatible);
   Graph ret = CopyAndReplaceSubgraphs(g, subset_assignment, num_subsets,
                                       CreateSubgraphNode);
   auto end = std::chrono::steady_clock::now();
@@ -375,7 +396,6 @@ Graph FusePointwise(const Graph &g, const size_t num_forward_outputs) {
   }
   return ret;
 }
-#endif  // MXNET_USE_CUDA
 
 }  // namespace exec
 }  // namespace mxnet
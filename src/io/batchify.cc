@@ -88,7 +88,8 @@ class GroupBatchify : public BatchifyFunction {
           std::vector<NDArray> curr({input[i]});
           inp.emplace_back(curr);
       }
-      std::vector<NDArray> tmp;
+      // hand the previous output over, so that the function can reuse its buffer
+      std::vector<NDArray> tmp{(*outputs)[i]};
       if (!fs_[i]->Batchify(inp, &tmp)) return false;
       (*outputs)[i] = tmp[0];
     }
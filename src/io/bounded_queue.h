@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file bounded_queue.h
+ * \brief blocking queue of limited capacity connecting the stages of the data pipelines
+ */
+
+#ifndef MXNET_IO_BOUNDED_QUEUE_H_
+#define MXNET_IO_BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace mxnet {
+namespace io {
+/*!
+ * \brief Multi-producer, multi-consumer blocking queue of limited capacity.
+ *  The producers block while the queue is full, so a slow consumer stage
+ *  limits the memory held by the faster stages in front of it.
+ */
+template<typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity = 1) : capacity_(capacity) {}
+  /*!
+   * \brief push the item, block while the queue is full
+   * \return false, when the queue was killed and the item was dropped
+   */
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this]() { return killed_ || queue_.size() < capacity_; });
+    if (killed_) return false;
+    queue_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+  /*!
+   * \brief pop the item, block while the queue is empty and not closed
+   * \return false, when the queue is closed and drained, or killed
+   */
+  bool Pop(T *item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return killed_ || closed_ || !queue_.empty(); });
+    if (killed_ || queue_.empty()) return false;
+    *item = std::move(queue_.front());
+    queue_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+  /*! \brief no more items will be pushed, the consumers drain the queue */
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+  }
+  /*! \brief drop the items and wake up everybody, e.g. when one of the stages failed */
+  void Kill() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    killed_ = true;
+    queue_.clear();
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+  /*! \brief make the queue empty and open again */
+  void Reset(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    closed_ = killed_ = false;
+    queue_.clear();
+  }
+  /*! \brief number of the items in the queue */
+  size_t Size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+
+ private:
+  size_t capacity_;
+  bool closed_ = false;
+  bool killed_ = false;
+  std::deque<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_BOUNDED_QUEUE_H_
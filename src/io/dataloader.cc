@@ -25,7 +25,10 @@
 #include <dmlc/parameter.h>
 #include <dmlc/omp.h>
 #include <mxnet/io.h>
+#include <exception>
+#include <thread>
 
+#include "./bounded_queue.h"
 #include "./inst_vector.h"
 #include "./iter_prefetcher.h"
 #include "../profiler/custom_op_profiler.h"
@@ -43,6 +46,8 @@ struct ThreadedDataLoaderParam : public dmlc::Parameter<ThreadedDataLoaderParam>
   std::intptr_t batchify_fn;
   /*! \brief pin memory to device id.*/
   int pin_device_id;
+  /*! \brief number of batches produced ahead by the background worker.*/
+  int prefetch_depth;
   // declare parameters
   DMLC_DECLARE_PARAMETER(ThreadedDataLoaderParam) {
       DMLC_DECLARE_FIELD(num_workers).set_default(0)
@@ -55,6 +60,10 @@ struct ThreadedDataLoaderParam : public dmlc::Parameter<ThreadedDataLoaderParam>
           .describe("Pointer to Batchify function.");
       DMLC_DECLARE_FIELD(pin_device_id).set_default(-1)
           .describe("If not negative, will move data to pinned memory.");
+      DMLC_DECLARE_FIELD(prefetch_depth).set_default(0).set_lower_bound(0)
+          .describe("Number of batches produced ahead of the consumer by a background "
+                    "worker, into a ring of reused batch buffers. "
+                    "0 produces the batches synchronously inside Next.");
   }
 };  // struct ThreadedDataLoaderParam
 
@@ -65,7 +74,9 @@ class ThreadedDataLoader : public IIterator<TBlobBatch> {
  public:
   ThreadedDataLoader() = default;
   // destructor
-  ~ThreadedDataLoader() override = default;
+  ~ThreadedDataLoader() override {
+    StopProducer();
+  }
   // constructor
   void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) override {
     param_.InitAllowUnknown(kwargs);
@@ -85,11 +96,17 @@ class ThreadedDataLoader : public IIterator<TBlobBatch> {
     dataset_len_ = dataset_->GetLen();
     sampler_ = static_cast<IIterator<DataBatch>* >(reinterpret_cast<void*>(param_.sampler));
     batchify_fn_ = *static_cast<BatchifyFunctionPtr*>(reinterpret_cast<void*>(param_.batchify_fn));
+    // one more slot than the depth, it holds the batch returned to the consumer
+    slots_.resize(param_.prefetch_depth > 0 ? param_.prefetch_depth + 1 : 0);
     this->BeforeFirst();
   }
   // before first
   void BeforeFirst() override {
+    StopProducer();
     sampler_->BeforeFirst();
+    if (param_.prefetch_depth > 0) {
+      StartProducer();
+    }
   }
 
   int64_t GetLenHint() const override {
@@ -97,6 +114,40 @@ class ThreadedDataLoader : public IIterator<TBlobBatch> {
   }
 
   bool Next() override {
+    if (param_.prefetch_depth == 0) {
+      value_ = &out_;
+      return LoadBatch(&batched_buffer_, &out_);
+    }
+    // the batch returned last time is no longer used by the consumer
+    if (held_slot_ >= 0) {
+      free_slots_.Push(held_slot_);
+      held_slot_ = -1;
+    }
+    int slot;
+    if (!ready_slots_.Pop(&slot)) return false;
+    held_slot_ = slot;
+    if (slots_[slot].error) {
+      std::exception_ptr error = slots_[slot].error;
+      slots_[slot].error = nullptr;
+      std::rethrow_exception(error);
+    }
+    value_ = &slots_[slot].out;
+    return true;
+  }
+
+  const TBlobBatch &Value() const override {
+    return *value_;
+  }
+
+ private:
+  /*! \brief batch buffers of one entry of the prefetch ring */
+  struct PrefetchSlot {
+    std::vector<NDArray> buffer;
+    TBlobBatch out;
+    std::exception_ptr error;
+  };
+  /*! \brief sample, load and batchify the next batch into buffer */
+  bool LoadBatch(std::vector<NDArray>* buffer, TBlobBatch* out) {
     bool has_next = sampler_->Next();
     if (!has_next) return false;
     auto samples = sampler_->Value();
@@ -136,31 +187,70 @@ class ThreadedDataLoader : public IIterator<TBlobBatch> {
     if (profiling) {
       profiler::CustomOpProfiler::Get()->OnCustomBegin("MXThreadedDataLoaderBatchify");
     }
-    CHECK(batchify_fn_->Batchify(inputs, &batched_buffer_))
+    CHECK(batchify_fn_->Batchify(inputs, buffer))
       << "Error call batchify inside dataloader";
     if (profiling) {
       profiler::CustomOpProfiler::Get()->OnCustomEnd();
     }
-    out_.batch_size = batched_buffer_.size();
-    out_.data.resize(batched_buffer_.size());
-    for (size_t i = 0; i < batched_buffer_.size(); ++i) {
-      out_.data[i] = batched_buffer_[i].data();
+    out->batch_size = buffer->size();
+    out->data.resize(buffer->size());
+    for (size_t i = 0; i < buffer->size(); ++i) {
+      out->data[i] = (*buffer)[i].data();
     }
-    out_.num_batch_padd = samples.num_batch_padd;
+    out->num_batch_padd = samples.num_batch_padd;
     return true;
   }
-
-  const TBlobBatch &Value() const override {
-    return out_;
+  /*! \brief fill the free slots of the ring in sampling order, until the epoch ends */
+  void Produce() {
+    int slot;
+    while (free_slots_.Pop(&slot)) {
+      PrefetchSlot& entry = slots_[slot];
+      bool has_next = true;
+      try {
+        has_next = LoadBatch(&entry.buffer, &entry.out);
+      } catch (...) {
+        entry.error = std::current_exception();
+      }
+      if (!has_next) break;
+      if (!ready_slots_.Push(slot)) return;
+      if (entry.error) break;
+    }
+    ready_slots_.Close();
+  }
+  void StartProducer() {
+    free_slots_.Reset(slots_.size());
+    ready_slots_.Reset(slots_.size());
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      free_slots_.Push(static_cast<int>(i));
+    }
+    held_slot_ = -1;
+    producer_ = std::thread([this]() { Produce(); });
+  }
+  void StopProducer() {
+    if (!producer_.joinable()) return;
+    free_slots_.Kill();
+    ready_slots_.Kill();
+    producer_.join();
   }
 
- private:
   /*! \brief Params */
   ThreadedDataLoaderParam param_;
   /*! \brief output */
   TBlobBatch out_;
   /*! \brief batched buffer */
   std::vector<NDArray> batched_buffer_;
+  /*! \brief output returned by Value */
+  const TBlobBatch *value_ = &out_;
+  /*! \brief ring of batch buffers filled by the background worker */
+  std::vector<PrefetchSlot> slots_;
+  /*! \brief slots of the ring ready to be refilled */
+  BoundedQueue<int> free_slots_;
+  /*! \brief filled slots in sampling order */
+  BoundedQueue<int> ready_slots_;
+  /*! \brief slot of the batch currently held by the consumer, -1 if none */
+  int held_slot_ = -1;
+  /*! \brief background worker producing the batches */
+  std::thread producer_;
   /*! \brief pointer to dataset */
   std::shared_ptr<Dataset> dataset_;
   /*! \brief dataset length */
@@ -135,6 +135,12 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
   int shuffle_chunk_seed;
   /*! \brief random seed for augmentations */
   dmlc::optional<int> seed_aug;
+  /*! \brief number of threads decoding the images in the pipelined mode */
+  int decode_threads;
+  /*! \brief number of threads assembling the batch in the pipelined mode */
+  int assemble_threads;
+  /*! \brief capacity of the queues between the stages of the pipeline */
+  int pipeline_queue_size;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(ImageRecParserParam) {
@@ -176,6 +182,20 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
         .describe("The random seed for shuffling");
     DMLC_DECLARE_FIELD(seed_aug).set_default(dmlc::optional<int>())
         .describe("Random seed for augmentations.");
+    DMLC_DECLARE_FIELD(decode_threads).set_lower_bound(0).set_default(0)
+        .describe("The number of threads decoding the images. When positive, ImageRecordIter2 "
+                  "processes the records in the pipeline read -> decode -> augment -> "
+                  "batch assemble, with bounded queues between the stages, and "
+                  "preprocess_threads is the number of augmenting threads. The stages keep "
+                  "running across the batches, the next batch is decoded while the current "
+                  "one is assembled. "
+                  "0 means each image is decoded, augmented and copied by the same thread.");
+    DMLC_DECLARE_FIELD(assemble_threads).set_lower_bound(1).set_default(1)
+        .describe("The number of threads normalizing the augmented images and copying "
+                  "them into the batch, when decode_threads is positive.");
+    DMLC_DECLARE_FIELD(pipeline_queue_size).set_lower_bound(1).set_default(64)
+        .describe("The number of images each queue between the pipeline stages can hold, "
+                  "when decode_threads is positive.");
   }
 };
 
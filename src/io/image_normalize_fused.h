@@ -0,0 +1,152 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file image_normalize_fused.h
+ * \brief fused channel swap, mirror, normalization and HWC to CHW transposition
+ *  of 3 channel images, used by the record iterators on their default path
+ */
+
+#ifndef MXNET_IO_IMAGE_NORMALIZE_FUSED_H_
+#define MXNET_IO_IMAGE_NORMALIZE_FUSED_H_
+
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace mxnet {
+namespace io {
+namespace fused {
+
+#if defined(__AVX2__)
+/*! \brief pixels processed by one iteration of the vectorized loops */
+constexpr int kBlockPixels = 16;
+
+/*!
+ * \brief Splits 16 interleaved 3 channel pixels (48 bytes) into one 16 byte
+ *  vector per channel, planes[c] holding channel c of the source.
+ */
+inline void Deinterleave3(const uint8_t* src, __m128i planes[3]) {
+  // masks[c][r] picks the bytes of channel c held by the r-th source vector
+  struct Masks {
+    alignas(16) int8_t m[3][3][16];
+    Masks() {
+      for (int c = 0; c < 3; ++c) {
+        for (int r = 0; r < 3; ++r) {
+          for (int i = 0; i < kBlockPixels; ++i) {
+            const int pos = 3 * i + c - 16 * r;
+            m[c][r][i] = (pos >= 0 && pos < 16) ? static_cast<int8_t>(pos) : -1;
+          }
+        }
+      }
+    }
+  };
+  static const Masks masks;
+  const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+  const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+  for (int ch = 0; ch < 3; ++ch) {
+    const __m128i* m = reinterpret_cast<const __m128i*>(masks.m[ch]);
+    planes[ch] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, _mm_load_si128(m)),
+                                           _mm_shuffle_epi8(b, _mm_load_si128(m + 1))),
+                              _mm_shuffle_epi8(c, _mm_load_si128(m + 2)));
+  }
+}
+
+/*! \brief (x - mean) * mult + bias for 8 pixels, rounding like the scalar code */
+inline __m256 Normalize8(__m128i bytes, __m256 mean, __m256 mult, __m256 bias) {
+  const __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+  return _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(x, mean), mult), bias);
+}
+#endif  // __AVX2__
+
+/*!
+ * \brief Normalizes one row of a BGR image into the rows of the R, G and B planes.
+ *  Output pixel j gets (x - mean) * mult + bias of source pixel j, or of pixel
+ *  cols - 1 - j when mirrored; mean, mult and bias are in RGB order.
+ */
+inline void NormalizeRowBGR(const uint8_t* src, int cols, float* const dst[3], bool mirror,
+                            const float mean[3], const float mult[3], const float bias[3]) {
+  int j = 0;
+#if defined(__AVX2__)
+  const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+  for (; j + kBlockPixels <= cols; j += kBlockPixels) {
+    __m128i planes[3];
+    Deinterleave3(src + 3 * j, planes);
+    for (int k = 0; k < 3; ++k) {
+      const __m256 vmean = _mm256_set1_ps(mean[k]);
+      const __m256 vmult = _mm256_set1_ps(mult[k]);
+      const __m256 vbias = _mm256_set1_ps(bias[k]);
+      const __m128i plane = planes[2 - k];
+      __m256 lo = Normalize8(plane, vmean, vmult, vbias);
+      __m256 hi = Normalize8(_mm_srli_si128(plane, 8), vmean, vmult, vbias);
+      if (mirror) {
+        _mm256_storeu_ps(dst[k] + cols - j - 8, _mm256_permutevar8x32_ps(lo, reverse));
+        _mm256_storeu_ps(dst[k] + cols - j - 16, _mm256_permutevar8x32_ps(hi, reverse));
+      } else {
+        _mm256_storeu_ps(dst[k] + j, lo);
+        _mm256_storeu_ps(dst[k] + j + 8, hi);
+      }
+    }
+  }
+#endif  // __AVX2__
+  for (; j < cols; ++j) {
+    const int out = mirror ? cols - j - 1 : j;
+    for (int k = 0; k < 3; ++k) {
+      const float x = src[3 * j + 2 - k];
+      dst[k][out] = (x - mean[k]) * mult[k] + bias[k];
+    }
+  }
+}
+
+/*!
+ * \brief Splits one row of a BGR image into the rows of the R, G and B planes,
+ *  without normalization.
+ */
+inline void SplitRowBGR(const uint8_t* src, int cols, uint8_t* const dst[3], bool mirror) {
+  int j = 0;
+#if defined(__AVX2__)
+  const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  for (; j + kBlockPixels <= cols; j += kBlockPixels) {
+    __m128i planes[3];
+    Deinterleave3(src + 3 * j, planes);
+    for (int k = 0; k < 3; ++k) {
+      if (mirror) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[k] + cols - j - kBlockPixels),
+                         _mm_shuffle_epi8(planes[2 - k], reverse));
+      } else {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[k] + j), planes[2 - k]);
+      }
+    }
+  }
+#endif  // __AVX2__
+  for (; j < cols; ++j) {
+    const int out = mirror ? cols - j - 1 : j;
+    for (int k = 0; k < 3; ++k) {
+      dst[k][out] = src[3 * j + 2 - k];
+    }
+  }
+}
+
+}  // namespace fused
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_IMAGE_NORMALIZE_FUSED_H_
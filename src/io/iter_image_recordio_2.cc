@@ -33,14 +33,27 @@
 #include <dmlc/omp.h>
 #include <dmlc/common.h>
 #include <dmlc/timer.h>
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 #if MXNET_USE_LIBJPEG_TURBO
 #include <turbojpeg.h>
 #endif
+#include "./bounded_queue.h"
 #include "./image_recordio.h"
 #include "./image_augmenter.h"
 #include "./image_iter_common.h"
+#include "./image_normalize_fused.h"
 #include "./inst_vector.h"
 #include "../common/utils.h"
 #include "../profiler/profiler.h"
@@ -48,10 +61,48 @@
 namespace mxnet {
 
 namespace io {
+/*! \brief stages of the image decoding pipeline */
+enum PipelineStage {
+  kRead, kDecode, kAugment, kAssemble, kNumPipelineStages
+};
+
+/*!
+ * \brief Number of images processed by a stage of the decoding pipeline and the time its
+ *  threads spent processing them (without waiting on the queues), reported as profiler
+ *  counters. Images per thread time give the throughput of one thread of the stage.
+ */
+class PipelineStageStats {
+ public:
+  explicit PipelineStageStats(const std::string& stage)
+    : images_((stage + ": images").c_str(), Domain()),
+      busy_((stage + ": thread time (us)").c_str(), Domain()) {}
+
+  void Add(size_t n_images, double seconds) {
+    if (profiler::Profiler::Get()->IsProfiling(profiler::Profiler::kImperative)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      images_ += n_images;
+      busy_ += static_cast<int64_t>(seconds * 1e6);
+    }
+  }
+
+ private:
+  static profiler::ProfileDomain* Domain() {
+    static profiler::ProfileDomain domain("ImageRecordIter2 pipeline");
+    return &domain;
+  }
+
+  std::mutex mutex_;
+  profiler::ProfileCounter images_;
+  profiler::ProfileCounter busy_;
+};
+
 // parser to parse image recordio
 template<typename DType>
 class ImageRecordIOParser2 {
  public:
+  ~ImageRecordIOParser2() {
+    StopPipeline();
+  }
   // initialize the parser
   inline void Init(const std::vector<std::pair<std::string, std::string> >& kwargs);
 
@@ -59,7 +110,11 @@ class ImageRecordIOParser2 {
   inline void BeforeFirst() {
     if (batch_param_.round_batch == 0 || !overflow) {
       n_parsed_ = 0;
-      return source_->BeforeFirst();
+      StopPipeline();
+      source_->BeforeFirst();
+      if (param_.decode_threads > 0) {
+        StartPipeline(legacy_shuffle_ ? batch_param_.batch_size : 0);
+      }
     } else {
       overflow = false;
     }
@@ -77,7 +132,51 @@ class ImageRecordIOParser2 {
 #if MXNET_USE_LIBJPEG_TURBO
   cv::Mat TJimdecode(cv::Mat buf, int color);
 #endif
+  /*! \brief random normalization parameters of one image */
+  struct Normalization {
+    bool is_mirrored = false;
+    float contrast_scaled = 1;
+    float illumination_scaled = 0;
+  };
+  /*! \brief record, which passes through the stages of the pipeline */
+  struct PipelineItem {
+    // sequence number of the chunk of the record since the start of the pipeline
+    size_t chunk = 0;
+    size_t idx = 0;
+    // copy of the record, the chunk is released when the source reads the next one
+    std::string record;
+    size_t image_index = 0;
+    cv::Mat image;
+    std::vector<float> label;
+    Normalization norm;
+  };
+  cv::Mat DecodeImage(const ImageRecordIO& rec);
+  void LoadLabel(const ImageRecordIO& rec, std::vector<float>* label_buf);
+  // applies the augmenters of the thread and draws the random normalization
+  void Augment(int tid, size_t idx, cv::Mat* res, std::vector<float>* label_buf,
+               Normalization* norm);
+  // normalizes the image into the batch (or the temporary storage, if it does not fit)
+  void Assemble(const cv::Mat& res, const std::vector<float>& label_buf, size_t image_index,
+                const Normalization& norm, size_t idx, DType* data_dptr, real_t* label_dptr,
+                InstVector<DType>* out_tmp);
+  bool ParseChunkPipelined(DType* data_dptr, real_t* label_dptr, const size_t current_size,
+    size_t* n_to_out);
+  // runs the body of a stage thread, a failure stops the whole pipeline
+  void RunPipelineStage(const std::function<void()>& body);
+  void ReadStage(size_t offset);
+  void DecodeStage();
+  void AugmentStage(int tid);
+  void AssembleStage(int tid);
 #endif
+  // starts the stage threads, the first chunk starts at the offset in the batch
+  inline void StartPipeline(size_t offset);
+  // stops and joins the stage threads, dropping the records in flight
+  inline void StopPipeline();
+  // starts the source over, when the end is reached in the middle of a round batch
+  inline void RewindSource();
+  // parses the next chunk of the source, returns false at the end of the data
+  inline bool ParseNextChunk(DType* data_dptr, real_t* label_dptr, const size_t current_size,
+    size_t* n_to_out);
   inline size_t ParseChunk(DType* data_dptr, real_t* label_dptr, const size_t current_size,
     dmlc::InputSplit::Blob * chunk);
   inline void CreateMeanImg();
@@ -94,7 +193,39 @@ class ImageRecordIOParser2 {
   #if MXNET_USE_OPENCV
   /*! \brief augmenters */
   std::vector<std::vector<std::unique_ptr<ImageAugmenter> > > augmenters_;
+  /*! \brief queues after the read, decode and augment stages of the pipeline */
+  std::array<BoundedQueue<PipelineItem>, kNumPipelineStages - 1> queues_;
+  /*! \brief threads of the pipeline stages, running across the chunks */
+  std::vector<std::thread> pipeline_threads_;
+  /*! \brief mutex and condition protecting the pipeline state below */
+  std::mutex pipeline_mutex_;
+  std::condition_variable pipeline_cv_;
+  /*! \brief number of the chunks requested by ParseNext, the last one is being assembled */
+  size_t n_requested_ = 0;
+  /*! \brief batch of the chunk being assembled */
+  DType* dest_data_ = nullptr;
+  real_t* dest_label_ = nullptr;
+  /*! \brief number of the assembled images of the chunk being assembled */
+  size_t n_assembled_ = 0;
+  /*! \brief offset in the batch and number of records of the chunks, which were read */
+  std::map<size_t, std::pair<size_t, size_t> > read_chunks_;
+  /*! \brief images of the next chunk, which reached the assembly before their batch */
+  std::vector<PipelineItem> stash_;
+  /*! \brief image index and place in temp_ of the overflow images of each assembling thread */
+  std::vector<std::vector<std::pair<size_t, std::pair<size_t, size_t> > > > pipeline_overflow_;
+  /*! \brief the read stage reached the end of the source */
+  bool read_end_ = false;
+  /*! \brief the read stage has to start the source over */
+  bool rewind_ = false;
+  /*! \brief the stage threads have to exit */
+  bool pipeline_stopping_ = false;
+  /*! \brief first failure of a stage */
+  std::exception_ptr pipeline_error_;
   #endif
+  /*! \brief throughput of the pipeline stages */
+  std::array<PipelineStageStats, kNumPipelineStages> stage_stats_ = {{
+    PipelineStageStats("read"), PipelineStageStats("decode"),
+    PipelineStageStats("augment"), PipelineStageStats("assemble")}};
   /*! \brief random samplers */
   std::vector<std::unique_ptr<common::RANDOM_ENGINE> > prnds_;
   common::RANDOM_ENGINE rnd_;
@@ -258,6 +389,10 @@ inline void ImageRecordIOParser2<DType>::Init(
       }
     }
   }
+  // unless the creation of the mean image already started it
+  if (param_.decode_threads > 0 && pipeline_threads_.empty()) {
+    StartPipeline(legacy_shuffle_ ? batch_param_.batch_size : 0);
+  }
 #else
   LOG(FATAL) << "ImageRec need opencv to process";
 #endif
@@ -269,7 +404,6 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
     return false;
   }
   CHECK(source_ != nullptr);
-  dmlc::InputSplit::Blob chunk;
   size_t current_size = 0;
   out->index.resize(batch_param_.batch_size);
 
@@ -316,16 +450,14 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
     // int n_to_copy;
     size_t n_to_out = 0;
     if (n_parsed_ == 0) {
-      if (source_->NextBatch(&chunk, batch_param_.batch_size)) {
-        inst_order_.clear();
-        inst_index_ = 0;
-        DType* data_dptr = static_cast<DType*>(out->data[0].data().dptr_);
-        real_t* label_dptr = static_cast<real_t*>(out->data[1].data().dptr_);
-        if (!legacy_shuffle_) {
-          n_to_out = ParseChunk(data_dptr, label_dptr, current_size, &chunk);
-        } else {
-          n_to_out = ParseChunk(nullptr, nullptr, batch_param_.batch_size, &chunk);
-        }
+      inst_order_.clear();
+      inst_index_ = 0;
+      DType* data_dptr = static_cast<DType*>(out->data[0].data().dptr_);
+      real_t* label_dptr = static_cast<real_t*>(out->data[1].data().dptr_);
+      const bool has_chunk = !legacy_shuffle_ ?
+        ParseNextChunk(data_dptr, label_dptr, current_size, &n_to_out) :
+        ParseNextChunk(nullptr, nullptr, batch_param_.batch_size, &n_to_out);
+      if (has_chunk) {
         // Count number of parsed images that do not fit into current out
         n_parsed_ = inst_order_.size();
         // shuffle instance order if needed
@@ -339,7 +471,7 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
         CHECK(!overflow) << "number of input images must be bigger than the batch size";
         if (batch_param_.round_batch != 0) {
           overflow = true;
-          source_->BeforeFirst();
+          RewindSource();
         } else {
           current_size = batch_param_.batch_size;
         }
@@ -409,6 +541,29 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
     }
   }
 
+  // fused single pass over the (cropped) rows for 3 channel images without mean image
+  if (n_channels == 3 && !meanfile_ready_ && res.depth() == CV_8U) {
+    if (std::is_same<DType, float>::value) {
+      for (int i = 0; i < res.rows; ++i) {
+        float* dst[3] = {reinterpret_cast<float*>(data[0][i].dptr_),
+                         reinterpret_cast<float*>(data[1][i].dptr_),
+                         reinterpret_cast<float*>(data[2][i].dptr_)};
+        fused::NormalizeRowBGR(res.ptr<uint8_t>(i), res.cols, dst, is_mirrored,
+                               RGBA_MEAN, RGBA_MULT, RGBA_BIAS);
+      }
+      return;
+    }
+    if (std::is_same<DType, uint8_t>::value) {
+      for (int i = 0; i < res.rows; ++i) {
+        uint8_t* dst[3] = {reinterpret_cast<uint8_t*>(data[0][i].dptr_),
+                           reinterpret_cast<uint8_t*>(data[1][i].dptr_),
+                           reinterpret_cast<uint8_t*>(data[2][i].dptr_)};
+        fused::SplitRowBGR(res.ptr<uint8_t>(i), res.cols, dst, is_mirrored);
+      }
+      return;
+    }
+  }
+
   int swap_indices[n_channels]; // NOLINT(*)
   if (n_channels == 1) {
     swap_indices[0] = 0;
@@ -518,12 +673,131 @@ cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
 #endif
 #endif
 
+#if MXNET_USE_OPENCV
+template<typename DType>
+cv::Mat ImageRecordIOParser2<DType>::DecodeImage(const ImageRecordIO& rec) {
+  cv::Mat buf(1, rec.content_size, CV_8U, rec.content);
+  cv::Mat res;
+  switch (param_.data_shape[0]) {
+   case 1:
+#if MXNET_USE_LIBJPEG_TURBO
+    res = TJimdecode(buf, 0);
+#else
+    res = cv::imdecode(buf, 0);
+#endif
+    break;
+   case 3:
+#if MXNET_USE_LIBJPEG_TURBO
+    res = TJimdecode(buf, 1);
+#else
+    res = cv::imdecode(buf, 1);
+#endif
+    break;
+   case 4:
+    // -1 to keep the number of channel of the encoded image, and not force gray or color.
+    res = cv::imdecode(buf, -1);
+    CHECK_EQ(res.channels(), 4)
+      << "Invalid image with index " << rec.image_index()
+      << ". Expected 4 channels, got " << res.channels();
+    break;
+   default:
+    LOG(FATAL) << "Invalid output shape " << param_.data_shape;
+  }
+  return res;
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::LoadLabel(const ImageRecordIO& rec,
+                                            std::vector<float>* label_buf) {
+  if (label_map_ != nullptr) {
+    *label_buf = label_map_->FindCopy(rec.image_index());
+  } else if (rec.label != nullptr) {
+    CHECK_EQ(param_.label_width, rec.num_label)
+      << "rec file provide " << rec.num_label << "-dimensional label "
+         "but label_width is set to " << param_.label_width;
+    label_buf->assign(rec.label, rec.label + rec.num_label);
+  } else {
+    CHECK_EQ(param_.label_width, 1)
+      << "label_width must be 1 unless an imglist is provided "
+         "or the rec file is packed with multi dimensional label";
+    label_buf->assign(&rec.header.label, &rec.header.label + 1);
+  }
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::Augment(int tid, size_t idx, cv::Mat* res,
+                                          std::vector<float>* label_buf, Normalization* norm) {
+  // If augmentation seed is supplied
+  // Re-seed RNG to guarantee reproducible results
+  if (param_.seed_aug.has_value()) {
+    prnds_[tid]->seed(idx + param_.seed_aug.value() + kRandMagic);
+  }
+  for (auto& aug : augmenters_[tid]) {
+    *res = aug->Process(*res, label_buf, prnds_[tid].get());
+  }
+
+  std::uniform_real_distribution<float> rand_uniform(0, 1);
+  std::bernoulli_distribution coin_flip(0.5);
+  norm->is_mirrored = (normalize_param_.rand_mirror && coin_flip(*(prnds_[tid])))
+                      || normalize_param_.mirror;
+  norm->contrast_scaled = 1;
+  norm->illumination_scaled = 0;
+  if (!std::is_same<DType, uint8_t>::value) {
+    norm->contrast_scaled =
+      (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_contrast * 2
+      - normalize_param_.max_random_contrast + 1)*normalize_param_.scale;
+    norm->illumination_scaled =
+      (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_illumination * 2
+      - normalize_param_.max_random_illumination) * normalize_param_.scale;
+  }
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::Assemble(const cv::Mat& res, const std::vector<float>& label_buf,
+                                           size_t image_index, const Normalization& norm,
+                                           size_t idx, DType* data_dptr, real_t* label_dptr,
+                                           InstVector<DType>* out_tmp) {
+  const int n_channels = res.channels();
+  mshadow::Tensor<cpu, 3, DType> data;
+  if (idx < batch_param_.batch_size) {
+    data = mshadow::Tensor<cpu, 3, DType>(data_dptr + idx*unit_size_[0],
+      mshadow::Shape3(n_channels, res.rows, res.cols));
+  } else {
+    out_tmp->Push(image_index,
+                  mshadow::Shape3(n_channels, res.rows, res.cols),
+                  mshadow::Shape1(param_.label_width));
+    data = out_tmp->data().Back();
+  }
+
+  // For RGB or RGBA data, swap the B and R channel:
+  // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
+  if (n_channels == 1) {
+    ProcessImage<1>(res, &data, norm.is_mirrored, norm.contrast_scaled, norm.illumination_scaled);
+  } else if (n_channels == 3) {
+    ProcessImage<3>(res, &data, norm.is_mirrored, norm.contrast_scaled, norm.illumination_scaled);
+  } else if (n_channels == 4) {
+    ProcessImage<4>(res, &data, norm.is_mirrored, norm.contrast_scaled, norm.illumination_scaled);
+  }
+
+  mshadow::Tensor<cpu, 1, real_t> label;
+  if (idx < batch_param_.batch_size) {
+    label = mshadow::Tensor<cpu, 1, real_t>(label_dptr + idx*unit_size_[1],
+      mshadow::Shape1(param_.label_width));
+  } else {
+    label = out_tmp->label().Back();
+  }
+
+  mshadow::Copy(label, mshadow::Tensor<cpu, 1>(const_cast<float*>(dmlc::BeginPtr(label_buf)),
+    mshadow::Shape1(label_buf.size())));
+}
+#endif  // MXNET_USE_OPENCV
+
 // Returns the number of images that are put into output
 template<typename DType>
 inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t* label_dptr,
   const size_t current_size, dmlc::InputSplit::Blob * chunk) {
-  temp_.resize(param_.preprocess_threads);
 #if MXNET_USE_OPENCV
+  temp_.resize(param_.preprocess_threads);
   // save opencv out
   dmlc::RecordIOChunkReader reader(*chunk, 0, 1);
   size_t gl_idx = current_size;
@@ -553,105 +827,14 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
       }
       if (!reader_has_data) break;
       // Opencv decode and augments
-      cv::Mat res;
       rec.Load(blob.dptr, blob.size);
-      cv::Mat buf(1, rec.content_size, CV_8U, rec.content);
-
-      // If augmentation seed is supplied
-      // Re-seed RNG to guarantee reproducible results
-      if (param_.seed_aug.has_value()) {
-        prnds_[tid]->seed(idx + param_.seed_aug.value() + kRandMagic);
-      }
-
-      switch (param_.data_shape[0]) {
-       case 1:
-#if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 0);
-#else
-        res = cv::imdecode(buf, 0);
-#endif
-        break;
-       case 3:
-#if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 1);
-#else
-        res = cv::imdecode(buf, 1);
-#endif
-        break;
-       case 4:
-        // -1 to keep the number of channel of the encoded image, and not force gray or color.
-        res = cv::imdecode(buf, -1);
-        CHECK_EQ(res.channels(), 4)
-          << "Invalid image with index " << rec.image_index()
-          << ". Expected 4 channels, got " << res.channels();
-        break;
-       default:
-        LOG(FATAL) << "Invalid output shape " << param_.data_shape;
-      }
-      const int n_channels = res.channels();
+      cv::Mat res = DecodeImage(rec);
       // load label before augmentations
       std::vector<float> label_buf;
-      if (label_map_ != nullptr) {
-        label_buf = label_map_->FindCopy(rec.image_index());
-      } else if (rec.label != nullptr) {
-        CHECK_EQ(param_.label_width, rec.num_label)
-          << "rec file provide " << rec.num_label << "-dimensional label "
-             "but label_width is set to " << param_.label_width;
-        label_buf.assign(rec.label, rec.label + rec.num_label);
-      } else {
-        CHECK_EQ(param_.label_width, 1)
-          << "label_width must be 1 unless an imglist is provided "
-             "or the rec file is packed with multi dimensional label";
-        label_buf.assign(&rec.header.label, &rec.header.label + 1);
-      }
-      for (auto& aug : augmenters_[tid]) {
-        res = aug->Process(res, &label_buf, prnds_[tid].get());
-      }
-      mshadow::Tensor<cpu, 3, DType> data;
-      if (idx < batch_param_.batch_size) {
-        data = mshadow::Tensor<cpu, 3, DType>(data_dptr + idx*unit_size_[0],
-          mshadow::Shape3(n_channels, res.rows, res.cols));
-      } else {
-        out_tmp.Push(static_cast<size_t>(rec.image_index()),
-                 mshadow::Shape3(n_channels, res.rows, res.cols),
-                 mshadow::Shape1(param_.label_width));
-        data = out_tmp.data().Back();
-      }
-
-      std::uniform_real_distribution<float> rand_uniform(0, 1);
-      std::bernoulli_distribution coin_flip(0.5);
-      bool is_mirrored = (normalize_param_.rand_mirror && coin_flip(*(prnds_[tid])))
-                         || normalize_param_.mirror;
-      float contrast_scaled = 1;
-      float illumination_scaled = 0;
-      if (!std::is_same<DType, uint8_t>::value) {
-        contrast_scaled =
-          (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_contrast * 2
-          - normalize_param_.max_random_contrast + 1)*normalize_param_.scale;
-        illumination_scaled =
-          (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_illumination * 2
-          - normalize_param_.max_random_illumination) * normalize_param_.scale;
-      }
-      // For RGB or RGBA data, swap the B and R channel:
-      // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
-      if (n_channels == 1) {
-        ProcessImage<1>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
-      } else if (n_channels == 3) {
-        ProcessImage<3>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
-      } else if (n_channels == 4) {
-        ProcessImage<4>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
-      }
-
-      mshadow::Tensor<cpu, 1, real_t> label;
-      if (idx < batch_param_.batch_size) {
-        label = mshadow::Tensor<cpu, 1, real_t>(label_dptr + idx*unit_size_[1],
-          mshadow::Shape1(param_.label_width));
-      } else {
-        label = out_tmp.label().Back();
-      }
-
-      mshadow::Copy(label, mshadow::Tensor<cpu, 1>(dmlc::BeginPtr(label_buf),
-        mshadow::Shape1(label_buf.size())));
+      LoadLabel(rec, &label_buf);
+      Normalization norm;
+      Augment(tid, idx, &res, &label_buf, &norm);
+      Assemble(res, label_buf, rec.image_index(), norm, idx, data_dptr, label_dptr, &out_tmp);
       res.release();
     }
   });
@@ -664,6 +847,277 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
 #endif
 }
 
+template<typename DType>
+inline bool ImageRecordIOParser2<DType>::ParseNextChunk(DType* data_dptr, real_t* label_dptr,
+  const size_t current_size, size_t* n_to_out) {
+#if MXNET_USE_OPENCV
+  if (param_.decode_threads > 0) {
+    return ParseChunkPipelined(data_dptr, label_dptr, current_size, n_to_out);
+  }
+#endif
+  dmlc::InputSplit::Blob chunk;
+  if (!source_->NextBatch(&chunk, batch_param_.batch_size)) return false;
+  *n_to_out = ParseChunk(data_dptr, label_dptr, current_size, &chunk);
+  return true;
+}
+
+template<typename DType>
+inline void ImageRecordIOParser2<DType>::RewindSource() {
+#if MXNET_USE_OPENCV
+  if (!pipeline_threads_.empty()) {
+    // the read stage waits at the end of the source, it starts over before the next chunk
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    rewind_ = true;
+    read_end_ = false;
+    pipeline_cv_.notify_all();
+    return;
+  }
+#endif
+  source_->BeforeFirst();
+}
+
+// The records flow through the stages
+//   read (1 thread) -> decode (decode_threads) -> augment (preprocess_threads)
+//   -> assemble into the batch (assemble_threads)
+// connected by the bounded queues, so that each stage runs at its own pace.
+// The stage threads keep running from chunk to chunk until the parser is reset
+// or destroyed. The read stage stays one chunk ahead of the chunk being assembled,
+// so the next chunk is decoded and augmented while ParseNext fills the current batch.
+template<typename DType>
+inline void ImageRecordIOParser2<DType>::StartPipeline(size_t offset) {
+#if MXNET_USE_OPENCV
+  CHECK(pipeline_threads_.empty());
+  const int n_assemble = param_.assemble_threads;
+  for (auto &queue : queues_) queue.Reset(param_.pipeline_queue_size);
+  temp_.resize(n_assemble);
+  pipeline_overflow_.assign(n_assemble, {});
+  pipeline_threads_.emplace_back([this, offset]() {
+    RunPipelineStage([&]() { ReadStage(offset); });
+  });
+  for (int i = 0; i < param_.decode_threads; ++i) {
+    pipeline_threads_.emplace_back([this]() {
+      RunPipelineStage([&]() { DecodeStage(); });
+    });
+  }
+  for (int tid = 0; tid < param_.preprocess_threads; ++tid) {
+    pipeline_threads_.emplace_back([this, tid]() {
+      RunPipelineStage([&]() { AugmentStage(tid); });
+    });
+  }
+  for (int tid = 0; tid < n_assemble; ++tid) {
+    pipeline_threads_.emplace_back([this, tid]() {
+      RunPipelineStage([&]() { AssembleStage(tid); });
+    });
+  }
+#endif
+}
+
+template<typename DType>
+inline void ImageRecordIOParser2<DType>::StopPipeline() {
+#if MXNET_USE_OPENCV
+  if (pipeline_threads_.empty()) return;
+  {
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    pipeline_stopping_ = true;
+    pipeline_cv_.notify_all();
+  }
+  for (auto &queue : queues_) queue.Kill();
+  for (auto &thread : pipeline_threads_) thread.join();
+  pipeline_threads_.clear();
+  n_requested_ = 0;
+  n_assembled_ = 0;
+  read_chunks_.clear();
+  stash_.clear();
+  read_end_ = rewind_ = pipeline_stopping_ = false;
+  pipeline_error_ = nullptr;
+#endif
+}
+
+#if MXNET_USE_OPENCV
+template<typename DType>
+bool ImageRecordIOParser2<DType>::ParseChunkPipelined(DType* data_dptr, real_t* label_dptr,
+  const size_t current_size, size_t* n_to_out) {
+  // after a failure the pipeline starts again
+  if (pipeline_threads_.empty()) StartPipeline(current_size);
+  // the overflow images of the previous chunk are already copied out
+  for (auto &out_tmp : temp_) out_tmp.Clear();
+  for (auto &places : pipeline_overflow_) places.clear();
+  std::vector<PipelineItem> early;
+  size_t seq;
+  {
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    seq = n_requested_++;
+    dest_data_ = data_dptr;
+    dest_label_ = label_dptr;
+    n_assembled_ = 0;
+    early.swap(stash_);
+    pipeline_cv_.notify_all();
+  }
+  // the images, which reached the assembly before their batch was known, go around again
+  for (auto &item : early) queues_[kAugment].Push(std::move(item));
+
+  std::pair<size_t, size_t> chunk;
+  {
+    std::unique_lock<std::mutex> lock(pipeline_mutex_);
+    pipeline_cv_.wait(lock, [&]() {
+      if (pipeline_error_) return true;
+      const auto it = read_chunks_.find(seq);
+      if (it == read_chunks_.end()) return read_end_;
+      return n_assembled_ == it->second.second;
+    });
+    if (pipeline_error_) {
+      const std::exception_ptr error = pipeline_error_;
+      lock.unlock();
+      StopPipeline();
+      std::rethrow_exception(error);
+    }
+    const auto it = read_chunks_.find(seq);
+    if (it == read_chunks_.end()) {
+      // end of the source, the chunk is requested again once the source starts over
+      --n_requested_;
+      return false;
+    }
+    chunk = it->second;
+    read_chunks_.erase(it);
+  }
+  CHECK_EQ(chunk.first, current_size) << "ImageRecordIter2: pipeline out of sync with the batch";
+
+  // The images, which do not fit into the batch, are kept in the order of the records
+  std::vector<std::pair<size_t, std::pair<size_t, size_t> > > order;
+  for (const auto &places : pipeline_overflow_) {
+    order.insert(order.end(), places.begin(), places.end());
+  }
+  std::sort(order.begin(), order.end());
+  for (const auto &place : order) inst_order_.push_back(place.second);
+
+  const size_t gl_idx = current_size + chunk.second;
+  *n_to_out = std::min(static_cast<size_t>(batch_param_.batch_size), gl_idx) - current_size;
+  return true;
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::RunPipelineStage(const std::function<void()>& body) {
+  try {
+    body();
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(pipeline_mutex_);
+      if (!pipeline_error_) pipeline_error_ = std::current_exception();
+      pipeline_cv_.notify_all();
+    }
+    for (auto &queue : queues_) queue.Kill();
+  }
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::ReadStage(size_t offset) {
+  PipelineItem item;
+  size_t seq = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(pipeline_mutex_);
+      pipeline_cv_.wait(lock, [&]() {
+        return pipeline_stopping_ || pipeline_error_ || rewind_ ||
+               (!read_end_ && seq <= n_requested_);
+      });
+      if (pipeline_stopping_ || pipeline_error_) return;
+      if (rewind_) {
+        rewind_ = false;
+        lock.unlock();
+        source_->BeforeFirst();
+        continue;
+      }
+    }
+    double start = dmlc::GetTime();
+    double busy = 0;
+    dmlc::InputSplit::Blob chunk;
+    if (!source_->NextBatch(&chunk, batch_param_.batch_size)) {
+      std::lock_guard<std::mutex> lock(pipeline_mutex_);
+      read_end_ = true;
+      pipeline_cv_.notify_all();
+      continue;
+    }
+    dmlc::RecordIOChunkReader reader(chunk, 0, 1);
+    dmlc::InputSplit::Blob blob;
+    size_t n_records = 0;
+    item.chunk = seq;
+    while (reader.NextRecord(&blob)) {
+      item.idx = offset + n_records++;
+      item.record.assign(static_cast<const char*>(blob.dptr), blob.size);
+      busy += dmlc::GetTime() - start;
+      if (!queues_[kRead].Push(std::move(item))) return;
+      start = dmlc::GetTime();
+    }
+    stage_stats_[kRead].Add(n_records, busy + dmlc::GetTime() - start);
+    {
+      std::lock_guard<std::mutex> lock(pipeline_mutex_);
+      read_chunks_[seq] = std::make_pair(offset, n_records);
+      pipeline_cv_.notify_all();
+    }
+    // the next chunk starts where ParseNext will be, once this one is consumed
+    offset = legacy_shuffle_ ? batch_param_.batch_size
+                             : (offset + n_records) % batch_param_.batch_size;
+    ++seq;
+  }
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::DecodeStage() {
+  ImageRecordIO rec;
+  PipelineItem item;
+  while (queues_[kRead].Pop(&item)) {
+    const double start = dmlc::GetTime();
+    rec.Load(dmlc::BeginPtr(item.record), item.record.size());
+    item.image = DecodeImage(rec);
+    item.image_index = rec.image_index();
+    // load label before augmentations
+    LoadLabel(rec, &item.label);
+    std::string().swap(item.record);
+    stage_stats_[kDecode].Add(1, dmlc::GetTime() - start);
+    if (!queues_[kDecode].Push(std::move(item))) return;
+  }
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::AugmentStage(int tid) {
+  PipelineItem item;
+  while (queues_[kDecode].Pop(&item)) {
+    const double start = dmlc::GetTime();
+    Augment(tid, item.idx, &item.image, &item.label, &item.norm);
+    stage_stats_[kAugment].Add(1, dmlc::GetTime() - start);
+    if (!queues_[kAugment].Push(std::move(item))) return;
+  }
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::AssembleStage(int tid) {
+  PipelineItem item;
+  while (queues_[kAugment].Pop(&item)) {
+    {
+      std::lock_guard<std::mutex> lock(pipeline_mutex_);
+      if (item.chunk >= n_requested_) {
+        // the batch of the next chunk is not known yet
+        stash_.push_back(std::move(item));
+        continue;
+      }
+    }
+    const double start = dmlc::GetTime();
+    if (item.idx >= batch_param_.batch_size) {
+      pipeline_overflow_[tid].emplace_back(item.idx, std::make_pair(tid, temp_[tid].Size()));
+    }
+    Assemble(item.image, item.label, item.image_index, item.norm, item.idx,
+             dest_data_, dest_label_, &temp_[tid]);
+    stage_stats_[kAssemble].Add(1, dmlc::GetTime() - start);
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    ++n_assembled_;
+    const auto it = read_chunks_.find(n_requested_ - 1);
+    if (it != read_chunks_.end() && n_assembled_ == it->second.second) {
+      pipeline_cv_.notify_all();
+    }
+  }
+}
+#endif  // MXNET_USE_OPENCV
+
 // create mean image.
 template<typename DType>
 inline void ImageRecordIOParser2<DType>::CreateMeanImg() {
@@ -32,6 +32,7 @@
 #include <thread>
 #include "mxnet/ndarray.h"
 #include "gradient_compression.h"
+#include "./comm_cpu_reduce-inl.h"
 #include "../ndarray/ndarray_function.h"
 #include "../operator/tensor/sparse_retain-inl.h"
 #include "../profiler/profiler.h"
@@ -104,13 +105,23 @@ class Comm {
 class CommCPU : public Comm {
  public:
   CommCPU() {
-    nthread_reduction_ = dmlc::GetEnv("MXNET_KVSTORE_REDUCTION_NTHREADS", 4);
+    nthread_reduction_ = dmlc::GetEnv("MXNET_KVSTORE_REDUCTION_NTHREADS", 0);
     bigarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_BIGARRAY_BOUND", 1000 * 1000);
+    bind_numa_ = dmlc::GetEnv("MXNET_KVSTORE_REDUCTION_NUMA", true);
     // TODO(junwu) delete the following data member, now for benchmark only
     is_serial_push_ = dmlc::GetEnv("MXNET_KVSTORE_SERIAL_PUSH", 0);
   }
   virtual ~CommCPU() { }
 
+  /**
+   * \brief sum dptr[i][offset, offset + size) of all i into dptr[0]
+   */
+  template<typename DType>
+  inline static void ReduceSumCPU(
+      const std::vector<DType*> &dptr, size_t offset, index_t size) {
+    reduce::ReduceSum(dptr, offset, size);
+  }
+
   void Init(int key, const NDArrayStorageType stype, const mxnet::TShape& shape,
             int type = mshadow::kFloat32) override {
     // Delayed allocation - the dense merged buffer might not be used at all if push()
@@ -164,9 +175,12 @@ class CommCPU : public Comm {
         const_vars[i-1] = reduce[i].var();
       }
 
+      // the pages of the buffers are placed once, by the first reduction
+      const bool bind_numa = bind_numa_ && !buf.numa_bound;
+      buf.numa_bound = true;
       Engine::Get()->PushAsync(
-        [reduce, this](RunContext rctx, Engine::CallbackOnComplete on_complete) {
-          ReduceSumCPU(reduce);
+        [reduce, bind_numa, this](RunContext rctx, Engine::CallbackOnComplete on_complete) {
+          ReduceSumCPU(reduce, bind_numa);
           on_complete();
         }, Context::CPU(), const_vars, {reduce[0].var()},
         FnProperty::kCPUPrioritized, priority, "KVStoreReduce");
@@ -270,7 +284,7 @@ class CommCPU : public Comm {
 
  private:
   // reduce sum into val[0]
-  inline void ReduceSumCPU(const std::vector<NDArray> &in_data) {
+  inline void ReduceSumCPU(const std::vector<NDArray> &in_data, bool bind_numa) {
     MSHADOW_TYPE_SWITCH(in_data[0].dtype(), DType, {
       std::vector<DType*> dptr(in_data.size());
       for (size_t i = 0; i < in_data.size(); ++i) {
@@ -279,7 +293,7 @@ class CommCPU : public Comm {
         dptr[i] = data.FlatTo2D<cpu, DType>().dptr_;
       }
       size_t total = in_data[0].shape().Size();
-      ReduceSumCPUImpl(dptr, total);
+      reduce::ParallelReduceSum(dptr, total, nthread_reduction_, bigarray_bound_, bind_numa);
     });
   }
 
@@ -355,67 +369,14 @@ class CommCPU : public Comm {
     });
   }
 
-  template<typename DType>
-  inline static void ReduceSumCPU(
-      const std::vector<DType*> &dptr, size_t offset, index_t size) {
-    using namespace mshadow;  // NOLINT(*)
-    Tensor<cpu, 1, DType> in_0(dptr[0] + offset, Shape1(size));
-    for (size_t i = 1; i < dptr.size(); i+=4) {
-      switch (dptr.size() - i) {
-        case 1: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          in_0 += in_1;
-          break;
-        }
-        case 2: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          in_0 += in_1 + in_2;
-          break;
-        }
-        case 3: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
-          in_0 += in_1 + in_2 + in_3;
-          break;
-        }
-        default: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_4(dptr[i+3] + offset, Shape1(size));
-          in_0 += in_1 + in_2 + in_3 + in_4;
-          break;
-        }
-      }
-    }
-  }
-
-  template<typename DType>
-  inline void ReduceSumCPUImpl(std::vector<DType*> dptr, size_t total) {
-    const size_t step = std::min(bigarray_bound_, static_cast<size_t>(4 << 10));
-    long ntask = (total + step - 1) / step; // NOLINT(*)
-    if (total < bigarray_bound_ || nthread_reduction_ <= 1) {
-      ReduceSumCPU(dptr, 0, total);
-    } else {
-      #pragma omp parallel for schedule(static) num_threads(nthread_reduction_)
-      for (long j = 0; j < ntask; ++j) { // NOLINT(*)
-        size_t k = static_cast<size_t>(j);
-        size_t begin = std::min(k * step, total);
-        size_t end = std::min((k + 1) * step, total);
-        if (j == ntask - 1) CHECK_EQ(end, total);
-        ReduceSumCPU(dptr, begin, static_cast<index_t>(end - begin));
-      }
-    }
-  }
-
   /// \brief temporal space for pushing and pulling
   struct BufferEntry {
     /// \brief the merged value
     NDArray merged;
     /// \brief the cpu buffer for gpu data
     std::vector<NDArray> copy_buf;
+    /// \brief whether the pages of the dense buffers are placed on the NUMA nodes
+    bool numa_bound = false;
     /// \brief the merged buffer for the given storage type
     inline NDArray& merged_buf(NDArrayStorageType stype) {
       if (stype == kDefaultStorage) {
@@ -438,6 +399,7 @@ class CommCPU : public Comm {
   std::unordered_map<int, BufferEntry> merge_buf_;
   size_t bigarray_bound_;
   int nthread_reduction_;
+  bool bind_numa_;
   bool is_serial_push_;
 };
 
@@ -0,0 +1,308 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file comm_cpu_reduce-inl.h
+ * \brief Cache blocked summation of arrays on CPU, used by the kvstore to reduce
+ *        the gradients of several devices (or processes) into one buffer.
+ */
+#ifndef MXNET_KVSTORE_COMM_CPU_REDUCE_INL_H_
+#define MXNET_KVSTORE_COMM_CPU_REDUCE_INL_H_
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#include <dmlc/omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "mxnet/base.h"
+#include "../engine/openmp.h"
+#include "../storage/storage_manager_helpers.h"
+
+namespace mxnet {
+namespace kvstore {
+namespace reduce {
+
+/*! \brief number of elements of a block, the fp32 running sum of which stays in L1 */
+constexpr size_t kBlockSize = 2048;
+/*! \brief maximal number of sources added to the running sum in one pass over a block */
+constexpr int kMaxFanIn = 8;
+
+/*!
+ * \brief Types summed up with the blocked kernel. The reduced precision types are
+ *        accumulated in fp32 and rounded once per block, the other types are summed
+ *        with the mshadow expressions.
+ */
+template<typename DType>
+struct BlockedSum : std::integral_constant<bool,
+    std::is_same<DType, float>::value ||
+    std::is_same<DType, mshadow::half::half_t>::value ||
+    std::is_same<DType, mshadow::bfloat::bf16_t>::value> {};
+
+#if defined(__AVX512F__)
+typedef __m512 VecF;
+constexpr int kVecWidth = 16;
+inline VecF VecAdd(VecF a, VecF b) { return _mm512_add_ps(a, b); }
+inline VecF VecLoad(const float *p) { return _mm512_loadu_ps(p); }
+inline void VecStore(float *p, VecF v) { _mm512_storeu_ps(p, v); }
+inline VecF VecLoad(const mshadow::half::half_t *p) {
+  return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+}
+inline void VecStore(mshadow::half::half_t *p, VecF v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm512_cvtps_ph(v, 0));
+}
+inline VecF VecLoad(const mshadow::bfloat::bf16_t *p) {
+  const __m512i bits =
+    _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+  return _mm512_castsi512_ps(_mm512_slli_epi32(bits, 16));
+}
+inline void VecStore(mshadow::bfloat::bf16_t *p, VecF v) {
+  // truncation, as the conversion of bf16_t
+  const __m512i bits = _mm512_srli_epi32(_mm512_castps_si512(v), 16);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm512_cvtepi32_epi16(bits));
+}
+template<typename DType>
+struct VecSupported : BlockedSum<DType> {};
+#elif defined(__AVX2__)
+typedef __m256 VecF;
+constexpr int kVecWidth = 8;
+inline VecF VecAdd(VecF a, VecF b) { return _mm256_add_ps(a, b); }
+inline VecF VecLoad(const float *p) { return _mm256_loadu_ps(p); }
+inline void VecStore(float *p, VecF v) { _mm256_storeu_ps(p, v); }
+#if defined(__F16C__)
+inline VecF VecLoad(const mshadow::half::half_t *p) {
+  return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+inline void VecStore(mshadow::half::half_t *p, VecF v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_cvtps_ph(v, 0));
+}
+#endif  // __F16C__
+inline VecF VecLoad(const mshadow::bfloat::bf16_t *p) {
+  const __m256i bits =
+    _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(bits, 16));
+}
+inline void VecStore(mshadow::bfloat::bf16_t *p, VecF v) {
+  // truncation, as the conversion of bf16_t
+  const __m256i bits = _mm256_srli_epi32(_mm256_castps_si256(v), 16);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                   _mm_packus_epi32(_mm256_castsi256_si128(bits),
+                                    _mm256_extracti128_si256(bits, 1)));
+}
+template<typename DType>
+struct VecSupported : std::integral_constant<bool,
+    std::is_same<DType, float>::value ||
+#if defined(__F16C__)
+    std::is_same<DType, mshadow::half::half_t>::value ||
+#endif  // __F16C__
+    std::is_same<DType, mshadow::bfloat::bf16_t>::value> {};
+#else
+template<typename DType>
+struct VecSupported : std::false_type {};
+#endif
+
+/*!
+ * \brief acc[0, len) += src[0][0, len) + ... + src[N-1][0, len),
+ *        the sources added to each other in a balanced tree first
+ */
+template<int N, typename DType>
+inline void AccumulateBlock(float *acc, const DType *const *src, size_t len) {
+  size_t i = 0;
+#if defined(__AVX2__) || defined(__AVX512F__)
+  if constexpr (VecSupported<DType>::value) {
+    for (; i + kVecWidth <= len; i += kVecWidth) {
+      VecF v[N];
+      for (int k = 0; k < N; ++k) v[k] = VecLoad(src[k] + i);
+      for (int stride = 1; stride < N; stride <<= 1) {
+        for (int k = 0; k + stride < N; k += stride << 1) v[k] = VecAdd(v[k], v[k + stride]);
+      }
+      VecStore(acc + i, VecAdd(VecLoad(acc + i), v[0]));
+    }
+  }
+#endif
+  for (; i < len; ++i) {
+    float v[N];
+    for (int k = 0; k < N; ++k) v[k] = static_cast<float>(src[k][i]);
+    for (int stride = 1; stride < N; stride <<= 1) {
+      for (int k = 0; k + stride < N; k += stride << 1) v[k] += v[k + stride];
+    }
+    acc[i] += v[0];
+  }
+}
+
+/*! \brief converts the len elements of src to dst */
+template<typename SrcType, typename DstType>
+inline void ConvertBlock(const SrcType *src, DstType *dst, size_t len) {
+  size_t i = 0;
+#if defined(__AVX2__) || defined(__AVX512F__)
+  if constexpr (VecSupported<SrcType>::value && VecSupported<DstType>::value) {
+    for (; i + kVecWidth <= len; i += kVecWidth) VecStore(dst + i, VecLoad(src + i));
+  }
+#endif
+  for (; i < len; ++i) dst[i] = DstType(static_cast<float>(src[i]));
+}
+
+/*!
+ * \brief sum dptr[i][offset, offset + size) of all i into dptr[0] block by block:
+ *        the fp32 running sum of a block stays in L1 while the sources are streamed
+ *        through it kMaxFanIn at a time, instead of all the sources at once.
+ */
+template<typename DType>
+inline void BlockedReduceSum(const std::vector<DType*> &dptr, size_t offset, size_t size) {
+  alignas(64) float buf[kBlockSize];
+  const DType *src[kMaxFanIn];
+  const size_t nsrc = dptr.size();
+  for (size_t begin = offset; begin < offset + size; begin += kBlockSize) {
+    const size_t len = std::min(kBlockSize, offset + size - begin);
+    DType *dst = dptr[0] + begin;
+    float *acc = buf;
+    if constexpr (std::is_same<DType, float>::value) {
+      acc = dst;
+    } else {
+      ConvertBlock(dst, acc, len);
+    }
+    for (size_t i = 1; i < nsrc; i += kMaxFanIn) {
+      const int n = static_cast<int>(std::min<size_t>(kMaxFanIn, nsrc - i));
+      for (int k = 0; k < n; ++k) src[k] = dptr[i + k] + begin;
+      switch (n) {
+        case 1: AccumulateBlock<1>(acc, src, len); break;
+        case 2: AccumulateBlock<2>(acc, src, len); break;
+        case 3: AccumulateBlock<3>(acc, src, len); break;
+        case 4: AccumulateBlock<4>(acc, src, len); break;
+        case 5: AccumulateBlock<5>(acc, src, len); break;
+        case 6: AccumulateBlock<6>(acc, src, len); break;
+        case 7: AccumulateBlock<7>(acc, src, len); break;
+        default: AccumulateBlock<8>(acc, src, len); break;
+      }
+    }
+    if constexpr (!std::is_same<DType, float>::value) {
+      ConvertBlock(acc, dst, len);
+    }
+  }
+}
+
+/*! \brief sum dptr[i][offset, offset + size) of all i into dptr[0] with mshadow expressions */
+template<typename DType>
+inline void ExprReduceSum(const std::vector<DType*> &dptr, size_t offset, index_t size) {
+  using namespace mshadow;  // NOLINT(*)
+  Tensor<cpu, 1, DType> in_0(dptr[0] + offset, Shape1(size));
+  for (size_t i = 1; i < dptr.size(); i+=4) {
+    switch (dptr.size() - i) {
+      case 1: {
+        Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
+        in_0 += in_1;
+        break;
+      }
+      case 2: {
+        Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
+        Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
+        in_0 += in_1 + in_2;
+        break;
+      }
+      case 3: {
+        Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
+        Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
+        Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
+        in_0 += in_1 + in_2 + in_3;
+        break;
+      }
+      default: {
+        Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
+        Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
+        Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
+        Tensor<cpu, 1, DType> in_4(dptr[i+3] + offset, Shape1(size));
+        in_0 += in_1 + in_2 + in_3 + in_4;
+        break;
+      }
+    }
+  }
+}
+
+/*! \brief sum dptr[i][offset, offset + size) of all i into dptr[0] */
+template<typename DType>
+inline void ReduceSum(const std::vector<DType*> &dptr, size_t offset, index_t size) {
+  if constexpr (BlockedSum<DType>::value) {
+    BlockedReduceSum(dptr, offset, static_cast<size_t>(size));
+  } else {
+    ExprReduceSum(dptr, offset, size);
+  }
+}
+
+/*!
+ * \brief Prefer the NUMA node of the calling thread for the pages, which lie
+ *        completely inside of dptr[i][begin, end) of all i.
+ */
+template<typename DType>
+inline void BindToCurrentNode(const std::vector<DType*> &dptr, size_t begin, size_t end) {
+  const int node = storage::numa::CurrentNode();
+  const uintptr_t page = storage::numa::kPageSize;
+  for (DType *p : dptr) {
+    const uintptr_t first = (reinterpret_cast<uintptr_t>(p + begin) + page - 1) & ~(page - 1);
+    const uintptr_t last = reinterpret_cast<uintptr_t>(p + end) & ~(page - 1);
+    if (last > first) {
+      storage::numa::BindToNode(reinterpret_cast<void *>(first), last - first, node);
+    }
+  }
+}
+
+/*!
+ * \brief number of threads used to reduce total elements
+ * \param nthread the requested number of threads, 0 for the recommended OpenMP thread count
+ */
+inline int NumThreads(int nthread, size_t total) {
+  if (nthread <= 0) nthread = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const size_t num_blocks = (total + kBlockSize - 1) / kBlockSize;
+  return static_cast<int>(std::max<size_t>(1, std::min<size_t>(nthread, num_blocks)));
+}
+
+/*!
+ * \brief sum dptr[i][0, total) of all i into dptr[0]
+ * \param nthread number of threads for big arrays, 0 for the recommended OpenMP thread count
+ * \param bigarray_bound arrays smaller than this are summed up by the calling thread
+ * \param bind_numa whether each thread prefers its NUMA node for the pages it sums up.
+ *        The arrays are split into one contiguous range of whole blocks per thread,
+ *        so that the same thread sums up the same range of the same arrays every time.
+ */
+template<typename DType>
+inline void ParallelReduceSum(const std::vector<DType*> &dptr, size_t total,
+                              int nthread, size_t bigarray_bound, bool bind_numa) {
+  nthread = NumThreads(nthread, total);
+  if (total < bigarray_bound || nthread <= 1) {
+    ReduceSum(dptr, 0, static_cast<index_t>(total));
+    return;
+  }
+  const size_t num_blocks = (total + kBlockSize - 1) / kBlockSize;
+  const size_t range = (num_blocks + nthread - 1) / nthread * kBlockSize;
+  bind_numa = bind_numa && storage::numa::NumNodes() > 1;
+  #pragma omp parallel for schedule(static, 1) num_threads(nthread)
+  for (int t = 0; t < nthread; ++t) {
+    const size_t begin = std::min(t * range, total);
+    const size_t end = std::min(begin + range, total);
+    if (begin == end) continue;
+    if (bind_numa) BindToCurrentNode(dptr, begin, end);
+    ReduceSum(dptr, begin, static_cast<index_t>(end - begin));
+  }
+}
+
+}  // namespace reduce
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_COMM_CPU_REDUCE_INL_H_
@@ -25,6 +25,11 @@
 #ifndef MXNET_KVSTORE_GRADIENT_COMPRESSION_INL_H_
 #define MXNET_KVSTORE_GRADIENT_COMPRESSION_INL_H_
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include "../operator/mxnet_op.h"
 
@@ -36,6 +41,14 @@ void Quantize2BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet:
                       const float threshold);
 void Dequantize2BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
                         const float threshold);
+void Quantize1BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                      const float threshold);
+void Dequantize1BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                        const float threshold);
+void QuantizeSparseImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                        const int group_bits, const bool random, const uint64_t seed);
+void DequantizeSparseImpl(mshadow::Stream<mshadow::gpu> *s,
+                          const std::vector<mxnet::TBlob> &inputs, const int group_bits);
 
 struct quantize_2bit {
   MSHADOW_XINLINE static void Map(int out_block_id,
@@ -138,6 +151,176 @@ void Dequantize2BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet
           threshold);               // positive threshold
 }
 
+struct quantize_1bit {
+  MSHADOW_XINLINE static void Map(int out_block_id,
+                                  int original_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual,
+                                  const float neg_threshold,
+                                  const float pos_threshold) {
+    // this block contains the signs of upto 32 values starting from out_block_id*32
+    const int start = out_block_id << 5;
+    const int end = (start + 32 <= original_size) ? start + 32 : original_size;
+    uint32_t bits = 0;
+    for (int i = start; i < end; i++) {
+      // adds gradient to existing residual to get updated grad
+      residual[i] += grad[i];
+      // the residual keeps the error of sending the sign only
+      if (residual[i] >= 0) {
+        bits |= 1u << (i - start);
+        residual[i] -= pos_threshold;
+      } else {
+        residual[i] -= neg_threshold;
+      }
+    }
+    reinterpret_cast<uint32_t *>(out)[out_block_id] = bits;
+  }
+};
+
+template<typename xpu>
+void Quantize1BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                              const float threshold) {
+  mxnet::op::mxnet_op::Kernel<quantize_1bit, xpu>
+    ::Launch(s,
+            (inputs[0].Size() + 31) >> 5,  // compressed array size
+            inputs[0].Size(),         // original size
+            inputs[2].dptr<float>(),  // compressed array
+            inputs[0].dptr<float>(),  // original array
+            inputs[1].dptr<float>(),  // residual array
+            -1 *threshold,            // negative threshold
+            threshold);               // positive threshold
+}
+
+struct dequantize_1bit {
+  MSHADOW_XINLINE static void Map(int i,
+                                  float *out,
+                                  float *in,
+                                  const float neg_threshold,
+                                  const float pos_threshold) {
+    // gets the block of 32 bits which holds the sign of this position
+    const uint32_t bits = reinterpret_cast<const uint32_t *>(in)[i >> 5];
+    out[i] = ((bits >> (i & 31)) & 1u) ? pos_threshold : neg_threshold;
+  }
+};
+
+template<typename xpu>
+void Dequantize1BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                                const float threshold) {
+  mxnet::op::mxnet_op::Kernel<dequantize_1bit, xpu>
+  ::Launch(s,
+          inputs[1].Size(),         // original size
+          inputs[1].dptr<float>(),  // out array
+          inputs[0].dptr<float>(),  // compressed array
+          -1 *threshold,            // negative threshold
+          threshold);               // positive threshold
+}
+
+/*!
+ * \brief topk and randomk compression send one value out of each group of
+ * 2^group_bits values, as one float: the value, whose lowest group_bits bits of
+ * the mantissa are replaced by the offset of the value in its group. The error
+ * of this truncation stays in the residual like the values which are not sent.
+ */
+MSHADOW_XINLINE uint32_t pack_sparse_value(float *value, const int offset, const int group_bits) {
+  union { float f; uint32_t u; } slot;
+  slot.f = *value;
+  slot.u &= ~((1u << group_bits) - 1u);
+  // the residual keeps what the truncated value does not send
+  *value -= slot.f;
+  return slot.u | static_cast<uint32_t>(offset);
+}
+
+MSHADOW_XINLINE uint64_t mix_seed(uint64_t x) {
+  // splitmix64 finalizer
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+struct quantize_sparse {
+  MSHADOW_XINLINE static void Map(int group_id,
+                                  int original_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual,
+                                  const int group_bits,
+                                  const bool random,
+                                  const uint64_t seed) {
+    const int start = group_id << group_bits;
+    const int end = (start + (1 << group_bits) <= original_size) ?
+                    start + (1 << group_bits) : original_size;
+    int best = start;
+    if (random) {
+      for (int i = start; i < end; i++) {
+        residual[i] += grad[i];
+      }
+      best = start + static_cast<int>(mix_seed(seed ^ mix_seed(group_id)) % (end - start));
+    } else {
+      float best_abs = -1.f;
+      for (int i = start; i < end; i++) {
+        residual[i] += grad[i];
+        const float a = fabsf(residual[i]);
+        if (a > best_abs) {
+          best_abs = a;
+          best = i;
+        }
+      }
+    }
+    reinterpret_cast<uint32_t *>(out)[group_id] =
+      pack_sparse_value(residual + best, best - start, group_bits);
+  }
+};
+
+template<typename xpu>
+void QuantizeSparseKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                                const int group_bits, const bool random, const uint64_t seed) {
+  const int64_t group = int64_t(1) << group_bits;
+  mxnet::op::mxnet_op::Kernel<quantize_sparse, xpu>
+    ::Launch(s,
+            (inputs[0].Size() + group - 1) >> group_bits,  // compressed array size
+            inputs[0].Size(),         // original size
+            inputs[2].dptr<float>(),  // compressed array
+            inputs[0].dptr<float>(),  // original array
+            inputs[1].dptr<float>(),  // residual array
+            group_bits, random, seed);
+}
+
+struct dequantize_sparse {
+  MSHADOW_XINLINE static void Map(int group_id,
+                                  int original_size,
+                                  float *out,
+                                  float *in,
+                                  const int group_bits) {
+    const int start = group_id << group_bits;
+    const int end = (start + (1 << group_bits) <= original_size) ?
+                    start + (1 << group_bits) : original_size;
+    const uint32_t mask = (1u << group_bits) - 1u;
+    union { float f; uint32_t u; } slot;
+    slot.u = reinterpret_cast<const uint32_t *>(in)[group_id];
+    const int offset = static_cast<int>(slot.u & mask);
+    slot.u &= ~mask;
+    for (int i = start; i < end; i++) {
+      out[i] = 0;
+    }
+    out[start + offset] = slot.f;
+  }
+};
+
+template<typename xpu>
+void DequantizeSparseKernelLaunch(mshadow::Stream<xpu> *s,
+                                  const std::vector<mxnet::TBlob> &inputs, const int group_bits) {
+  const int64_t group = int64_t(1) << group_bits;
+  mxnet::op::mxnet_op::Kernel<dequantize_sparse, xpu>
+  ::Launch(s,
+          (inputs[1].Size() + group - 1) >> group_bits,  // compressed array size
+          inputs[1].Size(),         // original size
+          inputs[1].dptr<float>(),  // out array
+          inputs[0].dptr<float>(),  // compressed array
+          group_bits);
+}
+
 inline void Quantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                              const std::vector<mxnet::TBlob> &inputs,
                              const float threshold) {
@@ -149,6 +332,118 @@ inline void Dequantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                                const float threshold) {
   Dequantize2BitKernelLaunch(s, inputs, threshold);
 }
+
+inline void Quantize1BitImpl(mshadow::Stream<mshadow::cpu> *s,
+                             const std::vector<mxnet::TBlob> &inputs,
+                             const float threshold) {
+#if defined(__AVX2__)
+  const int original_size = inputs[0].Size();
+  const int num_blocks = original_size >> 5;
+  uint32_t *out = reinterpret_cast<uint32_t *>(inputs[2].dptr<float>());
+  const float *grad = inputs[0].dptr<float>();
+  float *residual = inputs[1].dptr<float>();
+  // full blocks of 32 values, 8 values per instruction
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int block = 0; block < num_blocks; ++block) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 pos = _mm256_set1_ps(threshold);
+    const __m256 neg = _mm256_set1_ps(-threshold);
+    uint32_t bits = 0;
+    for (int k = 0; k < 4; ++k) {
+      const int i = (block << 5) + (k << 3);
+      const __m256 r = _mm256_add_ps(_mm256_loadu_ps(residual + i), _mm256_loadu_ps(grad + i));
+      const __m256 sign = _mm256_cmp_ps(r, zero, _CMP_GE_OQ);
+      bits |= static_cast<uint32_t>(_mm256_movemask_ps(sign)) << (k << 3);
+      _mm256_storeu_ps(residual + i, _mm256_sub_ps(r, _mm256_blendv_ps(neg, pos, sign)));
+    }
+    out[block] = bits;
+  }
+  if (num_blocks << 5 < original_size) {
+    quantize_1bit::Map(num_blocks, original_size, inputs[2].dptr<float>(),
+                       inputs[0].dptr<float>(), residual, -threshold, threshold);
+  }
+#else
+  Quantize1BitKernelLaunch(s, inputs, threshold);
+#endif
+}
+
+inline void Dequantize1BitImpl(mshadow::Stream<mshadow::cpu> *s,
+                               const std::vector<mxnet::TBlob> &inputs,
+                               const float threshold) {
+#if defined(__AVX2__)
+  const int original_size = inputs[1].Size();
+  const int num_blocks = original_size >> 5;
+  const uint32_t *in = reinterpret_cast<const uint32_t *>(inputs[0].dptr<float>());
+  float *out = inputs[1].dptr<float>();
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int block = 0; block < num_blocks; ++block) {
+    const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256 pos = _mm256_set1_ps(threshold);
+    const __m256 neg = _mm256_set1_ps(-threshold);
+    for (int k = 0; k < 4; ++k) {
+      const __m256i bits = _mm256_and_si256(_mm256_set1_epi32(in[block] >> (k << 3)), lanes);
+      const __m256 sign = _mm256_castsi256_ps(_mm256_cmpeq_epi32(bits, lanes));
+      _mm256_storeu_ps(out + (block << 5) + (k << 3), _mm256_blendv_ps(neg, pos, sign));
+    }
+  }
+  for (int i = num_blocks << 5; i < original_size; ++i) {
+    dequantize_1bit::Map(i, out, inputs[0].dptr<float>(), -threshold, threshold);
+  }
+#else
+  Dequantize1BitKernelLaunch(s, inputs, threshold);
+#endif
+}
+
+inline void QuantizeSparseImpl(mshadow::Stream<mshadow::cpu> *s,
+                               const std::vector<mxnet::TBlob> &inputs,
+                               const int group_bits, const bool random, const uint64_t seed) {
+#if defined(__AVX2__)
+  const int original_size = inputs[0].Size();
+  if (group_bits < 3) {
+    QuantizeSparseKernelLaunch(s, inputs, group_bits, random, seed);
+    return;
+  }
+  const int group = 1 << group_bits;
+  const int num_groups = original_size >> group_bits;
+  uint32_t *out = reinterpret_cast<uint32_t *>(inputs[2].dptr<float>());
+  const float *grad = inputs[0].dptr<float>();
+  float *residual = inputs[1].dptr<float>();
+  // full groups: accumulate and find the largest magnitude 8 values at a time,
+  // then the first value of this magnitude, as the scalar kernel does
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int group_id = 0; group_id < num_groups; ++group_id) {
+    const int start = group_id << group_bits;
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 max_abs = _mm256_setzero_ps();
+    for (int i = start; i < start + group; i += 8) {
+      const __m256 r = _mm256_add_ps(_mm256_loadu_ps(residual + i), _mm256_loadu_ps(grad + i));
+      _mm256_storeu_ps(residual + i, r);
+      max_abs = _mm256_max_ps(max_abs, _mm256_and_ps(r, abs_mask));
+    }
+    int best = start;
+    if (random) {
+      best = start + static_cast<int>(mix_seed(seed ^ mix_seed(group_id)) % group);
+    } else {
+      float lanes[8];
+      _mm256_storeu_ps(lanes, max_abs);
+      const float m = *std::max_element(lanes, lanes + 8);
+      while (best < start + group - 1 && fabsf(residual[best]) != m) ++best;
+    }
+    out[group_id] = pack_sparse_value(residual + best, best - start, group_bits);
+  }
+  if (num_groups << group_bits < original_size) {
+    quantize_sparse::Map(num_groups, original_size, inputs[2].dptr<float>(),
+                         inputs[0].dptr<float>(), residual, group_bits, random, seed);
+  }
+#else
+  QuantizeSparseKernelLaunch(s, inputs, group_bits, random, seed);
+#endif
+}
+
+inline void DequantizeSparseImpl(mshadow::Stream<mshadow::cpu> *s,
+                                 const std::vector<mxnet::TBlob> &inputs, const int group_bits) {
+  DequantizeSparseKernelLaunch(s, inputs, group_bits);
+}
 }  // namespace kvstore
 }  // namespace mxnet
 
@@ -33,6 +33,49 @@ namespace kvstore {
 
 DMLC_REGISTER_PARAMETER(GradientCompressionParam);
 
+namespace {
+
+template<typename xpu>
+void QuantizeImpl(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                  const CompressionType type, const float threshold,
+                  const int group_bits, const uint64_t seed) {
+  switch (type) {
+    case CompressionType::kTwoBit:
+      Quantize2BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kOneBit:
+      Quantize1BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      QuantizeSparseImpl(s, inputs, group_bits, type == CompressionType::kRandomK, seed);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported quantization of type " << static_cast<int>(type);
+  }
+}
+
+template<typename xpu>
+void DequantizeImpl(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                    const CompressionType type, const float threshold, const int group_bits) {
+  switch (type) {
+    case CompressionType::kTwoBit:
+      Dequantize2BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kOneBit:
+      Dequantize1BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      DequantizeSparseImpl(s, inputs, group_bits);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported dequantization of type " << static_cast<int>(type);
+  }
+}
+
+}  // namespace
+
 GradientCompression::GradientCompression() {
   type_ = CompressionType::kNone;
 }
@@ -44,6 +87,12 @@ void GradientCompression::SetParams(const std::vector<std::pair<std::string, std
   CHECK_GT(params.threshold, 0) << "threshold must be greater than 0";
   if (params.type == "2bit") {
     SetTwoBitCompression(params.threshold);
+  } else if (params.type == "1bit") {
+    SetOneBitCompression(params.threshold);
+  } else if (params.type == "topk") {
+    SetSparseCompression(CompressionType::kTopK, params.ratio);
+  } else if (params.type == "randomk") {
+    SetSparseCompression(CompressionType::kRandomK, params.ratio);
   } else {
     LOG(FATAL) << "Unknown type for gradient compression " << params.type;
   }
@@ -62,11 +111,28 @@ void GradientCompression::SetTwoBitCompression(const float threshold) {
   threshold_ = threshold;
 }
 
+void GradientCompression::SetOneBitCompression(const float threshold) {
+  type_ = CompressionType::kOneBit;
+  threshold_ = threshold;
+}
+
+void GradientCompression::SetSparseCompression(const CompressionType type, const float ratio) {
+  CHECK(type == CompressionType::kTopK || type == CompressionType::kRandomK);
+  CHECK(ratio > 0 && ratio <= 1) << "ratio must be in (0, 1]";
+  // one value out of the smallest power of two group holding 1 / ratio values,
+  // the offset of the value in its group must fit in the mantissa of a float
+  int group_bits = 0;
+  while ((int64_t(1) << group_bits) * static_cast<double>(ratio) < 1) group_bits++;
+  CHECK_LE(group_bits, 16) << "ratio must be at least 1/65536";
+  type_ = type;
+  group_bits_ = group_bits;
+}
+
 std::string GradientCompression::EncodeParams() {
   using namespace std;  // to reduce length of next line
   string rval = get_type_str();
-  if (type_ == CompressionType::kTwoBit) {
-    rval += "," + to_string(threshold_);
+  if (type_ != CompressionType::kNone) {
+    rval += "," + to_string(threshold_) + "," + to_string(group_bits_);
   }
   return rval;
 }
@@ -80,11 +146,18 @@ void GradientCompression::DecodeParams(const std::string &s) {
       threshold_ = stof(elems[1]);
     }
   }
+  if (elems.size() > 2) {
+    group_bits_ = stoi(elems[2]);
+  }
 }
 
 int GradientCompression::GetCompressionFactor() {
   if (type_ == CompressionType::kTwoBit) {
     return 16;
+  } else if (type_ == CompressionType::kOneBit) {
+    return 32;
+  } else if (type_ == CompressionType::kTopK || type_ == CompressionType::kRandomK) {
+    return 1 << group_bits_;
   } else {
     LOG(FATAL) << "Unsupported compression type: " << get_type_str();
     return 0;
@@ -106,19 +179,25 @@ void GradientCompression::Quantize(const mxnet::NDArray &from, mxnet::NDArray *t
   const int a = from.ctx().dev_mask();
   const int b = to->ctx().dev_mask();
   const float threshold = threshold_;
-  if (type_ == CompressionType::kTwoBit) {
+  const CompressionType type = type_;
+  const int group_bits = group_bits_;
+  // randomk picks other values at every step
+  const uint64_t seed = step_++;
+  if (type_ != CompressionType::kNone) {
     if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, residual, threshold](mxnet::RunContext ctx) {
+      mxnet::Engine::Get()->PushSync([from, to, residual, type, threshold, group_bits, seed]
+                                     (mxnet::RunContext ctx) {
         std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
-        Quantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
+        QuantizeImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, threshold, group_bits, seed);
       }, from.ctx(), {from.var()}, {to->var(), residual->var()},
       mxnet::FnProperty::kNormal, priority, "QuantizeCPU");
     } else {
 #if MXNET_USE_CUDA
       if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
-        mxnet::Engine::Get()->PushSync([from, to, residual, threshold](mxnet::RunContext ctx) {
+        mxnet::Engine::Get()->PushSync([from, to, residual, type, threshold, group_bits, seed]
+                                       (mxnet::RunContext ctx) {
           std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
-          Quantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
+          QuantizeImpl(ctx.get_stream<mshadow::gpu>(), inputs, type, threshold, group_bits, seed);
           // Wait GPU kernel to complete
           ctx.get_stream<mshadow::gpu>()->Wait();
         }, from.ctx(), {from.var()}, {to->var(), residual->var()},
@@ -142,19 +221,23 @@ void GradientCompression::Dequantize(const mxnet::NDArray &from, mxnet::NDArray
   const int a = from.ctx().dev_mask();
   const int b = to->ctx().dev_mask();
   const float threshold = threshold_;
-  if (type_ == CompressionType::kTwoBit) {
+  const CompressionType type = type_;
+  const int group_bits = group_bits_;
+  if (type_ != CompressionType::kNone) {
     if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
+      mxnet::Engine::Get()->PushSync([from, to, type, threshold, group_bits]
+                                     (mxnet::RunContext ctx) {
         std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
-        Dequantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
+        DequantizeImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, threshold, group_bits);
       }, from.ctx(), {from.var()}, {to->var()},
       mxnet::FnProperty::kNormal, priority, "DequantizeCPU");
     } else {
 #if MXNET_USE_CUDA
       if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
-        mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
+        mxnet::Engine::Get()->PushSync([from, to, type, threshold, group_bits]
+                                       (mxnet::RunContext ctx) {
           std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
-          Dequantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
+          DequantizeImpl(ctx.get_stream<mshadow::gpu>(), inputs, type, threshold, group_bits);
           // Wait GPU kernel to complete
           ctx.get_stream<mshadow::gpu>()->Wait();
         }, from.ctx(), {from.var()}, {to->var()},
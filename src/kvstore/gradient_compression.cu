@@ -36,5 +36,25 @@ void Dequantize2BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& input
                         const float threshold) {
   Dequantize2BitKernelLaunch(s, inputs, threshold);
 }
+
+void Quantize1BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                      const float threshold) {
+  Quantize1BitKernelLaunch(s, inputs, threshold);
+}
+
+void Dequantize1BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                        const float threshold) {
+  Dequantize1BitKernelLaunch(s, inputs, threshold);
+}
+
+void QuantizeSparseImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                        const int group_bits, const bool random, const uint64_t seed) {
+  QuantizeSparseKernelLaunch(s, inputs, group_bits, random, seed);
+}
+
+void DequantizeSparseImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                          const int group_bits) {
+  DequantizeSparseKernelLaunch(s, inputs, group_bits);
+}
 }  // namespace kvstore
 }  // namespace mxnet
@@ -35,17 +35,21 @@ namespace mxnet {
 namespace kvstore {
 
 enum class CompressionType {
-  kNone, kTwoBit
+  kNone, kTwoBit, kOneBit, kTopK, kRandomK
 };
 
 struct GradientCompressionParam : public dmlc::Parameter<GradientCompressionParam> {
   std::string type;
   float threshold;
+  float ratio;
   DMLC_DECLARE_PARAMETER(GradientCompressionParam) {
     DMLC_DECLARE_FIELD(type)
       .describe("Type of gradient compression to use, like `2bit` for example");
     DMLC_DECLARE_FIELD(threshold).set_default(0.5)
-      .describe("Threshold to use for 2bit gradient compression");
+      .describe("Threshold to use for 2bit gradient compression, "
+                "and magnitude of the values sent by 1bit gradient compression");
+    DMLC_DECLARE_FIELD(ratio).set_default(0.01)
+      .describe("Fraction of the values sent by topk and randomk gradient compression");
   }
 };
 
@@ -78,6 +82,19 @@ class GradientCompression {
    */
   void SetTwoBitCompression(const float threshold);
 
+  /*!
+   * \brief sets one bit gradient compression with error feedback
+   * \param threshold magnitude of the dequantized values, which are +threshold or -threshold
+   */
+  void SetOneBitCompression(const float threshold);
+
+  /*!
+   * \brief sets topk or randomk gradient compression with residual accumulation
+   * \param type kTopK or kRandomK
+   * \param ratio fraction of the values to send, rounded down to a power of two
+   */
+  void SetSparseCompression(const CompressionType type, const float ratio);
+
   /*!
    * \brief encodes parameters of gc into a string
    */
@@ -132,6 +149,16 @@ class GradientCompression {
    * all negative gradients will be thresholded to -1*`threshold_`
    */
   float threshold_ = 0;
+
+  /*!
+   * \brief log2 of the number of values of which topk and randomk compression send one
+   */
+  int group_bits_ = 0;
+
+  /*!
+   * \brief number of quantizations issued, which seeds the choice of randomk compression
+   */
+  uint64_t step_ = 0;
 };
 }  // namespace kvstore
 }  // namespace mxnet
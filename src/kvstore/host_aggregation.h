@@ -0,0 +1,373 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file host_aggregation.h
+ * \brief reduction of the pushes of the worker processes of one host through
+ *  shared memory, for the hierarchical dist_sync kvstore
+ */
+
+#ifndef MXNET_KVSTORE_HOST_AGGREGATION_H_
+#define MXNET_KVSTORE_HOST_AGGREGATION_H_
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "mxnet/engine.h"
+#include "mxnet/ndarray.h"
+#include "./comm.h"
+#include "./comm_cpu_reduce-inl.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief Reduces the pushes of the worker processes of one host in shared memory.
+ *
+ * Only the leader (local rank 0) of the host talks to the servers: it pushes the
+ * sum of the local values and publishes the pulled value to the other processes
+ * of the host. Every key has a shared segment with one slot per local process,
+ * one slot for the pulled value and the counters which order the generations of
+ * pushes and pulls. The waits on the other processes run on a polling thread, so
+ * that they never block the engine.
+ *
+ * The names of the shared segments are removed as soon as all local processes
+ * mapped them, so that the memory is freed with the last process, even if it
+ * crashes. The names of the segments carry the process id of the leader, and the
+ * leader removes those of the leaders which are no longer alive at startup.
+ */
+class HostAggregator {
+ public:
+  /*! \brief push or pull of the leader, calls the callback when the servers replied */
+  typedef std::function<void(char* data, size_t size,
+                             const std::function<void()>& on_complete)> RemoteOp;
+
+  /**
+   * \param group name of the group, the same for all processes aggregating together
+   * \param barrier barrier over all worker processes of the job
+   */
+  HostAggregator(const std::string& group, const std::function<void()>& barrier) {
+    nthread_reduction_ = dmlc::GetEnv("MXNET_KVSTORE_REDUCTION_NTHREADS", 0);
+    bigarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_BIGARRAY_BOUND", 1000 * 1000);
+    std::stringstream name;
+    name << "/mxkv_" << std::hex << std::hash<std::string>()(group);
+    const std::string registry_name = name.str();
+    // a registry left behind by a job, which crashed, would count its processes
+    shm_unlink(registry_name.c_str());
+    barrier();
+    Registry* registry = static_cast<Registry*>(Map(registry_name, sizeof(Registry)));
+    local_rank_ = registry->count++;
+    if (local_rank_ == 0) {
+      registry->nonce = std::random_device()();
+      registry->leader_pid = getpid();
+    }
+    barrier();
+    // every process has mapped the registry, a later job starts with a new one
+    if (is_leader()) shm_unlink(registry_name.c_str());
+    local_size_ = registry->count;
+    name << "_" << std::dec << registry->leader_pid << "_" << std::hex << registry->nonce;
+    munmap(registry, sizeof(Registry));
+    prefix_ = name.str();
+    if (is_leader()) RemoveStaleSegments(registry_name);
+    poller_ = std::thread([this]() { Poll(); });
+  }
+
+  ~HostAggregator() {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      stop_ = true;
+      cond_.notify_all();
+    }
+    poller_.join();
+    for (auto& entry : segments_) {
+      Segment& seg = entry.second;
+      // the name is still there, if not all local processes used the key
+      if (is_leader() && seg.ctl->attached < static_cast<uint64_t>(local_size_)) {
+        shm_unlink(seg.name.c_str());
+      }
+      munmap(seg.ctl, seg.map_size);
+      Engine::Get()->DeleteVariable([](RunContext) {}, Context::CPU(), seg.var);
+    }
+  }
+
+  int local_rank() const { return local_rank_; }
+  int local_size() const { return local_size_; }
+  bool is_leader() const { return local_rank_ == 0; }
+
+  /**
+   * \brief engine variable, which orders the pushes and pulls of the key in this process
+   */
+  Engine::VarHandle var(int key, const NDArray& like) {
+    return GetSegment(key, like)->var;
+  }
+
+  /**
+   * \brief adds src to the sum of the host. The leader pushes the sum with push_fn,
+   *  once all local processes contributed. Called by an engine operation.
+   */
+  void Push(int key, const NDArray& src, const RemoteOp& push_fn,
+            const Engine::CallbackOnComplete& on_complete) {
+    Segment* seg = GetSegment(key, src);
+    const uint64_t gen = ++seg->push_gen;
+    const char* data = static_cast<const char*>(src.data().dptr_);
+    if (is_leader()) {
+      // the slot of the leader is free, since its previous push completed
+      std::memcpy(Slot(seg, 0), data, seg->size);
+      ++seg->ctl->arrived;
+      const uint64_t expected = gen * local_size_;
+      Enqueue([seg, expected]() { return seg->ctl->arrived >= expected; },
+              [this, seg, gen, push_fn, on_complete]() {
+                Sum(seg);
+                seg->ctl->summed = gen;
+                push_fn(Slot(seg, 0), seg->size, [on_complete]() { on_complete(); });
+              });
+    } else {
+      // wait until the leader summed the previous generation out of the slot
+      Enqueue([seg, gen]() { return seg->ctl->summed + 1 >= gen; },
+              [this, seg, data, on_complete]() {
+                std::memcpy(Slot(seg, local_rank_), data, seg->size);
+                ++seg->ctl->arrived;
+                on_complete();
+              });
+    }
+  }
+
+  /**
+   * \brief the leader pulls the key with pull_fn, then all local processes
+   *  copy the pulled value into dst. Called by an engine operation.
+   */
+  void Pull(int key, const NDArray& dst, const RemoteOp& pull_fn,
+            const Engine::CallbackOnComplete& on_complete) {
+    Segment* seg = GetSegment(key, dst);
+    const uint64_t gen = ++seg->pull_gen;
+    char* out = static_cast<char*>(dst.data().dptr_);
+    char* pulled = Slot(seg, local_size_);
+    if (is_leader()) {
+      // wait until the other processes copied the previous pull out of the shared slot
+      const uint64_t expected = (gen - 1) * (local_size_ - 1);
+      Enqueue([seg, expected]() { return seg->ctl->consumed >= expected; },
+              [seg, gen, out, pulled, pull_fn, on_complete]() {
+                pull_fn(pulled, seg->size, [seg, gen, out, pulled, on_complete]() {
+                  std::memcpy(out, pulled, seg->size);
+                  seg->ctl->released = gen;
+                  on_complete();
+                });
+              });
+    } else {
+      Enqueue([seg, gen]() { return seg->ctl->released >= gen; },
+              [seg, out, pulled, on_complete]() {
+                std::memcpy(out, pulled, seg->size);
+                ++seg->ctl->consumed;
+                on_complete();
+              });
+    }
+  }
+
+ private:
+  /*! \brief shared registry of the processes of the group */
+  struct Registry {
+    std::atomic<int> count;
+    std::atomic<uint64_t> nonce;
+    std::atomic<pid_t> leader_pid;
+  };
+  /*! \brief shared counters of one key, each on its own cache line */
+  struct Control {
+    alignas(64) std::atomic<uint64_t> arrived;
+    alignas(64) std::atomic<uint64_t> summed;
+    alignas(64) std::atomic<uint64_t> released;
+    alignas(64) std::atomic<uint64_t> consumed;
+    alignas(64) std::atomic<uint64_t> attached;
+  };
+  /*! \brief mapping of the shared segment of one key */
+  struct Segment {
+    std::string name;
+    Control* ctl = nullptr;
+    size_t map_size = 0;
+    // bytes of the value, and of a slot of the segment
+    size_t size = 0;
+    size_t slot_size = 0;
+    int dtype = 0;
+    // generations of the pushes and pulls of this process
+    uint64_t push_gen = 0;
+    uint64_t pull_gen = 0;
+    Engine::VarHandle var = nullptr;
+  };
+  /*! \brief a wait on the other processes, followed by the action */
+  struct Task {
+    std::function<bool()> ready;
+    std::function<void()> run;
+  };
+  static constexpr size_t kAlign = 64;
+  static constexpr int kPollIntervalUs = 20;
+
+  static void* Map(const std::string& name, size_t size) {
+    // all processes of the group truncate to the same size, whoever creates the segment
+    int fid = shm_open(name.c_str(), O_CREAT|O_RDWR, 0600);
+    CHECK_NE(fid, -1) << "Failed to open shared memory " << name
+                      << ". shm_open failed with error " << strerror(errno);
+    CHECK_EQ(ftruncate(fid, size), 0);
+    void* ptr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, fid, 0);
+    CHECK_NE(ptr, MAP_FAILED)
+        << "Failed to map shared memory. mmap failed with error " << strerror(errno);
+    CHECK_EQ(close(fid), 0);
+    return ptr;
+  }
+
+  Segment* GetSegment(int key, const NDArray& like) {
+    std::lock_guard<std::mutex> lk(segments_mu_);
+    const size_t size = like.shape().Size() * mshadow::mshadow_sizeof(like.dtype());
+    auto it = segments_.find(key);
+    if (it != segments_.end()) {
+      CHECK_EQ(it->second.size, size) << "Size of key " << key << " changed";
+      return &it->second;
+    }
+    Segment& seg = segments_[key];
+    seg.name = prefix_ + "_" + std::to_string(key);
+    seg.size = size;
+    seg.slot_size = (size + kAlign - 1) / kAlign * kAlign;
+    seg.dtype = like.dtype();
+    // local_size_ slots for the pushes, and one for the pulled value
+    seg.map_size = sizeof(Control) + seg.slot_size * (local_size_ + 1);
+    seg.ctl = static_cast<Control*>(Map(seg.name, seg.map_size));
+    // the last local process to map the segment removes its name
+    if (++seg.ctl->attached == static_cast<uint64_t>(local_size_)) {
+      shm_unlink(seg.name.c_str());
+    }
+    seg.var = Engine::Get()->NewVariable();
+    return &seg;
+  }
+
+  /*!
+   * \brief removes the segments of the group, which a leader no longer alive left
+   *  behind in /dev/shm, their names being group_prefix_<pid>_<nonce>_<key>
+   */
+  static void RemoveStaleSegments(const std::string& group_prefix) {
+    DIR* dir = opendir("/dev/shm");
+    if (dir == nullptr) return;
+    const std::string prefix = group_prefix.substr(1) + "_";
+    std::vector<std::string> stale;
+    while (const dirent* entry = readdir(dir)) {
+      const std::string file = entry->d_name;
+      if (file.compare(0, prefix.size(), prefix) != 0) continue;
+      const pid_t pid = static_cast<pid_t>(strtol(file.c_str() + prefix.size(), nullptr, 10));
+      if (pid > 0 && kill(pid, 0) == -1 && errno == ESRCH) {
+        stale.push_back("/" + file);
+      }
+    }
+    closedir(dir);
+    for (const auto& name : stale) {
+      LOG(INFO) << "Removing shared memory " << name << " of a crashed process";
+      shm_unlink(name.c_str());
+    }
+  }
+
+  static char* Slot(Segment* seg, int i) {
+    return reinterpret_cast<char*>(seg->ctl) + sizeof(Control) + seg->slot_size * i;
+  }
+
+  // sums the slots of all local processes into the slot of the leader
+  void Sum(Segment* seg) {
+    if (local_size_ == 1) return;
+    MSHADOW_TYPE_SWITCH(seg->dtype, DType, {
+      std::vector<DType*> dptr(local_size_);
+      for (int i = 0; i < local_size_; ++i) {
+        dptr[i] = reinterpret_cast<DType*>(Slot(seg, i));
+      }
+      const size_t total = seg->size / sizeof(DType);
+      reduce::ParallelReduceSum(dptr, total, nthread_reduction_, bigarray_bound_, false);
+    });
+  }
+
+  void Enqueue(std::function<bool()> ready, std::function<void()> run) {
+    // skip the polling thread if the other processes are already there
+    if (ready()) {
+      run();
+      return;
+    }
+    std::lock_guard<std::mutex> lk(mu_);
+    tasks_.push_back(Task{std::move(ready), std::move(run)});
+    cond_.notify_one();
+  }
+
+  // runs the tasks, whose waits are over, in any order, so that the keys cannot block each other
+  void Poll() {
+    std::unique_lock<std::mutex> lk(mu_);
+    while (true) {
+      cond_.wait(lk, [this]() { return stop_ || !tasks_.empty(); });
+      if (stop_) return;
+      bool progress = false;
+      for (auto it = tasks_.begin(); it != tasks_.end();) {
+        if (it->ready()) {
+          Task task = std::move(*it);
+          it = tasks_.erase(it);
+          lk.unlock();
+          task.run();
+          lk.lock();
+          progress = true;
+        } else {
+          ++it;
+        }
+      }
+      if (!progress) {
+        lk.unlock();
+        std::this_thread::sleep_for(std::chrono::microseconds(kPollIntervalUs));
+        lk.lock();
+      }
+    }
+  }
+
+  int local_rank_ = 0;
+  int local_size_ = 1;
+  std::string prefix_;
+  int nthread_reduction_;
+  size_t bigarray_bound_;
+  std::mutex segments_mu_;
+  std::unordered_map<int, Segment> segments_;
+  std::mutex mu_;
+  std::condition_variable cond_;
+  std::list<Task> tasks_;
+  bool stop_ = false;
+  std::thread poller_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_HOST_AGGREGATION_H_
@@ -64,6 +64,10 @@ KVStore* KVStore::Create(const char *type_name) {
       // configure the server to be the sync mode
       kv->SendCommandToServers(static_cast<int>(kvstore::CommandType::kSyncMode), "");
     }
+    if (!has("_async") && ps_type != "p3" && kv->IsWorkerNode() &&
+        dmlc::GetEnv("MXNET_KVSTORE_HOST_AGGREGATION", false)) {
+      static_cast<kvstore::KVStoreDist*>(kv)->EnableHostAggregation();
+    }
 #else
     LOG(FATAL) << "compile with USE_DIST_KVSTORE=1 to use " << tname;
     return nullptr;
@@ -32,6 +32,7 @@
 #include "mxnet/engine.h"
 #include "ps/ps.h"
 #include "./kvstore_dist_server.h"
+#include "./host_aggregation.h"
 namespace mxnet {
 namespace kvstore {
 
@@ -61,6 +62,7 @@ class KVStoreDist : public KVStoreLocal {
 
   virtual ~KVStoreDist() {
     Engine::Get()->WaitForAll();
+    host_agg_.reset();
     customer_id_ = 0;
     if (IsWorkerNode()) {
       if (barrier_before_exit_) {
@@ -75,6 +77,33 @@ class KVStoreDist : public KVStoreLocal {
     }
   }
 
+  /**
+   * \brief reduce the pushes of the workers of one host through shared memory, and
+   *  let only one worker per host push to and pull from the servers. Must be called
+   *  by all workers of a dist_sync kvstore, before the first push.
+   */
+  void EnableHostAggregation() {
+    CHECK(IsWorkerNode());
+    CHECK_EQ(ps_worker_->get_customer()->customer_id(), 0)
+      << "Host aggregation supports one dist kvstore per process";
+    // workers of the same job with the same group name aggregate together
+    std::string group = dmlc::GetEnv("MXNET_KVSTORE_HOST_GROUP", std::string());
+    if (group.empty()) {
+      char hostname[256] = {0};
+      gethostname(hostname, sizeof(hostname) - 1);
+      group = hostname;
+    }
+    group += "@" + dmlc::GetEnv("DMLC_PS_ROOT_URI", std::string()) + ":" +
+             dmlc::GetEnv("DMLC_PS_ROOT_PORT", std::string());
+    host_agg_.reset(new HostAggregator(group, [this]() { Barrier(); }));
+    if (host_agg_->is_leader()) {
+      // the servers expect one push per group instead of one per worker
+      SendCommandToServers(static_cast<int>(CommandType::kSetHostGroup),
+                           std::to_string(host_agg_->local_size()));
+    }
+    Barrier();
+  }
+
   void set_updater(const Updater& updater) override {
     CHECK(updater) << "invalid updater";
     if (IsServerNode()) {
@@ -262,7 +291,14 @@ class KVStoreDist : public KVStoreLocal {
 
       CHECK(gradient_compression_->get_type() == CompressionType::kNone)
                << "Compression not supported with PushPull";
-      PushPullDefault(key, comm_buf, priority);
+      if (host_agg_) {
+        PSKV& pskv = EncodeDefaultKey(key, comm_buf.shape().Size(),
+                                      mshadow::mshadow_sizeof(push_dtype));
+        PushHostAggregated(key, comm_buf, pskv, priority);
+        PullHostAggregated(key, comm_buf, priority);
+      } else {
+        PushPullDefault(key, comm_buf, priority);
+      }
       comm_->Broadcast(key, comm_buf, outs, priority);
     }
   }
@@ -294,7 +330,11 @@ class KVStoreDist : public KVStoreLocal {
         recv_buf = NDArray(grouped_vals[i][0]->shape(), pinned_ctx_,
                            true, grouped_vals[i][0]->dtype());
       }
-      PullDefault(key, recv_buf, priority);
+      if (host_agg_) {
+        PullHostAggregated(key, recv_buf, priority);
+      } else {
+        PullDefault(key, recv_buf, priority);
+      }
 
       comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
     }
@@ -376,10 +416,18 @@ class KVStoreDist : public KVStoreLocal {
       const int dtype = merged.dtype();
       const int num_bytes = mshadow::mshadow_sizeof(dtype);
       // push to servers
+      // the initialization is pushed by rank 0 alone, without aggregation
+      CHECK(!host_agg_ || !do_merge || (storage_type == kDefaultStorage &&
+            gradient_compression_->get_type() == CompressionType::kNone))
+        << "Host aggregation supports dense pushes without gradient compression only";
       if (storage_type == kDefaultStorage) {
         if (gradient_compression_->get_type() == CompressionType::kNone) {
           PSKV& pskv = EncodeDefaultKey(key, comm_buf.shape().Size(), num_bytes);
-          PushDefault(key, comm_buf, pskv, priority);
+          if (host_agg_ && do_merge) {
+            PushHostAggregated(key, comm_buf, pskv, priority);
+          } else {
+            PushDefault(key, comm_buf, pskv, priority);
+          }
         } else {
           CHECK_EQ(dtype, mshadow::kFloat32) << "Gradient compression is only supported for "
                                              << "float32 type of parameters";
@@ -466,6 +514,53 @@ class KVStoreDist : public KVStoreLocal {
         "KVStoreDistDefaultPush");
   }
 
+  // push through the host aggregation, only the leader of the host pushes the sum
+  void PushHostAggregated(int key, const NDArray &send_buf, const PSKV& pskv, int priority) {
+    auto push_local = [this, key, pskv, send_buf](RunContext rctx,
+                                                  Engine::CallbackOnComplete cb) {
+      const int cmd = GetCommandType(RequestType::kDefaultPushPull, send_buf.dtype());
+      host_agg_->Push(key, send_buf,
+        [this, pskv, cmd](char* data, size_t size, const std::function<void()>& done) {
+          // false means no delete
+          ps::SArray<char> vals(data, size, false);
+          CHECK_NOTNULL(ps_worker_)->ZPush(pskv.keys, vals, pskv.lens, cmd, done);
+        }, cb);
+    };
+    Engine::Get()->PushAsync(
+        push_local,
+        pinned_ctx_,
+        {send_buf.var()},
+        {host_agg_->var(key, send_buf)},
+        FnProperty::kNormal,
+        priority,
+        "KVStoreDistHostAggregatedPush");
+  }
+
+  // pull through the host aggregation, only the leader of the host pulls from the servers
+  void PullHostAggregated(int key, const NDArray &recv_buf, int priority) {
+    auto pull_local = [this, key, recv_buf](RunContext rctx, Engine::CallbackOnComplete cb) {
+      const int dtype = recv_buf.dtype();
+      const int cmd = GetCommandType(RequestType::kDefaultPushPull, dtype);
+      PSKV* pskv = &EncodeDefaultKey(key, recv_buf.shape().Size(),
+                                     mshadow::mshadow_sizeof(dtype));
+      host_agg_->Pull(key, recv_buf,
+        [this, pskv, cmd](char* data, size_t size, const std::function<void()>& done) {
+          // false means not to delete data when SArray is deleted
+          auto vals = new ps::SArray<char>(data, size, false);
+          CHECK_NOTNULL(ps_worker_)->ZPull(pskv->keys, vals, &pskv->lens, cmd,
+                                           [vals, done]() { delete vals; done(); });
+        }, cb);
+    };
+    Engine::Get()->PushAsync(
+        pull_local,
+        pinned_ctx_,
+        {},
+        {recv_buf.var(), host_agg_->var(key, recv_buf)},
+        FnProperty::kNormal,
+        priority,
+        "KVStoreDistHostAggregatedPull");
+  }
+
   // push row sparse gradient
   virtual void PushRowSparse(int key, const NDArray &send_buf, int priority) {
     using namespace rowsparse;
@@ -760,6 +855,14 @@ class KVStoreDist : public KVStoreLocal {
     return pskv;
   }
 
+  /**
+   * \brief ps key under which a server stores its rows of a row sparse key.
+   * The keys of the rows are offset from it by their row ids.
+   */
+  virtual inline ps::Key RowSparseMasterKey(const int key, const int server) {
+    return ps::Postoffice::Get()->GetServerKeyRanges()[server].begin() + key;
+  }
+
   // Note: this encoding method for row sparse keys doesn't allow cross-layer batching
   virtual inline PSKV& EncodeRowSparseKey(const int key, const int64_t num_elem,
                                           const int64_t num_rows, const int64_t *offsets,
@@ -781,7 +884,7 @@ class KVStoreDist : public KVStoreLocal {
       int64_t start_row = 0;
       // parition it to all servers
       for (int i = 0; i < num_servers; ++i) {
-        ps::Key master_key = krs[i].begin() + key;
+        ps::Key master_key = RowSparseMasterKey(key, i);
         pskv.keys.push_back(master_key);
         pskv.lens.push_back(0);
         if (offsets && num_elem > 0) {
@@ -794,7 +897,7 @@ class KVStoreDist : public KVStoreLocal {
           auto lb = std::lower_bound(offsets, offsets + num_rows, start_row);
           auto ub = std::upper_bound(offsets, offsets + num_rows, end_row - 1);
           for (auto offset = lb; offset < ub; offset++) {
-            ps::Key ps_key = krs[i].begin() + key + (*offset - start_row);
+            ps::Key ps_key = master_key + (*offset - start_row);
             CHECK_LT(ps_key, krs[i].end());
             pskv.keys.push_back(ps_key);
             const int part_size = unit_len * num_bytes;
@@ -808,11 +911,11 @@ class KVStoreDist : public KVStoreLocal {
     } else {
       // send it to a single random picked server
       const int server = (key * 9973) % num_servers;
-      ps::Key master_key = krs[server].begin() + key;
+      ps::Key master_key = RowSparseMasterKey(key, server);
       pskv.keys.push_back(master_key);
       pskv.lens.push_back(0);
       for (int64_t i = 0; i < num_rows; i++) {
-        ps::Key ps_key = krs[server].begin() + key + offsets[i];
+        ps::Key ps_key = master_key + offsets[i];
         CHECK_LT(ps_key, krs[server].end());
         pskv.keys.push_back(ps_key);
         pskv.lens.push_back(unit_len * num_bytes);
@@ -847,6 +950,10 @@ class KVStoreDist : public KVStoreLocal {
    * during gradient compression
    */
   std::unordered_map<int, NDArray> residual_;
+  /**
+   * \brief aggregation of the workers of this host, if enabled
+   */
+  std::unique_ptr<HostAggregator> host_agg_;
   bool log_verbose_;
 };
 
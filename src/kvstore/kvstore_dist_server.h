@@ -34,6 +34,8 @@
 #include <memory>
 #include <functional>
 #include <future>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include "../profiler/profiler.h"
 #include "../operator/tensor/elemwise_binary_op-inl.h"
@@ -45,7 +47,7 @@ namespace kvstore {
 // maintain same order in frontend.
 enum class CommandType {
   kController, kSetMultiPrecision, kStopServer, kSyncMode,
-  kSetGradientCompression, kSetProfilerParams
+  kSetGradientCompression, kSetProfilerParams, kSetHostGroup
 };
 
 enum class RequestType {
@@ -134,6 +136,17 @@ class Executor {
     fut.wait();
   }
 
+  /**
+   * \brief queue a function for the thread called \ref Start without waiting
+   *  for it. functions run in the order they were queued. threadsafe
+   */
+  void ExecAsync(const Func& func) {
+    Block blk(func);
+    std::lock_guard<std::mutex> lk(mu_);
+    queue_.push(std::move(blk));
+    cond_.notify_one();
+  }
+
   /**
    * \brief stop the thread, threadsafe
    */
@@ -152,6 +165,27 @@ class Executor {
   std::condition_variable cond_;
 };
 
+/**
+ * \brief map from key to value, which can be looked up from several threads.
+ *  The map is node based, so references to the values stay valid while other
+ *  keys are inserted.
+ */
+template<typename V>
+class KeyMap {
+ public:
+  V& operator[](int key) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return map_[key];
+  }
+  // iteration is not locked, it must not run concurrently with the data requests
+  typename std::unordered_map<int, V>::iterator begin() { return map_.begin(); }
+  typename std::unordered_map<int, V>::iterator end() { return map_.end(); }
+
+ private:
+  std::unordered_map<int, V> map_;
+  std::mutex mu_;
+};
+
 class KVStoreDistServer {
  public:
   KVStoreDistServer() {
@@ -164,9 +198,21 @@ class KVStoreDistServer {
     sync_mode_ = false;
     gradient_compression_ = std::make_shared<GradientCompression>();
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+    const int num_update_threads = dmlc::GetEnv("MXNET_KVSTORE_SERVER_UPDATE_THREADS", 0);
+    for (int i = 0; i < num_update_threads; ++i) {
+      update_execs_.emplace_back(new Executor());
+      Executor* exec = update_execs_.back().get();
+      update_threads_.emplace_back([exec]() { exec->Start(); });
+    }
   }
 
   ~KVStoreDistServer() {
+    for (auto& exec : update_execs_) {
+      exec->Stop();
+    }
+    for (auto& thread : update_threads_) {
+      thread.join();
+    }
     profiler::Profiler::Get()->SetState(profiler::Profiler::ProfilerState(0));
     delete ps_server_;
   }
@@ -198,6 +244,8 @@ class KVStoreDistServer {
 
   void CommandHandle(const ps::SimpleData& recved, ps::SimpleApp* app) {
     CommandType recved_type = static_cast<CommandType>(recved.head);
+    // commands change the state read by the data requests, finish the queued ones first
+    WaitUpdateExecutors();
     switch (recved_type) {
       case CommandType::kStopServer:
         exec_.Stop();
@@ -205,6 +253,12 @@ class KVStoreDistServer {
       case CommandType::kSyncMode:
         sync_mode_ = true;
         break;
+      case CommandType::kSetHostGroup:
+        // sent by the leader of each group of workers aggregating on their host
+        ++num_host_groups_;
+        grouped_workers_ += std::stoi(recved.body);
+        CHECK_LE(grouped_workers_, ps::NumWorkers());
+        break;
       case CommandType::kSetGradientCompression:
         gradient_compression_->DecodeParams(recved.body);
         break;
@@ -322,10 +376,45 @@ class KVStoreDistServer {
     }
   }
 
+  /**
+   * \brief wait until the update executors have handled all queued data requests
+   */
+  void WaitUpdateExecutors() {
+    for (auto& exec : update_execs_) {
+      exec->Exec([]() {});
+    }
+  }
+
+  /**
+   * \brief key, whose update executor handles the request
+   */
+  int RequestKey(const DataHandleType type, const ps::KVMeta& req_meta,
+                 const ps::KVPairs<char>& req_data) {
+    // compressed pushes send the original size as the first key
+    if (type.requestType == RequestType::kCompressedPushPull && req_meta.push) {
+      return DecodeKey(req_data.keys[1]);
+    }
+    return DecodeKey(req_data.keys[0]);
+  }
+
   void DataHandleEx(const ps::KVMeta& req_meta,
                     const ps::KVPairs<char>& req_data,
                     ps::KVServer<char>* server) {
     DataHandleType type = DepairDataHandleType(req_meta.cmd);
+    if (!update_execs_.empty()) {
+      // all requests of a key go to the same executor, which keeps their order
+      const size_t shard = static_cast<size_t>(RequestKey(type, req_meta, req_data))
+                           % update_execs_.size();
+      update_execs_[shard]->ExecAsync([this, type, req_meta, req_data, server]() {
+        DataHandleTyped(type, req_meta, req_data, server);
+      });
+      return;
+    }
+    DataHandleTyped(type, req_meta, req_data, server);
+  }
+
+  void DataHandleTyped(const DataHandleType type, const ps::KVMeta& req_meta,
+                       const ps::KVPairs<char>& req_data, ps::KVServer<char>* server) {
     switch (type.requestType) {
       case RequestType::kRowSparsePushPull:
         DataHandleRowSparse(type, req_meta, req_data, server);
@@ -339,22 +428,42 @@ class KVStoreDistServer {
     }
   }
 
+  /**
+   * \brief number of pushes of a key per iteration in sync mode
+   */
+  inline int NumPushers() const {
+    // once all workers aggregate on their hosts, only the leaders push
+    return grouped_workers_ == ps::NumWorkers() ? num_host_groups_ : ps::NumWorkers();
+  }
+
   inline bool has_multi_precision_copy(const DataHandleType type) {
     return multi_precision_ && type.dtype != mshadow::kFloat32;
   }
 
+  /**
+   * \brief run the updater on the main thread, or on the update executor of the key
+   */
+  void RunUpdater(const int key, const NDArray& update, NDArray* stored) {
+    if (update_execs_.empty()) {
+      // let the main thread to execute updater_, which is necessary for python
+      exec_.Exec([this, key, &update, stored]() {
+        CHECK(updater_);
+        updater_(key, update, stored);
+      });
+    } else {
+      CHECK(updater_);
+      updater_(key, update, stored);
+    }
+  }
+
   inline void ApplyUpdates(const DataHandleType type, const int key,
                            const ps::KVPairs<char>& req_data, UpdateBuf *update_buf,
                            ps::KVServer<char>* server) {
-    if (!sync_mode_ || update_buf->request.size() == (size_t) ps::NumWorkers()) {
-      // let the main thread to execute updater_, which is necessary for python
+    if (!sync_mode_ || update_buf->request.size() == (size_t) NumPushers()) {
       auto& stored = has_multi_precision_copy(type) ? store_realt_[key] : store_[key];
       auto& update =  sync_mode_ ? update_buf->merged : update_buf->temp_array;
       if (updater_) {
-        exec_.Exec([this, key, &update, &stored](){
-          CHECK(updater_);
-          updater_(key, update, &stored);
-        });
+        RunUpdater(key, update, &stored);
       } else {
         CHECK(sync_mode_) << "Updater needs to be set for async mode";
         // if no updater, just copy
@@ -676,10 +785,7 @@ class KVStoreDistServer {
       } else {
         // async push
         gradient_compression_->Dequantize(recved, &decomp_buf, 0);
-        exec_.Exec([this, key, &decomp_buf, &stored]() {
-          CHECK(updater_);
-          updater_(key, decomp_buf, &stored);
-        });
+        RunUpdater(key, decomp_buf, &stored);
         server->Response(req_meta);
         stored.WaitToRead();
       }
@@ -772,29 +878,40 @@ class KVStoreDistServer {
    * \brief user defined mode for push
    */
   bool sync_mode_;
+  /**
+   * \brief number of groups of workers aggregating on their host, and of their workers
+   */
+  int num_host_groups_ = 0;
+  int grouped_workers_ = 0;
   KVStore::Controller controller_;
   KVStore::Updater updater_;
 
   /**
    * \brief store_ contains the value at kvstore for each key
    */
-  std::unordered_map<int, NDArray> store_;
-  std::unordered_map<int, NDArray> store_realt_;
+  KeyMap<NDArray> store_;
+  KeyMap<NDArray> store_realt_;
 
   /**
    * \brief merge_buf_ is a buffer used if sync_mode is true. It represents
    * values from different workers being merged. The store will be updated
    * to this value when values from all workers are pushed into this buffer.
    */
-  std::unordered_map<int, UpdateBuf> update_buf_;
+  KeyMap<UpdateBuf> update_buf_;
 
   /**
    * \brief decomp_buf_ is a buffer into which compressed values are
    * decompressed before merging to the store. used when compress_!='none'
    */
-  std::unordered_map<int, NDArray> decomp_buf_;
+  KeyMap<NDArray> decomp_buf_;
 
   Executor exec_;
+  /**
+   * \brief executors handling the data requests of the keys hashed to them,
+   *  empty if the requests are handled by the ps-lite thread
+   */
+  std::vector<std::unique_ptr<Executor>> update_execs_;
+  std::vector<std::thread> update_threads_;
   ps::KVServer<char>* ps_server_;
 
   // whether to LOG verbose information
@@ -16,7 +16,6 @@
  * specific language governing permissions and limitations
  * under the License.
  */
-
 /**
  * Copyright (c) 2015 by Contributors
  * @file   p3store_dist.h
@@ -27,6 +26,10 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
 #include <utility>
 #include "./kvstore_dist.h"
 #include "mxnet/engine.h"
@@ -36,24 +39,22 @@ namespace kvstore {
 
 /**
  * \brief distributed p3store
+ *
+ * Every key is sliced into chunks of at most MXNET_KVSTORE_SLICE_THRESHOLD
+ * parameters, which are sent as separate requests with the priority of the key,
+ * so that the slices of the front layers overtake the slices of the big back
+ * layers. The pulls go through a window of MXNET_KVSTORE_P3_PULL_WINDOW slices
+ * on the worker, which always issues the slice of the highest priority first.
  */
 class P3StoreDist : public KVStoreDist {
  public:
   explicit P3StoreDist(bool use_device_comm)
       : KVStoreDist(use_device_comm) {
     slice_threshold_ = dmlc::GetEnv("MXNET_KVSTORE_SLICE_THRESHOLD", 40 * 1000);
-  }
-
-  void PullRowSparse(const std::vector<int>& str_keys,
-                     const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
-                     int priority) final {
-    LOG(FATAL) << "NotImplementedError: PullRowSparse not supported in P3StoreDist.";
-  }
-
-  void PullRowSparse(const std::vector<std::string>& str_keys,
-                     const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
-                     int priority) final {
-    LOG(FATAL) << "NotImplementedError: PullRowSparse not supported in P3StoreDist.";
+    pull_window_ = dmlc::GetEnv("MXNET_KVSTORE_P3_PULL_WINDOW", 0);
+    if (pull_window_ <= 0) {
+      pull_window_ = 2 * ps::NumServers();
+    }
   }
 
   void set_updater(const Updater& updater) final {
@@ -61,52 +62,83 @@ class P3StoreDist : public KVStoreDist {
           << "Please set MXNET_UPDATE_ON_KVSTORE to false.";
   }
 
-  void SetGradientCompression(const std::vector<std::pair<std::string, std::string>>
-                              & kwargs) final {
-    LOG(FATAL) << "NotImplementedError: Gradient compression not supported in P3StoreDist.";
-  }
-
  private:
+  /**
+   * \brief a slice waiting for a free place in the pull window
+   */
+  struct PendingPull {
+    int priority;
+    uint64_t seq;
+    std::function<void()> issue;
+    // std::priority_queue pops the largest element first
+    bool operator<(const PendingPull& other) const {
+      if (priority != other.priority) return priority < other.priority;
+      return seq > other.seq;
+    }
+  };
+
   inline void InitKV(const int key, const NDArray& value) override {
-    CHECK_EQ(value.storage_type(), kDefaultStorage)
-        << "Default storage type for values expected in P3StoreDist";
     comm_->Init(key, value.storage_type(), value.shape(), value.dtype());
-    /* Fix the key encoding */
-    EncodeDefaultKey(key, value.shape().Size(), mshadow::mshadow_sizeof(value.dtype()));
+    // place the slices now, in the order of initialization which all workers share
+    const size_t size = value.shape().Size();
+    const int num_bytes = mshadow::mshadow_sizeof(value.dtype());
+    if (value.storage_type() == kRowSparseStorage) {
+      std::vector<ps::Key> master_keys;
+      for (int server = 0; server < ps::NumServers(); ++server) {
+        master_keys.push_back(AllocKey(server));
+      }
+      std::lock_guard<std::mutex> lock(mu_);
+      rsp_master_keys_[key] = std::move(master_keys);
+    } else if (gradient_compression_->get_type() != CompressionType::kNone) {
+      EncodeCompressedKey(key, size, false, num_bytes);
+    } else {
+      EncodeDefaultKey(key, size, num_bytes);
+    }
   }
 
   void PushCompressed(int key, const NDArray& comm_buf, const PSKV& pskv,
                       int priority) final {
-    LOG(FATAL) << "NotImplementedError: PushCompressed not implemented in P3StoreDist.";
+    auto &small_buf = compr_buf_[key];
+    auto &res_buf = residual_[key];
+    const size_t original_size = comm_buf.shape().Size();
+    const int dtype = comm_buf.dtype();
+    const int num_bytes = mshadow::mshadow_sizeof(dtype);
+
+    // Init the small buffer and residual_ buffer for quantize
+    if (small_buf.is_none()) {
+      small_buf = NDArray(mxnet::TShape{static_cast<int64_t>(pskv.size / num_bytes)},
+                          comm_buf.ctx(), false, dtype);
+      res_buf = NDArray(mxnet::TShape{static_cast<int64_t>(original_size)},
+                        comm_buf.ctx(), false, dtype);
+      res_buf = 0;
+    }
+    gradient_compression_->Quantize(comm_buf, &small_buf, &res_buf, priority);
+    auto push_to_servers = [this, key, dtype, pskv, small_buf, priority]
+      (RunContext rctx, Engine::CallbackOnComplete cb) {
+        char* data = static_cast<char *>(small_buf.data().dptr_);
+        const int cmd = GetCommandType(RequestType::kCompressedPushPull, dtype);
+        // a slice is made of the original size of the slice and the compressed data
+        PushSlices(pskv, data, 2, cmd, priority, cb);
+      };
+    // acquire locks on both comm_buf and small_buf so that
+    // pull (which uses comm_buf) for the same key waits till push finishes
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {small_buf.var(), comm_buf.var()},
+        {},
+        FnProperty::kNormal,
+        priority,
+        "P3StoreDistCompressedPush");
   }
 
   void PushDefault(int key, const NDArray &send_buf, const PSKV& pskv,
                    int priority) override {
     auto push_to_servers = [this, key, pskv, send_buf, priority]
       (RunContext rctx, Engine::CallbackOnComplete cb) {
-        const int dtype = send_buf.dtype();
-        // convert to ps keys
-        const size_t size = send_buf.shape().Size() * mshadow::mshadow_sizeof(dtype);
         char* data = static_cast<char *>(send_buf.data().dptr_);
-        // do push. false means no delete
-        ps::SArray<char> vals(data, size, false);
-        int cmd = GetCommandType(RequestType::kDefaultPushPull, dtype);
-
-        size_t off = 0;
-        auto counter = new std::atomic<int>(pskv.keys.size());
-        for (size_t idx = 0; idx < pskv.keys.size(); idx++) {
-          auto ks = pskv.keys.segment(idx, idx+1);
-          auto ls = pskv.lens.segment(idx, idx+1);
-          auto vs = vals.segment(off, off + pskv.lens[idx]);
-          CHECK_NOTNULL(ps_worker_)->ZPush(
-            ks, vs, ls, cmd, [counter, cb]() {
-                if (--(*counter) == 0) {
-                  delete counter;
-                  cb();
-                }
-              }, priority);
-          off += pskv.lens[idx];
-        }
+        const int cmd = GetCommandType(RequestType::kDefaultPushPull, send_buf.dtype());
+        PushSlices(pskv, data, 1, cmd, priority, cb);
       };
     Engine::Get()->PushAsync(
         push_to_servers,
@@ -118,38 +150,29 @@ class P3StoreDist : public KVStoreDist {
         "P3StoreDistDefaultPush");
   }
 
-  void PushRowSparse(int key, const NDArray &send_buf, int priority) override {
-    LOG(FATAL) << "NotImplementedError: PushRowSparse not implemented in P3StoreDist.";
-  }
-
   void PullDefault(int key, const NDArray &recv_buf, int priority) override {
-    CHECK(gradient_compression_->get_type() == CompressionType::kNone)
-       << "Gradient compression not supported in P3StoreDist.";
     auto pull_from_servers = [this, key, recv_buf, priority](
         RunContext rctx, Engine::CallbackOnComplete cb) {
       // convert to ps keys
       size_t size = recv_buf.shape().Size();
       const int dtype = recv_buf.dtype();
       const int num_bytes = mshadow::mshadow_sizeof(dtype);
-      PSKV& pskv = EncodeDefaultKey(key, size, num_bytes);
+      const bool compressed = gradient_compression_->get_type() != CompressionType::kNone;
+      PSKV& pskv = compressed ? EncodeCompressedKey(key, size, false, num_bytes) :
+                                EncodeDefaultKey(key, size, num_bytes);
       char* data = static_cast<char*> (recv_buf.data().dptr_);
-      // issue pull
-      const int cmd = GetCommandType(RequestType::kDefaultPushPull, dtype);
-      size_t off = 0;
+      const int cmd = GetCommandType(compressed ? RequestType::kCompressedPushPull :
+                                                  RequestType::kDefaultPushPull, dtype);
       auto counter = new std::atomic<int>(pskv.keys.size());
+      size_t off = 0;
       for (size_t idx = 0; idx < pskv.keys.size(); idx++) {
-        auto ks = pskv.keys.segment(idx, idx+1);
-        auto ls = new ps::SArray<int>(1, pskv.lens[idx]);
-        auto vs = new ps::SArray<char>(data + off, pskv.lens[idx], false);
-        CHECK_NOTNULL(ps_worker_)->ZPull(
-          ks, vs, ls, cmd, [vs, ls, counter, cb]() {
-              delete vs;
-              delete ls;
-              if (--(*counter) == 0) {
-                delete counter;
-                cb();
-              }
-            }, priority);
+        PullSlice(pskv.keys.segment(idx, idx+1), pskv.lens.segment(idx, idx+1),
+                  data + off, cmd, priority, [counter, cb]() {
+            if (--(*counter) == 0) {
+              delete counter;
+              cb();
+            }
+          });
         off += pskv.lens[idx];
       }
     };
@@ -165,7 +188,75 @@ class P3StoreDist : public KVStoreDist {
 
   void PullRowSparse_(const int key, const NDArray& recv_buf,
                       const NDArray& indices, int priority) override {
-    LOG(FATAL) << "NotImplementedError: PullRowSparse not implemented in P3StoreDist.";
+    using namespace rowsparse;
+    auto pull_from_servers = [this, key, recv_buf, indices, priority]
+      (RunContext rctx, Engine::CallbackOnComplete cb) {
+      // allocate memory for the buffer
+      CHECK_EQ(indices.dtype(), mshadow::kInt64);
+      const TBlob idx_data = indices.data();
+      const size_t num_rows = idx_data.shape_.Size();
+      recv_buf.CheckAndAlloc({mshadow::Shape1(num_rows)});
+      const int dtype = recv_buf.dtype();
+      char* data = static_cast<char *>(recv_buf.data().dptr_);
+      const auto offsets = idx_data.dptr<int64_t>();
+      const auto unit_len = recv_buf.shape().ProdShape(1, recv_buf.shape().ndim());
+      const int64_t size = num_rows * unit_len;
+      const int num_bytes = mshadow::mshadow_sizeof(dtype);
+      // convert to ps keys in row sparse format
+      PSKV& pskv = EncodeRowSparseKey(key, size, num_rows, offsets,
+                                      unit_len, recv_buf.shape()[0],
+                                      num_bytes);
+      const int cmd = GetCommandType(RequestType::kRowSparsePushPull, dtype);
+      // copy indices to recv_buf. this needs to be done before ZPull
+      // because after pull is done, the callback function returns and locks are released.
+      // at this point, later functions may access the indices variable while copy happens
+      mshadow::Copy(recv_buf.aux_data(kIdx).FlatTo1D<cpu, int64_t>(),
+                    idx_data.FlatTo1D<cpu, int64_t>());
+      // every slice is a request of the master key of a server and at most
+      // slice_threshold_ parameters worth of its rows
+      const size_t rows_per_slice = std::max<size_t>(1, slice_threshold_ / unit_len);
+      std::vector<std::pair<ps::SArray<ps::Key>, ps::SArray<int>>> slices;
+      size_t idx = 0;
+      while (idx < pskv.keys.size()) {
+        CHECK_EQ(pskv.lens[idx], 0) << "expected the master key of a server";
+        const ps::Key master_key = pskv.keys[idx++];
+        size_t end = idx;
+        while (end < pskv.keys.size() && pskv.lens[end] != 0) end++;
+        for (; idx < end; idx += rows_per_slice) {
+          const size_t n = std::min(rows_per_slice, end - idx);
+          ps::SArray<ps::Key> ks(n + 1);
+          ps::SArray<int> ls(n + 1);
+          ks[0] = master_key;
+          ls[0] = 0;
+          std::copy(pskv.keys.begin() + idx, pskv.keys.begin() + idx + n, ks.begin() + 1);
+          std::copy(pskv.lens.begin() + idx, pskv.lens.begin() + idx + n, ls.begin() + 1);
+          slices.emplace_back(ks, ls);
+        }
+      }
+      if (slices.empty()) {
+        cb();
+        return;
+      }
+      auto counter = new std::atomic<int>(slices.size());
+      size_t off = 0;
+      for (const auto& slice : slices) {
+        PullSlice(slice.first, slice.second, data + off, cmd, priority, [counter, cb]() {
+            if (--(*counter) == 0) {
+              delete counter;
+              cb();
+            }
+          });
+        off += std::accumulate(slice.second.begin(), slice.second.end(), size_t(0));
+      }
+    };
+    CHECK_NOTNULL(Engine::Get())->PushAsync(
+        pull_from_servers,
+        pinned_ctx_,
+        {indices.var()},
+        {recv_buf.var()},
+        FnProperty::kNormal,
+        priority,
+        "P3StoreDistRowSparsePull");
   }
 
   void PushPullDefault(int key, const NDArray &comm_buf, int priority) override {
@@ -181,20 +272,23 @@ class P3StoreDist : public KVStoreDist {
       PSKV& pskv = EncodeDefaultKey(key, size, num_bytes);
       char* data = static_cast<char*>(comm_buf.data().dptr_);
 
+      // a slice is pulled through the pull window as soon as the servers acknowledge
+      // its push, i.e. have aggregated it, instead of all slices coming back at once
       size_t off = 0;
       auto counter = new std::atomic<int>(pskv.keys.size());
       for (size_t idx = 0; idx < pskv.keys.size(); idx++) {
         auto ks = pskv.keys.segment(idx, idx+1);
-        auto ls = new ps::SArray<int>(1, pskv.lens[idx]);
-        auto vs = new ps::SArray<char>(data + off, pskv.lens[idx], false);
-        CHECK_NOTNULL(ps_worker_)->ZPushPull(
-          ks, *vs, vs, ls, cmd, [vs, ls, counter, cb]() {
-              delete vs;
-              delete ls;
-              if (--(*counter) == 0) {
-                delete counter;
-                cb();
-              }
+        auto ls = pskv.lens.segment(idx, idx+1);
+        char* slice = data + off;
+        ps::SArray<char> vs(slice, pskv.lens[idx], false);
+        CHECK_NOTNULL(ps_worker_)->ZPush(
+          ks, vs, ls, cmd, [this, ks, ls, slice, cmd, priority, counter, cb]() {
+              PullSlice(ks, ls, slice, cmd, priority, [counter, cb]() {
+                  if (--(*counter) == 0) {
+                    delete counter;
+                    cb();
+                  }
+                });
             }, priority);
         off += pskv.lens[idx];
       }
@@ -209,6 +303,108 @@ class P3StoreDist : public KVStoreDist {
         "P3StoreDistDefaultStoragePushPull");
   }
 
+  /**
+   * \brief push every slice of pskv as a separate request, and call cb once all
+   *  of them are acknowledged. A slice is made of keys_per_slice consecutive keys.
+   *  The pushes are not held back by a window: in sync mode the servers acknowledge
+   *  a push only once all workers pushed it, so workers which hold back different
+   *  slices would wait for each other.
+   */
+  void PushSlices(const PSKV& pskv, char* data, const size_t keys_per_slice, const int cmd,
+                  const int priority, const Engine::CallbackOnComplete& cb) {
+    CHECK_EQ(pskv.keys.size() % keys_per_slice, 0);
+    size_t off = 0;
+    auto counter = new std::atomic<int>(pskv.keys.size() / keys_per_slice);
+    for (size_t idx = 0; idx < pskv.keys.size(); idx += keys_per_slice) {
+      auto ks = pskv.keys.segment(idx, idx + keys_per_slice);
+      auto ls = pskv.lens.segment(idx, idx + keys_per_slice);
+      const size_t len = std::accumulate(ls.begin(), ls.end(), size_t(0));
+      // do push. false means no delete
+      ps::SArray<char> vs(data + off, len, false);
+      CHECK_NOTNULL(ps_worker_)->ZPush(
+        ks, vs, ls, cmd, [counter, cb]() {
+            if (--(*counter) == 0) {
+              delete counter;
+              cb();
+            }
+          }, priority);
+      off += len;
+    }
+  }
+
+  /**
+   * \brief pull one slice into data once there is room in the pull window
+   */
+  void PullSlice(const ps::SArray<ps::Key>& keys, const ps::SArray<int>& lens, char* data,
+                 const int cmd, const int priority, const std::function<void()>& done) {
+    auto issue = [this, keys, lens, data, cmd, priority, done]() {
+      // the response overwrites the lens, which may be shared with the pskv
+      auto ls = new ps::SArray<int>();
+      ls->CopyFrom(lens.data(), lens.size());
+      const size_t len = std::accumulate(lens.begin(), lens.end(), size_t(0));
+      auto vs = new ps::SArray<char>(data, len, false);
+      CHECK_NOTNULL(ps_worker_)->ZPull(
+        keys, vs, ls, cmd, [this, vs, ls, done]() {
+            delete vs;
+            delete ls;
+            ReleasePullWindow();
+            done();
+          }, priority);
+    };
+    {
+      std::lock_guard<std::mutex> lock(pull_mu_);
+      pending_pulls_.push({priority, pull_seq_++, issue});
+    }
+    DispatchPulls();
+  }
+
+  /**
+   * \brief issue the pending pulls of the highest priority while the window allows
+   */
+  void DispatchPulls() {
+    while (true) {
+      std::function<void()> issue;
+      {
+        std::lock_guard<std::mutex> lock(pull_mu_);
+        if (pending_pulls_.empty() || inflight_pulls_ >= pull_window_) return;
+        issue = pending_pulls_.top().issue;
+        pending_pulls_.pop();
+        ++inflight_pulls_;
+      }
+      issue();
+    }
+  }
+
+  void ReleasePullWindow() {
+    {
+      std::lock_guard<std::mutex> lock(pull_mu_);
+      --inflight_pulls_;
+    }
+    DispatchPulls();
+  }
+
+  /**
+   * \brief the next unused ps key of server. The keys are handed out in the order
+   *  of initialization, which is the same on all workers, so that the slices of
+   *  different keys never share a ps key, whatever their sizes and key ids are.
+   */
+  inline ps::Key AllocKey(const int server) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+    if (next_key_offset_.empty()) next_key_offset_.resize(krs.size(), 0);
+    ps::Key ps_key = krs[server].begin() + next_key_offset_[server]++;
+    CHECK_LT(ps_key, krs[server].end());
+    return ps_key;
+  }
+
+  /**
+   * \brief server of the next slice, the slices are spread round robin
+   */
+  inline int NextServer() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return next_server_++ % ps::NumServers();
+  }
+
   inline PSKV& EncodeDefaultKey(const int key, const size_t num_arr_elems,
                                 const int num_bytes) override {
     mu_.lock();
@@ -219,34 +415,98 @@ class P3StoreDist : public KVStoreDist {
       CHECK_EQ(static_cast<size_t>(pskv.size), pskv_size)
         << "The value size cannot be changed " << pskv_size << ". Key is " << key;
     } else {
-      auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
-      const int num_servers = krs.size();
-      CHECK_GT(num_servers, 0);
-
       int64_t num_params = num_arr_elems * num_bytes;
       int64_t slice_bound = slice_threshold_ * num_bytes;
-      static size_t server = 0;
+      pskv.size = 0;
       while (num_params > 0) {
-        ps::Key ps_key = krs[server%num_servers].begin()
-                         + (ps::Key)(key + server/num_servers);
-        CHECK_LT(ps_key, krs[server%num_servers].end());
-        pskv.keys.push_back(ps_key);
+        pskv.keys.push_back(AllocKey(NextServer()));
         const size_t part_size = static_cast<size_t>((num_params > slice_bound)
                 ? slice_bound : num_params);
         pskv.lens.push_back(part_size);
         pskv.size += part_size;
 
         num_params -= part_size;
-        server++;
       }
     }
     return pskv;
   }
 
+  /**
+   * \brief slice the key for gradient compression. The slices hold a whole number of
+   *  compressed elements, the push pskv has for each slice the dummy key giving the
+   *  original size of the slice followed by the key of the slice.
+   */
+  inline PSKV& EncodeCompressedKey(const int key, const size_t original_num_elem,
+                                   const bool is_push, const int num_bytes) override {
+    const size_t compr_num_elem = gradient_compression_->GetCompressedSize(original_num_elem);
+    mu_.lock();
+    PSKV& pskv = (is_push) ? compr_ps_kv_[key].push : compr_ps_kv_[key].pull;
+    PSKV& pull_pskv = compr_ps_kv_[key].pull;
+    PSKV& push_pskv = compr_ps_kv_[key].push;
+    mu_.unlock();
+
+    if (!pskv.keys.empty()) {
+      const size_t num_elem = (is_push) ? compr_num_elem : original_num_elem;
+      CHECK_EQ(static_cast<size_t >(pskv.size), num_elem * num_bytes)
+        << "The value size can't be changed. For key " << key;
+    } else {
+      auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+      const size_t factor = gradient_compression_->GetCompressionFactor();
+      const size_t slice_compr = std::max<size_t>(1, slice_threshold_ / factor);
+      push_pskv.size = 0;
+      pull_pskv.size = 0;
+      for (size_t begin = 0; begin < compr_num_elem; begin += slice_compr) {
+        const size_t part_compr = std::min(slice_compr, compr_num_elem - begin);
+        const size_t part_orig = std::min(part_compr * factor, original_num_elem - begin * factor);
+        const int server = NextServer();
+        const ps::Key ps_key = AllocKey(server);
+        // meta info
+        ps::Key ps_key_dummy = krs[server].begin() + part_orig;
+        CHECK_LT(ps_key_dummy, krs[server].end());
+        push_pskv.keys.push_back(ps_key_dummy);
+        push_pskv.lens.push_back(0);
+        // data
+        push_pskv.keys.push_back(ps_key);
+        pull_pskv.keys.push_back(ps_key);
+        push_pskv.lens.push_back(part_compr * num_bytes);
+        pull_pskv.lens.push_back(part_orig * num_bytes);
+        push_pskv.size += part_compr * num_bytes;
+        pull_pskv.size += part_orig * num_bytes;
+      }
+      CHECK_EQ(static_cast<size_t>(push_pskv.size), compr_num_elem * num_bytes);
+      CHECK_EQ(static_cast<size_t>(pull_pskv.size), original_num_elem * num_bytes);
+    }
+    return pskv;
+  }
+
+  inline ps::Key RowSparseMasterKey(const int key, const int server) override {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = rsp_master_keys_.find(key);
+    CHECK(it != rsp_master_keys_.end()) << "init " << key << " first";
+    return it->second[server];
+  }
+
   /**
    * \brief threshold for the parameter slice size
    */
   size_t slice_threshold_;
+  /**
+   * \brief maximum number of slices being pulled at once
+   */
+  int pull_window_;
+  int inflight_pulls_ = 0;
+  uint64_t pull_seq_ = 0;
+  std::priority_queue<PendingPull> pending_pulls_;
+  std::mutex pull_mu_;
+  /**
+   * \brief ps keys handed out so far per server, and the server of the next slice
+   */
+  std::vector<ps::Key> next_key_offset_;
+  int next_server_ = 0;
+  /**
+   * \brief ps key of every server for the row sparse keys
+   */
+  std::unordered_map<int, std::vector<ps::Key>> rsp_master_keys_;
 };
 
 }  // namespace kvstore
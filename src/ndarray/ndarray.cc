@@ -22,6 +22,7 @@
  * \file ndarray.cc
  * \brief ndarry module of mxnet
  */
+#include <dmlc/endian.h>
 #include <dmlc/io.h>
 #include <dmlc/memory_io.h>
 #include <dmlc/logging.h>
@@ -31,6 +32,7 @@
 #include <mxnet/resource.h>
 #include <mxnet/imperative.h>
 #include <mshadow/tensor.h>
+#include <limits>
 #include "./ndarray_function.h"
 #include "../common/utils.h"
 #include "../operator/tensor/matrix_op-inl.h"
@@ -42,6 +44,21 @@
 #include <opencv2/opencv.hpp>
 #endif  // MXNET_USE_OPENCV
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !defined(_WIN32)
+
+// The mapped files are used in place, without the byte swapping of dmlc::Stream::Read,
+// so they are only mapped when the host has the byte order of the files
+#if !defined(_WIN32) && DMLC_IO_NO_ENDIAN_SWAP
+#define MXNET_NDARRAY_MAPPED_LOAD 1
+#else
+#define MXNET_NDARRAY_MAPPED_LOAD 0
+#endif
+
 namespace dmlc {
 DMLC_REGISTRY_ENABLE(::mxnet::NDArrayFunctionReg);
 }  // namespace dmlc
@@ -107,6 +124,36 @@ void NDArray::SetShapeFromChunk() const {
   }
 }
 
+void NDArray::InitFromArena(const NDArray &arena, size_t byte_offset, size_t size,
+                            const mxnet::TShape &shape, int dtype) {
+  CHECK_EQ(arena.storage_type(), kDefaultStorage)
+    << "InitFromArena is intended only for kDefaultStorage.";
+  CHECK(!arena.IsView());
+  CHECK_GE(size, shape.Size() * mshadow::mshadow_sizeof(dtype))
+    << "NDArray.InitFromArena: the array is bigger than its memory.";
+  arena.ptr_->CheckAndAlloc();
+  CHECK_GE(arena.ptr_->shandle.size, byte_offset + size)
+    << "NDArray.InitFromArena: the array exceeds the memory that was allocated.";
+  // a static chunk, the memory is freed with the arena
+  auto chunk = std::make_shared<Chunk>();
+  chunk->ctx = arena.ptr_->ctx;
+  chunk->storage_shape = shape;
+  chunk->shandle = arena.ptr_->shandle;
+  chunk->shandle.dptr = static_cast<char*>(arena.ptr_->shandle.dptr) + byte_offset;
+  chunk->shandle.size = size;
+  chunk->var = Engine::Get()->NewVariable();
+  chunk->arena = arena.ptr_;
+  arena.ptr_->carved_vars.push_back(chunk->var);
+  ptr_ = std::move(chunk);
+  Init(kDefaultStorage, shape, dtype);
+}
+
+void NDArray::AddMemoryDependency(const NDArray &other) {
+  CHECK(ptr_->arena != nullptr && ptr_->arena == other.ptr_->arena)
+    << "AddMemoryDependency is intended only for the arrays carved out of one arena.";
+  ptr_->memory_vars.push_back(other.var());
+}
+
 struct ChunkMem {
   Storage::Handle h;
   std::vector<Storage::Handle> aux_h;
@@ -125,6 +172,26 @@ NDArray::Chunk::~Chunk() {
   mem.mem = this->mkl_mem_;
 #endif
   if (auto engine = engine_ref_.lock()) {
+    if (arena) {
+      // the variable belongs to the arena, which is kept alive until the
+      // operators of the chunk are done
+      auto arena_ref = arena;
+      engine->PushAsync([mem, arena_ref](RunContext s, Engine::CallbackOnComplete on_complete) {
+          on_complete();
+        }, shandle.ctx, {}, {var}, FnProperty::kNormal, 0, "ReleaseArenaChunk");
+      return;
+    }
+    if (!carved_vars.empty()) {
+      // the memory is freed after the operators of the chunks carved out of it
+      std::vector<Engine::VarHandle> vars(carved_vars);
+      vars.push_back(var);
+      engine->PushAsync([](RunContext s, Engine::CallbackOnComplete on_complete) {
+          on_complete();
+        }, shandle.ctx, {}, vars, FnProperty::kNormal, 0, "ReleaseArena");
+      for (auto carved_var : carved_vars) {
+        engine->DeleteVariable([](RunContext s) {}, shandle.ctx, carved_var);
+      }
+    }
     engine->DeleteVariable([mem, skip_free](RunContext s) {
       if (skip_free == false) {
 #if MXNET_USE_MKLDNN == 1
@@ -1960,6 +2027,10 @@ bool NDArray::Load(dmlc::Stream *strm) {
 }
 
 const uint64_t kMXAPINDArrayListMagic = 0x112;
+// magic number of the indexed format with the aligned payloads
+const uint64_t kMXAPINDArrayIndexedMagic = 0x113;
+// alignment of the payloads in the indexed format
+constexpr size_t kNDArrayPayloadAlign = 64;
 
 void NDArray::Save(dmlc::Stream* fo,
                    const std::vector<NDArray>& data,
@@ -1977,10 +2048,15 @@ void NDArray::Load(dmlc::Stream* fi,
   uint64_t header, reserved;
   CHECK(fi->Read(&header))
       << "Invalid NDArray file format";
-  CHECK(fi->Read(&reserved))
-      << "Invalid NDArray file format";
+  if (header == kMXAPINDArrayIndexedMagic) {
+    // the index directly follows the magic number
+    LoadIndexed(fi, data, keys);
+    return;
+  }
   CHECK(header == kMXAPINDArrayListMagic)
       << "Invalid NDArray file format";
+  CHECK(fi->Read(&reserved))
+      << "Invalid NDArray file format";
   CHECK(fi->Read(data))
       << "Invalid NDArray file format";
   CHECK(fi->Read(keys))
@@ -1989,6 +2065,509 @@ void NDArray::Load(dmlc::Stream* fi,
       << "Invalid NDArray file format";
 }
 
+namespace {
+// file size for the streams, whose size is not known
+constexpr uint64_t kUnknownFileSize = std::numeric_limits<uint64_t>::max();
+
+// whether the type of the array in the file is known
+bool IsKnownDType(int32_t dtype) {
+  switch (dtype) {
+    case mshadow::kFloat32:
+    case mshadow::kFloat64:
+    case mshadow::kFloat16:
+    case mshadow::kBfloat16:
+    case mshadow::kUint8:
+    case mshadow::kInt8:
+    case mshadow::kInt32:
+    case mshadow::kInt64:
+    case mshadow::kBool:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// checks that the payload of the shape and type at the offset is within the file
+void CheckPayload(uint64_t offset, const mxnet::TShape &shape, int dtype, uint64_t file_size) {
+  uint64_t nbytes = mshadow::mshadow_sizeof(dtype);
+  for (int i = 0; i < shape.ndim(); ++i) {
+    const uint64_t dim = shape[i];
+    CHECK(dim == 0 || nbytes <= kUnknownFileSize / dim) << "Invalid NDArray file format";
+    nbytes *= dim;
+  }
+  CHECK(offset <= file_size && nbytes <= file_size - offset) << "Invalid NDArray file format";
+}
+
+/*!
+ * \brief Entry of the index of the indexed NDArray file format.
+ *
+ * The indexed format is laid out as
+ *   uint64_t magic (kMXAPINDArrayIndexedMagic), uint64_t flags, uint64_t header size,
+ *   uint64_t whether the arrays are named, uint64_t number of entries, entries,
+ * followed by the payloads (data and aux data of each array), which start at
+ * the offsets recorded in the entries, aligned to kNDArrayPayloadAlign bytes.
+ */
+struct NDArrayIndexEntry {
+  std::string name;
+  // kUndefinedStorage for the none arrays, which have no payload
+  int32_t stype = kUndefinedStorage;
+  int32_t dtype = -1;
+  Context ctx;
+  mxnet::TShape shape;
+  // shape of the data of the sparse array
+  mxnet::TShape storage_shape;
+  std::vector<int32_t> aux_types;
+  mxnet::ShapeVector aux_shapes;
+  // offsets of the payloads from the beginning of the file
+  uint64_t offset = 0;
+  std::vector<uint64_t> aux_offsets;
+
+  explicit NDArrayIndexEntry(const NDArray &arr = NDArray(), const std::string &name = "")
+    : name(name) {
+    if (arr.is_none()) return;
+    stype = arr.storage_type();
+    dtype = arr.dtype();
+    ctx = arr.ctx();
+    shape = arr.shape();
+    if (stype != kDefaultStorage) {
+      storage_shape = arr.storage_shape();
+      for (size_t i = 0; i < num_aux_data(arr.storage_type()); ++i) {
+        aux_types.push_back(arr.aux_type(i));
+        aux_shapes.push_back(arr.aux_shape(i));
+      }
+      aux_offsets.resize(aux_types.size());
+    }
+  }
+
+  size_t data_bytes() const {
+    const auto &data_shape = stype == kDefaultStorage? shape : storage_shape;
+    return mshadow::mshadow_sizeof(dtype) * data_shape.Size();
+  }
+
+  size_t aux_bytes(size_t i) const {
+    return mshadow::mshadow_sizeof(aux_types[i]) * aux_shapes[i].Size();
+  }
+
+  void Save(dmlc::Stream *strm) const {
+    strm->Write(name);
+    strm->Write(stype);
+    if (stype == kUndefinedStorage) return;
+    strm->Write(dtype);
+    ctx.Save(strm);
+    shape.Save(strm);
+    strm->Write(offset);
+    if (stype == kDefaultStorage) return;
+    storage_shape.Save(strm);
+    strm->Write(aux_types);
+    for (size_t i = 0; i < aux_types.size(); ++i) {
+      aux_shapes[i].Save(strm);
+      strm->Write(aux_offsets[i]);
+    }
+  }
+
+  bool Load(dmlc::Stream *strm) {
+    if (!strm->Read(&name) || !strm->Read(&stype)) return false;
+    if (stype == kUndefinedStorage) return true;
+    if (!strm->Read(&dtype) || !ctx.Load(strm) || !shape.Load(strm) || !strm->Read(&offset))
+      return false;
+    if (stype == kDefaultStorage) return true;
+    if (!storage_shape.Load(strm) || !strm->Read(&aux_types)) return false;
+    aux_shapes.resize(aux_types.size());
+    aux_offsets.resize(aux_types.size());
+    for (size_t i = 0; i < aux_types.size(); ++i) {
+      if (!aux_shapes[i].Load(strm) || !strm->Read(&aux_offsets[i])) return false;
+    }
+    return true;
+  }
+
+  /*!
+   * \brief checks the entry, before anything is allocated or read for it
+   * \param file_size size of the file, the payloads must be within it
+   */
+  void Validate(uint64_t file_size) const {
+    if (stype == kUndefinedStorage) return;
+    CHECK(stype == kDefaultStorage || stype == kRowSparseStorage || stype == kCSRStorage)
+        << "Invalid NDArray file format";
+    CHECK(IsKnownDType(dtype) && shape_is_known(shape)) << "Invalid NDArray file format";
+    if (stype == kDefaultStorage) {
+      CheckPayload(offset, shape, dtype, file_size);
+      return;
+    }
+    CHECK(aux_types.size() == num_aux_data(static_cast<NDArrayStorageType>(stype)) &&
+          shape_is_known(storage_shape)) << "Invalid NDArray file format";
+    CheckPayload(offset, storage_shape, dtype, file_size);
+    for (size_t i = 0; i < aux_types.size(); ++i) {
+      CHECK(IsKnownDType(aux_types[i]) && shape_is_known(aux_shapes[i]))
+          << "Invalid NDArray file format";
+      CheckPayload(aux_offsets[i], aux_shapes[i], aux_types[i], file_size);
+    }
+  }
+
+  /*! \brief allocates the CPU array for the payloads of the entry */
+  NDArray Allocate() const {
+    if (stype == kDefaultStorage)
+      return NDArray(shape, Context::CPU(), false, dtype);
+    return NDArray(static_cast<NDArrayStorageType>(stype), shape, Context::CPU(), false,
+                   dtype, aux_types, aux_shapes, storage_shape);
+  }
+};
+
+/*! \brief header and index of the indexed NDArray file */
+struct NDArrayIndex {
+  // bit 0: the arrays were saved in np shape semantics
+  uint64_t flags = 0;
+  uint64_t header_size = 0;
+  uint64_t has_names = 0;
+  std::vector<NDArrayIndexEntry> entries;
+
+  static constexpr uint64_t kNumpyShape = 1;
+
+  void Save(dmlc::Stream *strm) const {
+    strm->Write(kMXAPINDArrayIndexedMagic);
+    strm->Write(flags);
+    strm->Write(header_size);
+    strm->Write(has_names);
+    strm->Write(static_cast<uint64_t>(entries.size()));
+    for (const auto &entry : entries) entry.Save(strm);
+  }
+
+  // loads and checks the index, which follows the magic number
+  void Load(dmlc::Stream *strm, uint64_t file_size = kUnknownFileSize) {
+    uint64_t size;
+    CHECK(strm->Read(&flags) && strm->Read(&header_size) &&
+          strm->Read(&has_names) && strm->Read(&size))
+        << "Invalid NDArray file format";
+    CHECK_LE(header_size, file_size) << "Invalid NDArray file format";
+    entries.clear();
+    for (uint64_t i = 0; i < size; ++i) {
+      entries.emplace_back();
+      CHECK(entries.back().Load(strm)) << "Invalid NDArray file format";
+      entries.back().Validate(file_size);
+    }
+    if (flags & kNumpyShape) {
+      CHECK(Imperative::Get()->is_np_shape())
+          << "ndarray was saved in np shape semantics, must be loaded in the same semantics."
+             " Please turn on np shape semantics in Python using `with np_shape(True)`"
+             " or decorator `use_np_shape` to scope the code of loading the ndarray.";
+    } else {
+      CHECK(Imperative::Get()->is_np_shape() == GlobalOn || !Imperative::Get()->is_np_shape())
+          << "ndarray was not saved in np shape semantics, but being loaded in np shape semantics."
+             " Please turn off np shape semantics in Python using `with np_shape(False)`"
+             " to scope the code of loading the ndarray.";
+    }
+  }
+
+  void Keys(std::vector<std::string> *keys) const {
+    keys->clear();
+    if (!has_names) return;
+    for (const auto &entry : entries) keys->push_back(entry.name);
+  }
+};
+
+/*!
+ * \brief Reads the payload at the given offset of the file, when the stream is at *pos.
+ * The streams are read only forward, the padding is skipped.
+ */
+void ReadPayload(dmlc::Stream *strm, uint64_t offset, size_t nbytes, void *dst, uint64_t *pos) {
+  CHECK_GE(offset, *pos) << "Invalid NDArray file format";
+  char padding[kNDArrayPayloadAlign];
+  while (*pos < offset) {
+    const size_t nskip = std::min<uint64_t>(offset - *pos, sizeof(padding));
+    CHECK_EQ(strm->Read(padding, nskip), nskip) << "Invalid NDArray file format";
+    *pos += nskip;
+  }
+  CHECK_EQ(strm->Read(dst, nbytes), nbytes) << "Invalid NDArray file format";
+  *pos += nbytes;
+}
+
+/*! \brief loads the array of the entry, the stream is at *pos of the file */
+NDArray LoadIndexedEntry(dmlc::Stream *strm, const NDArrayIndexEntry &entry, uint64_t *pos) {
+  if (entry.stype == kUndefinedStorage) return NDArray();
+  NDArray temp = entry.Allocate();
+  ReadPayload(strm, entry.offset, entry.data_bytes(), temp.data().dptr_, pos);
+  for (size_t i = 0; i < entry.aux_types.size(); ++i) {
+    ReadPayload(strm, entry.aux_offsets[i], entry.aux_bytes(i), temp.aux_data(i).dptr_, pos);
+  }
+#if MXNET_USE_CUDA
+  if (entry.ctx.dev_mask() != cpu::kDevMask) {
+    int device_count = -1;
+    cudaGetDeviceCount(&device_count);
+    if (device_count > 0) return temp.Copy(entry.ctx);
+  }
+#endif
+  return temp;
+}
+}  // namespace
+
+void NDArray::SaveIndexed(dmlc::Stream* fo,
+                          const std::vector<NDArray>& data,
+                          const std::vector<std::string>& names) {
+  CHECK(names.empty() || names.size() == data.size())
+      << "Number of names must be the same as the number of arrays";
+  NDArrayIndex index;
+  index.flags = Imperative::Get()->is_np_shape()? NDArrayIndex::kNumpyShape : 0;
+  index.has_names = !names.empty();
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (Imperative::Get()->is_np_shape()) {
+      CHECK_EQ(data[i].storage_type(), kDefaultStorage)
+          << "only allow serializing ndarray of default storage type in np shape semantics";
+    }
+    // the shapes of the sparse data are known only once they are computed
+    data[i].WaitToRead();
+    index.entries.emplace_back(data[i], names.empty()? std::string() : names[i]);
+  }
+
+  // The offsets have fixed size, hence they do not change the size of the header
+  std::string header;
+  {
+    dmlc::MemoryStringStream strm(&header);
+    index.Save(&strm);
+  }
+  auto align = [](uint64_t pos) {
+    return (pos + kNDArrayPayloadAlign - 1) / kNDArrayPayloadAlign * kNDArrayPayloadAlign;
+  };
+  index.header_size = header.size();
+  uint64_t pos = header.size();
+  for (auto &entry : index.entries) {
+    if (entry.stype == kUndefinedStorage) continue;
+    entry.offset = align(pos);
+    pos = entry.offset + entry.data_bytes();
+    for (size_t i = 0; i < entry.aux_types.size(); ++i) {
+      entry.aux_offsets[i] = align(pos);
+      pos = entry.aux_offsets[i] + entry.aux_bytes(i);
+    }
+  }
+  header.clear();
+  {
+    dmlc::MemoryStringStream strm(&header);
+    index.Save(&strm);
+  }
+  CHECK_EQ(header.size(), index.header_size);
+  fo->Write(header.data(), header.size());
+
+  pos = header.size();
+  const char padding[kNDArrayPayloadAlign] = {};
+  auto write_payload = [&](uint64_t offset, const TBlob &blob, size_t nbytes) {
+    CHECK(blob.CheckContiguous());
+    fo->Write(padding, offset - pos);
+    fo->Write(blob.dptr_, nbytes);
+    pos = offset + nbytes;
+  };
+  for (size_t i = 0; i < data.size(); ++i) {
+    const auto &entry = index.entries[i];
+    if (entry.stype == kUndefinedStorage) continue;
+    // The arrays are brought to CPU one by one
+    NDArray nd_cpu;
+    if (data[i].ctx().dev_mask() != cpu::kDevMask) {
+      nd_cpu = data[i].Copy(Context::CPU());
+      nd_cpu.WaitToRead();
+    } else {
+      nd_cpu = data[i];
+#if MXNET_USE_MKLDNN == 1
+      if (nd_cpu.IsMKLDNNData())
+        nd_cpu = nd_cpu.Reorder2Default();
+#endif
+    }
+    write_payload(entry.offset, nd_cpu.data(), entry.data_bytes());
+    for (size_t j = 0; j < entry.aux_types.size(); ++j) {
+      write_payload(entry.aux_offsets[j], nd_cpu.aux_data(j), entry.aux_bytes(j));
+    }
+  }
+}
+
+void NDArray::LoadIndexed(dmlc::Stream* fi,
+                          std::vector<NDArray>* data,
+                          std::vector<std::string>* keys) {
+  NDArrayIndex index;
+  index.Load(fi);
+  index.Keys(keys);
+  // the stream is right after the header
+  uint64_t pos = index.header_size;
+  data->clear();
+  for (const auto &entry : index.entries) {
+    data->push_back(LoadIndexedEntry(fi, entry, &pos));
+  }
+}
+
+void NDArray::LoadByName(const std::string& fname,
+                         const std::vector<std::string>& names,
+                         std::vector<NDArray>* data) {
+  std::unique_ptr<dmlc::SeekStream> fi(dmlc::SeekStream::CreateForRead(fname.c_str()));
+  uint64_t header;
+  CHECK(fi->Read(&header)) << "Invalid NDArray file format";
+  std::vector<std::string> keys;
+  data->clear();
+  if (header != kMXAPINDArrayIndexedMagic) {
+    // The other formats have no index, all the arrays are loaded
+    fi->Seek(0);
+    std::vector<NDArray> all;
+    Load(fi.get(), &all, &keys);
+    std::unordered_map<std::string, size_t> idx;
+    for (size_t i = 0; i < keys.size(); ++i) idx[keys[i]] = i;
+    for (const auto &name : names) {
+      const auto it = idx.find(name);
+      CHECK(it != idx.end()) << "Array " << name << " is not found in " << fname;
+      data->push_back(all[it->second]);
+    }
+    return;
+  }
+
+  NDArrayIndex index;
+  index.Load(fi.get());
+  std::unordered_map<std::string, const NDArrayIndexEntry *> idx;
+  for (const auto &entry : index.entries) idx[entry.name] = &entry;
+  for (const auto &name : names) {
+    const auto it = idx.find(name);
+    CHECK(index.has_names && it != idx.end()) << "Array " << name << " is not found in " << fname;
+    const auto &entry = *it->second;
+    uint64_t pos = entry.offset;
+    fi->Seek(pos);
+    data->push_back(LoadIndexedEntry(fi.get(), entry, &pos));
+  }
+}
+
+#if MXNET_NDARRAY_MAPPED_LOAD
+namespace {
+/*!
+ * \brief Private (copy-on-write) read-write mapping of a whole file.
+ * The pages are shared with the page cache, and hence between the processes,
+ * until they are written to.
+ */
+class MappedFile {
+ public:
+  MappedFile(void *data, size_t size) : data_(data), size_(size) {}
+  ~MappedFile() { munmap(data_, size_); }
+
+  /*! \brief maps the file, returns nullptr when the file cannot be mapped */
+  static std::shared_ptr<MappedFile> Map(const std::string &fname) {
+    const int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+    return std::make_shared<MappedFile>(data, st.st_size);
+  }
+
+  char *data() const   { return static_cast<char *>(data_); }
+  size_t size() const  { return size_; }
+
+ private:
+  void *data_;
+  size_t size_;
+};
+
+/*!
+ * \brief Creates the dense CPU NDArray directly on the top of the payload of the mapped file.
+ * \return false, when the payload cannot be used in place (it is misaligned or out of the file).
+ */
+bool MapNDArray(const std::shared_ptr<MappedFile> &file, size_t offset,
+                const mxnet::TShape &shape, int type_flag, NDArray *out) {
+  // The mapped data are given to the operators, which may use the aligned loads
+#if MXNET_USE_MKLDNN == 1
+  constexpr size_t kAlign = kMKLDNNAlign;
+#else
+  constexpr size_t kAlign = 1;
+#endif
+  const size_t type_size = mshadow::mshadow_sizeof(type_flag);
+  const size_t nbytes = type_size * shape.Size();
+  char *dptr = file->data() + offset;
+  const auto addr = reinterpret_cast<uintptr_t>(dptr);
+  if (offset + nbytes > file->size() || addr % type_size || addr % kAlign) return false;
+
+  // The mapping is released together with the last NDArray, which uses it
+  const TBlob blob(static_cast<void *>(dptr), shape, cpu::kDevMask, type_flag, 0);
+  *out = NDArray(blob, 0, [file]() {});
+  return true;
+}
+
+/*!
+ * \brief Creates the dense CPU NDArray of the record at the current position of the stream
+ * directly on the top of the mapped file. When the record cannot be used in place
+ * (legacy or sparse records, non-CPU context, misaligned data), the position of the
+ * stream is restored and false is returned, so that the record is loaded by copying.
+ */
+bool LoadMappedNDArray(dmlc::MemoryFixedSizeStream *strm,
+                       const std::shared_ptr<MappedFile> &file, NDArray *out) {
+  const size_t start = strm->Tell();
+  auto copy = [&]() {
+    strm->Seek(start);
+    return false;
+  };
+  uint32_t magic;
+  if (strm->Read(&magic, sizeof(magic)) != sizeof(magic)) return copy();
+  // np shape semantics mismatch is reported by NDArray::Load
+  if (magic != (Imperative::Get()->is_np_shape()? NDARRAY_V3_MAGIC : NDARRAY_V2_MAGIC))
+    return copy();
+  int32_t stype;
+  if (strm->Read(&stype, sizeof(stype)) != sizeof(stype) || stype != kDefaultStorage)
+    return copy();
+  mxnet::TShape shape;
+  if (!shape.Load(strm) || shape.ndim() <= 0 || !shape_is_known(shape) || shape.Size() == 0)
+    return copy();
+  Context ctx;
+  if (!ctx.Load(strm) || ctx.dev_mask() != cpu::kDevMask) return copy();
+  int32_t type_flag;
+  if (strm->Read(&type_flag, sizeof(type_flag)) != sizeof(type_flag)) return copy();
+
+  const size_t offset = strm->Tell();
+  if (!MapNDArray(file, offset, shape, type_flag, out)) return copy();
+  strm->Seek(offset + mshadow::mshadow_sizeof(type_flag) * shape.Size());
+  return true;
+}
+}  // namespace
+#endif  // MXNET_NDARRAY_MAPPED_LOAD
+
+void NDArray::LoadMapped(const std::string &fname,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* keys) {
+#if MXNET_NDARRAY_MAPPED_LOAD
+  const auto file = MappedFile::Map(fname);
+  if (file) {
+    dmlc::MemoryFixedSizeStream fi(file->data(), file->size());
+    uint64_t header, reserved, size;
+    CHECK(fi.Read(&header)) << "Invalid NDArray file format";
+    if (header == kMXAPINDArrayIndexedMagic) {
+      NDArrayIndex index;
+      index.Load(&fi, file->size());
+      index.Keys(keys);
+      data->resize(index.entries.size());
+      for (size_t i = 0; i < index.entries.size(); ++i) {
+        const auto &entry = index.entries[i];
+        if (entry.stype == kDefaultStorage && entry.ctx.dev_mask() == cpu::kDevMask &&
+            entry.shape.Size() > 0 &&
+            MapNDArray(file, entry.offset, entry.shape, entry.dtype, &(*data)[i])) {
+          continue;
+        }
+        uint64_t pos = entry.offset;
+        fi.Seek(pos);
+        (*data)[i] = LoadIndexedEntry(&fi, entry, &pos);
+      }
+      return;
+    }
+    CHECK(fi.Read(&reserved) && header == kMXAPINDArrayListMagic)
+        << "Invalid NDArray file format";
+    CHECK(fi.Read(&size)) << "Invalid NDArray file format";
+    data->resize(size);
+    for (NDArray &arr : *data) {
+      if (!LoadMappedNDArray(&fi, file, &arr)) {
+        CHECK(arr.Load(&fi)) << "Invalid NDArray file format";
+      }
+    }
+    CHECK(fi.Read(keys)) << "Invalid NDArray file format";
+    CHECK(keys->size() == 0 || keys->size() == data->size())
+        << "Invalid NDArray file format";
+    return;
+  }
+#endif  // MXNET_NDARRAY_MAPPED_LOAD
+  // The file cannot be mapped (remote or special file, unsupported platform or byte order)
+  std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname.c_str(), "r"));
+  Load(fi.get(), data, keys);
+}
+
 NDArray NDArray::Copy(Context ctx) const {
   NDArray ret;
   if (kDefaultStorage == storage_type()) {
@@ -27,7 +27,13 @@
 #include <nnvm/graph_attr_types.h>
 #include <nnvm/op_attr_types.h>
 #include <mxnet/base.h>
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "graph_algorithm.h"
 #include "../operator/operator_common.h"
 
@@ -64,6 +70,9 @@ size_t MXGetDTypeSize(const int type_flag) {
 
 namespace {
 
+// alignment of the storage offsets assigned by the offset planner
+constexpr size_t kArenaAlignment = 256;
+
 // simple graph based allocator.
 class MXGraphAllocator {
  public:
@@ -82,7 +91,7 @@ class MXGraphAllocator {
     if (!mxnet::shape_is_known(shape)) return kBadStorageID;
     // search memory block in [size / match_range_, size * match_range_)
     size_t size = shape.Size() * MXGetDTypeSize(dtype);
-    if (match_range_ == 0) return this->Alloc(dev_id, size);
+    if (match_range_ == 0) return this->Alloc(dev_id, size, node_id);
     auto begin = free_.lower_bound(size / match_range_);
     auto mid = free_.lower_bound(size);
     auto end = free_.upper_bound(size * match_range_);
@@ -112,7 +121,7 @@ class MXGraphAllocator {
       return e->id;
     }
     // cannot find anything return a new one.
-    return this->Alloc(dev_id, size);
+    return this->Alloc(dev_id, size, node_id);
   }
   // release a memory space.
   void Release(StorageID id, uint32_t node_id) {
@@ -120,6 +129,7 @@ class MXGraphAllocator {
     if (id == kExternalStorageID || id == kDynamicStorageID) return;
     StorageEntry *e = data_[id].get();
     e->released_by_node = node_id;
+    if (match_range_ == 0) return;
     free_.insert({e->max_bytes, e});
   }
 
@@ -132,6 +142,55 @@ class MXGraphAllocator {
     return total;
   }
 
+  /*!
+   * \brief Pack the storage entries into one arena per device.
+   *  The lifetime of an entry spans from the node that requested it to the node
+   *  that released it, and entries with overlapping lifetimes get disjoint byte
+   *  ranges. The entries are placed greedily from the largest one, each at the
+   *  lowest aligned offset that does not conflict with the entries placed before.
+   *  This is only meaningful when the storage is not reused, i.e. match_range is 0.
+   * \param alignment alignment of the offsets in bytes.
+   * \param offsets the byte offset of each storage entry in the arena of its device.
+   * \return the total number of bytes of the arenas.
+   */
+  size_t AssignOffsets(size_t alignment, std::vector<size_t>* offsets) const {
+    auto align = [alignment](size_t x) { return (x + alignment - 1) / alignment * alignment; };
+    std::vector<const StorageEntry*> order;
+    order.reserve(data_.size());
+    for (auto &p : data_) order.push_back(p.get());
+    std::stable_sort(order.begin(), order.end(),
+                     [](const StorageEntry* a, const StorageEntry* b) {
+                       return a->max_bytes > b->max_bytes;
+                     });
+    offsets->assign(data_.size(), 0);
+    std::unordered_map<int, size_t> arena_bytes;
+    std::vector<const StorageEntry*> placed;
+    std::vector<std::pair<size_t, size_t> > conflicts;
+    for (const StorageEntry* e : order) {
+      if (e->max_bytes == 0) continue;
+      conflicts.clear();
+      for (const StorageEntry* p : placed) {
+        if (p->device_id != e->device_id ||
+            p->allocated_by_node > e->released_by_node ||
+            e->allocated_by_node > p->released_by_node) continue;
+        conflicts.emplace_back((*offsets)[p->id], (*offsets)[p->id] + p->max_bytes);
+      }
+      std::sort(conflicts.begin(), conflicts.end());
+      size_t offset = 0;
+      for (const auto& c : conflicts) {
+        if (offset + e->max_bytes <= c.first) break;
+        offset = std::max(offset, align(c.second));
+      }
+      (*offsets)[e->id] = offset;
+      placed.push_back(e);
+      size_t &total = arena_bytes[e->device_id];
+      total = std::max(total, offset + e->max_bytes);
+    }
+    size_t total = 0;
+    for (const auto& kv : arena_bytes) total += kv.second;
+    return total;
+  }
+
   // constructor
   explicit MXGraphAllocator(const IndexedGraph* idx, const size_t match_range) : idx_(idx) {
     this->Init(match_range, dmlc::GetEnv("NNVM_EXEC_NUM_TEMP", 1));
@@ -153,12 +212,13 @@ class MXGraphAllocator {
     }
   }
 
-  StorageID Alloc(int dev_id, size_t size) {
+  StorageID Alloc(int dev_id, size_t size, uint32_t node_id) {
     StorageID id = static_cast<StorageID>(data_.size());
     std::unique_ptr<StorageEntry> ptr(new StorageEntry());
     ptr->id = id;
     ptr->device_id = dev_id;
     ptr->max_bytes = size;
+    ptr->allocated_by_node = node_id;
     data_.emplace_back(std::move(ptr));
     return id;
   }
@@ -170,8 +230,11 @@ class MXGraphAllocator {
     int device_id;
     // maximum size of storage requested.
     size_t max_bytes{0};
-    // node index that released it last time
-    uint32_t released_by_node{0};
+    // node index that requested it first time
+    uint32_t allocated_by_node{0};
+    // node index that released it last time, the storage is live until the
+    // end of the graph if it is never released.
+    uint32_t released_by_node{std::numeric_limits<uint32_t>::max()};
   };
   // scale used for rough match
   size_t match_range_;
@@ -371,6 +434,34 @@ Graph MXPlanMemory(Graph ret) {
     storage.resize(idx.num_node_entries(), -1);
   }
 
+  // "greedy" reuses released storage of a similar size, "offset" packs the
+  // lifetimes of all the entries into a single arena.
+  std::string planner = dmlc::GetEnv("MXNET_MEMORY_PLANNER", std::string("greedy"));
+  if (ret.attrs.count("memory_planner") != 0 &&
+      !ret.GetAttr<std::string>("memory_planner").empty()) {
+    planner = ret.GetAttr<std::string>("memory_planner");
+  }
+  CHECK(planner == "greedy" || planner == "offset")
+      << "Unknown memory planner " << planner << ", expected greedy or offset";
+  ret.attrs["memory_planner"] = std::make_shared<any>(planner);
+  if (planner == "offset") {
+    std::vector<int> storage_inplace_index(idx.num_node_entries(), -1);
+    // every request gets a new storage, which are then placed in the arena
+    MXGraphAllocator allocator(&idx, 0);
+    size_t storage_num_not_allocated =
+      MXAllocMemory(ret, idx, node_range, &storage, &storage_inplace_index,
+                  ref_count, &allocator);
+    std::vector<size_t> storage_offset;
+    size_t storage_allocated_bytes = allocator.AssignOffsets(kArenaAlignment, &storage_offset);
+    ret.attrs["storage_id"] = std::make_shared<any>(std::move(storage));
+    ret.attrs["storage_inplace_index"] = std::make_shared<any>(std::move(storage_inplace_index));
+    ret.attrs["storage_offset"] = std::make_shared<any>(std::move(storage_offset));
+    ret.attrs["storage_allocated_bytes"] = std::make_shared<any>(storage_allocated_bytes);
+    ret.attrs["storage_num_not_allocated"] = std::make_shared<any>(storage_num_not_allocated);
+    return ret;
+  }
+  ret.attrs.erase("storage_offset");
+
   // Search the best NNVM_EXEC_MATCH_RANGE parameter. This is turned off by default
   size_t min_allocated_bytes = -1;
   size_t max_match_range = dmlc::GetEnv("NNVM_EXEC_MATCH_RANGE", 16);
@@ -414,7 +505,8 @@ NNVM_REGISTER_PASS(MXPlanMemory)
 .depend_graph_attr("dtype")
 .depend_graph_attr("shape")
 .provide_graph_attr("storage_id")
-.provide_graph_attr("storage_inplace_index");
+.provide_graph_attr("storage_inplace_index")
+.provide_graph_attr("storage_offset");
 
 }  // namespace
 }  // namespace pass
@@ -43,6 +43,22 @@ struct InterleavedMatMulParam : public dmlc::Parameter<InterleavedMatMulParam> {
   }
 };
 
+struct InterleavedSelfAttParam : public dmlc::Parameter<InterleavedSelfAttParam> {
+  int heads;
+  bool causal;
+  bool use_length;
+  DMLC_DECLARE_PARAMETER(InterleavedSelfAttParam) {
+    DMLC_DECLARE_FIELD(heads)
+    .describe("Set number of heads");
+    DMLC_DECLARE_FIELD(causal)
+    .set_default(false)
+    .describe("Whether every query only attends to the keys up to its own position");
+    DMLC_DECLARE_FIELD(use_length)
+    .set_default(false)
+    .describe("Whether to ignore the keys past the valid_length of every sequence");
+  }
+};
+
 template<typename xpu>
 static void DivSqrtDimForward_(const nnvm::NodeAttrs& attrs,
                   const OpContext& ctx,
@@ -23,6 +23,9 @@
  * \brief CPU implementation of the operators used in Transformer
  */
 #include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "./transformer-inl.h"
 #include "../tensor/elemwise_unary_op.h"
 
@@ -30,6 +33,7 @@ namespace mxnet {
 namespace op {
 
 DMLC_REGISTER_PARAMETER(InterleavedMatMulParam);
+DMLC_REGISTER_PARAMETER(InterleavedSelfAttParam);
 
 static bool InterleavedMatMulSelfAttQKShape(const NodeAttrs& attrs,
                                             mxnet::ShapeVector* in_shape,
@@ -647,6 +651,413 @@ void BackwardInterleavedMatMulEncDecValAttCPU(const nnvm::NodeAttrs& attrs,
   }
 }
 
+/*! \brief number of queries whose scores are computed together */
+const index_t kSelfAttQueryBlock = 64;
+/*! \brief number of keys whose scores are computed together */
+const index_t kSelfAttKeyBlock = 128;
+
+static bool InterleavedSelfAttShape(const NodeAttrs& attrs,
+                                    mxnet::ShapeVector* in_shape,
+                                    mxnet::ShapeVector* out_shape) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), params.use_length ? 2U : 1U)
+    << "Input:[queries_keys_values" << (params.use_length ? ", valid_length" : "")
+    << "] currently have, " << in_shape->size() << " inputs";
+  auto qkv_shape = in_shape->at(0);
+  if (!mxnet::ndim_is_known(qkv_shape)) return false;
+  CHECK_EQ(qkv_shape.ndim(), 3U)
+    << "Input queries_keys_values should be 3D in seq_length-batch-3*proj_dim, "
+    << "currently is: " << qkv_shape.ndim() << "D";
+  CHECK_EQ(qkv_shape[2] % (3 * params.heads), 0)
+    << "queries_keys_values.shape[2] should be a multiple of 3 * heads, "
+    << "currently is " << qkv_shape[2];
+  if (params.use_length) {
+    SHAPE_ASSIGN_CHECK(*in_shape, 1, mxnet::TShape({qkv_shape[1]}));
+  }
+  out_shape->resize(2);
+  SHAPE_ASSIGN_CHECK(*out_shape, 0,
+    mxnet::TShape({qkv_shape[0], qkv_shape[1], qkv_shape[2] / 3}));
+  SHAPE_ASSIGN_CHECK(*out_shape, 1,
+    mxnet::TShape({params.heads * qkv_shape[1], qkv_shape[0]}));
+  return true;
+}
+
+static bool InterleavedSelfAttType(const NodeAttrs& attrs,
+                                   std::vector<int>* in_attrs,
+                                   std::vector<int>* out_attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), params.use_length ? 2U : 1U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, (*in_attrs)[0]);
+  TYPE_ASSIGN_CHECK(*out_attrs, 1, (*in_attrs)[0]);
+  TYPE_ASSIGN_CHECK(*in_attrs, 0, (*out_attrs)[0]);
+  if (params.use_length) {
+    // valid_length may be of any integer or floating point type, int32 unless given
+    if ((*in_attrs)[1] == -1) {
+      TYPE_ASSIGN_CHECK(*in_attrs, 1, mshadow::kInt32);
+    }
+    CHECK((*in_attrs)[1] != mshadow::kBool && (*in_attrs)[1] != mshadow::kInt16)
+      << "valid_length should be of an integer or floating point type, currently is "
+      << (*in_attrs)[1];
+  }
+  return (*in_attrs)[0] != -1;
+}
+
+/*!
+ * \brief Number of keys visible to the queries of a block, the keys being
+ *  limited by the valid length of the sequence and, if causal, by the last query.
+ */
+static inline index_t SelfAttKeyEnd(const bool causal, const index_t length,
+                                    const index_t q_begin, const index_t q_rows) {
+  return causal ? std::min(length, q_begin + q_rows) : length;
+}
+
+/*!
+ * \brief Number of keys of the block starting at k_begin visible to query q.
+ */
+static inline index_t SelfAttRowKeys(const bool causal, const index_t q,
+                                     const index_t k_begin, const index_t k_rows) {
+  return causal ? std::max(index_t(0), std::min(k_rows, q + 1 - k_begin)) : k_rows;
+}
+
+static std::vector<index_t> SelfAttLengths(const TBlob* valid_length,
+                                           const index_t sequences,
+                                           const index_t seq_len) {
+  std::vector<index_t> lengths(sequences, seq_len);
+  if (valid_length != nullptr) {
+    MSHADOW_TYPE_SWITCH(valid_length->type_flag_, LType, {
+      const LType* length_ptr = valid_length->dptr<LType>();
+      for (index_t b = 0; b < sequences; ++b) {
+        lengths[b] = std::max(index_t(0),
+                              std::min(seq_len, static_cast<index_t>(length_ptr[b])));
+      }
+    });
+  }
+  return lengths;
+}
+
+/*!
+ * \brief Fused self attention: the scores of a block of queries are computed against
+ *  one block of keys at a time and folded into the output with an online softmax,
+ *  so that the seq_length x seq_length attention maps are never stored. The log-sum-exp
+ *  of the scores of every query is kept for the backward pass.
+ */
+void InterleavedSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                           const OpContext &ctx,
+                           const std::vector<TBlob> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &outputs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  if (req[0] == kNullOp && req[1] == kNullOp)
+    return;
+
+  CHECK_EQ(inputs[0].type_flag_, mshadow::kFloat32)
+    << "Only FP32 is supported on CPU at the moment";
+
+  mshadow::Stream<cpu>* s = ctx.get_stream<cpu>();
+  const float* queries_keys_values = inputs[0].FlatTo2D<cpu, float>(s).dptr_;
+  float* output                    = outputs[0].FlatTo2D<cpu, float>(s).dptr_;
+  float* logsumexp                 = outputs[1].FlatTo2D<cpu, float>(s).dptr_;
+
+  const index_t qkv_seq_len    = inputs[0].shape_[0];
+  const index_t sequences      = inputs[0].shape_[1];
+  const index_t output_lin_dim = inputs[0].shape_[2];
+  const index_t embed_dim      = output_lin_dim / 3;
+  const index_t head_dim       = embed_dim / params.heads;
+  const index_t attn_batches   = params.heads * sequences;
+  const index_t lead_dim       = attn_batches * 3 * head_dim;
+  const index_t out_lead_dim   = attn_batches * head_dim;
+  const float scale            = 1.0 / sqrt(static_cast<float>(head_dim));
+  const std::vector<index_t> lengths =
+    SelfAttLengths(params.use_length ? &inputs[1] : nullptr, sequences, qkv_seq_len);
+
+  const index_t q_blocks  = (qkv_seq_len + kSelfAttQueryBlock - 1) / kSelfAttQueryBlock;
+  const int nthreads      = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const index_t scores_size = kSelfAttQueryBlock * kSelfAttKeyBlock;
+  const index_t acc_size    = kSelfAttQueryBlock * head_dim;
+  const index_t thread_size = scores_size + acc_size + 2 * kSelfAttQueryBlock;
+  mshadow::Tensor<cpu, 1, float> workspace =
+    ctx.requested[0].get_space_typed<cpu, 1, float>(mshadow::Shape1(nthreads * thread_size), s);
+
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t task = 0; task < attn_batches * q_blocks; ++task) {
+    float* scores    = workspace.dptr_ + omp_get_thread_num() * thread_size;
+    float* acc       = scores + scores_size;
+    float* row_max   = acc + acc_size;
+    float* row_sum   = row_max + kSelfAttQueryBlock;
+    const index_t a       = task / q_blocks;
+    const index_t q_begin = (task % q_blocks) * kSelfAttQueryBlock;
+    const index_t q_rows  = std::min(kSelfAttQueryBlock, qkv_seq_len - q_begin);
+    const float* queries  = queries_keys_values + q_begin * lead_dim + a * 3 * head_dim;
+    const float* keys     = queries_keys_values + a * 3 * head_dim + head_dim;
+    const float* values   = keys + head_dim;
+    const index_t k_end   = SelfAttKeyEnd(params.causal, lengths[a / params.heads],
+                                          q_begin, q_rows);
+    std::fill(acc, acc + q_rows * head_dim, 0.f);
+    std::fill(row_max, row_max + q_rows, -std::numeric_limits<float>::infinity());
+    std::fill(row_sum, row_sum + q_rows, 0.f);
+    for (index_t k_begin = 0; k_begin < k_end; k_begin += kSelfAttKeyBlock) {
+      const index_t k_rows = std::min(kSelfAttKeyBlock, k_end - k_begin);
+      cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans,
+                  q_rows, k_rows, head_dim,
+                  scale, queries, lead_dim,
+                  keys + k_begin * lead_dim, lead_dim,
+                  0.f, scores, kSelfAttKeyBlock);
+      for (index_t i = 0; i < q_rows; ++i) {
+        float* row = scores + i * kSelfAttKeyBlock;
+        const index_t row_keys = SelfAttRowKeys(params.causal, q_begin + i, k_begin, k_rows);
+        if (row_keys == 0) {
+          std::fill(row, row + k_rows, 0.f);
+          continue;
+        }
+        const float new_max = std::max(row_max[i], *std::max_element(row, row + row_keys));
+        const float correction = std::exp(row_max[i] - new_max);
+        float sum = 0.f;
+        for (index_t j = 0; j < row_keys; ++j) {
+          row[j] = std::exp(row[j] - new_max);
+          sum += row[j];
+        }
+        std::fill(row + row_keys, row + k_rows, 0.f);
+        row_max[i] = new_max;
+        row_sum[i] = row_sum[i] * correction + sum;
+        if (correction != 1.f) {
+          float* acc_row = acc + i * head_dim;
+          for (index_t j = 0; j < head_dim; ++j) {
+            acc_row[j] *= correction;
+          }
+        }
+      }
+      cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                  q_rows, head_dim, k_rows,
+                  1.f, scores, kSelfAttKeyBlock,
+                  values + k_begin * lead_dim, lead_dim,
+                  1.f, acc, head_dim);
+    }
+    for (index_t i = 0; i < q_rows; ++i) {
+      // queries without any visible key attend to nothing
+      const bool empty = row_sum[i] == 0.f;
+      const float inv_sum = empty ? 0.f : 1.f / row_sum[i];
+      float* out_row = output + (q_begin + i) * out_lead_dim + a * head_dim;
+      const float* acc_row = acc + i * head_dim;
+      if (req[0] != kNullOp) {
+        for (index_t j = 0; j < head_dim; ++j) {
+          KERNEL_ASSIGN(out_row[j], req[0], acc_row[j] * inv_sum);
+        }
+      }
+      if (req[1] != kNullOp) {
+        KERNEL_ASSIGN(logsumexp[a * qkv_seq_len + q_begin + i], req[1],
+                      empty ? -std::numeric_limits<float>::infinity()
+                            : row_max[i] + std::log(row_sum[i]));
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Backward of the fused self attention. The probabilities of every block of
+ *  scores are recomputed from the saved log-sum-exp. With enough attention batches
+ *  for all the threads the work is split over the attention batches, whose gradients
+ *  of the keys and values are accumulated over all the blocks of queries. Otherwise
+ *  the gradients of the keys and values are computed per block of keys, and those of
+ *  the queries per block of queries, the blocks of scores being computed twice.
+ */
+void BackwardInterleavedSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                                   const OpContext &ctx,
+                                   const std::vector<TBlob> &inputs,
+                                   const std::vector<OpReqType> &req,
+                                   const std::vector<TBlob> &outputs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  if (params.use_length && req[1] != kNullOp) {
+    MSHADOW_TYPE_SWITCH(outputs[1].type_flag_, LType, {
+      if (req[1] == kWriteTo) {
+        std::fill(outputs[1].dptr<LType>(), outputs[1].dptr<LType>() + outputs[1].Size(),
+                  LType(0));
+      }
+    });
+  }
+  if (req[0] == kNullOp)
+    return;
+
+  CHECK_EQ(inputs[0].type_flag_, mshadow::kFloat32)
+    << "Only FP32 is supported on CPU at the moment";
+
+  const index_t out_idx = params.use_length ? 3 : 2;
+  mshadow::Stream<cpu>* s = ctx.get_stream<cpu>();
+  const float* output_grads        = inputs[0].FlatTo2D<cpu, float>(s).dptr_;
+  const float* queries_keys_values = inputs[1].FlatTo2D<cpu, float>(s).dptr_;
+  const float* output              = inputs[out_idx].FlatTo2D<cpu, float>(s).dptr_;
+  const float* logsumexp           = inputs[out_idx + 1].FlatTo2D<cpu, float>(s).dptr_;
+  float* queries_keys_values_grads = outputs[0].FlatTo2D<cpu, float>(s).dptr_;
+
+  const index_t qkv_seq_len    = inputs[1].shape_[0];
+  const index_t sequences      = inputs[1].shape_[1];
+  const index_t output_lin_dim = inputs[1].shape_[2];
+  const index_t embed_dim      = output_lin_dim / 3;
+  const index_t head_dim       = embed_dim / params.heads;
+  const index_t attn_batches   = params.heads * sequences;
+  const index_t lead_dim       = attn_batches * 3 * head_dim;
+  const index_t out_lead_dim   = attn_batches * head_dim;
+  const float scale            = 1.0 / sqrt(static_cast<float>(head_dim));
+  const std::vector<index_t> lengths =
+    SelfAttLengths(params.use_length ? &inputs[2] : nullptr, sequences, qkv_seq_len);
+
+  const int nthreads        = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const index_t scores_size = kSelfAttQueryBlock * kSelfAttKeyBlock;
+  const index_t thread_size = 2 * scores_size + kSelfAttQueryBlock;
+  mshadow::Tensor<cpu, 1, float> workspace =
+    ctx.requested[0].get_space_typed<cpu, 1, float>(mshadow::Shape1(nthreads * thread_size), s);
+
+  // rowsum(dO * O) of the queries of a block
+  auto out_dots = [&](const index_t a, const index_t q_begin, const index_t q_rows,
+                      float* out_dot) {
+    for (index_t i = 0; i < q_rows; ++i) {
+      const float* out_row = output + (q_begin + i) * out_lead_dim + a * head_dim;
+      const float* grad_row = output_grads + (q_begin + i) * out_lead_dim + a * head_dim;
+      float dot = 0.f;
+      for (index_t j = 0; j < head_dim; ++j) {
+        dot += out_row[j] * grad_row[j];
+      }
+      out_dot[i] = dot;
+    }
+  };
+  // probabilities P and gradients dS of the scores of a block of queries and keys
+  auto block_grads = [&](const index_t a, const index_t q_begin, const index_t q_rows,
+                         const index_t k_begin, const index_t k_rows, const float* out_dot,
+                         float* probs, float* probs_grads) {
+    const float* queries   = queries_keys_values + q_begin * lead_dim + a * 3 * head_dim;
+    const float* keys      = queries_keys_values + a * 3 * head_dim + head_dim;
+    const float* values    = keys + head_dim;
+    const float* out_grads = output_grads + q_begin * out_lead_dim + a * head_dim;
+    const float* lse       = logsumexp + a * qkv_seq_len + q_begin;
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans,
+                q_rows, k_rows, head_dim,
+                scale, queries, lead_dim,
+                keys + k_begin * lead_dim, lead_dim,
+                0.f, probs, kSelfAttKeyBlock);
+    for (index_t i = 0; i < q_rows; ++i) {
+      float* row = probs + i * kSelfAttKeyBlock;
+      const index_t row_keys = SelfAttRowKeys(params.causal, q_begin + i, k_begin, k_rows);
+      for (index_t j = 0; j < row_keys; ++j) {
+        row[j] = std::exp(row[j] - lse[i]);
+      }
+      std::fill(row + row_keys, row + k_rows, 0.f);
+    }
+    // dP = dO V^T, then dS = P * (dP - rowsum(dO * O))
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans,
+                q_rows, k_rows, head_dim,
+                1.f, out_grads, out_lead_dim,
+                values + k_begin * lead_dim, lead_dim,
+                0.f, probs_grads, kSelfAttKeyBlock);
+    for (index_t i = 0; i < q_rows; ++i) {
+      const float* row = probs + i * kSelfAttKeyBlock;
+      float* grad_row = probs_grads + i * kSelfAttKeyBlock;
+      for (index_t j = 0; j < k_rows; ++j) {
+        grad_row[j] = row[j] * (grad_row[j] - out_dot[i]);
+      }
+    }
+  };
+  // dV += P^T dO, dK += scale * dS^T Q
+  auto keys_values_grads = [&](const index_t a, const index_t q_begin, const index_t q_rows,
+                               const index_t k_begin, const index_t k_rows,
+                               const float* probs, const float* probs_grads) {
+    const float* queries   = queries_keys_values + q_begin * lead_dim + a * 3 * head_dim;
+    const float* out_grads = output_grads + q_begin * out_lead_dim + a * head_dim;
+    float* keys_grads      = queries_keys_values_grads + a * 3 * head_dim + head_dim;
+    float* values_grads    = keys_grads + head_dim;
+    cblas_sgemm(CblasRowMajor, CblasTrans, CblasNoTrans,
+                k_rows, head_dim, q_rows,
+                1.f, probs, kSelfAttKeyBlock,
+                out_grads, out_lead_dim,
+                1.f, values_grads + k_begin * lead_dim, lead_dim);
+    cblas_sgemm(CblasRowMajor, CblasTrans, CblasNoTrans,
+                k_rows, head_dim, q_rows,
+                scale, probs_grads, kSelfAttKeyBlock,
+                queries, lead_dim,
+                1.f, keys_grads + k_begin * lead_dim, lead_dim);
+  };
+  // dQ += scale * dS K
+  auto queries_grads = [&](const index_t a, const index_t q_begin, const index_t q_rows,
+                           const index_t k_begin, const index_t k_rows,
+                           const float* probs_grads) {
+    const float* keys = queries_keys_values + a * 3 * head_dim + head_dim;
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                q_rows, head_dim, k_rows,
+                scale, probs_grads, kSelfAttKeyBlock,
+                keys + k_begin * lead_dim, lead_dim,
+                1.f, queries_keys_values_grads + q_begin * lead_dim + a * 3 * head_dim, lead_dim);
+  };
+
+  if (req[0] == kWriteTo) {
+    #pragma omp parallel for num_threads(nthreads)
+    for (index_t i = 0; i < qkv_seq_len; ++i) {
+      std::fill(queries_keys_values_grads + i * lead_dim,
+                queries_keys_values_grads + (i + 1) * lead_dim, 0.f);
+    }
+  }
+
+  if (attn_batches >= nthreads) {
+    #pragma omp parallel for num_threads(nthreads)
+    for (index_t a = 0; a < attn_batches; ++a) {
+      float* probs       = workspace.dptr_ + omp_get_thread_num() * thread_size;
+      float* probs_grads = probs + scores_size;
+      float* out_dot     = probs_grads + scores_size;
+      for (index_t q_begin = 0; q_begin < qkv_seq_len; q_begin += kSelfAttQueryBlock) {
+        const index_t q_rows = std::min(kSelfAttQueryBlock, qkv_seq_len - q_begin);
+        const index_t k_end  = SelfAttKeyEnd(params.causal, lengths[a / params.heads],
+                                             q_begin, q_rows);
+        out_dots(a, q_begin, q_rows, out_dot);
+        for (index_t k_begin = 0; k_begin < k_end; k_begin += kSelfAttKeyBlock) {
+          const index_t k_rows = std::min(kSelfAttKeyBlock, k_end - k_begin);
+          block_grads(a, q_begin, q_rows, k_begin, k_rows, out_dot, probs, probs_grads);
+          keys_values_grads(a, q_begin, q_rows, k_begin, k_rows, probs, probs_grads);
+          queries_grads(a, q_begin, q_rows, k_begin, k_rows, probs_grads);
+        }
+      }
+    }
+    return;
+  }
+
+  // too few attention batches for the threads: every block of keys accumulates its
+  // gradients over the blocks of queries, then every block of queries over the keys
+  const index_t q_blocks = (qkv_seq_len + kSelfAttQueryBlock - 1) / kSelfAttQueryBlock;
+  const index_t k_blocks = (qkv_seq_len + kSelfAttKeyBlock - 1) / kSelfAttKeyBlock;
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t task = 0; task < attn_batches * k_blocks; ++task) {
+    float* probs       = workspace.dptr_ + omp_get_thread_num() * thread_size;
+    float* probs_grads = probs + scores_size;
+    float* out_dot     = probs_grads + scores_size;
+    const index_t a       = task / k_blocks;
+    const index_t k_begin = (task % k_blocks) * kSelfAttKeyBlock;
+    for (index_t q_begin = 0; q_begin < qkv_seq_len; q_begin += kSelfAttQueryBlock) {
+      const index_t q_rows = std::min(kSelfAttQueryBlock, qkv_seq_len - q_begin);
+      const index_t k_end  = SelfAttKeyEnd(params.causal, lengths[a / params.heads],
+                                           q_begin, q_rows);
+      if (k_begin >= k_end) continue;
+      const index_t k_rows = std::min(kSelfAttKeyBlock, k_end - k_begin);
+      out_dots(a, q_begin, q_rows, out_dot);
+      block_grads(a, q_begin, q_rows, k_begin, k_rows, out_dot, probs, probs_grads);
+      keys_values_grads(a, q_begin, q_rows, k_begin, k_rows, probs, probs_grads);
+    }
+  }
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t task = 0; task < attn_batches * q_blocks; ++task) {
+    float* probs       = workspace.dptr_ + omp_get_thread_num() * thread_size;
+    float* probs_grads = probs + scores_size;
+    float* out_dot     = probs_grads + scores_size;
+    const index_t a       = task / q_blocks;
+    const index_t q_begin = (task % q_blocks) * kSelfAttQueryBlock;
+    const index_t q_rows  = std::min(kSelfAttQueryBlock, qkv_seq_len - q_begin);
+    const index_t k_end   = SelfAttKeyEnd(params.causal, lengths[a / params.heads],
+                                          q_begin, q_rows);
+    out_dots(a, q_begin, q_rows, out_dot);
+    for (index_t k_begin = 0; k_begin < k_end; k_begin += kSelfAttKeyBlock) {
+      const index_t k_rows = std::min(kSelfAttKeyBlock, k_end - k_begin);
+      block_grads(a, q_begin, q_rows, k_begin, k_rows, out_dot, probs, probs_grads);
+      queries_grads(a, q_begin, q_rows, k_begin, k_rows, probs_grads);
+    }
+  }
+}
+
 NNVM_REGISTER_OP(_contrib_interleaved_matmul_selfatt_qk)
 .describe(R"code(Compute the matrix multiplication between the projections of
 queries and keys in multihead attention use as self attention.
@@ -830,6 +1241,86 @@ NNVM_REGISTER_OP(_backward_interleaved_matmul_encdec_valatt)
 .set_attr_parser(ParamParser<InterleavedMatMulParam>)
 .set_attr<FCompute>("FCompute<cpu>", BackwardInterleavedMatMulEncDecValAttCPU);
 
+NNVM_REGISTER_OP(_contrib_interleaved_selfatt)
+.describe(R"code(Compute multihead self attention from the interleaved projections of
+queries, keys and values, fusing the matrix multiplications, the scaling, the masking
+and the softmax.
+
+the input must be a single tensor of interleaved projections
+of queries, keys and values following the layout:
+(seq_length, batch_size, num_heads * head_dim * 3)
+
+the equivalent code would be::
+
+  att = mx.nd.contrib.interleaved_matmul_selfatt_qk(queries_keys_values, heads=num_heads)
+  # keys past valid_length, or following the query if causal, get a score of -inf
+  att = mx.nd.softmax(att, axis=-1)
+  output = mx.nd.contrib.interleaved_matmul_selfatt_valatt(queries_keys_values, att,
+                                                           heads=num_heads)
+
+The CPU implementation processes blocks of queries against blocks of keys with an
+online softmax, so that the (batch_size * num_heads, seq_length, seq_length) attention
+maps are never materialized, neither in the forward nor in the backward pass.
+Queries without any valid key produce zeros. valid_length may be of any integer or
+floating point type and defaults to int32.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 2 : 1;
+})
+.set_num_outputs(2)
+.set_attr_parser(ParamParser<InterleavedSelfAttParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return params.use_length ?
+    std::vector<std::string>{"queries_keys_values", "valid_length"} :
+    std::vector<std::string>{"queries_keys_values"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"output", "logsumexp"};
+})
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs", [](const NodeAttrs& attrs) {
+  return 1;
+})
+.set_attr<mxnet::FInferShape>("FInferShape", InterleavedSelfAttShape)
+.set_attr<nnvm::FInferType>("FInferType", InterleavedSelfAttType)
+.set_attr<FCompute>("FCompute<cpu>", InterleavedSelfAttCPU)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<nnvm::FGradient>("FGradient", [](const nnvm::ObjectPtr& n,
+                                           const std::vector<nnvm::NodeEntry>& ograds) {
+  std::vector<nnvm::NodeEntry> heads;
+  heads.push_back(ograds[0]);  // ograd
+  for (auto& h : n->inputs) {
+    heads.push_back(h);  // queries_keys_values, valid_length
+  }
+  heads.emplace_back(n, 0, 0);  // output
+  heads.emplace_back(n, 1, 0);  // logsumexp
+  return MakeGradNode("_backward_interleaved_selfatt", n, heads, n->attrs.dict);
+})
+.add_argument("queries_keys_values", "NDArray-or-Symbol", "Queries, keys and values interleaved")
+.add_argument("valid_length", "NDArray-or-Symbol", "Valid length of every sequence, "
+              "used if use_length is true")
+.add_arguments(InterleavedSelfAttParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_interleaved_selfatt)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 5 : 4;
+})
+.set_num_outputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 2 : 1;
+})
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr_parser(ParamParser<InterleavedSelfAttParam>)
+.set_attr<FCompute>("FCompute<cpu>", BackwardInterleavedSelfAttCPU)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+});
+
 
 // relu
 MXNET_OPERATOR_REGISTER_UNARY(_contrib_div_sqrt_dim)
@@ -24,8 +24,6 @@
 #include <map>
 #include <vector>
 
-#if MXNET_USE_CUDA
-
 namespace mxnet {
 
 namespace fusion {
@@ -220,6 +218,8 @@ const std::vector<std::string> variable_io_ops = {
 };
 
 
+#if MXNET_USE_CUDA
+
 const char kernel_begin[] = R"code(
 const int tid = threadIdx.x + blockIdx.x * blockDim.x;
 for (int i = tid; i < N; i+= gridDim.x * blockDim.x) {
@@ -230,10 +230,10 @@ const char kernel_end[] = R"code(}
 }
 )code";
 
+#endif  // MXNET_USE_CUDA
+
 }  // namespace fusion
 
 }  // namespace mxnet
 
-#endif  // MXNET_USE_CUDA
-
 #endif  // MXNET_OPERATOR_FUSION_FUSED_OP_INL_H_
@@ -17,14 +17,17 @@
  * under the License.
  */
 
+#include <dmlc/omp.h>
 #include <tuple>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 
 #include "./fused_op.h"
 #include "../operator_common.h"
+#include "../../engine/openmp.h"
 #include "../../imperative/exec_pass.h"
 
-#if MXNET_USE_CUDA
-
 namespace mxnet {
 
 DMLC_REGISTER_PARAMETER(FusedOpConfig);
@@ -177,6 +180,221 @@ FusedOp::GetAttrs(const std::string& attr_name, const uint32_t node_id) {
                          outputs);
 }
 
+void FusedOp::SelectIntermediateAttrs(const std::vector<mxnet::TShape> &in_shapes,
+                                      const std::vector<mxnet::TShape> &out_shapes,
+                                      const std::vector<int> &in_dtypes,
+                                      const std::vector<int> &out_dtypes) {
+  for (auto it = intermediate_shapes_.begin();
+       it != intermediate_shapes_.end();
+       ++it) {
+    if (it->input_attr == in_shapes && it->output_attr == out_shapes) {
+      intermediate_shapes_.erase(intermediate_shapes_.begin(), it);
+      break;
+    }
+  }
+  for (auto it = intermediate_dtypes_.begin();
+       it != intermediate_dtypes_.end();
+       ++it) {
+    if (it->input_attr == in_dtypes && it->output_attr == out_dtypes) {
+      intermediate_dtypes_.erase(intermediate_dtypes_.begin(), it);
+      break;
+    }
+  }
+}
+
+namespace {
+
+inline size_t AlignCPUScratch(size_t bytes) {
+  return (bytes + 63) & ~static_cast<size_t>(63);
+}
+
+inline bool BlobsOverlap(const TBlob& a, const TBlob& b) {
+  const char* a_begin = static_cast<const char*>(a.dptr_);
+  const char* b_begin = static_cast<const char*>(b.dptr_);
+  const char* a_end = a_begin + a.Size() * mshadow::mshadow_sizeof(a.type_flag_);
+  const char* b_end = b_begin + b.Size() * mshadow::mshadow_sizeof(b.type_flag_);
+  return a_begin < b_end && b_begin < a_end;
+}
+
+}  // namespace
+
+/*
+ * The CPU version does not generate code. Instead, the nodes of the subgraph
+ * are executed one after another with their own FCompute<cpu> implementations,
+ * but on cache-sized tiles of the data: every thread takes a tile of
+ * kCPUTileSize elements and pushes it through the whole chain before moving on
+ * to the next one, keeping all the intermediate results in a per-thread
+ * scratch buffer. A chain of k pointwise ops then makes a single pass over
+ * main memory instead of k. If the subgraph contains entries of different
+ * sizes (e.g. broadcasting), the nodes are executed on the full tensors
+ * instead, which still avoids allocating the intermediates in the graph.
+ */
+template <>
+void FusedOp::Forward<cpu>(const nnvm::NodeAttrs& attrs,
+                           const OpContext &ctx,
+                           const std::vector<TBlob> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &outputs) {
+  using namespace mshadow;
+  static auto& fcompute_cpu = Op::GetAttr<FCompute>("FCompute<cpu>");
+  std::lock_guard<std::mutex> lock(my_mutex_);
+  CHECK_GE(outputs.size(), 1) << "There needs to be at least 1 output.";
+  CHECK_EQ(inputs.size(), inputs_.size());
+  CHECK_EQ(outputs.size(), outputs_.size());
+
+  std::vector<mxnet::TShape> in_shapes, out_shapes;
+  std::vector<int> in_dtypes, out_dtypes;
+  for (const auto& blob : inputs) {
+    in_shapes.push_back(blob.shape_);
+    in_dtypes.push_back(blob.type_flag_);
+  }
+  for (const auto& blob : outputs) {
+    out_shapes.push_back(blob.shape_);
+    out_dtypes.push_back(blob.type_flag_);
+  }
+  SelectIntermediateAttrs(in_shapes, out_shapes, in_dtypes, out_dtypes);
+
+  const auto& node_shapes = intermediate_shapes_[0].internal_attr;
+  const auto& node_dtypes = intermediate_dtypes_[0].internal_attr;
+  const auto& g = subgraph_.indexed_graph();
+  const auto& input_nids = g.input_nodes();
+  const size_t num_entries = g.num_node_entries();
+
+  const index_t N = outputs[0].Size();
+  bool tiled = true;
+  for (size_t eid = 0; eid < num_entries; ++eid) {
+    tiled = tiled && static_cast<index_t>(node_shapes[eid].Size()) == N;
+  }
+
+  // Where each entry of the subgraph lives: an input, an output written
+  // directly or a slot in the scratch buffer
+  constexpr int kScratch = -1;
+  std::vector<int> entry_input(num_entries, kScratch);
+  std::vector<int> entry_output(num_entries, kScratch);
+  std::vector<size_t> scratch_offset(num_entries, 0);
+  for (size_t i = 0; i < input_nids.size(); ++i) {
+    entry_input[g.entry_id(input_nids[i], 0)] = i;
+  }
+  for (size_t i = 0; i < g.outputs().size(); ++i) {
+    entry_output[g.entry_id(g.outputs()[i])] = i;
+  }
+  // Inputs aliasing one of the outputs (FInplaceOption allows any pair) need
+  // to be copied before a tile of the output gets overwritten
+  std::vector<bool> copy_input(inputs.size(), false);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    for (size_t j = 0; j < outputs.size(); ++j) {
+      if (req[j] != kNullOp && BlobsOverlap(inputs[i], outputs[j])) {
+        copy_input[i] = true;
+      }
+    }
+  }
+  size_t scratch_size = 0;
+  for (size_t eid = 0; eid < num_entries; ++eid) {
+    const int in = entry_input[eid];
+    const int out = entry_output[eid];
+    const bool needs_scratch = (in != kScratch) ? copy_input[in] :
+                               (out == kScratch || (req[out] != kWriteTo &&
+                                                    req[out] != kWriteInplace));
+    if (needs_scratch) {
+      const size_t elems = tiled ? kCPUTileSize : node_shapes[eid].Size();
+      scratch_offset[eid] = scratch_size;
+      scratch_size += AlignCPUScratch(elems * mshadow_sizeof(node_dtypes[eid]));
+    } else {
+      scratch_offset[eid] = std::numeric_limits<size_t>::max();
+    }
+  }
+
+  const index_t num_tiles = tiled ? (N + kCPUTileSize - 1) / kCPUTileSize : 1;
+  const int nthreads = std::max(1, std::min(
+      engine::OpenMP::Get()->GetRecommendedOMPThreadCount(),
+      static_cast<int>(num_tiles)));
+  // The nodes of the subgraph do not request any resource (see IsCPUFusionCompatible),
+  // so the temporary space of the fused op is only used for the scratch buffers
+  char* workspace = nullptr;
+  if (scratch_size > 0) {
+    workspace = ctx.requested[0].get_space_typed<cpu, 1, char>(
+        Shape1(scratch_size * nthreads), ctx.get_stream<cpu>()).dptr_;
+  }
+
+  auto entry_blob = [&](const uint32_t eid, const index_t begin,
+                        const index_t len, char* scratch) {
+    const int dtype = node_dtypes[eid];
+    const mxnet::TShape shape = tiled ? mxnet::TShape(mshadow::Shape1(len)) : node_shapes[eid];
+    if (scratch_offset[eid] != std::numeric_limits<size_t>::max()) {
+      return TBlob(scratch + scratch_offset[eid], shape, cpu::kDevMask, dtype);
+    }
+    const TBlob& base = (entry_input[eid] != kScratch) ? inputs[entry_input[eid]]
+                                                       : outputs[entry_output[eid]];
+    char* ptr = static_cast<char*>(base.dptr_) + begin * mshadow_sizeof(dtype);
+    return TBlob(ptr, shape, cpu::kDevMask, dtype);
+  };
+
+  auto run_range = [&](const index_t begin, const index_t len, char* scratch) {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (copy_input[i]) {
+        const uint32_t eid = g.entry_id(input_nids[i], 0);
+        const size_t type_size = mshadow_sizeof(node_dtypes[eid]);
+        std::memcpy(scratch + scratch_offset[eid],
+                    static_cast<const char*>(inputs[i].dptr_) + begin * type_size,
+                    len * type_size);
+      }
+    }
+    for (size_t nid = 0; nid < g.num_nodes(); ++nid) {
+      const auto& node = g[nid];
+      if (node.source->is_variable()) continue;
+      std::vector<TBlob> node_inputs, node_outputs;
+      node_inputs.reserve(node.inputs.size());
+      for (const auto& e : node.inputs) {
+        node_inputs.emplace_back(entry_blob(g.entry_id(e), begin, len, scratch));
+      }
+      const uint32_t num_outputs = node.source->num_outputs();
+      node_outputs.reserve(num_outputs);
+      for (uint32_t i = 0; i < num_outputs; ++i) {
+        node_outputs.emplace_back(entry_blob(g.entry_id(nid, i), begin, len, scratch));
+      }
+      const std::vector<OpReqType> node_req(num_outputs, kWriteTo);
+      fcompute_cpu[node.source->op()](node.source->attrs, ctx,
+                                      node_inputs, node_req, node_outputs);
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      if (req[i] != kAddTo) continue;
+      const uint32_t eid = g.entry_id(g.outputs()[i]);
+      MSHADOW_TYPE_SWITCH(outputs[i].type_flag_, DType, {
+        const DType* src = reinterpret_cast<const DType*>(scratch + scratch_offset[eid]);
+        DType* dst = outputs[i].dptr<DType>() + begin;
+        for (index_t j = 0; j < len; ++j) {
+          dst[j] += src[j];
+        }
+      });
+    }
+  };
+
+  if (!tiled) {
+    run_range(0, N, workspace);
+    return;
+  }
+  dmlc::OMPException omp_exc;
+  #pragma omp parallel for num_threads(nthreads) schedule(static)
+  for (index_t tile = 0; tile < num_tiles; ++tile) {
+    omp_exc.Run([&] {
+      const int tid = omp_get_thread_num();
+      const index_t begin = tile * kCPUTileSize;
+      run_range(begin, std::min(kCPUTileSize, N - begin),
+                workspace + tid * scratch_size);
+    });
+  }
+  omp_exc.Rethrow();
+}
+
+void FusedOpForwardCPU(const nnvm::NodeAttrs& attrs,
+                       const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+  const FusedOpPtr& op = nnvm::get<FusedOpPtr>(attrs.parsed);
+  op->Forward<cpu>(attrs, ctx, inputs, req, outputs);
+}
+
 bool FusedOpInferShape(const nnvm::NodeAttrs& attrs,
                        std::vector<mxnet::TShape> *in_attrs,
                        std::vector<mxnet::TShape> *out_attrs) {
@@ -240,6 +458,15 @@ NNVM_REGISTER_OP(_FusedOp)
                                              FusedOpProvideStorageType)
 .set_attr<mxnet::FInferShape>("FInferShape", FusedOpInferShape)
 .set_attr<nnvm::FInferType>("FInferType", FusedOpInferType)
+.set_attr<FCompute>("FCompute<cpu>", FusedOpForwardCPU)
+.set_attr<FResourceRequestEx>("FResourceRequestEx",
+  [](const NodeAttrs& attrs, const int dev_mask, const DispatchMode dispatch_mode) {
+    std::vector<ResourceRequest> request;
+    if (dev_mask == mshadow::cpu::kDevMask) {
+      request.emplace_back(ResourceRequest::kTempSpace);
+    }
+    return request;
+  })
 .set_attr_parser(FusedOpParamParser)
 .add_argument("data", "NDArray-or-Symbol[]", "Data");
 
@@ -301,5 +528,3 @@ NNVM_REGISTER_OP(_FusedOpOutHelper)
 .set_attr<exec::FAccessSubgraphType>("FAccessSubgraphType", FusedOpOutHelperType);
 
 }  // namespace mxnet
-
-#endif  // MXNET_USE_CUDA
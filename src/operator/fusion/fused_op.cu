@@ -634,22 +634,7 @@ void FusedOp::CheckShapesAndTypes(const std::vector<TBlob> &inputs,
     *nvec = max(*nvec, mshadowTypeToVectorLength(blob.type_flag_));
   }
 
-  for (auto it = intermediate_shapes_.begin();
-       it != intermediate_shapes_.end();
-       ++it) {
-    if (it->input_attr == in_shapes && it->output_attr == out_shapes) {
-      intermediate_shapes_.erase(intermediate_shapes_.begin(), it);
-      break;
-    }
-  }
-  for (auto it = intermediate_dtypes_.begin();
-       it != intermediate_dtypes_.end();
-       ++it) {
-    if (it->input_attr == *in_dtypes && it->output_attr == *out_dtypes) {
-      intermediate_dtypes_.erase(intermediate_dtypes_.begin(), it);
-      break;
-    }
-  }
+  SelectIntermediateAttrs(in_shapes, out_shapes, *in_dtypes, *out_dtypes);
 }
 
 template <>
@@ -28,14 +28,18 @@
 #include <mutex>
 #include <tuple>
 
-#if MXNET_USE_CUDA
-
 namespace mxnet {
 
 namespace fusion {
   enum KernelVariants {kGeneral, kShapeOptimized,
     kNumKernelVariants  // Not a variant- leave this at the end
   };
+
+  /*! \brief Number of elements processed at once by a single CPU thread.
+   *         Intermediate results of the whole fused chain for one tile
+   *         are kept in a per-thread scratch buffer that fits in L2 cache.
+   */
+  const index_t kCPUTileSize = 4096;
 }
 
 struct FusedOpConfig : public dmlc::Parameter<FusedOpConfig> {
@@ -125,6 +129,7 @@ class FusedOp {
   }
 
  private:
+#if MXNET_USE_CUDA
   std::string GenerateCode(const std::vector<OpReqType> &req,
                            const std::vector<int> &in_dtypes,
                            const std::vector<int> &out_dtypes,
@@ -146,6 +151,17 @@ class FusedOp {
                            std::vector<int> *out_dtypes,
                            std::vector<int> *out_ndims,
                            int *nvec);
+#endif  // MXNET_USE_CUDA
+
+  /*! \brief Drop the intermediate attributes stored by InferShape/InferType
+   *         that were computed before the ones matching the given signature,
+   *         so that intermediate_shapes_[0]/intermediate_dtypes_[0] describe
+   *         the current call.
+   */
+  void SelectIntermediateAttrs(const std::vector<mxnet::TShape> &in_shapes,
+                               const std::vector<mxnet::TShape> &out_shapes,
+                               const std::vector<int> &in_dtypes,
+                               const std::vector<int> &out_dtypes);
 
   std::vector<FusedOpEntry> inputs_;
   std::vector<FusedOpEntry> outputs_;
@@ -177,7 +193,9 @@ class FusedOp {
   std::vector<uint32_t> extra_shape_args_;
   std::vector<uint32_t> check_shape_args_;
 
+#if MXNET_USE_CUDA
   CUfunction kernel_functions_[fusion::kNumKernelVariants];
+#endif  // MXNET_USE_CUDA
   bool initialized_;
   int kernel_function_dev_id_;
 
@@ -200,6 +218,4 @@ using FusedOpHelperParamPtr = std::shared_ptr<FusedOpHelperParam>;
 
 }  // namespace mxnet
 
-#endif  // MXNET_USE_CUDA
-
 #endif  // MXNET_OPERATOR_FUSION_FUSED_OP_H_
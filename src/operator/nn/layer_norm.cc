@@ -25,6 +25,8 @@
 
 #include "layer_norm-inl.h"
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
 #include "../elemwise_op_common.h"
 
 #if MSHADOW_USE_MKL == 1
@@ -68,11 +70,115 @@ static bool LayerNormShape(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
+/*! \brief number of interleaved Welford accumulators per row */
+constexpr int kLayerNormLanes = 8;
+
+/*!
+ * \brief Single pass mean and variance of a row with Welford's algorithm.
+ *  The row is split over kLayerNormLanes interleaved accumulators so that the
+ *  updates vectorize, and the lanes are combined with Chan's formula.
+ */
+template<typename AType, typename DType>
+inline void LayerNormRowMoments(const DType* x, const index_t n, AType* mean, AType* var) {
+  AType lane_mean[kLayerNormLanes], lane_m2[kLayerNormLanes];
+  for (int l = 0; l < kLayerNormLanes; ++l) {
+    lane_mean[l] = lane_m2[l] = AType(0);
+  }
+  const index_t nvec = n / kLayerNormLanes;
+  for (index_t k = 0; k < nvec; ++k) {
+    const AType inv_count = AType(1) / static_cast<AType>(k + 1);
+    const DType* xk = x + k * kLayerNormLanes;
+    for (int l = 0; l < kLayerNormLanes; ++l) {
+      const AType v = static_cast<AType>(xk[l]);
+      const AType delta = v - lane_mean[l];
+      lane_mean[l] += delta * inv_count;
+      lane_m2[l] += delta * (v - lane_mean[l]);
+    }
+  }
+  AType count = 0, m = 0, m2 = 0;
+  if (nvec > 0) {
+    const AType lane_count = static_cast<AType>(nvec);
+    for (int l = 0; l < kLayerNormLanes; ++l) {
+      const AType new_count = count + lane_count;
+      const AType delta = lane_mean[l] - m;
+      m += delta * lane_count / new_count;
+      m2 += lane_m2[l] + delta * delta * count * lane_count / new_count;
+      count = new_count;
+    }
+  }
+  for (index_t j = nvec * kLayerNormLanes; j < n; ++j) {
+    const AType v = static_cast<AType>(x[j]);
+    count += 1;
+    const AType delta = v - m;
+    m += delta / count;
+    m2 += delta * (v - m);
+  }
+  *mean = m;
+  *var = n > 0 ? m2 / static_cast<AType>(n) : AType(0);
+}
+
+/*!
+ * \brief Fused forward of LayerNorm over the last axis: one pass for the moments
+ *  and one pass writing the output, accumulating in AType.
+ */
+template<typename AType, typename DType>
+void LayerNormCPUKernel(const index_t nbatch, const index_t nchannel, const AType eps,
+                        const DType* in_data, const DType* gamma, const DType* beta,
+                        DType* out_data, DType* mean_data, DType* std_data) {
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t i = 0; i < nbatch; ++i) {
+    const DType* x = in_data + i * nchannel;
+    DType* y = out_data + i * nchannel;
+    AType mean, var;
+    LayerNormRowMoments(x, nchannel, &mean, &var);
+    const AType std = std::sqrt(var + eps);
+    const AType inv_std = AType(1) / std;
+#if !defined(_MSC_VER)
+#pragma omp simd
+#endif
+    for (index_t j = 0; j < nchannel; ++j) {
+      y[j] = DType((static_cast<AType>(x[j]) - mean) * inv_std * static_cast<AType>(gamma[j])
+                   + static_cast<AType>(beta[j]));
+    }
+    mean_data[i] = DType(mean);
+    std_data[i] = DType(std);
+  }
+}
+
+void LayerNormCPUContig(const LayerNormParam& param,
+                        const OpContext& ctx, const std::vector<TBlob>& inputs,
+                        const std::vector<OpReqType>& req,
+                        const std::vector<TBlob>& outputs) {
+  const TBlob& in_data = inputs[layernorm::kData];
+  const index_t nchannel = in_data.shape_[in_data.ndim() - 1];
+  const index_t nbatch = in_data.shape_.Size() / nchannel;
+  CHECK_EQ(in_data.CheckContiguous(), true);
+  CHECK_EQ(outputs[layernorm::kOut].CheckContiguous(), true);
+  MSHADOW_REAL_TYPE_SWITCH_EX(in_data.type_flag_, DType, AType, {
+    LayerNormCPUKernel<AType, DType>(nbatch, nchannel, static_cast<AType>(param.eps),
+                                     in_data.dptr<DType>(),
+                                     inputs[layernorm::kGamma].dptr<DType>(),
+                                     inputs[layernorm::kBeta].dptr<DType>(),
+                                     outputs[layernorm::kOut].dptr<DType>(),
+                                     outputs[layernorm::kMean].dptr<DType>(),
+                                     outputs[layernorm::kStd].dptr<DType>());
+  });
+}
+
 template<>
 void LayerNormCompute<cpu>(const nnvm::NodeAttrs& attrs,
                            const OpContext& ctx, const std::vector<TBlob>& inputs,
                            const std::vector<OpReqType>& req,
                            const std::vector<TBlob>& outputs) {
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kAddTo);
+  int axis = GetRealAxis(param.axis, inputs[0].ndim());
+  CHECK(axis >= 0 && axis < inputs[0].ndim()) << "Channel axis out of range: " << param.axis;
+  if (axis == inputs[0].ndim() - 1 && inputs[0].Size() > 0) {
+    return LayerNormCPUContig(param, ctx, inputs, req, outputs);
+  }
   return LayerNormComputeGeneral<cpu>(attrs, ctx, inputs, req, outputs);
 }
 
@@ -121,11 +227,141 @@ void LayerNormComputeMKL(const nnvm::NodeAttrs& attrs,
 #endif
 
 
+/*!
+ * \brief Fused backward of LayerNorm over the last axis.
+ *  With \bar{x} = (x - mean) / std and w = og * gamma / std:
+ *    grad_x = w - mean(w, axis) - \bar{x} * mean(w * \bar{x}, axis)
+ *    grad_gamma = sum(og * \bar{x}, exclude_axis), grad_beta = sum(og, exclude_axis)
+ *  The rows are split in npart contiguous ranges. Each range accumulates its own
+ *  partial grad_gamma/grad_beta in part_gamma/part_beta ([npart, nchannel] each),
+ *  which are summed over the parts afterwards.
+ */
+template<typename AType, typename DType>
+void LayerNormGradCPUKernel(const index_t nbatch, const index_t nchannel, const int npart,
+                            const DType* ograd, const DType* in_data, const DType* gamma,
+                            const DType* mean_data, const DType* std_data,
+                            const OpReqType data_req, DType* data_grad,
+                            AType* part_gamma, AType* part_beta) {
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const bool need_gamma_beta = part_gamma != nullptr;
+  const bool data_addto = data_req == kAddTo;
+  const AType inv_nchannel = AType(1) / static_cast<AType>(nchannel);
+  const index_t rows_per_part = (nbatch + npart - 1) / npart;
+  #pragma omp parallel for num_threads(nthreads)
+  for (int part = 0; part < npart; ++part) {
+    AType* pgamma = need_gamma_beta ? part_gamma + part * nchannel : nullptr;
+    AType* pbeta = need_gamma_beta ? part_beta + part * nchannel : nullptr;
+    if (need_gamma_beta) {
+      std::fill(pgamma, pgamma + nchannel, AType(0));
+      std::fill(pbeta, pbeta + nchannel, AType(0));
+    }
+    const index_t row_end = std::min(nbatch, (part + 1) * rows_per_part);
+    for (index_t i = part * rows_per_part; i < row_end; ++i) {
+      const DType* og = ograd + i * nchannel;
+      const DType* x = in_data + i * nchannel;
+      const AType mean = static_cast<AType>(mean_data[i]);
+      const AType inv_std = AType(1) / static_cast<AType>(std_data[i]);
+      AType sum_w = 0, sum_w_xhat = 0;
+      if (need_gamma_beta) {
+#if !defined(_MSC_VER)
+#pragma omp simd reduction(+:sum_w, sum_w_xhat)
+#endif
+        for (index_t j = 0; j < nchannel; ++j) {
+          const AType g = static_cast<AType>(og[j]);
+          const AType xhat = (static_cast<AType>(x[j]) - mean) * inv_std;
+          const AType w = g * static_cast<AType>(gamma[j]) * inv_std;
+          sum_w += w;
+          sum_w_xhat += w * xhat;
+          pgamma[j] += g * xhat;
+          pbeta[j] += g;
+        }
+      } else {
+#if !defined(_MSC_VER)
+#pragma omp simd reduction(+:sum_w, sum_w_xhat)
+#endif
+        for (index_t j = 0; j < nchannel; ++j) {
+          const AType xhat = (static_cast<AType>(x[j]) - mean) * inv_std;
+          const AType w = static_cast<AType>(og[j]) * static_cast<AType>(gamma[j]) * inv_std;
+          sum_w += w;
+          sum_w_xhat += w * xhat;
+        }
+      }
+      if (data_req == kNullOp) continue;
+      const AType mean_w = sum_w * inv_nchannel;
+      const AType mean_w_xhat = sum_w_xhat * inv_nchannel;
+      DType* dx = data_grad + i * nchannel;
+#if !defined(_MSC_VER)
+#pragma omp simd
+#endif
+      for (index_t j = 0; j < nchannel; ++j) {
+        const AType xhat = (static_cast<AType>(x[j]) - mean) * inv_std;
+        const AType w = static_cast<AType>(og[j]) * static_cast<AType>(gamma[j]) * inv_std;
+        const AType grad = w - mean_w - xhat * mean_w_xhat;
+        dx[j] = DType(data_addto ? static_cast<AType>(dx[j]) + grad : grad);
+      }
+    }
+  }
+}
+
+void LayerNormGradCPUContig(const LayerNormParam& param,
+                            const OpContext& ctx, const std::vector<TBlob>& inputs,
+                            const std::vector<OpReqType>& req,
+                            const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  const TBlob& ograd = inputs[0];
+  const TBlob& in_data = inputs[1];
+  const index_t nchannel = in_data.shape_[in_data.ndim() - 1];
+  const index_t nbatch = in_data.shape_.Size() / nchannel;
+  CHECK_EQ(ograd.CheckContiguous(), true);
+  CHECK_EQ(in_data.CheckContiguous(), true);
+  CHECK_NE(req[0], kWriteInplace);
+  const bool need_gamma_beta = req[1] != kNullOp || req[2] != kNullOp;
+  if (req[0] == kNullOp && !need_gamma_beta) return;
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int npart = static_cast<int>(std::max<index_t>(1, std::min<index_t>(nthreads, nbatch)));
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  MSHADOW_REAL_TYPE_SWITCH_EX(in_data.type_flag_, DType, AType, {
+    AType* part_gamma = nullptr;
+    AType* part_beta = nullptr;
+    if (need_gamma_beta) {
+      Tensor<cpu, 1, AType> workspace = ctx.requested[0].get_space_typed<cpu, 1, AType>(
+        Shape1(2 * npart * nchannel), s);
+      part_gamma = workspace.dptr_;
+      part_beta = workspace.dptr_ + npart * nchannel;
+    }
+    LayerNormGradCPUKernel<AType, DType>(nbatch, nchannel, npart,
+                                         ograd.dptr<DType>(), in_data.dptr<DType>(),
+                                         inputs[2].dptr<DType>(), inputs[3].dptr<DType>(),
+                                         inputs[4].dptr<DType>(), req[0],
+                                         outputs[0].dptr<DType>(), part_gamma, part_beta);
+    if (need_gamma_beta) {
+      DType* gamma_grad = outputs[1].dptr<DType>();
+      DType* beta_grad = outputs[2].dptr<DType>();
+      #pragma omp parallel for num_threads(nthreads)
+      for (index_t j = 0; j < nchannel; ++j) {
+        AType sum_gamma = 0, sum_beta = 0;
+        for (int part = 0; part < npart; ++part) {
+          sum_gamma += part_gamma[part * nchannel + j];
+          sum_beta += part_beta[part * nchannel + j];
+        }
+        KERNEL_ASSIGN(gamma_grad[j], req[1], DType(sum_gamma));
+        KERNEL_ASSIGN(beta_grad[j], req[2], DType(sum_beta));
+      }
+    }
+  });
+}
+
 template<>
 void LayerNormGradCompute<cpu>(const nnvm::NodeAttrs& attrs,
                                const OpContext& ctx, const std::vector<TBlob>& inputs,
                                const std::vector<OpReqType>& req,
                                const std::vector<TBlob>& outputs) {
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  int axis = GetRealAxis(param.axis, inputs[0].ndim());
+  CHECK(axis >= 0 && axis < inputs[0].ndim()) << "Channel axis out of range: " << param.axis;
+  if (axis == inputs[0].ndim() - 1 && inputs[0].Size() > 0) {
+    return LayerNormGradCPUContig(param, ctx, inputs, req, outputs);
+  }
   return LayerNormGradComputeGeneral<cpu>(attrs, ctx, inputs, req, outputs);
 }
 
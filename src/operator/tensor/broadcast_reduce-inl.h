@@ -27,6 +27,9 @@
 
 #include <mxnet/operator_util.h>
 #include <algorithm>
+#include <cmath>
+#include <memory>
+#include <type_traits>
 #include <vector>
 #include <string>
 #include <utility>
@@ -317,16 +320,262 @@ void BinaryBroadcastComputeImpl(Stream<cpu> *s, const OpReqType req,
                     lhs.dptr<DType>(), rhs.dptr<DType>(), out.dptr<DType>());
 }
 
+template<typename Reducer, int ndim, typename AType, typename DType, typename OP,
+         typename IndexOP = mxnet::op::mshadow_op::set_index_no_op<AType, index_t>>
+MSHADOW_XINLINE void seq_reduce_range(const index_t idx, const index_t begin, const index_t end,
+                                      const DType* __restrict big, const Shape<ndim>& bshape,
+                                      const Shape<ndim>& sshape, const Shape<ndim>& rshape,
+                                      const Shape<ndim>& rstride, AType* val, AType* residual) {
+  Shape<ndim> coord = mxnet_op::unravel(idx, sshape);
+  index_t j = mxnet_op::ravel(coord, bshape);
+  for (index_t k = begin; k < end; ++k) {
+    coord = mxnet_op::unravel(k, rshape);
+    AType temp = OP::Map(big[j + mxnet_op::dot(coord, rstride)]);
+    if (IndexOP::do_op)
+      IndexOP::Op(&temp, k);
+    Reducer::Reduce(*val, temp, *residual);
+  }
+}
+
+/*!
+ * \brief Minimum number of elements a thread reduces on its own. Reductions with too
+ *  few outputs to occupy all threads split the reduced axis in chunks of at least
+ *  this size, each thread producing a partial result that is merged afterwards.
+ */
+constexpr index_t kReduceSplitGrain = 16384;
+/*! \brief number of outputs accumulated together when the leading axes are reduced */
+constexpr index_t kReduceColumnBlock = 256;
+/*! \brief number of independent accumulators of the vectorized contiguous sum */
+constexpr int kReduceLanes = 8;
+
+/*! \brief memory layouts of a reduction which have a dedicated CPU kernel */
+enum class ReduceLayout {
+  kGeneral,  // reduced and kept axes interleave
+  kInner,    // only trailing axes are reduced, big is viewed as [N, M]
+  kOuter     // only leading axes are reduced, big is viewed as [M, N]
+};
+
+template<int ndim>
+inline ReduceLayout reduce_layout(const Shape<ndim>& small, const Shape<ndim>& big) {
+  bool inner = true, outer = true, seen_kept = false, seen_reduced = false;
+  for (int i = 0; i < ndim; ++i) {
+    if (big[i] == 1) continue;
+    if (small[i] == big[i]) {
+      inner = inner && !seen_reduced;
+      seen_kept = true;
+    } else {
+      outer = outer && !seen_kept;
+      seen_reduced = true;
+    }
+  }
+  if (inner) return ReduceLayout::kInner;
+  if (outer) return ReduceLayout::kOuter;
+  return ReduceLayout::kGeneral;
+}
+
+/*!
+ * \brief Reduction of contiguous memory, without the unravel of every element.
+ *  Range() reduces src[begin, end) into (val, residual) and Columns() reduces the
+ *  rows [begin, end) of a row-major [M, stride] matrix into the first ncol columns
+ *  of (val, residual). Both accumulate into already initialized values and pass
+ *  the position along the reduced axis to IndexOP.
+ */
+template<typename Reducer, typename AType, typename DType, typename OP, typename IndexOP,
+         typename = void>
+struct contiguous_reduce {
+  static void Range(const DType* __restrict src, const index_t begin, const index_t end,
+                    AType* val, AType* residual) {
+    for (index_t k = begin; k < end; ++k) {
+      AType temp = OP::Map(src[k]);
+      if (IndexOP::do_op)
+        IndexOP::Op(&temp, k);
+      Reducer::Reduce(*val, temp, *residual);
+    }
+  }
+
+  static void Columns(const DType* __restrict src, const index_t stride, const index_t ncol,
+                      const index_t begin, const index_t end, AType* val, AType* residual) {
+    for (index_t k = begin; k < end; ++k) {
+      const DType* row = src + k * stride;
+      for (index_t j = 0; j < ncol; ++j) {
+        AType temp = OP::Map(row[j]);
+        if (IndexOP::do_op)
+          IndexOP::Op(&temp, k);
+        Reducer::Reduce(val[j], temp, residual[j]);
+      }
+    }
+  }
+};
+
+/*!
+ * \brief Floating point sum. The Kahan steps of red::sum are applied on plain
+ *  (non-volatile) registers and spread over independent lanes, so that the
+ *  compiler can keep them in SIMD registers.
+ */
+template<typename AType, typename DType, typename OP, typename IndexOP>
+struct contiguous_reduce<mshadow::red::sum, AType, DType, OP, IndexOP,
+                         typename std::enable_if<std::is_floating_point<AType>::value &&
+                                                 !IndexOP::do_op>::type> {
+  MSHADOW_XINLINE static void Add(AType* __restrict sum, AType* __restrict residual,
+                                  const AType src) {
+    const AType y = src - *residual;
+    const AType t = *sum + y;
+    *residual = std::isinf(t) ? AType(0) : (t - *sum) - y;
+    *sum = t;
+  }
+
+  static void Range(const DType* __restrict src, const index_t begin, const index_t end,
+                    AType* val, AType* residual) {
+    AType sum[kReduceLanes], res[kReduceLanes];
+    for (int l = 0; l < kReduceLanes; ++l) {
+      sum[l] = res[l] = AType(0);
+    }
+    index_t k = begin;
+    for (; k + kReduceLanes <= end; k += kReduceLanes) {
+      #pragma unroll
+      for (int l = 0; l < kReduceLanes; ++l) {
+        Add(&sum[l], &res[l], AType(OP::Map(src[k + l])));
+      }
+    }
+    for (int l = 0; k < end; ++k, ++l) {
+      Add(&sum[l], &res[l], AType(OP::Map(src[k])));
+    }
+    for (int l = 0; l < kReduceLanes; ++l) {
+      mshadow::red::sum::Merge(*val, *residual, sum[l], res[l]);
+    }
+  }
+
+  static void Columns(const DType* __restrict src, const index_t stride, const index_t ncol,
+                      const index_t begin, const index_t end,
+                      AType* __restrict val, AType* __restrict residual) {
+    for (index_t k = begin; k < end; ++k) {
+      const DType* __restrict row = src + k * stride;
+      for (index_t j = 0; j < ncol; ++j) {
+        Add(&val[j], &residual[j], AType(OP::Map(row[j])));
+      }
+    }
+  }
+};
+
+/*!
+ * \brief Reduction of the leading axes: small[j] reduces big[k * N + j] for k < M.
+ *  Blocks of kReduceColumnBlock outputs sweep the rows together; when there are
+ *  fewer blocks than threads the rows are split as well and merged afterwards.
+ */
+template<typename Reducer, typename AType, typename DType, typename OType, typename OP,
+         typename IndexOP>
+void seq_reduce_columns(const index_t N, const index_t M, const bool addto,
+                        const DType* big, OType* small, const int nthreads) {
+  typedef contiguous_reduce<Reducer, AType, DType, OP, IndexOP> ContiguousReduce;
+  const index_t nblock = (N + kReduceColumnBlock - 1) / kReduceColumnBlock;
+  const index_t nsplit = nblock >= nthreads ? 1 :
+    std::min<index_t>((nthreads + nblock - 1) / nblock,
+                      std::max<index_t>(1, M * std::min(N, kReduceColumnBlock) /
+                                           kReduceSplitGrain));
+  const index_t chunk = (M + nsplit - 1) / nsplit;
+  // std::vector<bool> has no addressable elements, hence the plain arrays
+  std::unique_ptr<AType[]> partial_val, partial_res;
+  if (nsplit > 1) {
+    partial_val.reset(new AType[nsplit * N]);
+    partial_res.reset(new AType[nsplit * N]);
+  }
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t t = 0; t < nblock * nsplit; ++t) {
+    const index_t part = t / nblock;
+    const index_t j0 = (t % nblock) * kReduceColumnBlock;
+    const index_t ncol = std::min(kReduceColumnBlock, N - j0);
+    AType val[kReduceColumnBlock], residual[kReduceColumnBlock];
+    for (index_t j = 0; j < ncol; ++j) {
+      Reducer::SetInitValue(val[j], residual[j]);
+    }
+    ContiguousReduce::Columns(big + j0, N, ncol, std::min(M, part * chunk),
+                              std::min(M, (part + 1) * chunk), val, residual);
+    if (nsplit == 1) {
+      for (index_t j = 0; j < ncol; ++j) {
+        Reducer::Finalize(val[j], residual[j]);
+        assign(&small[j0 + j], addto, OType(val[j]));
+      }
+    } else {
+      std::copy(val, val + ncol, partial_val.get() + part * N + j0);
+      std::copy(residual, residual + ncol, partial_res.get() + part * N + j0);
+    }
+  }
+  if (nsplit == 1) return;
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t j = 0; j < N; ++j) {
+    AType val = partial_val[j], residual = partial_res[j];
+    for (index_t part = 1; part < nsplit; ++part) {
+      Reducer::Merge(val, residual, partial_val[part * N + j], partial_res[part * N + j]);
+    }
+    Reducer::Finalize(val, residual);
+    assign(&small[j], addto, OType(val));
+  }
+}
+
 template<typename Reducer, int ndim, typename AType, typename DType, typename OType, typename OP,
          typename IndexOP = mxnet::op::mshadow_op::set_index_no_op<AType, index_t>>
 void seq_reduce_compute(const size_t N, const size_t M, const bool addto,
                         const DType *big, OType *small, const Shape<ndim> bshape,
                         const Shape<ndim> sshape, const Shape<ndim> rshape,
                         const Shape<ndim> rstride) {
-  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
-  for (index_t idx = 0; idx < static_cast<index_t>(N); ++idx) {
-    seq_reduce_assign<Reducer, ndim, AType, DType, OType, OP, IndexOP>(idx, M, addto, big, small,
-        bshape, sshape, rshape, rstride);
+  typedef contiguous_reduce<Reducer, AType, DType, OP, IndexOP> ContiguousReduce;
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const index_t n = N, m = M;
+  if (n == 0) return;
+  const ReduceLayout layout = reduce_layout(sshape, bshape);
+  if (layout == ReduceLayout::kOuter && n > 1 && m > 1) {
+    seq_reduce_columns<Reducer, AType, DType, OType, OP, IndexOP>(n, m, addto, big, small,
+                                                                  nthreads);
+    return;
+  }
+  const bool inner = layout == ReduceLayout::kInner;
+  // Split the reduced axis only when the outputs alone cannot occupy the threads.
+  const index_t nsplit = n >= nthreads ? 1 :
+    std::min<index_t>((nthreads + n - 1) / n, std::max<index_t>(1, m / kReduceSplitGrain));
+  if (nsplit == 1) {
+    #pragma omp parallel for num_threads(nthreads)
+    for (index_t idx = 0; idx < n; ++idx) {
+      if (inner) {
+        AType val, residual;
+        Reducer::SetInitValue(val, residual);
+        ContiguousReduce::Range(big + idx * m, 0, m, &val, &residual);
+        Reducer::Finalize(val, residual);
+        assign(&small[idx], addto, OType(val));
+      } else {
+        seq_reduce_assign<Reducer, ndim, AType, DType, OType, OP, IndexOP>(idx, M, addto, big,
+            small, bshape, sshape, rshape, rstride);
+      }
+    }
+    return;
+  }
+  // Partial results are merged in the order of the reduced axis, which keeps the
+  // first index among equal values for argmin/argmax.
+  const index_t chunk = (m + nsplit - 1) / nsplit;
+  std::unique_ptr<AType[]> partial_val(new AType[n * nsplit]), partial_res(new AType[n * nsplit]);
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t t = 0; t < n * nsplit; ++t) {
+    const index_t idx = t / nsplit;
+    const index_t begin = std::min(m, (t % nsplit) * chunk);
+    const index_t end = std::min(m, begin + chunk);
+    AType val, residual;
+    Reducer::SetInitValue(val, residual);
+    if (inner) {
+      ContiguousReduce::Range(big + idx * m, begin, end, &val, &residual);
+    } else {
+      seq_reduce_range<Reducer, ndim, AType, DType, OP, IndexOP>(idx, begin, end, big, bshape,
+          sshape, rshape, rstride, &val, &residual);
+    }
+    partial_val[t] = val;
+    partial_res[t] = residual;
+  }
+  for (index_t idx = 0; idx < n; ++idx) {
+    AType val = partial_val[idx * nsplit], residual = partial_res[idx * nsplit];
+    for (index_t part = 1; part < nsplit; ++part) {
+      Reducer::Merge(val, residual, partial_val[idx * nsplit + part],
+                     partial_res[idx * nsplit + part]);
+    }
+    Reducer::Finalize(val, residual);
+    assign(&small[idx], addto, OType(val));
   }
 }
 
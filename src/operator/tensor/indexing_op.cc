@@ -363,6 +363,76 @@ void TakeOpForward<cpu>(const nnvm::NodeAttrs& attrs,
   });
 }
 
+/*! \brief number of bits of the row ids sorted per radix pass */
+const int kEmbeddingRadixBits = 8;
+const int kEmbeddingRadixSize = 1 << kEmbeddingRadixBits;
+
+/*!
+ * \brief Stable parallel LSD radix sort of the positions of the indices by row id.
+ *  On return (*keys)[i] is the i-th smallest row id and (*pos)[i] its position in
+ *  `data`, positions of equal row ids being in increasing order. The four arrays
+ *  of n elements are swapped between passes, so *keys and *pos may point to the
+ *  former temporary arrays on return.
+ * \param hist temporary storage for nthreads * kEmbeddingRadixSize counters
+ */
+template<typename IType>
+void EmbeddingRadixSortCPU(const IType* data, const nnvm::dim_t n, const nnvm::dim_t num_rows,
+                           const int nthreads, nnvm::dim_t** keys, nnvm::dim_t** pos,
+                           nnvm::dim_t** keys_tmp, nnvm::dim_t** pos_tmp, nnvm::dim_t* hist) {
+  using nnvm::dim_t;
+  const dim_t chunk = (n + nthreads - 1) / nthreads;
+  #pragma omp parallel for num_threads(nthreads)
+  for (dim_t i = 0; i < n; ++i) {
+    (*keys)[i] = static_cast<dim_t>(data[i]);
+    (*pos)[i] = i;
+  }
+  for (int shift = 0; ((num_rows - 1) >> shift) > 0; shift += kEmbeddingRadixBits) {
+    const dim_t* src_keys = *keys;
+    const dim_t* src_pos = *pos;
+    dim_t* dst_keys = *keys_tmp;
+    dim_t* dst_pos = *pos_tmp;
+    #pragma omp parallel for num_threads(nthreads)
+    for (int t = 0; t < nthreads; ++t) {
+      dim_t* thread_hist = hist + t * kEmbeddingRadixSize;
+      std::fill(thread_hist, thread_hist + kEmbeddingRadixSize, 0);
+      const dim_t end = std::min(n, (t + 1) * chunk);
+      for (dim_t i = t * chunk; i < end; ++i) {
+        ++thread_hist[(src_keys[i] >> shift) & (kEmbeddingRadixSize - 1)];
+      }
+    }
+    // turn the counts into the first destination of every (digit, thread)
+    dim_t offset = 0;
+    for (int d = 0; d < kEmbeddingRadixSize; ++d) {
+      for (int t = 0; t < nthreads; ++t) {
+        const dim_t count = hist[t * kEmbeddingRadixSize + d];
+        hist[t * kEmbeddingRadixSize + d] = offset;
+        offset += count;
+      }
+    }
+    #pragma omp parallel for num_threads(nthreads)
+    for (int t = 0; t < nthreads; ++t) {
+      dim_t* thread_hist = hist + t * kEmbeddingRadixSize;
+      const dim_t end = std::min(n, (t + 1) * chunk);
+      for (dim_t i = t * chunk; i < end; ++i) {
+        const dim_t dst = thread_hist[(src_keys[i] >> shift) & (kEmbeddingRadixSize - 1)]++;
+        dst_keys[dst] = src_keys[i];
+        dst_pos[dst] = src_pos[i];
+      }
+    }
+    std::swap(*keys, *keys_tmp);
+    std::swap(*pos, *pos_tmp);
+  }
+}
+
+/*!
+ * \brief Row sparse gradient of the embedding weight, computed in time and memory
+ *  proportional to the number of indices rather than to the number of rows.
+ *  The positions of the indices are bucketed by row id with a radix sort; the
+ *  sorted positions are then split evenly between the threads, so that a row hit
+ *  by many indices is summed by several threads. Each thread writes the rows which
+ *  start in its range and sums the continuation of a row started by a previous
+ *  thread into a thread-local buffer, which is added once all threads are done.
+ */
 template<>
 inline void SparseEmbeddingOpBackwardRspImpl<cpu>(const bool deterministic,
                                                   const OpContext& ctx,
@@ -372,25 +442,21 @@ inline void SparseEmbeddingOpBackwardRspImpl<cpu>(const bool deterministic,
                                                   const NDArray& output) {
   using namespace mshadow;
   using namespace mxnet_op;
-  using namespace mshadow::expr;
   using namespace rowsparse;
   using nnvm::dim_t;
   if (req == kNullOp) return;
   CHECK_EQ(req, kWriteTo) << "SparseEmbedding layer doesn't support "
                           << "weight gradient calculation with req != write";
 
-  // Request temporary storage for marking non-zero rows and prefix sum
   Stream<cpu> *s = ctx.get_stream<cpu>();
-  dim_t num_rows = output.shape()[0];
-  dim_t row_length = output.shape()[1];
-  size_t workspace_size = num_rows * sizeof(dim_t);
-  Tensor<cpu, 1, char> workspace =
-    ctx.requested[embedding::kTempSpace].get_space_typed<cpu, 1, char>(
-      Shape1(workspace_size), s);
-  dim_t* row_flg = reinterpret_cast<dim_t*>(workspace.dptr_);
-  // prefix sum array re-uses the row_flg array temp space
-  dim_t* prefix_sum = row_flg;
-  dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  const dim_t num_rows = output.shape()[0];
+  const dim_t row_length = output.shape()[1];
+  const dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  if (data_size == 0) {
+    FillZerosRspImpl(s, output);
+    return;
+  }
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
 
   MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
     MSHADOW_SGL_DBL_TYPE_SWITCH(ograd.type_flag_, DType, {
@@ -404,37 +470,76 @@ inline void SparseEmbeddingOpBackwardRspImpl<cpu>(const bool deterministic,
           bool is_valid = CheckIndexOutOfBound(data_ptr, data.shape_.Size(), min, max);
           CHECK(is_valid) << "Embedding input contains data out of bound";
         }
-        // mark row flags
-        Fill<false>(s, TBlob(row_flg, Shape1(num_rows), cpu::kDevMask), kWriteTo, 0);
-        Kernel<MarkRowFlgKernel, cpu>::Launch(s, data_size, row_flg, data.dptr<IType>());
-        // calculate inclusive prefix sum
-        // TODO(haibin) ideally this is should be done in parallel
-        prefix_sum[0] = row_flg[0];
-        for (dim_t i = 1; i < num_rows; i++) {
-          prefix_sum[i] = prefix_sum[i - 1] + row_flg[i];
+        // Request temporary storage for the radix sort, the counters of the threads
+        // and the partial rows summed by the threads
+        const size_t sort_size = 4 * data_size * sizeof(dim_t);
+        const size_t hist_size = nthreads * (kEmbeddingRadixSize + 1) * sizeof(dim_t);
+        const size_t head_size = nthreads * row_length * sizeof(DType);
+        Tensor<cpu, 1, char> workspace =
+          ctx.requested[embedding::kTempSpace].get_space_typed<cpu, 1, char>(
+            Shape1(sort_size + hist_size + head_size), s);
+        dim_t* keys = reinterpret_cast<dim_t*>(workspace.dptr_);
+        dim_t* pos = keys + data_size;
+        dim_t* keys_tmp = pos + data_size;
+        dim_t* pos_tmp = keys_tmp + data_size;
+        dim_t* hist = pos_tmp + data_size;
+        dim_t* row_start = hist + nthreads * kEmbeddingRadixSize;
+        DType* heads = reinterpret_cast<DType*>(workspace.dptr_ + sort_size + hist_size);
+        EmbeddingRadixSortCPU(data.dptr<IType>(), data_size, num_rows, nthreads,
+                              &keys, &pos, &keys_tmp, &pos_tmp, hist);
+
+        // count the rows starting in the range of every thread
+        const dim_t chunk = (data_size + nthreads - 1) / nthreads;
+        #pragma omp parallel for num_threads(nthreads)
+        for (int t = 0; t < nthreads; ++t) {
+          dim_t count = 0;
+          const dim_t end = std::min(data_size, (t + 1) * chunk);
+          for (dim_t i = t * chunk; i < end; ++i) {
+            count += (i == 0 || keys[i] != keys[i - 1]);
+          }
+          row_start[t] = count;
         }
-        // total number of non-zero rows
-        dim_t nnr = prefix_sum[num_rows - 1];
-        if (nnr == 0) {
-          FillZerosRspImpl(s, output);
-          return;
+        dim_t nnr = 0;
+        for (int t = 0; t < nthreads; ++t) {
+          const dim_t count = row_start[t];
+          row_start[t] = nnr;
+          nnr += count;
         }
         output.CheckAndAlloc({Shape1(nnr)});
         RType* grad_row_idx = output.aux_data(kIdx).dptr<RType>();
-        // fill row_idx array of output matrix, using the row_flg values
-        Kernel<FillRspRowIdxKernel, cpu>::Launch(s, num_rows,
-            grad_row_idx, prefix_sum, num_rows);
-        // prefill with zeros
         DType* grad_data = output.data().dptr<DType>();
-        Fill<false>(s, TBlob(grad_data, Shape1(nnr * row_length),
-            cpu::kDevMask), kWriteTo, 0);
-        // add the final gradients
-        const int num_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
-        dim_t segment_len = (nnr + num_threads - 1) / num_threads;
-        Kernel<AddTakeGradRspKernel, cpu>::Launch(s, num_threads, grad_data, prefix_sum,
-                                                  ograd.dptr<DType>(), row_length,
-                                                  data.dptr<IType>(), data_size, segment_len,
-                                                  num_rows);
+
+        // sum the output gradients of every row
+        #pragma omp parallel for num_threads(nthreads)
+        for (int t = 0; t < nthreads; ++t) {
+          const dim_t begin = std::min(data_size, t * chunk);
+          const dim_t end = std::min(data_size, begin + chunk);
+          DType* dst = heads + t * row_length;
+          std::fill(dst, dst + row_length, DType(0));
+          dim_t row = row_start[t];
+          for (dim_t i = begin; i < end; ++i) {
+            if (i == 0 || keys[i] != keys[i - 1]) {
+              grad_row_idx[row] = static_cast<RType>(keys[i]);
+              dst = grad_data + row * row_length;
+              std::fill(dst, dst + row_length, DType(0));
+              ++row;
+            }
+            const DType* src = ograd.dptr<DType>() + pos[i] * row_length;
+            for (dim_t j = 0; j < row_length; ++j) {
+              dst[j] += src[j];
+            }
+          }
+        }
+        // add the rows continued from a previous thread, in the order of the threads
+        for (int t = 1; t < nthreads; ++t) {
+          const dim_t begin = t * chunk;
+          if (begin >= data_size || keys[begin] != keys[begin - 1]) continue;
+          DType* dst = grad_data + (row_start[t] - 1) * row_length;
+          const DType* src = heads + t * row_length;
+          for (dim_t j = 0; j < row_length; ++j) {
+            dst[j] += src[j];
+          }
+        }
       });
     });
   });
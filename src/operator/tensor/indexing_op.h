@@ -439,48 +439,6 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
   });
 }
 
-struct AddTakeGradRspKernel {
-  /*!
-   * \brief Each thread i is responsible for row slices in [segment_start, segment_end)
-            of the result gradient
-   * \param tid             global thread id
-   * \param grad            the gradient to calculate
-   * \param prefix_sum      the inclusive prefix sum of row ids of the gradient
-   * \param ograd           output gradient
-   * \param row_length      the length of the row slices of the gradient
-   * \param data_val        the values of input data
-   * \param data_size       number of values of input data
-   * \param segment_length  the length of row segment to process for each thread
-   * \param nnr             total number of non-zero rows of result gradient
-   */
-  template<typename DType, typename IType>
-  MSHADOW_CINLINE static void Map(int tid,
-                                  DType* grad,
-                                  const nnvm::dim_t* prefix_sum,
-                                  const DType* ograd,
-                                  const nnvm::dim_t row_length,
-                                  const IType* data_val,
-                                  const nnvm::dim_t data_size,
-                                  const nnvm::dim_t segment_length,
-                                  const nnvm::dim_t nnr) {
-    using nnvm::dim_t;
-    dim_t segment_start = tid * segment_length;
-    dim_t segment_end = std::min(nnr, segment_start + segment_length);
-    // scan all data
-    for (dim_t data_i = 0; data_i < data_size; data_i++) {
-      dim_t data = static_cast<dim_t>(data_val[data_i]);
-      dim_t grad_row_id = prefix_sum[data] - 1;
-      if (grad_row_id < segment_start || grad_row_id >= segment_end) continue;
-      // no projection is performed
-      dim_t ograd_i = data_i * row_length;
-      dim_t grad_i = grad_row_id * row_length;
-      for (dim_t offset = 0; offset < row_length; offset++) {
-        grad[grad_i + offset] += ograd[ograd_i + offset];
-      }
-    }
-  }
-};
-
 template<typename xpu>
 inline void SparseEmbeddingOpBackwardRspImpl(const bool deterministic,
                                              const OpContext& ctx,
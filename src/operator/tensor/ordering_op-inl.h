@@ -222,47 +222,154 @@ struct fill_ind {
   }
 };
 
+/*! \brief number of values tested together against the current top-k threshold */
+const int kTopKFilterBlock = 16;
+/*! \brief minimum number of elements of a row handled by one thread */
+const index_t kTopKSplitGrain = 1 << 16;
+
+/*! \brief a value of a row of the sorted data together with its index in the row */
+template<typename DType>
+struct TopKPair {
+  DType val;
+  index_t idx;
+};
+
+/*!
+ * \brief Order of the pairs: by value, then by index, so that equal values keep
+ *  the order they have in the source data.
+ */
+template<typename DType, bool is_ascend>
+struct TopKPairCompare {
+  MSHADOW_XINLINE static bool Better(const DType& a, const DType& b) {
+    return is_ascend ? a < b : a > b;
+  }
+  bool operator()(const TopKPair<DType>& a, const TopKPair<DType>& b) const {
+    if (Better(a.val, b.val)) return true;
+    if (Better(b.val, a.val)) return false;
+    return a.idx < b.idx;
+  }
+};
+
+/*!
+ * \brief Collects the K best pairs of row[begin, end) into `buf`, in no particular order.
+ *  Values are filtered against the K-th best value found so far: blocks of
+ *  kTopKFilterBlock values none of which can enter the top K are skipped after one
+ *  vectorizable test, the others are appended to `buf`, which is cut back to its K
+ *  best pairs by a selection whenever it holds 2K pairs.
+ */
+template<typename DType, bool is_ascend>
+void TopKSelect(const DType* row, const index_t begin, const index_t end, const index_t K,
+                std::vector<TopKPair<DType> >* buf) {
+  typedef TopKPairCompare<DType, is_ascend> Compare;
+  const size_t capacity = static_cast<size_t>(std::min(end - begin, 2 * K));
+  buf->clear();
+  buf->reserve(capacity);
+  DType threshold = DType(0);
+  auto shrink = [&]() {
+    std::nth_element(buf->begin(), buf->begin() + (K - 1), buf->end(), Compare());
+    buf->resize(K);
+    threshold = (*buf)[K - 1].val;
+  };
+  index_t i = begin;
+  // Until the buffer fills up for the first time there is no threshold.
+  for (; i < end && buf->size() < capacity; ++i) {
+    buf->push_back({row[i], i});
+  }
+  if (buf->size() <= static_cast<size_t>(K)) return;
+  shrink();
+  // Any later pair with a value equal to the threshold has a larger index than the
+  // K-th best pair, so only values strictly better than the threshold can enter.
+  for (; i + kTopKFilterBlock <= end; i += kTopKFilterBlock) {
+    bool any = false;
+    for (int j = 0; j < kTopKFilterBlock; ++j) {
+      any |= Compare::Better(row[i + j], threshold);
+    }
+    if (!any) continue;
+    for (int j = 0; j < kTopKFilterBlock; ++j) {
+      if (Compare::Better(row[i + j], threshold)) {
+        buf->push_back({row[i + j], i + j});
+        if (buf->size() == capacity) shrink();
+      }
+    }
+  }
+  for (; i < end; ++i) {
+    if (Compare::Better(row[i], threshold)) {
+      buf->push_back({row[i], i});
+      if (buf->size() == capacity) shrink();
+    }
+  }
+  if (buf->size() > static_cast<size_t>(K)) shrink();
+}
+
+/*! \brief Sorts the K best candidates of a row and writes them out */
+template<typename DType, bool is_ascend>
+void TopKWriteRow(std::vector<TopKPair<DType> >* cand, const index_t K, const index_t offset,
+                  DType* sorted_vals, index_t* indices) {
+  typedef TopKPairCompare<DType, is_ascend> Compare;
+  if (cand->size() > static_cast<size_t>(K)) {
+    std::nth_element(cand->begin(), cand->begin() + (K - 1), cand->end(), Compare());
+    cand->resize(K);
+  }
+  std::sort(cand->begin(), cand->end(), Compare());
+  for (size_t j = 0; j < cand->size(); ++j) {
+    sorted_vals[j] = (*cand)[j].val;
+    indices[j] = offset + (*cand)[j].idx;
+  }
+}
+
+/*!
+ * \brief Top K of each of the M rows of length N of `vals`. Rows are handled by
+ *  different threads; when there are fewer rows than threads the rows are also
+ *  split in chunks whose candidates are merged afterwards.
+ */
+template<typename DType, bool is_ascend>
+void TopKSortCPU(const DType* vals, DType* sorted_vals, index_t* indices,
+                 const index_t M, const index_t N, const index_t K) {
+  typedef TopKPair<DType> Pair;
+  const int omp_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount());
+  const index_t nsplit = M >= omp_threads ? 1 :
+    std::max<index_t>(1, std::min<index_t>((omp_threads + M - 1) / M, N / kTopKSplitGrain));
+  if (nsplit == 1) {
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t i = 0; i < M; ++i) {
+      std::vector<Pair> cand;
+      TopKSelect<DType, is_ascend>(vals + i * N, 0, N, K, &cand);
+      TopKWriteRow<DType, is_ascend>(&cand, K, i * N, sorted_vals + i * N, indices + i * N);
+    }
+    return;
+  }
+  const index_t chunk = (N + nsplit - 1) / nsplit;
+  std::vector<std::vector<Pair> > cand(M * nsplit);
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t t = 0; t < M * nsplit; ++t) {
+    const index_t i = t / nsplit;
+    const index_t begin = std::min(N, (t % nsplit) * chunk);
+    TopKSelect<DType, is_ascend>(vals + i * N, begin, std::min(N, begin + chunk), K, &cand[t]);
+  }
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t i = 0; i < M; ++i) {
+    std::vector<Pair>& merged = cand[i * nsplit];
+    for (index_t part = 1; part < nsplit; ++part) {
+      merged.insert(merged.end(), cand[i * nsplit + part].begin(), cand[i * nsplit + part].end());
+    }
+    TopKWriteRow<DType, is_ascend>(&merged, K, i * N, sorted_vals + i * N, indices + i * N);
+  }
+}
+
 template<typename DType>
 MSHADOW_FORCE_INLINE void TopKSort(const Tensor<cpu, 1, DType>& dat,
                                    const Tensor<cpu, 1, index_t>& ind,
                                    const Tensor<cpu, 1, char>& work,
                                    index_t K, index_t N, bool is_ascend,
                                    Stream<cpu> *s) {
-  // Use full sort when K is relatively large.
-  const bool full_sort(K*8 > N);
   // Batch size.
   const index_t M(work.size(0)/(sizeof(DType)*N));
-  const int omp_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount());
-  #pragma omp parallel for num_threads(omp_threads)
-  for (index_t i = 0; i < M; ++i) {
-    // Tensor `work` stores the flattened source data, while `dat` stores the sorted result.
-    DType *vals = reinterpret_cast<DType*>(work.dptr_);
-    DType *sorted_vals = dat.dptr_+i*N;
-    index_t *indices = ind.dptr_+i*N;
-    if (is_ascend) {
-      if (full_sort) {
-        std::sort(indices, indices+N,
-                  [&](const index_t& i1, const index_t& i2){
-          return vals[i1] < vals[i2]; });
-      } else {
-        std::partial_sort(indices, indices+K, indices+N,
-                          [&](const index_t& i1, const index_t& i2){
-          return vals[i1] < vals[i2]; });
-      }
-    } else {
-      if (full_sort) {
-        std::sort(indices, indices+N,
-                  [&](const index_t& i1, const index_t& i2){
-          return vals[i1] > vals[i2]; });
-      } else {
-        std::partial_sort(indices, indices+K, indices+N,
-                          [&](const index_t& i1, const index_t& i2){
-          return vals[i1] > vals[i2]; });
-      }
-    }
-    for (index_t j = 0; j < K; ++j) {
-      sorted_vals[j] = vals[indices[j]];
-    }
+  // Tensor `work` stores the flattened source data, while `dat` stores the sorted result.
+  const DType *vals = reinterpret_cast<const DType*>(work.dptr_);
+  if (is_ascend) {
+    TopKSortCPU<DType, true>(vals, dat.dptr_, ind.dptr_, M, N, K);
+  } else {
+    TopKSortCPU<DType, false>(vals, dat.dptr_, ind.dptr_, M, N, K);
   }
 }
 
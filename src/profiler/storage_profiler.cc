@@ -33,6 +33,11 @@
 namespace mxnet {
 namespace profiler {
 
+CpuNUMAStorageProfiler* CpuNUMAStorageProfiler::Get() {
+  static CpuNUMAStorageProfiler cpu_numa_storage_profiler;
+  return &cpu_numa_storage_profiler;
+}
+
 #if MXNET_USE_CUDA
 
 GpuDeviceStorageProfiler* GpuDeviceStorageProfiler::Get() {
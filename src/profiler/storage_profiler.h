@@ -21,6 +21,10 @@
 
 #include <mxnet/libinfo.h>
 #include <mxnet/storage.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -123,6 +127,56 @@ class DeviceStorageProfiler {
   std::vector<std::shared_ptr<profiler::ProfileCounter>> mem_counters_;
 };
 
+/*!
+ * \brief Per NUMA node statistics of the memory, allocated by the NUMA-aware CPU pool.
+ *        The amount of memory in use on each node is always tracked; it is also
+ *        reported through ProfileCounters while the memory profiling is on.
+ */
+class CpuNUMAStorageProfiler {
+ public:
+  static constexpr int kMaxNodes = 64;
+  /*! \brief get the global instance */
+  static CpuNUMAStorageProfiler* Get();
+
+  void OnAlloc(int node, size_t size) {
+    const size_t used = (used_[node] += size);
+    ++num_allocs_[node];
+    UpdateCounter(node, used);
+  }
+
+  void OnFree(int node, size_t size) {
+    const size_t used = (used_[node] -= size);
+    UpdateCounter(node, used);
+  }
+
+  /*! \brief number of bytes currently in use on the NUMA node */
+  size_t UsedMemory(int node) const        { return used_[node]; }
+  /*! \brief total number of allocations served from the NUMA node */
+  size_t NumAllocations(int node) const    { return num_allocs_[node]; }
+
+ private:
+  void UpdateCounter(int node, size_t used) {
+    profiler::Profiler *prof = profiler::Profiler::Get();
+    if (prof->IsProfiling(profiler::Profiler::kMemory)) {
+      std::unique_lock<std::mutex> lk(mutex_);
+      auto &counter = counters_[node];
+      if (!counter) {
+        const std::string name = "Memory: cpu NUMA node " + std::to_string(node);
+        counter = std::make_shared<profiler::ProfileCounter>(name.c_str(), &domain_);
+      }
+      *counter = used;
+    }
+  }
+
+  /*! \brief Domain of the memory profiling information */
+  profiler::ProfileDomain domain_{"CPU NUMA Storage"};
+  /*! \brief Mutex protecting the lazy creation and the update of the counters */
+  std::mutex mutex_;
+  std::array<std::atomic<size_t>, kMaxNodes> used_{};
+  std::array<std::atomic<size_t>, kMaxNodes> num_allocs_{};
+  std::array<std::shared_ptr<profiler::ProfileCounter>, kMaxNodes> counters_;
+};
+
 #if MXNET_USE_CUDA
 
 /*!
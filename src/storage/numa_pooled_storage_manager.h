@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file numa_pooled_storage_manager.h
+ * \brief NUMA-aware storage manager with a memory pool per NUMA node.
+ */
+#ifndef MXNET_STORAGE_NUMA_POOLED_STORAGE_MANAGER_H_
+#define MXNET_STORAGE_NUMA_POOLED_STORAGE_MANAGER_H_
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "./pooled_storage_manager.h"
+#include "../profiler/storage_profiler.h"
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief CPU storage manager, which keeps a separate PooledStorageManager for
+ * each NUMA node of the host. The memory is allocated from the pool of the node,
+ * on which the calling thread is running, so that the worker threads operate
+ * on the local memory. Released chunks are always returned to the pool of the
+ * node they were allocated on.
+ */
+template<typename BucketingStrategy, typename StoringMethod>
+class NUMAPooledStorageManager final : public StorageManager {
+ public:
+  explicit NUMAPooledStorageManager(const Context &ctx) {
+    const int num_nodes = numa::NumNodes();
+    pools_.reserve(num_nodes);
+    for (int node = 0; node < num_nodes; ++node) {
+      pools_.emplace_back(std::make_unique<Pool>(ctx, 0, CreateContextHelperCPU("CPU", node)));
+    }
+  }
+  /*!
+   * \brief Default destructor.
+   */
+  ~NUMAPooledStorageManager() override = default;
+
+  void Alloc(Storage::Handle* handle) override {
+    const int node = numa::CurrentNode();
+    pools_[node]->Alloc(handle);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      node_of_chunk_[handle->dptr] = node;
+    }
+    profiler::CpuNUMAStorageProfiler::Get()->OnAlloc(node, handle->size);
+  }
+
+  void Free(Storage::Handle handle) override {
+    const int node = ReleaseNode(handle.dptr);
+    pools_[node]->Free(handle);
+    profiler::CpuNUMAStorageProfiler::Get()->OnFree(node, handle.size);
+  }
+
+  void DirectFree(Storage::Handle handle) override {
+    const int node = ReleaseNode(handle.dptr);
+    pools_[node]->DirectFree(handle);
+    profiler::CpuNUMAStorageProfiler::Get()->OnFree(node, handle.size);
+  }
+
+  void ReleaseAll() override {
+    for (auto &pool : pools_)
+      pool->ReleaseAll();
+  }
+
+ private:
+  using Pool = PooledStorageManager<BucketingStrategy, StoringMethod>;
+
+  // Returns the NUMA node of the chunk and forgets about the chunk
+  int ReleaseNode(void *dptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = node_of_chunk_.find(dptr);
+    CHECK(it != node_of_chunk_.end()) << "Freeing memory not allocated by the NUMA pool";
+    const int node = it->second;
+    node_of_chunk_.erase(it);
+    return node;
+  }
+
+  // memory pool for each NUMA node
+  std::vector<std::unique_ptr<Pool>> pools_;
+  // NUMA node of each chunk in use
+  std::unordered_map<void *, int> node_of_chunk_;
+  // mutex protecting node_of_chunk_
+  std::mutex mutex_;
+  DISALLOW_COPY_AND_ASSIGN(NUMAPooledStorageManager);
+};  // class NUMAPooledStorageManager
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_STORAGE_NUMA_POOLED_STORAGE_MANAGER_H_
@@ -28,6 +28,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <memory>
 #include <mutex>
 #include <tuple>
 #include "./storage_manager.h"
@@ -43,10 +44,43 @@ typedef enum {
   large_alloc_size,
   round_linear_cutoff,
   pool_reserve,
+  huge_pages,
 } env_var_type;
 
 const std::string env_var_name(const char* dev_type, env_var_type type);
 
+/*!
+ * \brief Creates the helper for the CPU memory of the pool.
+ * The memory is backed by the huge pages when MXNET_<dev_type>_MEM_POOL_HUGE_PAGES
+ * is set to "Transparent" or "Explicit". The size of the explicit huge pages is
+ * defined by the pool page size, when it is set to a power of 2 of at least 2 MiB.
+ * \param dev_type device type used in the names of the environment variables
+ * \param node NUMA node of the memory, -1 when the memory is not bound to any node
+ */
+inline std::unique_ptr<ContextHelper> CreateContextHelperCPU(const char *dev_type,
+                                                             int node = -1) {
+  using HugePages = ContextHelperCPUHugePages;
+  const auto env_var = env_var_name(dev_type, huge_pages);
+  const std::string mode = dmlc::GetEnv(env_var.c_str(), std::string("None"));
+  if (mode == "None") {
+    if (node < 0)
+      return std::make_unique<ContextHelperCPU>();
+    return std::make_unique<ContextHelperCPUNUMA>(node);
+  }
+
+  if (mode != "Transparent" && mode != "Explicit") {
+    LOG(FATAL) << env_var << " should be one of None, Transparent or Explicit. Got "
+               << mode << ".";
+  }
+
+  const size_t page_size = dmlc::GetEnv(env_var_name(dev_type, pool_page_size).c_str(), 4096);
+  const bool page_is_huge = page_size >= HugePages::kTransparentHugePageSize &&
+                              (page_size & (page_size - 1)) == 0;
+  return std::make_unique<HugePages>(
+    mode == "Explicit"? HugePages::Mode::kExplicit : HugePages::Mode::kTransparent,
+    page_is_huge? page_size : HugePages::kTransparentHugePageSize, node);
+}
+
 #if MXNET_USE_CUDA
 #define SET_DEVICE(device_store, contextHelper, ctx, flag) \
       const auto *device_store = flag? contextHelper.get()->SetCurrentDevice(ctx) : nullptr;
@@ -78,7 +112,14 @@ template<typename BucketingStrategy, typename StoringMethod>
 class PooledStorageManager : public StorageManager,
              public BucketingStrategy, public StoringMethod {
  public:
-  explicit PooledStorageManager(const Context &ctx, int num_gpu_device) {
+  /*!
+   * \brief Constructor.
+   * \param ctx context of the memory pool
+   * \param num_gpu_device number of available GPUs
+   * \param cpuHelper optional helper used instead of the default one for the CPU memory
+   */
+  explicit PooledStorageManager(const Context &ctx, int num_gpu_device,
+                                std::unique_ptr<ContextHelper> cpuHelper = nullptr) {
     const char *dev_type = nullptr;
     switch (dev_type_ = ctx.dev_type) {
 #if MXNET_USE_CUDA
@@ -95,8 +136,9 @@ class PooledStorageManager : public StorageManager,
       case Context::kCPUPinned: dev_type = "CPU_PINNED";
 #endif
                                 dev_type_ = Context::kCPU;
-      case Context::kCPU:       contextHelper_ = std::make_unique<ContextHelperCPU>();
-                                dev_type = "CPU";
+      case Context::kCPU:       dev_type = "CPU";
+                                contextHelper_ = cpuHelper? std::move(cpuHelper) :
+                                                 CreateContextHelperCPU(dev_type);
       default:                  break;
     }
 
@@ -24,6 +24,7 @@
 #include "./storage_manager.h"
 #include "./naive_storage_manager.h"
 #include "./pooled_storage_manager.h"
+#include "./numa_pooled_storage_manager.h"
 #include "./cpu_shared_storage_manager.h"
 #include "./cpu_device_storage.h"
 #include "./gpu_device_storage.h"
@@ -77,6 +78,17 @@ StorageManager *CreateStorageManager(const Context &ctx, const char *context,
     ptr = new PooledStorageManager<RoundPower2, VectorContainer>(ctx, num_gpu_device);
   } else if (*pStrategy == "Naive") {
     ptr = new PooledStorageManager<RoundMultiple, UnorderedMapContainer>(ctx, num_gpu_device);
+  } else if (*pStrategy == "NUMA") {
+    // The pools per NUMA node are used only for the CPU memory
+    if (ctx.dev_type == Context::kCPU)
+      ptr = new NUMAPooledStorageManager<RoundMultiple, UnorderedMapContainer>(ctx);
+    else
+      ptr = new PooledStorageManager<RoundMultiple, UnorderedMapContainer>(ctx, num_gpu_device);
+  } else if (*pStrategy == "NUMARound") {
+    if (ctx.dev_type == Context::kCPU)
+      ptr = new NUMAPooledStorageManager<RoundPower2, VectorContainer>(ctx);
+    else
+      ptr = new PooledStorageManager<RoundPower2, VectorContainer>(ctx, num_gpu_device);
   } else if (*pStrategy == "Unpooled") {
     if (ctx.dev_type == Context::kCPU || num_gpu_device == 0)
       ptr = new NaiveStorageManager<CPUDeviceStorage>();
@@ -238,12 +250,13 @@ void StorageImpl::SharedIncrementRefCount(Storage::Handle handle) {
 }
 
 const std::string env_var_name(const char* dev_type, env_var_type type) {
-  static const std::array<std::string, 5> name = {
+  static const std::array<std::string, 6> name = {
                         "MEM_POOL_TYPE",
                         "POOL_PAGE_SIZE",
                         "MEM_LARGE_ALLOC_ROUND_SIZE",
                         "MEM_POOL_ROUND_LINEAR_CUTOFF",
                         "MEM_POOL_RESERVE",
+                        "MEM_POOL_HUGE_PAGES",
                         };
 
   return std::string("MXNET_") + dev_type + "_" + name[type];
@@ -35,18 +35,95 @@ typedef  mxnet::common::cuda::DeviceStore CudaDeviceStore;
 #include <mach/mach_host.h>
 #else
 #include <sys/sysinfo.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <dirent.h>
 #endif  // __APPLE__
 #else
 #include <Windows.h>
 #include <process.h>
 #endif  // _WIN32
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
 #include <tuple>
+#include <unordered_map>
 #include "../common/utils.h"
 
 namespace mxnet {
 namespace storage {
 
+/*!
+ * \brief NUMA topology queries and memory placement used by the NUMA-aware CPU pool.
+ * The Linux system calls are used directly, so that no dependency on libnuma is needed.
+ * On other platforms (or when the kernel does not support NUMA) all the memory
+ * is considered to belong to the single node 0.
+ */
+namespace numa {
+
+/*! \brief maximal number of nodes, for which the memory placement is supported */
+constexpr int kMaxNodes = 64;
+/*! \brief alignment (and granularity) of the memory, bound to a NUMA node */
+constexpr size_t kPageSize = 4096;
+
+/*! \brief number of NUMA nodes of the host */
+inline int NumNodes() {
+  static const int num_nodes = []() {
+    int max_node = 0;
+#if defined(__linux__) && !defined(ANDROID) && !defined(__ANDROID__)
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir) {
+      while (const struct dirent *entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "node", 4) == 0 &&
+            entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+          max_node = std::max(max_node, std::atoi(entry->d_name + 4));
+        }
+      }
+      closedir(dir);
+    }
+#endif
+    return std::min(max_node + 1, kMaxNodes);
+  }();
+  return num_nodes;
+}
+
+/*! \brief NUMA node of the CPU, on which the calling thread is running */
+inline int CurrentNode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+    return std::min(static_cast<int>(node), NumNodes() - 1);
+#endif
+  return 0;
+}
+
+/*!
+ * \brief Set the preferred NUMA node for the pages of the (page aligned) memory block.
+ * \return false, when the placement is not supported. In that case the pages
+ *         are placed on the node of the thread, which touches them first.
+ */
+inline bool BindToNode(void *ptr, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  if (node < 0 || node >= kMaxNodes || NumNodes() == 1)
+    return false;
+  constexpr int kMPolPreferred = 1;     // MPOL_PREFERRED from <numaif.h>
+  constexpr unsigned kMPolMFMove = 2;   // MPOL_MF_MOVE: migrate the pages already touched
+  const uint64_t node_mask = uint64_t(1) << node;
+  // The kernel reads (maxnode - 1) bits of the mask
+  return syscall(SYS_mbind, ptr, size, kMPolPreferred, &node_mask,
+                 sizeof(node_mask) * 8 + 1, kMPolMFMove) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace numa
+
 /*!
  * \brief Abstract class, which contains context specific methods used by PooledStorageManager.
  */
@@ -119,7 +196,7 @@ class ContextHelperCPU : public ContextHelper {
     mxnet::common::AlignedMemFree(dptr);
   }
 
- private:
+ protected:
 #if MXNET_USE_MKLDNN == 1 || MXNET_USE_INTGEMM == 1
   // MKLDNN requires special alignment. 64 is used by the MKLDNN library in
   // memory allocation.
@@ -129,6 +206,125 @@ class ContextHelperCPU : public ContextHelper {
 #endif
 };
 
+/*!
+ * \brief Class, which contains the methods used by the PooledStorageManager
+ * for CPU memory placed on one particular NUMA node.
+ */
+class ContextHelperCPUNUMA : public ContextHelperCPU {
+ public:
+  explicit ContextHelperCPUNUMA(int node) : node_(node) {}
+
+  int Malloc(void **ppNtr, size_t size) const override {
+    // The whole pages are allocated, so that no other allocation shares the bound pages
+    size = (size + numa::kPageSize - 1) / numa::kPageSize * numa::kPageSize;
+    const size_t alignment = std::max(alignment_, numa::kPageSize);
+    if (!mxnet::common::AlignedMemAlloc(ppNtr, size, alignment))
+      return -1;
+
+    // When mbind is not available, we rely on the first-touch placement
+    numa::BindToNode(*ppNtr, size, node_);
+    return 0;
+  }
+
+  inline int node() const                               { return node_; }
+
+ private:
+  // NUMA node of the memory, allocated by this helper
+  const int node_;
+};
+
+/*!
+ * \brief Class, which contains the methods used by the PooledStorageManager for
+ * CPU memory backed by the huge pages. The chunks of at least one huge page are
+ *  - either mapped from the explicitly reserved pool of huge pages (MAP_HUGETLB),
+ *  - or aligned to the huge page boundary and advised to be backed by the
+ *    transparent huge pages (MADV_HUGEPAGE).
+ * When the explicit huge pages are not available, the transparent ones are used.
+ * The smaller chunks are allocated as regular CPU memory.
+ * When the NUMA node is not negative, the memory is also bound to that node.
+ */
+class ContextHelperCPUHugePages : public ContextHelperCPUNUMA {
+ public:
+  enum class Mode { kTransparent, kExplicit };
+  /*! \brief size of the transparent huge pages */
+  static constexpr size_t kTransparentHugePageSize = 2 * 1024 * 1024;
+
+  ContextHelperCPUHugePages(Mode mode, size_t huge_page_size, int node = -1)
+    : ContextHelperCPUNUMA(node), mode_(mode), huge_page_size_(huge_page_size) {}
+
+  int Malloc(void **ppNtr, size_t size) const override {
+    if (size < std::min(huge_page_size_, kTransparentHugePageSize)) {
+      return node() < 0? ContextHelperCPU::Malloc(ppNtr, size) :
+                         ContextHelperCPUNUMA::Malloc(ppNtr, size);
+    }
+
+    if (mode_ == Mode::kExplicit && size % huge_page_size_ == 0 &&
+        !huge_pages_unavailable_.load(std::memory_order_relaxed) && MapHugePages(ppNtr, size)) {
+      numa::BindToNode(*ppNtr, size, node());
+      return 0;
+    }
+
+    // The kernel backs by the huge pages the aligned regions, which are fully covered
+    if (!mxnet::common::AlignedMemAlloc(ppNtr, size, kTransparentHugePageSize))
+      return -1;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    madvise(*ppNtr, size, MADV_HUGEPAGE);
+#endif
+    numa::BindToNode(*ppNtr, size, node());
+    return 0;
+  }
+
+  void Free(void *dptr) const override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto it = mapped_.find(dptr);
+      if (it != mapped_.end()) {
+#if defined(__linux__)
+        munmap(dptr, it->second);
+#endif
+        mapped_.erase(it);
+        return;
+      }
+    }
+    ContextHelperCPU::Free(dptr);
+  }
+
+ private:
+  bool MapHugePages(void **ppNtr, size_t size) const {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    if (huge_page_size_ != kTransparentHugePageSize) {
+      // Huge pages of non default size (for instance, 1 GiB) are requested explicitly
+      constexpr int kMapHugeShift = 26;   // MAP_HUGE_SHIFT from <linux/mman.h>
+      flags |= common::ilog2ul(huge_page_size_ - 1) << kMapHugeShift;
+    }
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (ptr != MAP_FAILED) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      mapped_[ptr] = size;
+      *ppNtr = ptr;
+      return true;
+    }
+#endif
+    // Once the pool is exhausted (or absent), the later chunks skip the mmap attempt
+    if (!huge_pages_unavailable_.exchange(true)) {
+      LOG(WARNING) << "Explicit huge pages of " << huge_page_size_ << " bytes are not available"
+                   << " (see /proc/sys/vm/nr_hugepages), transparent huge pages are used instead";
+    }
+    return false;
+  }
+
+  const Mode mode_;
+  // size of the explicit huge pages
+  const size_t huge_page_size_;
+  // chunks mapped from the explicit huge pages and their sizes
+  mutable std::unordered_map<void *, size_t> mapped_;
+  // whether a MAP_HUGETLB mapping failed, so only the transparent huge pages are used
+  mutable std::atomic<bool> huge_pages_unavailable_{false};
+  // mutex protecting mapped_
+  mutable std::mutex mutex_;
+};
+
 #if MXNET_USE_CUDA
 /*!
  * \brief Class, which contains the GPU specific methods used by PooledStorageManager.
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file auto_bulk_perf.cc
+ * \brief Throughput of imperative style loops of small CPU operations,
+ *        with and without the automatic bulking of the threaded engines
+ */
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <gtest/gtest.h>
+#include <mxnet/engine.h>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/engine/engine_impl.h"
+#include "../include/test_util.h"
+
+namespace {
+
+constexpr int kTensorSize = 16;
+
+/*!
+ * \brief Run num_loops interleaved loops of `x = x + 1` on small arrays, as
+ *        imperative code does: every step writes a new array, reads the array
+ *        of the previous step and deletes it. The value of each loop is read
+ *        back every sync_every steps.
+ * \return number of executed operations per second
+ */
+double ImperativeLoopOpsPerSec(mxnet::Engine* engine, int num_loops, int num_steps,
+                               int sync_every) {
+  struct Array {
+    mxnet::Engine::VarHandle var;
+    std::shared_ptr<std::vector<float> > data;
+  };
+  auto new_array = [engine]() {
+    return Array{engine->NewVariable(), std::make_shared<std::vector<float> >(kTensorSize, 0)};
+  };
+  auto delete_array = [engine](const Array& a) {
+    auto data = a.data;
+    engine->DeleteVariable([data](mxnet::RunContext) {}, mxnet::Context::CPU(), a.var);
+  };
+  std::vector<Array> x;
+  for (int i = 0; i < num_loops; ++i) x.push_back(new_array());
+  const double start = dmlc::GetTime();
+  for (int k = 1; k <= num_steps; ++k) {
+    for (int i = 0; i < num_loops; ++i) {
+      Array y = new_array();
+      auto in = x[i].data;
+      auto out = y.data;
+      engine->PushSync([in, out](mxnet::RunContext) {
+          for (int j = 0; j < kTensorSize; ++j) (*out)[j] = (*in)[j] + 1;
+        }, mxnet::Context::CPU(), {x[i].var}, {y.var});
+      delete_array(x[i]);
+      x[i] = y;
+      if (k % sync_every == 0) {
+        engine->WaitForVar(x[i].var);
+        EXPECT_EQ((*x[i].data)[0], static_cast<float>(k));
+      }
+    }
+  }
+  engine->WaitForAll();
+  const double elapsed = dmlc::GetTime() - start;
+  for (int i = 0; i < num_loops; ++i) {
+    EXPECT_EQ((*x[i].data)[kTensorSize - 1], static_cast<float>(num_steps));
+    delete_array(x[i]);
+  }
+  engine->WaitForAll();
+  return static_cast<double>(num_loops) * num_steps / elapsed;
+}
+
+}  // namespace
+
+TEST(ENGINE_PERF, AutoBulkImperativeLoop) {
+  const int num_steps = mxnet::test::performance_run ? 50000 : 2000;
+  for (const char* auto_bulk_size : {"0", "16", "64"}) {
+    setenv("MXNET_ENGINE_AUTO_BULK_SIZE", auto_bulk_size, 1);
+    std::unique_ptr<mxnet::Engine> engine(mxnet::engine::CreateThreadedEnginePerDevice());
+    for (int num_loops : {1, 4}) {
+      for (int sync_every : {100, num_steps}) {
+        const double ops = ImperativeLoopOpsPerSec(engine.get(), num_loops, num_steps,
+                                                   sync_every);
+        LOG(INFO) << "auto_bulk_size=" << auto_bulk_size << "\tloops=" << num_loops
+                  << "\tsync_every=" << sync_every << "\t" << ops << " ops/sec";
+      }
+    }
+  }
+  unsetenv("MXNET_ENGINE_AUTO_BULK_SIZE");
+}
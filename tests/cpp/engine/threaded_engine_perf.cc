@@ -0,0 +1,196 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file threaded_engine_perf.cc
+ * \brief Scheduling throughput of the threaded engines for tiny CPU operations
+ */
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <gtest/gtest.h>
+#include <mxnet/engine.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/engine/engine_impl.h"
+#include "../include/test_util.h"
+
+namespace {
+
+struct EngineInfo {
+  std::string name;
+  mxnet::Engine* (*create)();
+};
+
+const std::vector<EngineInfo> perf_engines = {
+  {"ThreadedEnginePooled", mxnet::engine::CreateThreadedEnginePooled},
+  {"ThreadedEnginePerDevice", mxnet::engine::CreateThreadedEnginePerDevice},
+  {"ThreadedEngineWorkStealing", mxnet::engine::CreateThreadedEngineWorkStealing},
+};
+
+/*!
+ * \brief Push num_chains independent chains of num_ops operations each,
+ *        every operation of a chain writing the variable of its chain.
+ * \return number of executed operations per second
+ */
+double ChainOpsPerSec(mxnet::Engine* engine, int num_chains, int num_ops,
+                      std::atomic<int64_t>* counter) {
+  std::vector<mxnet::Engine::VarHandle> vars;
+  for (int i = 0; i < num_chains; ++i) {
+    vars.push_back(engine->NewVariable());
+  }
+  const double start = dmlc::GetTime();
+  for (int k = 0; k < num_ops; ++k) {
+    for (int i = 0; i < num_chains; ++i) {
+      engine->PushSync([counter](mxnet::RunContext) { ++(*counter); },
+                       mxnet::Context::CPU(), {}, {vars[i]});
+    }
+  }
+  engine->WaitForAll();
+  const double elapsed = dmlc::GetTime() - start;
+  for (auto var : vars) {
+    engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), var);
+  }
+  engine->WaitForAll();
+  return num_chains * num_ops / elapsed;
+}
+
+/*!
+ * \brief Repeatedly write one variable and fan out to fan_out readers,
+ *        each writing its own variable.
+ * \return number of executed operations per second
+ */
+double FanOutOpsPerSec(mxnet::Engine* engine, int fan_out, int num_rounds,
+                       std::atomic<int64_t>* counter) {
+  auto source = engine->NewVariable();
+  std::vector<mxnet::Engine::VarHandle> sinks;
+  for (int i = 0; i < fan_out; ++i) {
+    sinks.push_back(engine->NewVariable());
+  }
+  const double start = dmlc::GetTime();
+  for (int k = 0; k < num_rounds; ++k) {
+    engine->PushSync([counter](mxnet::RunContext) { ++(*counter); },
+                     mxnet::Context::CPU(), {}, {source});
+    for (int i = 0; i < fan_out; ++i) {
+      engine->PushSync([counter](mxnet::RunContext) { ++(*counter); },
+                       mxnet::Context::CPU(), {source}, {sinks[i]});
+    }
+  }
+  engine->WaitForAll();
+  const double elapsed = dmlc::GetTime() - start;
+  engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), source);
+  for (auto var : sinks) {
+    engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), var);
+  }
+  engine->WaitForAll();
+  return num_rounds * (fan_out + 1) / elapsed;
+}
+
+/*!
+ * \brief Push tiny operations from several threads at once, every operation
+ *        reading one and writing another of a small set of shared variables,
+ *        which stresses the dependency tracking of the variables.
+ * \return number of pushed and executed operations per second
+ */
+double ConcurrentPushesPerSec(mxnet::Engine* engine, int num_pushers, int num_vars,
+                              int num_ops, std::atomic<int64_t>* counter) {
+  std::vector<mxnet::Engine::VarHandle> vars;
+  for (int i = 0; i < num_vars; ++i) {
+    vars.push_back(engine->NewVariable());
+  }
+  const double start = dmlc::GetTime();
+  std::vector<std::thread> pushers;
+  for (int t = 0; t < num_pushers; ++t) {
+    pushers.emplace_back([=]() {
+      for (int k = 0; k < num_ops; ++k) {
+        const int read = (t + k) % num_vars;
+        const int write = (t + k + 1) % num_vars;
+        engine->PushSync([counter](mxnet::RunContext) { ++(*counter); },
+                         mxnet::Context::CPU(), {vars[read]}, {vars[write]});
+      }
+    });
+  }
+  for (auto& pusher : pushers) pusher.join();
+  engine->WaitForAll();
+  const double elapsed = dmlc::GetTime() - start;
+  for (auto var : vars) {
+    engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), var);
+  }
+  engine->WaitForAll();
+  return num_pushers * num_ops / elapsed;
+}
+
+}  // namespace
+
+TEST(ENGINE_PERF, DependencyChains) {
+  const int num_ops = mxnet::test::performance_run ? 20000 : 1000;
+  const std::vector<int> num_chains = mxnet::test::performance_run ?
+                                      std::vector<int>{1, 4, 16, 64} :
+                                      std::vector<int>{1, 16};
+  for (const auto& info : perf_engines) {
+    std::unique_ptr<mxnet::Engine> engine(info.create());
+    for (int chains : num_chains) {
+      std::atomic<int64_t> counter{0};
+      const double ops = ChainOpsPerSec(engine.get(), chains, num_ops, &counter);
+      EXPECT_EQ(counter.load(), static_cast<int64_t>(chains) * num_ops);
+      LOG(INFO) << info.name << "\tchains=" << chains << "\t" << ops << " ops/sec";
+    }
+  }
+}
+
+TEST(ENGINE_PERF, WideFanOut) {
+  const int num_rounds = mxnet::test::performance_run ? 2000 : 100;
+  const std::vector<int> fan_outs = mxnet::test::performance_run ?
+                                    std::vector<int>{8, 64, 512} :
+                                    std::vector<int>{64};
+  for (const auto& info : perf_engines) {
+    std::unique_ptr<mxnet::Engine> engine(info.create());
+    for (int fan_out : fan_outs) {
+      std::atomic<int64_t> counter{0};
+      const double ops = FanOutOpsPerSec(engine.get(), fan_out, num_rounds, &counter);
+      EXPECT_EQ(counter.load(), static_cast<int64_t>(fan_out + 1) * num_rounds);
+      LOG(INFO) << info.name << "\tfan_out=" << fan_out << "\t" << ops << " ops/sec";
+    }
+  }
+}
+
+TEST(ENGINE_PERF, ConcurrentPushes) {
+  const int num_ops = mxnet::test::performance_run ? 50000 : 2000;
+  const std::vector<int> num_pushers = mxnet::test::performance_run ?
+                                       std::vector<int>{1, 2, 4, 8} :
+                                       std::vector<int>{1, 4};
+  for (const auto& info : perf_engines) {
+    std::unique_ptr<mxnet::Engine> engine(info.create());
+    for (int pushers : num_pushers) {
+      for (int num_vars : {4, 256}) {
+        std::atomic<int64_t> counter{0};
+        const double ops = ConcurrentPushesPerSec(engine.get(), pushers, num_vars,
+                                                  num_ops, &counter);
+        EXPECT_EQ(counter.load(), static_cast<int64_t>(pushers) * num_ops);
+        LOG(INFO) << info.name << "\tpushers=" << pushers << "\tvars=" << num_vars
+                  << "\t" << ops << " pushes/sec";
+      }
+    }
+  }
+}
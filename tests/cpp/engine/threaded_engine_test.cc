@@ -30,10 +30,13 @@
 #include <mxnet/engine.h>
 #include <mxnet/ndarray.h>
 #include <dmlc/timer.h>
+#include <atomic>
 #include <ctime>
 #include <cstdio>
+#include <cstdlib>
 #include <thread>
 #include <chrono>
+#include <memory>
 #include <vector>
 #include <random>
 
@@ -128,12 +131,14 @@ double EvaluateWorkloads(const std::vector<Workload>& workloads,
 }
 
 TEST(Engine, start_stop) {
-  const int num_engine = 3;
+  const int num_engine = 4;
   std::vector<mxnet::Engine*> engine(num_engine);
   engine[0] = mxnet::engine::CreateNaiveEngine();
   engine[1] = mxnet::engine::CreateThreadedEnginePooled();
   engine[2] = mxnet::engine::CreateThreadedEnginePerDevice();
-  std::string type_names[3] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+  engine[3] = mxnet::engine::CreateThreadedEngineWorkStealing();
+  std::string type_names[4] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice",
+                               "ThreadedEngineWorkStealing"};
 
   for (int i = 0; i < num_engine; ++i) {
     LOG(INFO) << "Stopping: " << type_names[i];
@@ -147,7 +152,7 @@ TEST(Engine, start_stop) {
 TEST(Engine, RandSumExpr) {
   std::vector<Workload> workloads;
   int num_repeat = 5;
-  const int num_engine = 4;
+  const int num_engine = 5;
 
   std::vector<double> t(num_engine, 0.0);
   std::vector<mxnet::Engine*> engine(num_engine);
@@ -156,6 +161,7 @@ TEST(Engine, RandSumExpr) {
   engine[1] = mxnet::engine::CreateNaiveEngine();
   engine[2] = mxnet::engine::CreateThreadedEnginePooled();
   engine[3] = mxnet::engine::CreateThreadedEnginePerDevice();
+  engine[4] = mxnet::engine::CreateThreadedEngineWorkStealing();
 
   for (int repeat = 0; repeat < num_repeat; ++repeat) {
     srand(time(nullptr) + repeat);
@@ -178,6 +184,7 @@ TEST(Engine, RandSumExpr) {
   LOG(INFO) << "NaiveEngine\t\t"  << t[1] << " sec";
   LOG(INFO) << "ThreadedEnginePooled\t" << t[2] << " sec";
   LOG(INFO) << "ThreadedEnginePerDevice\t" << t[3] << " sec";
+  LOG(INFO) << "ThreadedEngineWorkStealing\t" << t[4] << " sec";
 }
 
 void Foo(mxnet::RunContext, int i) { printf("The fox says %d\n", i); }
@@ -437,12 +444,14 @@ TEST(Engine, basics) {
 }
 
 TEST(Engine, VarVersion) {
-  const size_t num_engines = 3;
+  const size_t num_engines = 4;
   std::vector<mxnet::Engine*> engines(num_engines);
   engines[0] = mxnet::engine::CreateNaiveEngine();
   engines[1] = mxnet::engine::CreateThreadedEnginePooled();
   engines[2] = mxnet::engine::CreateThreadedEnginePerDevice();
-  std::string type_names[3] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+  engines[3] = mxnet::engine::CreateThreadedEngineWorkStealing();
+  std::string type_names[4] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice",
+                               "ThreadedEngineWorkStealing"};
   for (size_t k = 0; k < num_engines; ++k) {
     auto engine = engines[k];
     std::vector<mxnet::Engine::OprHandle> oprs;
@@ -494,6 +503,105 @@ TEST(Engine, VarVersion) {
   }
 }
 
+/*!
+ * \brief Push random reads and writes on a few shared variables from several
+ *        threads at once and check that a write never runs concurrently with
+ *        any other operation on its variable.
+ */
+TEST(Engine, VarDependencyStress) {
+  const int num_vars = 4;
+  const int num_pushers = 4;
+  const int num_ops = 5000;
+  const size_t num_engines = 3;
+  std::vector<mxnet::Engine*> engines(num_engines);
+  engines[0] = mxnet::engine::CreateThreadedEnginePooled();
+  engines[1] = mxnet::engine::CreateThreadedEnginePerDevice();
+  engines[2] = mxnet::engine::CreateThreadedEngineWorkStealing();
+  for (auto engine : engines) {
+    std::vector<mxnet::Engine::VarHandle> vars;
+    std::vector<std::atomic<int>> readers(num_vars), writers(num_vars);
+    std::vector<std::atomic<int>> num_writes(num_vars);
+    for (int i = 0; i < num_vars; ++i) {
+      vars.push_back(engine->NewVariable());
+      readers[i] = 0;
+      writers[i] = 0;
+      num_writes[i] = 0;
+    }
+    std::atomic<int> violations{0};
+    std::atomic<int> pushed_writes{0};
+    std::vector<std::thread> pushers;
+    for (int t = 0; t < num_pushers; ++t) {
+      pushers.emplace_back([&, t]() {
+        std::mt19937 generator(seed_ + t);
+        std::uniform_int_distribution<int> distribution_var(0, num_vars - 1);
+        for (int k = 0; k < num_ops; ++k) {
+          const int v = distribution_var(generator);
+          if (generator() % 4 == 0) {
+            ++pushed_writes;
+            engine->PushSync([&, v](mxnet::RunContext) {
+                if (++writers[v] != 1 || readers[v] != 0) ++violations;
+                ++num_writes[v];
+                --writers[v];
+              }, mxnet::Context::CPU(), {}, {vars[v]});
+          } else {
+            engine->PushSync([&, v](mxnet::RunContext) {
+                ++readers[v];
+                if (writers[v] != 0) ++violations;
+                --readers[v];
+              }, mxnet::Context::CPU(), {vars[v]}, {});
+          }
+        }
+      });
+    }
+    for (auto& pusher : pushers) pusher.join();
+    engine->WaitForAll();
+    EXPECT_EQ(violations.load(), 0);
+    int total_writes = 0;
+    for (int i = 0; i < num_vars; ++i) {
+      EXPECT_EQ(vars[i]->version(), static_cast<size_t>(num_writes[i].load()));
+      total_writes += num_writes[i];
+      engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), vars[i]);
+    }
+    EXPECT_EQ(total_writes, pushed_writes.load());
+    engine->WaitForAll();
+  }
+}
+
+TEST(Engine, AutoBulkFlush) {
+  setenv("MXNET_ENGINE_AUTO_BULK_SIZE", "64", 1);
+  setenv("MXNET_ENGINE_AUTO_BULK_TIME_US", "1000", 1);
+  std::unique_ptr<mxnet::Engine> engine(mxnet::engine::CreateThreadedEnginePerDevice());
+  unsetenv("MXNET_ENGINE_AUTO_BULK_SIZE");
+  unsetenv("MXNET_ENGINE_AUTO_BULK_TIME_US");
+  auto push_chain = [&engine](mxnet::Engine::VarHandle var, std::atomic<int>* count, int n) {
+    for (int i = 0; i < n; ++i) {
+      engine->PushSync([count](mxnet::RunContext) { ++*count; },
+                       mxnet::Context::CPU(), {}, {var});
+    }
+  };
+
+  // a wait in another thread executes the bulk left open by the pushing thread
+  auto var = engine->NewVariable();
+  std::atomic<int> count{0};
+  std::thread pusher([&]() { push_chain(var, &count, 10); });
+  pusher.join();
+  std::thread waiter([&]() { engine->WaitForVar(var); });
+  waiter.join();
+  EXPECT_EQ(count.load(), 10);
+
+  // without any further push or wait, the bulk is executed after the time limit
+  count = 0;
+  push_chain(var, &count, 10);
+  const double start = dmlc::GetTime();
+  while (count.load() < 10 && dmlc::GetTime() - start < 10) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(count.load(), 10);
+
+  engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), var);
+  engine->WaitForAll();
+}
+
 #ifdef _OPENMP
 
 struct TestSaveAndRestoreOMPState {
@@ -0,0 +1,238 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file cached_op_threadsafe_test.cc
+ * \brief Tests batching of the concurrent calls of a thread safe CachedOp
+ */
+#include <gtest/gtest.h>
+#include <mxnet/c_api.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint32_t kInDim = 4;
+const uint32_t kOutDim = 3;
+
+// out = FullyConnected(data, weight, num_hidden=3, no_bias=True)
+const char* kFullyConnectedJSON = R"({
+  "nodes": [
+    {"op": "null", "name": "data", "inputs": []},
+    {"op": "null", "name": "weight", "inputs": []},
+    {"op": "FullyConnected", "name": "fc",
+     "attrs": {"num_hidden": "3", "no_bias": "True"},
+     "inputs": [[0, 0, 0], [1, 0, 0]]}
+  ],
+  "arg_nodes": [0, 1],
+  "node_row_ptr": [0, 1, 2, 3],
+  "heads": [[2, 0, 0]],
+  "attrs": {"mxnet_version": ["int", 10700]}
+})";
+
+NDArrayHandle MakeArray(const std::vector<uint32_t>& shape, std::mt19937* gen) {
+  NDArrayHandle handle;
+  EXPECT_EQ(MXNDArrayCreate(shape.data(), shape.size(), 1, 0, 0, 0, &handle), 0);
+  size_t size = 1;
+  for (const auto s : shape) size *= s;
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> values(size);
+  for (auto& v : values) v = dist(*gen);
+  EXPECT_EQ(MXNDArraySyncCopyFromCPU(handle, values.data(), size), 0);
+  return handle;
+}
+
+CachedOpHandle MakeCachedOp(SymbolHandle sym, uint32_t max_batch_size, uint32_t timeout_us) {
+  const std::string batch = std::to_string(max_batch_size);
+  const std::string timeout = std::to_string(timeout_us);
+  std::vector<const char*> keys = {"data_indices", "param_indices", "static_alloc",
+                                   "max_batch_size", "batch_timeout_us"};
+  std::vector<const char*> vals = {"[0]", "[1]", "false", batch.c_str(), timeout.c_str()};
+  CachedOpHandle op;
+  EXPECT_EQ(MXCreateCachedOp(sym, keys.size(), keys.data(), vals.data(), &op, true), 0);
+  return op;
+}
+
+struct CallResult {
+  bool ok = false;
+  std::string error;
+  std::vector<float> values;
+  double seconds = 0;
+};
+
+CallResult Invoke(CachedOpHandle op, NDArrayHandle data, NDArrayHandle weight) {
+  CallResult result;
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<NDArrayHandle> inputs = {data, weight};
+  int num_outputs = 0;
+  NDArrayHandle* outputs = nullptr;
+  const int* stypes = nullptr;
+  if (MXInvokeCachedOp(op, inputs.size(), inputs.data(), 1, 0,
+                       &num_outputs, &outputs, &stypes) != 0) {
+    result.error = MXGetLastError();
+    return result;
+  }
+  NDArrayHandle out = outputs[0];
+  int ndim;
+  const int* shape;
+  EXPECT_EQ(MXNDArrayGetShape(out, &ndim, &shape), 0);
+  size_t size = 1;
+  for (int i = 0; i < ndim; ++i) size *= shape[i];
+  result.values.resize(size);
+  EXPECT_EQ(MXNDArraySyncCopyToCPU(out, result.values.data(), size), 0);
+  MXNDArrayFree(out);
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  result.ok = true;
+  return result;
+}
+
+class CachedOpThreadSafeBatching : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(MXSymbolCreateFromJSON(kFullyConnectedJSON, &sym_), 0);
+    reference_ = MakeCachedOp(sym_, 0, 0);
+  }
+
+  void TearDown() override {
+    MXFreeCachedOp(reference_);
+    MXSymbolFree(sym_);
+  }
+
+  // runs the calls concurrently, call i starting after delays[i] seconds
+  std::vector<CallResult> RunConcurrently(CachedOpHandle op,
+                                          const std::vector<NDArrayHandle>& data,
+                                          const std::vector<NDArrayHandle>& weights,
+                                          const std::vector<double>& delays) {
+    std::vector<CallResult> results(data.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < data.size(); ++i) {
+      threads.emplace_back([&, i]() {
+        std::this_thread::sleep_for(std::chrono::duration<double>(delays[i]));
+        results[i] = Invoke(op, data[i], weights[i]);
+      });
+    }
+    for (auto& t : threads) t.join();
+    return results;
+  }
+
+  // compares the result of a call with the unbatched forward of the same inputs
+  void ExpectUnbatched(const CallResult& result, NDArrayHandle data, NDArrayHandle weight) {
+    ASSERT_TRUE(result.ok) << result.error;
+    const CallResult expected = Invoke(reference_, data, weight);
+    ASSERT_TRUE(expected.ok) << expected.error;
+    ASSERT_EQ(result.values.size(), expected.values.size());
+    for (size_t i = 0; i < expected.values.size(); ++i) {
+      EXPECT_NEAR(result.values[i], expected.values[i], 1e-5f);
+    }
+  }
+
+  SymbolHandle sym_;
+  CachedOpHandle reference_;
+  std::mt19937 gen_{17};
+};
+
+}  // namespace
+
+TEST_F(CachedOpThreadSafeBatching, FullBatch) {
+  // the batch is full long before the timeout
+  const uint32_t max_batch = 8;
+  CachedOpHandle op = MakeCachedOp(sym_, max_batch, 10000000);
+  NDArrayHandle weight = MakeArray({kOutDim, kInDim}, &gen_);
+  std::vector<NDArrayHandle> data;
+  for (uint32_t i = 0; i < 4; ++i) {
+    data.push_back(MakeArray({i % 2 + 1, kInDim}, &gen_));
+  }
+  // 1 + 2 + 1 + 2 + 2 = 8 rows, the last call completes the batch
+  data.push_back(MakeArray({2, kInDim}, &gen_));
+  std::vector<NDArrayHandle> weights(data.size(), weight);
+  std::vector<double> delays(data.size(), 0.0);
+  delays.back() = 0.2;
+  const auto results = RunConcurrently(op, data, weights, delays);
+  for (size_t i = 0; i < data.size(); ++i) {
+    ExpectUnbatched(results[i], data[i], weight);
+    EXPECT_LT(results[i].seconds, 5.0);
+  }
+  for (auto d : data) MXNDArrayFree(d);
+  MXNDArrayFree(weight);
+  MXFreeCachedOp(op);
+}
+
+TEST_F(CachedOpThreadSafeBatching, ManyThreads) {
+  const uint32_t max_batch = 4;
+  CachedOpHandle op = MakeCachedOp(sym_, max_batch, 2000);
+  NDArrayHandle weight = MakeArray({kOutDim, kInDim}, &gen_);
+  std::vector<NDArrayHandle> data;
+  for (uint32_t i = 0; i < 32; ++i) {
+    // calls as large as the maximum batch size are not batched
+    data.push_back(MakeArray({i % max_batch + 1, kInDim}, &gen_));
+  }
+  std::vector<NDArrayHandle> weights(data.size(), weight);
+  const auto results = RunConcurrently(op, data, weights,
+                                       std::vector<double>(data.size(), 0.0));
+  for (size_t i = 0; i < data.size(); ++i) {
+    ExpectUnbatched(results[i], data[i], weight);
+  }
+  for (auto d : data) MXNDArrayFree(d);
+  MXNDArrayFree(weight);
+  MXFreeCachedOp(op);
+}
+
+TEST_F(CachedOpThreadSafeBatching, NonStackableCallFlushesBatch) {
+  // the second call uses other parameters, so it closes the batch of the first
+  // one instead of waiting for the timeout
+  const double timeout = 3.0;
+  CachedOpHandle op = MakeCachedOp(sym_, 8, static_cast<uint32_t>(timeout * 1e6));
+  NDArrayHandle weight1 = MakeArray({kOutDim, kInDim}, &gen_);
+  NDArrayHandle weight2 = MakeArray({kOutDim, kInDim}, &gen_);
+  std::vector<NDArrayHandle> data = {MakeArray({2, kInDim}, &gen_),
+                                     MakeArray({1, kInDim}, &gen_)};
+  const auto results = RunConcurrently(op, data, {weight1, weight2}, {0.0, 0.2});
+  ExpectUnbatched(results[0], data[0], weight1);
+  ExpectUnbatched(results[1], data[1], weight2);
+  EXPECT_LT(results[0].seconds, timeout / 2);
+  for (auto d : data) MXNDArrayFree(d);
+  MXNDArrayFree(weight1);
+  MXNDArrayFree(weight2);
+  MXFreeCachedOp(op);
+}
+
+TEST_F(CachedOpThreadSafeBatching, LeaderErrorReachesAllCalls) {
+  // the data do not match the weight, so the forward of the batch fails
+  CachedOpHandle op = MakeCachedOp(sym_, 3, 10000000);
+  NDArrayHandle weight = MakeArray({kOutDim, kInDim}, &gen_);
+  std::vector<NDArrayHandle> data = {MakeArray({1, kInDim + 1}, &gen_),
+                                     MakeArray({2, kInDim + 1}, &gen_)};
+  const auto results = RunConcurrently(op, data, {weight, weight}, {0.0, 0.2});
+  for (const auto& result : results) {
+    EXPECT_FALSE(result.ok);
+    EXPECT_FALSE(result.error.empty());
+  }
+  // the op keeps working after the error
+  NDArrayHandle good = MakeArray({1, kInDim}, &gen_);
+  ExpectUnbatched(Invoke(op, good, weight), good, weight);
+  for (auto d : data) MXNDArrayFree(d);
+  MXNDArrayFree(good);
+  MXNDArrayFree(weight);
+  MXFreeCachedOp(op);
+}
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file comm_cpu_reduce_test.cc
+ * \brief Correctness and bandwidth of the summation used by the CPU kvstore reduction
+ */
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../src/kvstore/comm_cpu_reduce-inl.h"
+#include "../include/test_util.h"
+
+namespace {
+
+using mxnet::kvstore::reduce::ExprReduceSum;
+using mxnet::kvstore::reduce::ParallelReduceSum;
+
+/*! \brief fills num_src arrays of the given size with random values */
+template<typename DType>
+std::vector<std::vector<DType>> RandomSources(int num_src, size_t size, std::mt19937* gen) {
+  std::uniform_real_distribution<float> dis(-1.f, 1.f);
+  std::vector<std::vector<DType>> src(num_src, std::vector<DType>(size));
+  for (auto& s : src) {
+    for (auto& v : s) v = DType(dis(*gen));
+  }
+  return src;
+}
+
+template<typename DType>
+std::vector<DType*> Pointers(std::vector<std::vector<DType>>* src) {
+  std::vector<DType*> dptr;
+  for (auto& s : *src) dptr.push_back(s.data());
+  return dptr;
+}
+
+/*! \brief checks the sum of the sources against the sum in double precision */
+template<typename DType>
+void CheckReduceSum(double rtol) {
+  std::mt19937 gen(42);
+  for (int num_src : {1, 2, 3, 7, 8, 9, 16, 33}) {
+    for (size_t size : {1, 15, 2048, 2049, 100003}) {
+      auto src = RandomSources<DType>(num_src, size, &gen);
+      std::vector<double> expected(size, 0.0);
+      for (const auto& s : src) {
+        for (size_t i = 0; i < size; ++i) expected[i] += static_cast<double>(s[i]);
+      }
+      ParallelReduceSum(Pointers(&src), size, 4, 1000, true);
+      for (size_t i = 0; i < size; ++i) {
+        ASSERT_NEAR(static_cast<double>(src[0][i]), expected[i],
+                    rtol * (1.0 + std::abs(expected[i])))
+          << "num_src=" << num_src << " size=" << size << " i=" << i;
+      }
+    }
+  }
+}
+
+/*! \brief bytes read per second by the summation */
+template<typename Fn>
+double Bandwidth(int num_src, size_t size, int num_runs, Fn fn) {
+  fn();
+  const double start = dmlc::GetTime();
+  for (int r = 0; r < num_runs; ++r) fn();
+  const double elapsed = (dmlc::GetTime() - start) / num_runs;
+  return num_src * size * sizeof(float) / elapsed;
+}
+
+}  // namespace
+
+TEST(KVSTORE_REDUCE, SumFloat) {
+  CheckReduceSum<float>(1e-5);
+}
+
+TEST(KVSTORE_REDUCE, SumDouble) {
+  CheckReduceSum<double>(1e-12);
+}
+
+TEST(KVSTORE_REDUCE, SumHalf) {
+  CheckReduceSum<mshadow::half::half_t>(2e-3);
+}
+
+TEST(KVSTORE_REDUCE, SumBFloat16) {
+  CheckReduceSum<mshadow::bfloat::bf16_t>(1.6e-2);
+}
+
+TEST(KVSTORE_REDUCE, SumInt) {
+  CheckReduceSum<int32_t>(0);
+}
+
+// Compares the blocked summation with the summation of the mshadow expressions,
+// split into 4K elements tasks on 4 threads, as the reduction of CommCPU did before
+TEST(KVSTORE_REDUCE_PERF, Bandwidth) {
+  const size_t size = mxnet::test::performance_run ? 16 << 20 : 1 << 18;
+  const int num_runs = mxnet::test::performance_run ? 20 : 2;
+  const std::vector<int> num_srcs = mxnet::test::performance_run ?
+                                    std::vector<int>{8, 16, 32} :
+                                    std::vector<int>{8};
+  std::mt19937 gen(0);
+  for (int num_src : num_srcs) {
+    auto src = RandomSources<float>(num_src, size, &gen);
+    const auto dptr = Pointers(&src);
+    const double expr = Bandwidth(num_src, size, num_runs, [&]() {
+      const size_t step = 4 << 10;
+      const long ntask = (size + step - 1) / step;  // NOLINT(*)
+      #pragma omp parallel for schedule(static) num_threads(4)
+      for (long j = 0; j < ntask; ++j) {  // NOLINT(*)
+        const size_t begin = j * step;
+        const size_t end = std::min(begin + step, size);
+        ExprReduceSum(dptr, begin, static_cast<mxnet::index_t>(end - begin));
+      }
+    });
+    LOG(INFO) << "expression\tsources=" << num_src << "\tthreads=4\t"
+              << expr / 1e9 << " GB/sec";
+    for (int nthread : {4, 0}) {
+      const double blocked = Bandwidth(num_src, size, num_runs, [&]() {
+        ParallelReduceSum(dptr, size, nthread, 0, true);
+      });
+      LOG(INFO) << "blocked\tsources=" << num_src << "\tthreads="
+                << mxnet::kvstore::reduce::NumThreads(nthread, size) << "\t"
+                << blocked / 1e9 << " GB/sec";
+    }
+  }
+}
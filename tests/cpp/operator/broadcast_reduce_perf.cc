@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * Copyright (c) 2020 by Contributors
+ * \file broadcast_reduce_perf.cc
+ * \brief Timing of the CPU reduction engine against a reduction which
+ *        parallelizes over the outputs only and unravels every element
+ */
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <gtest/gtest.h>
+#include <mxnet/tensor_blob.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "../../src/operator/tensor/broadcast_reduce-inl.h"
+#include "../include/test_util.h"
+
+namespace {
+
+constexpr int kNDim = 2;
+
+using mshadow::index_t;
+using mshadow::Shape;
+using mshadow::Shape2;
+using mxnet::op::mshadow_op::identity;
+
+/*! \brief reference: one output per iteration, as before the reduction engine */
+template<typename Reducer>
+void ReduceByOutput(const Shape<kNDim>& bshape, const Shape<kNDim>& sshape,
+                    const float* big, float* small) {
+  Shape<kNDim> rshape, rstride;
+  mxnet::op::broadcast::diff(sshape, bshape, &rshape, &rstride);
+  const index_t N = sshape.Size(), M = rshape.Size();
+  const int nthreads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t idx = 0; idx < N; ++idx) {
+    mxnet::op::broadcast::seq_reduce_assign<Reducer, kNDim, float, float, float, identity>(
+      idx, M, false, big, small, bshape, sshape, rshape, rstride);
+  }
+}
+
+template<typename Reducer>
+void ReduceByEngine(const Shape<kNDim>& bshape, const Shape<kNDim>& sshape,
+                    const float* big, float* small) {
+  Shape<kNDim> rshape, rstride;
+  mxnet::op::broadcast::diff(sshape, bshape, &rshape, &rstride);
+  mxnet::op::broadcast::seq_reduce_compute<Reducer, kNDim, float, float, float, identity>(
+    sshape.Size(), rshape.Size(), false, big, small, bshape, sshape, rshape, rstride);
+}
+
+template<typename Reducer>
+void TimeReduce(const std::string& name, const Shape<kNDim>& bshape,
+                const Shape<kNDim>& sshape, const int repeat) {
+  std::vector<float> big(bshape.Size());
+  for (size_t i = 0; i < big.size(); ++i) {
+    big[i] = static_cast<float>(i % 97) / 97.0f - 0.5f;
+  }
+  std::vector<float> expected(sshape.Size()), actual(sshape.Size());
+  ReduceByOutput<Reducer>(bshape, sshape, big.data(), expected.data());
+  ReduceByEngine<Reducer>(bshape, sshape, big.data(), actual.data());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-3 * std::max(1.0f, std::abs(expected[i])));
+  }
+  double start = dmlc::GetTime();
+  for (int i = 0; i < repeat; ++i) {
+    ReduceByOutput<Reducer>(bshape, sshape, big.data(), expected.data());
+  }
+  const double by_output = (dmlc::GetTime() - start) / repeat;
+  start = dmlc::GetTime();
+  for (int i = 0; i < repeat; ++i) {
+    ReduceByEngine<Reducer>(bshape, sshape, big.data(), actual.data());
+  }
+  const double by_engine = (dmlc::GetTime() - start) / repeat;
+  LOG(INFO) << name << "\t" << bshape << " -> " << sshape
+            << "\tby output: " << by_output * 1e3 << " ms"
+            << "\tengine: " << by_engine * 1e3 << " ms"
+            << "\tspeedup: " << by_output / by_engine;
+}
+
+}  // namespace
+
+TEST(BROADCAST_REDUCE_PERF, TimingCPU) {
+  const index_t scale = mxnet::test::performance_run ? 16 : 1;
+  const int repeat = mxnet::test::performance_run ? 20 : 2;
+  const std::vector<Shape<kNDim> > shapes = {
+    Shape2(1024 * scale, 1024),
+    Shape2(16, 65536 * scale),
+    Shape2(65536 * scale, 16),
+  };
+  for (const auto& shape : shapes) {
+    TimeReduce<mshadow::red::sum>("sum all", shape, Shape2(1, 1), repeat);
+    TimeReduce<mshadow::red::sum>("sum rows", shape, Shape2(shape[0], 1), repeat);
+    TimeReduce<mshadow::red::sum>("sum columns", shape, Shape2(1, shape[1]), repeat);
+    TimeReduce<mshadow::red::maximum>("max all", shape, Shape2(1, 1), repeat);
+    TimeReduce<mshadow::red::maximum>("max rows", shape, Shape2(shape[0], 1), repeat);
+    TimeReduce<mshadow::red::maximum>("max columns", shape, Shape2(1, shape[1]), repeat);
+  }
+}
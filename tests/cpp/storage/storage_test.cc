@@ -26,7 +26,9 @@
 #include <mxnet/storage.h>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include "test_util.h"
+#include "../../../src/storage/numa_pooled_storage_manager.h"
 
 TEST(Storage, Basic_CPU) {
   constexpr size_t kSize = 1024;
@@ -70,6 +72,63 @@ TEST(Storage, CPU_MemAlign) {
 }
 
 
+TEST(Storage, CPU_NUMAPool) {
+  using mxnet::storage::NUMAPooledStorageManager;
+  using mxnet::storage::RoundMultiple;
+  using mxnet::storage::UnorderedMapContainer;
+  auto profiler = mxnet::profiler::CpuNUMAStorageProfiler::Get();
+  mxnet::Context context_cpu = mxnet::Context::CPU(0);
+  NUMAPooledStorageManager<RoundMultiple, UnorderedMapContainer> pool(context_cpu);
+
+  constexpr size_t kSize = 3000;
+  const int node = mxnet::storage::numa::CurrentNode();
+  EXPECT_LT(node, mxnet::storage::numa::NumNodes());
+  const size_t used_before = profiler->UsedMemory(node);
+
+  mxnet::Storage::Handle handle;
+  handle.ctx = context_cpu;
+  handle.size = kSize;
+  pool.Alloc(&handle);
+  ASSERT_NE(handle.dptr, nullptr);
+  EXPECT_EQ(reinterpret_cast<intptr_t>(handle.dptr) % mxnet::storage::numa::kPageSize, 0);
+  EXPECT_EQ(profiler->UsedMemory(node), used_before + kSize);
+  std::memset(handle.dptr, 0, kSize);
+  void *dptr = handle.dptr;
+  pool.Free(handle);
+  EXPECT_EQ(profiler->UsedMemory(node), used_before);
+
+  // the chunk is reused when allocated from the same node
+  pool.Alloc(&handle);
+  if (mxnet::storage::numa::CurrentNode() == node)
+    EXPECT_EQ(handle.dptr, dptr);
+  pool.DirectFree(handle);
+  pool.ReleaseAll();
+}
+
+TEST(Storage, CPU_HugePages) {
+  using mxnet::storage::ContextHelperCPUHugePages;
+  using Pool = mxnet::storage::PooledStorageManager<mxnet::storage::RoundMultiple,
+                                                    mxnet::storage::UnorderedMapContainer>;
+  constexpr size_t kHugePage = ContextHelperCPUHugePages::kTransparentHugePageSize;
+  mxnet::Context context_cpu = mxnet::Context::CPU(0);
+  // Explicit huge pages fall back to the transparent ones, when none are reserved
+  for (auto mode : {ContextHelperCPUHugePages::Mode::kTransparent,
+                    ContextHelperCPUHugePages::Mode::kExplicit}) {
+    Pool pool(context_cpu, 0, std::make_unique<ContextHelperCPUHugePages>(mode, kHugePage));
+    for (size_t size : {size_t(1000), 2 * kHugePage, 3 * kHugePage + 100}) {
+      mxnet::Storage::Handle handle;
+      handle.ctx = context_cpu;
+      handle.size = size;
+      pool.Alloc(&handle);
+      ASSERT_NE(handle.dptr, nullptr);
+      if (size >= kHugePage)
+        EXPECT_EQ(reinterpret_cast<intptr_t>(handle.dptr) % kHugePage, 0);
+      std::memset(handle.dptr, 1, size);
+      pool.DirectFree(handle);
+    }
+  }
+}
+
 #if MXNET_USE_CUDA
 TEST(Storage_GPU, Basic_GPU) {
   if (mxnet::test::unitTestsWithCuda) {
@@ -0,0 +1,98 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import os
+import sys
+sys.path.insert(0, "../../python/")
+import argparse
+import mxnet as mx
+import numpy as np
+
+# slice every key into many slices, and pull them one at a time
+os.environ['MXNET_KVSTORE_SLICE_THRESHOLD'] = '1000'
+os.environ['MXNET_KVSTORE_P3_PULL_WINDOW'] = '1'
+
+shape = (2, 3)
+big_shape = (1200, 1200)
+rsp_shape = (3000, 10)
+threshold = 0.5
+
+
+def check_diff(A, x, rank):
+    assert (np.sum(np.abs((A - x).asnumpy())) == 0), (rank, A.asnumpy(), x)
+
+
+def test_dense(kv, nrepeat):
+    my_rank = kv.rank
+    nworker = kv.num_workers
+    keys = ['3', '5', '99']
+    shapes = [shape, shape, big_shape]
+    kv.init(keys, [mx.nd.ones(s) for s in shapes])
+    rsp_key = '9'
+    kv.init(rsp_key, mx.nd.ones(rsp_shape).tostype('row_sparse'))
+    expected = (nworker + 1) * nworker / 2
+    for _ in range(nrepeat):
+        # the servers have no optimizer, they store the sum of the pushes
+        for k, s in zip(keys, shapes):
+            kv.push(k, mx.nd.ones(s) * (my_rank + 1))
+            val = mx.nd.zeros(s)
+            kv.pull(k, out=val)
+            check_diff(val, expected, my_rank)
+            val = mx.nd.zeros(s)
+            kv.pushpull(k, mx.nd.ones(s) * (my_rank + 1), out=val)
+            check_diff(val, expected, my_rank)
+
+        kv.push(rsp_key, (mx.nd.ones(rsp_shape) * (my_rank + 1)).tostype('row_sparse'))
+        row_ids = mx.nd.array(np.arange(my_rank, rsp_shape[0], 3), dtype='int64')
+        val = mx.nd.sparse.zeros('row_sparse', rsp_shape)
+        kv.row_sparse_pull(rsp_key, out=val, row_ids=row_ids)
+        dense = val.asnumpy()
+        retained = dense[row_ids.asnumpy().astype(np.int64)]
+        assert np.all(retained == expected), (my_rank, retained)
+        assert np.sum(dense) == retained.size * expected, my_rank
+
+
+def test_compressed(kv, nrepeat):
+    my_rank = kv.rank
+    nworker = kv.num_workers
+    kv.set_gradient_compression({'type': '2bit', 'threshold': threshold})
+    keys = ['3', '99']
+    shapes = [shape, big_shape]
+    kv.init(keys, [mx.nd.zeros(s) for s in shapes])
+    for _ in range(nrepeat):
+        for k, s in zip(keys, shapes):
+            # a gradient of the threshold is sent exactly, without residual
+            kv.push(k, mx.nd.ones(s) * threshold)
+            val = mx.nd.zeros(s)
+            kv.pull(k, out=val)
+            check_diff(val, nworker * threshold, my_rank)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='test the sliced P3 kvstore')
+    parser.add_argument('--type', type=str, default='dense', choices=['dense', 'compressed'])
+    parser.add_argument('--nrepeat', type=int, default=3)
+    opt = parser.parse_args()
+    kv = mx.kv.create('dist_sync')
+    if opt.type == 'dense':
+        test_dense(kv, opt.nrepeat)
+    else:
+        test_compressed(kv, opt.nrepeat)
+    print('worker {} passed'.format(kv.rank))
@@ -88,9 +88,11 @@ def set_optimizer(use_multiprecision):
     kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate, multi_precision=use_multiprecision))
     return kv
 
-def init_kv_compressed(kv):
+def init_kv_compressed(kv, compression_params=None):
     threshold = 0.5
-    kv.set_gradient_compression({'type': '2bit', 'threshold': threshold})
+    if compression_params is None:
+        compression_params = {'type': '2bit', 'threshold': threshold}
+    kv.set_gradient_compression(compression_params)
     # init kv compression keys
     for k, s in compr_keys_shapes:
         kv.init(k, mx.nd.zeros(s))
@@ -328,6 +330,62 @@ def test_sync_2bit_compression(threshold, nrepeat):
     check_compr_random(threshold, nrepeat)
     print('worker ' + str(my_rank) + ' is done with compression tests')
 
+def test_sync_1bit_compression(threshold, nrepeat):
+    # values of the threshold are sent exactly and leave no residual
+    curval = np.zeros(1)
+    for sign in [1, -1]:
+        for i in range(nrepeat):
+            curval += sign * threshold * rate * nworker
+            for k, s in compr_keys_shapes:
+                kv.push(k, mx.nd.ones(s) * sign * threshold)
+                val = mx.nd.zeros(s)
+                kv.pull(k, val)
+                check_diff(val, curval[0])
+    # any value is sent as the sign of value plus residual
+    for k, s in compr_init_keys_shapes:
+        orig = mx.nd.zeros(s)
+        kv.pull(k, orig)
+        kv.push(k, mx.nd.ones(s) * 0.1)
+        val = mx.nd.zeros(s)
+        kv.pull(k, val)
+        check_diff(val - orig, threshold * rate * nworker)
+    print('worker ' + str(my_rank) + ' is done with 1bit compression tests')
+
+def test_sync_sparse_compression(compression, group, nrepeat):
+    def group_view(arr):
+        flat = arr.asnumpy().reshape(-1)
+        pad = (-flat.size) % group
+        return np.concatenate([flat, np.zeros(pad)]).reshape(-1, group)
+
+    for k, s in compr_keys_shapes:
+        size = int(np.prod(s))
+        if compression == 'topk':
+            # one spike per group, which is the value sent
+            grad = np.zeros(size)
+            grad[::group] = 1
+            kv.push(k, mx.nd.array(grad.reshape(s)))
+            val = mx.nd.zeros(s)
+            kv.pull(k, val)
+            check_diff(val, mx.nd.array(grad.reshape(s) * rate * nworker))
+            # nothing is left in the residual
+            kv.push(k, mx.nd.zeros(s))
+            kv.pull(k, val)
+            check_diff(val, mx.nd.array(grad.reshape(s) * rate * nworker))
+        else:
+            orig = mx.nd.zeros(s)
+            kv.pull(k, orig)
+            for i in range(nrepeat):
+                kv.push(k, mx.nd.ones(s))
+                val = mx.nd.zeros(s)
+                kv.pull(k, val)
+                # the workers choose the same value of every group, which holds
+                # what accumulated there since it was last sent
+                diff = group_view(val - orig)
+                assert np.all(np.count_nonzero(diff, axis=1) == 1), (my_rank, k)
+                assert np.all(diff >= rate * nworker), (my_rank, k)
+                orig = val
+    print('worker ' + str(my_rank) + ' is done with ' + compression + ' compression tests')
+
 def test_sync_init(gpu_tests=False):
     def get_dtype(idx, cur_keys):
         if idx < len(cur_keys)/2:
@@ -459,5 +517,14 @@ if __name__ == "__main__":
         kv, threshold = init_kv_compressed(kv)
         kv = set_optimizer(use_multiprecision=opt.multiprecision)
         test_sync_2bit_compression(threshold, opt.nrepeat)
+    elif opt.type == 'compressed_1bit_cpu':
+        kv, threshold = init_kv_compressed(kv, {'type': '1bit', 'threshold': 0.5})
+        kv = set_optimizer(use_multiprecision=opt.multiprecision)
+        test_sync_1bit_compression(threshold, opt.nrepeat)
+    elif opt.type in ('compressed_topk_cpu', 'compressed_randomk_cpu'):
+        compression = opt.type.split('_')[1]
+        kv, _ = init_kv_compressed(kv, {'type': compression, 'ratio': 1.0 / 64})
+        kv = set_optimizer(use_multiprecision=opt.multiprecision)
+        test_sync_sparse_compression(compression, 64, opt.nrepeat)
     else:
         raise RuntimeError("Unknown test type")
@@ -0,0 +1,80 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import os
+import sys
+sys.path.insert(0, "../../python/")
+import argparse
+import mxnet as mx
+import numpy as np
+
+# split the workers of this machine into two groups, as if they ran on two hosts
+os.environ['MXNET_KVSTORE_HOST_AGGREGATION'] = '1'
+os.environ['MXNET_KVSTORE_HOST_GROUP'] = 'group{}'.format(os.getpid() % 2)
+
+shape = (2, 3)
+big_shape = (1200, 1200)        # bigger than MXNET_KVSTORE_BIGARRAY_BOUND
+keys_shapes = [('3', shape), ('5', shape), ('99', big_shape)]
+fp16_keys_shapes = [('4', shape), ('100', big_shape)]
+rate = 2
+
+kv = mx.kv.create('dist_sync')
+my_rank = kv.rank
+nworker = kv.num_workers
+
+
+def check_diff(A, x):
+    assert (np.sum(np.abs((A - x).asnumpy())) == 0), (my_rank, A.asnumpy(), x)
+
+
+def test_push_pull(nrepeat):
+    for dtype, ks in [('float32', keys_shapes), ('float16', fp16_keys_shapes)]:
+        for k, s in ks:
+            for i in range(nrepeat):
+                kv.push(k, mx.nd.ones(s, dtype=dtype) * (my_rank + 1))
+                num = (nworker + 1) * nworker * rate / 2 * (i + 1) + 1
+                val = mx.nd.zeros(s, dtype=dtype)
+                kv.pull(k, out=val)
+                check_diff(val, num)
+                # consecutive pulls see the same value
+                kv.pull(k, out=val)
+                check_diff(val, num)
+
+
+def test_pushpull(nrepeat):
+    k, s = '7', shape
+    kv.init(k, mx.nd.ones(s))
+    for i in range(nrepeat):
+        val = mx.nd.zeros(s)
+        kv.pushpull(k, mx.nd.ones(s) * (my_rank + 1), out=val)
+        num = (nworker + 1) * nworker * rate / 2 * (i + 1) + 1
+        check_diff(val, num)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='test hierarchical dist_sync kvstore')
+    parser.add_argument('--nrepeat', type=int, default=7)
+    opt = parser.parse_args()
+    for dtype, ks in [('float32', keys_shapes), ('float16', fp16_keys_shapes)]:
+        kv.init([k for k, _ in ks], [mx.nd.ones(s, dtype=dtype) for _, s in ks])
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate))
+    test_push_pull(opt.nrepeat)
+    test_pushpull(opt.nrepeat)
+    print('worker {} passed'.format(my_rank))
@@ -0,0 +1,106 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import os
+from tempfile import TemporaryDirectory
+import mxnet as mx
+import numpy as np
+from mxnet import profiler
+from mxnet.test_utils import *
+from common import with_seed
+
+def ran_fused_op(f):
+    """Whether a _FusedOp was executed while running f"""
+    with TemporaryDirectory(prefix='test_fusion_cpu_') as tmpdir:
+        profiler.set_config(profile_all=True, aggregate_stats=True,
+                            filename=os.path.join(tmpdir, 'profile.json'))
+        profiler.set_state('run')
+        profiler.dumps(reset=True)
+        f()
+        mx.nd.waitall()
+        profiler.set_state('stop')
+        return '_FusedOp' in profiler.dumps(reset=True)
+
+def check_fused_symbol_cpu(sym, **kwargs):
+    inputs = sym.list_inputs()
+    shapes = {inp : kwargs[inp].shape for inp in inputs}
+    # Double identity so that there is always something to fuse
+    test_sym = mx.sym.Group([mx.sym.identity(mx.sym.identity(s)) for s in sym])
+    rtol = {'float32' : 1.5e-6, 'float64' : 1.5e-6}
+    atol = {'float32' : 1e-7, 'float64' : 1e-7}
+    for dtype in ['float32', 'float64']:
+        data = {inp : kwargs[inp].astype(dtype) for inp in inputs}
+        for grad_req in ['write', 'add']:
+            type_dict = {inp : dtype for inp in inputs}
+            # the graph is optimized on the first forward, which needs to see the flag
+            with environment('MXNET_USE_FUSION', '0'):
+                orig_exec = test_sym._simple_bind(ctx=mx.cpu(), grad_req=grad_req,
+                                                  type_dict=type_dict, **shapes)
+                fwd_orig = orig_exec.forward(is_train=True, **data)
+                out_grads = [mx.nd.ones_like(arr) for arr in fwd_orig]
+                orig_exec.backward(out_grads=out_grads)
+            with environment('MXNET_USE_FUSION', '1'):
+                fused_exec = test_sym._simple_bind(ctx=mx.cpu(), grad_req=grad_req,
+                                                   type_dict=type_dict, **shapes)
+                fwd_fused = fused_exec.forward(is_train=True, **data)
+                fused_exec.backward(out_grads=out_grads)
+            # the fused CPU path actually ran, and only with fusion enabled
+            assert ran_fused_op(lambda: fused_exec.forward(is_train=True, **data))
+            assert not ran_fused_op(lambda: orig_exec.forward(is_train=True, **data))
+            for orig, fused in zip(fwd_orig, fwd_fused):
+                np.testing.assert_allclose(orig.asnumpy(), fused.asnumpy(),
+                                           rtol=rtol[dtype], atol=atol[dtype])
+            for orig, fused in zip(orig_exec.grad_arrays, fused_exec.grad_arrays):
+                if orig is None and fused is None:
+                    continue
+                assert orig is not None
+                assert fused is not None
+                np.testing.assert_allclose(orig.asnumpy(), fused.asnumpy(),
+                                           rtol=rtol[dtype], atol=atol[dtype])
+
+@with_seed()
+def test_fusion_cpu_chains():
+    a = mx.sym.Variable('a')
+    b = mx.sym.Variable('b')
+    # Large enough to be split into multiple tiles
+    shape = (37, 1021)
+    arr1 = mx.random.uniform(shape=shape)
+    arr2 = mx.random.uniform(shape=shape)
+    check_fused_symbol_cpu(mx.sym.relu(a + b) * b, a=arr1, b=arr2)
+    check_fused_symbol_cpu(mx.sym.exp(mx.sym.tanh(a) * 3 - b) / (b + 1), a=arr1, b=arr2)
+    check_fused_symbol_cpu(mx.sym.Cast(mx.sym.sigmoid(a * b), dtype='float64') + 1,
+                           a=arr1, b=arr2)
+    check_fused_symbol_cpu(mx.sym.Group([mx.sym.sqrt(a + 1), mx.sym.square(a) * b]),
+                           a=arr1, b=arr2)
+    check_fused_symbol_cpu(mx.sym.reshape(mx.sym.clip(a - b, a_min=-0.2, a_max=0.2),
+                                          shape=(-1,)) * 2, a=arr1, b=arr2)
+
+@with_seed()
+def test_fusion_cpu_hybrid_block():
+    class Chain(mx.gluon.HybridBlock):
+        def hybrid_forward(self, F, x, y):
+            return F.cast(F.relu(x + y) * y, dtype='float64')
+
+    x = mx.nd.random.uniform(shape=(64, 1000))
+    y = mx.nd.random.uniform(shape=(64, 1000))
+    expected = Chain()(x, y)
+    with environment('MXNET_USE_FUSION', '1'):
+        net = Chain()
+        net.hybridize(static_alloc=True)
+        out = net(x, y)
+        assert ran_fused_op(lambda: net(x, y))
+    assert out.dtype == np.float64
+    assert_almost_equal(out.asnumpy(), expected.asnumpy())
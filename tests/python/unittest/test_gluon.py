@@ -1665,6 +1665,159 @@ def test_hybrid_static_memory_switching(static_alloc, static_shape):
         y.backward()
     mx.nd.waitall()
 
+
+@pytest.mark.parametrize('static_alloc', [False, True])
+def test_hybrid_compile_cache(static_alloc):
+    # the cache directory is read once per process, so the model runs in subprocesses
+    import subprocess
+    import sys
+    script = """
+import sys
+import mxnet as mx
+mx.random.seed(1234)
+net = mx.gluon.model_zoo.vision.get_resnet(1, 18, pretrained=False)
+net.initialize()
+x = mx.nd.random.uniform(shape=(2, 3, 32, 32))
+net(x)
+net.hybridize(static_alloc=%s)
+mx.nd.save(sys.argv[1], [net(x), net(x[:1])])
+""" % static_alloc
+    with tempfile.TemporaryDirectory() as tmpdir:
+        env = dict(os.environ, MXNET_CACHED_OP_CACHE_DIR=tmpdir)
+        outputs = []
+        for i in range(2):
+            out_file = os.path.join(tmpdir, 'out%d.nd' % i)
+            subprocess.check_call([sys.executable, '-c', script, out_file], env=env)
+            outputs.append(mx.nd.load(out_file))
+            # one entry for each input shape
+            assert len([f for f in os.listdir(tmpdir) if f.endswith('.cache')]) == 2
+        for cold, warm in zip(*outputs):
+            assert_array_equal(cold.asnumpy(), warm.asnumpy())
+        # another subgraph backend does not reuse the entries
+        out_file = os.path.join(tmpdir, 'out_backend.nd')
+        env['MXNET_SUBGRAPH_BACKEND'] = 'default'
+        subprocess.check_call([sys.executable, '-c', script, out_file], env=env)
+        assert len([f for f in os.listdir(tmpdir) if f.endswith('.cache')]) == 4
+
+@with_seed()
+@pytest.mark.parametrize('bucket_sizes', [None, [4, 6, 10]])
+def test_hybrid_shape_buckets(bucket_sizes):
+    class Net(gluon.HybridBlock):
+        def __init__(self, **kwargs):
+            super(Net, self).__init__(**kwargs)
+            self.dense = nn.Dense(5, flatten=False)
+
+        def hybrid_forward(self, F, x, scale):
+            return self.dense(x) * scale, F.sum(x, axis=1)
+
+    net = Net()
+    net.initialize()
+    scale = mx.nd.array([2.0])
+    inputs = [mx.nd.random.uniform(shape=(2, length, 3)) for length in [3, 5, 8, 3, 10, 12, 5]]
+    expected = [net(x, scale) for x in inputs]
+    net.hybridize(static_alloc=True, max_static_alloc_shapes=2, bucket_axis=1,
+                  bucket_sizes=bucket_sizes, bucket_output_axes=[1, None])
+    for x, (y_expected, sum_expected) in zip(inputs, expected):
+        y, x_sum = net(x, scale)
+        assert y.shape == y_expected.shape
+        assert_almost_equal(y.asnumpy(), y_expected.asnumpy(), rtol=1e-5, atol=1e-6)
+        # the sum over the padded axis includes the zero padding
+        assert_almost_equal(x_sum.asnumpy(), sum_expected.asnumpy(), rtol=1e-5, atol=1e-6)
+
+
+@with_seed()
+def test_hybrid_shape_buckets_output_axes():
+    class Net(gluon.HybridBlock):
+        def hybrid_forward(self, F, x):
+            # the second output has the padded length along axis 1 without being
+            # a sequence, the third one is a sequence along axis 0
+            return x * 2, F.ones((2, 4)), F.transpose(x, axes=(1, 0))
+
+    net = Net()
+    net.hybridize(bucket_axis=1, bucket_sizes=[4], bucket_output_axes=[1, None, 0])
+    x = mx.nd.random.uniform(shape=(2, 3))
+    y, ones, y_t = net(x)
+    assert_almost_equal(y.asnumpy(), x.asnumpy() * 2)
+    assert ones.shape == (2, 4)
+    assert_almost_equal(y_t.asnumpy(), x.asnumpy().T)
+
+    net.hybridize(bucket_axis=1, bucket_sizes=[4], bucket_output_axes=[1, 0, 0])
+    with pytest.raises(ValueError):
+        net(mx.nd.random.uniform(shape=(3, 3)))
+    net.hybridize(bucket_axis=1, bucket_sizes=[4], bucket_output_axes=[1])
+    with pytest.raises(ValueError):
+        net(x)
+
+
+@with_seed()
+def test_hybrid_max_static_alloc_shapes():
+    net = nn.HybridSequential()
+    net.add(nn.Dense(8, activation='relu'), nn.Dense(4))
+    net.initialize()
+    inputs = [mx.nd.random.uniform(shape=(batch_size, 6)) for batch_size in [1, 4, 1, 7, 4, 1]]
+    expected = [net(x) for x in inputs]
+    net.hybridize(static_alloc=True, static_shape=True, max_static_alloc_shapes=2)
+    for x, y_expected in zip(inputs, expected):
+        assert_almost_equal(net(x).asnumpy(), y_expected.asnumpy(), rtol=1e-5, atol=1e-6)
+
+
+@with_seed()
+def test_hybrid_offset_memory_planner():
+    def build():
+        net = nn.HybridSequential()
+        net.add(nn.Conv2D(8, 3, padding=1, activation='relu'), nn.BatchNorm(),
+                nn.Conv2D(8, 3, padding=1), nn.Activation('tanh'),
+                nn.Dense(16, activation='relu'), nn.Dense(4))
+        net.initialize(mx.init.Xavier())
+        return net
+    x = mx.nd.random.uniform(shape=(2, 3, 8, 8))
+    expected = build()
+    params = expected.collect_params()
+    with autograd.record():
+        y_expected = expected(x)
+    y_expected.backward()
+    for static_alloc in [False, True]:
+        net = build()
+        for name, param in net.collect_params().items():
+            param.set_data(params[name.replace(net.prefix, expected.prefix)].data())
+        net.hybridize(static_alloc=static_alloc, memory_planner='offset')
+        for _ in range(2):
+            with autograd.record():
+                y = net(x)
+            y.backward()
+            assert_almost_equal(y.asnumpy(), y_expected.asnumpy(), rtol=1e-5, atol=1e-6)
+            for name, param in net.collect_params().items():
+                if param.grad_req == 'null':
+                    continue
+                expected_grad = params[name.replace(net.prefix, expected.prefix)].grad()
+                assert_almost_equal(param.grad().asnumpy(), expected_grad.asnumpy(),
+                                    rtol=1e-4, atol=1e-5)
+        assert_almost_equal(net(x).asnumpy(), expected(x).asnumpy(), rtol=1e-5, atol=1e-6)
+
+
+@with_seed()
+def test_hybrid_offset_memory_planner_branches():
+    # the independent branches run in parallel, while the arrays of a branch reuse
+    # the memory of the arrays of the other branches released before
+    class Branches(gluon.HybridBlock):
+        def hybrid_forward(self, F, x):
+            outs = []
+            for i in range(4):
+                y = x
+                for _ in range(6):
+                    y = F.tanh(y * 1.01 + i)
+                outs.append(F.sum(y, axis=1))
+            return F.concat(*outs, dim=0)
+    x = mx.nd.random.uniform(shape=(64, 256))
+    expected = Branches()(x).asnumpy()
+    for static_alloc in [False, True]:
+        net = Branches()
+        net.hybridize(static_alloc=static_alloc, memory_planner='offset')
+        outs = [net(x).copy() for _ in range(8)]
+        for out in outs:
+            assert_almost_equal(out.asnumpy(), expected, rtol=1e-5, atol=1e-5)
+
+
 @with_seed()
 def test_hook():
     global hook_call_count
@@ -568,6 +568,28 @@ def test_mx_data_loader_nopython():
     for _ in dl1:
         pass
 
+def test_mx_data_loader_prefetch_depth():
+    from mxnet.gluon.data.dataloader import _MXThreadedDataLoader, _check_mx_loader_capability
+    from mxnet.gluon.data.vision.transforms import ToTensor
+    dataset = mx.gluon.data.vision.MNIST(train=False).transform_first(ToTensor())
+    batch_sampler = gluon.data.BatchSampler(gluon.data.SequentialSampler(len(dataset)), 32, 'keep')
+    batchify_fn = mx.gluon.data.batchify.Group(mx.gluon.data.batchify.Stack(),
+                                               mx.gluon.data.batchify.Stack())
+    def load(prefetch_depth):
+        use_mx_iter, args = _check_mx_loader_capability(dataset, batch_sampler, batchify_fn)
+        assert use_mx_iter, args
+        return _MXThreadedDataLoader(num_workers=2, prefetch_depth=prefetch_depth, **args)
+    reference = [(x.asnumpy(), y.asnumpy()) for x, y in load(0)]
+    loader = load(3)
+    # two epochs, the ring is restarted on reset
+    for _ in range(2):
+        num_batches = 0
+        for (x, y), (ex, ey) in zip(loader, reference):
+            assert np.all(x.asnumpy() == ex)
+            assert np.all(y.asnumpy() == ey)
+            num_batches += 1
+        assert num_batches == len(reference)
+
 def test_batchify_stack():
     a = np.array([[1, 2, 3, 4], [5, 6, 7, 8]])
     b = np.array([[5, 6, 7, 8], [1, 2, 3, 4]])
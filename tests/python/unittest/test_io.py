@@ -95,6 +95,68 @@ def test_Cifar10Rec(cifar10):
     for i in range(10):
         assert(labelcount[i] == 5000)
 
+@pytest.mark.parametrize('decode_threads,assemble_threads', [(1, 1), (3, 2)])
+def test_Cifar10Rec_pipelined(cifar10, decode_threads, assemble_threads):
+    def make_iter(**kwargs):
+        return mx.io.ImageRecordIter(
+            path_imgrec=os.path.join(cifar10, 'cifar', 'train.rec'),
+            mean_img=os.path.join(cifar10, 'cifar', 'cifar10_mean.bin'),
+            rand_crop=True,
+            rand_mirror=True,
+            seed_aug=7,
+            shuffle=False,
+            data_shape=(3, 28, 28),
+            batch_size=128,
+            preprocess_threads=2,
+            prefetch_buffer=1,
+            **kwargs)
+    # the pipeline must produce the same batches as the per-thread processing,
+    # also across the epochs and after a reset in the middle of an epoch
+    reference = make_iter()
+    pipelined = make_iter(decode_threads=decode_threads, assemble_threads=assemble_threads,
+                          pipeline_queue_size=8)
+    for _ in range(3):
+        batch, expected = pipelined.next(), reference.next()
+        assert_almost_equal(batch.data[0].asnumpy(), expected.data[0].asnumpy())
+    for _ in range(2):
+        pipelined.reset()
+        reference.reset()
+        num_batches = 0
+        for batch, expected in zip_longest(pipelined, reference):
+            assert batch is not None and expected is not None
+            assert_almost_equal(batch.data[0].asnumpy(), expected.data[0].asnumpy())
+            assert_almost_equal(batch.label[0].asnumpy(), expected.label[0].asnumpy())
+            assert batch.pad == expected.pad
+            num_batches += 1
+        assert num_batches == (50000 + 127) // 128
+
+@pytest.mark.parametrize('mirror', [False, True])
+def test_Cifar10Rec_fused_normalize(cifar10, mirror):
+    def make_iter(**kwargs):
+        return mx.io.ImageRecordIter(
+            path_imgrec=os.path.join(cifar10, 'cifar', 'train.rec'),
+            rand_crop=False,
+            mirror=mirror,
+            shuffle=False,
+            data_shape=(3, 28, 28),
+            batch_size=100,
+            num_parts=50,
+            preprocess_threads=2,
+            **kwargs)
+    mean = np.array([125.3, 123.0, 113.9]).reshape((1, 3, 1, 1))
+    std = np.array([63.0, 62.1, 66.7]).reshape((1, 3, 1, 1))
+    # the normalized float batches must match the raw uint8 batches normalized in numpy
+    normalized = make_iter(mean_r=125.3, mean_g=123.0, mean_b=113.9,
+                           std_r=63.0, std_g=62.1, std_b=66.7)
+    raw = make_iter(dtype='uint8')
+    num_batches = 0
+    for batch, expected in zip_longest(normalized, raw):
+        assert batch is not None and expected is not None
+        expected_data = (expected.data[0].asnumpy().astype(np.float32) - mean) / std
+        assert_almost_equal(batch.data[0].asnumpy(), expected_data, rtol=1e-4, atol=1e-4)
+        num_batches += 1
+    assert num_batches > 0
+
 @pytest.mark.parametrize('inter_method', [0,1,2,3,4,9,10])
 def test_inter_methods_in_augmenter(inter_method, cifar10):
     dataiter = mx.io.ImageRecordIter(
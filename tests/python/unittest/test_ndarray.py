@@ -23,6 +23,7 @@ import os
 import pickle as pkl
 import random
 import functools
+import struct
 import pytest
 from common import with_seed, assertRaises, TemporaryDirectory
 from mxnet.test_utils import almost_equal
@@ -430,6 +431,119 @@ def test_ndarray_legacy_load():
         assert same(data[i].asnumpy(), legacy_data[i].asnumpy())
 
 
+@with_seed()
+def test_ndarray_mmap_load():
+    with TemporaryDirectory(prefix='test_mmap_load_') as tmpdir:
+        fname = os.path.join(tmpdir, 'mmap.params')
+        dmap = {'dense_%s' % i : random_ndarray(np.random.randint(1, 5)) for i in range(10)}
+        dmap['int8'] = mx.nd.arange(37, dtype='int8')
+        dmap['row_sparse'] = mx.nd.sparse.zeros('row_sparse', (4, 3))
+        mx.nd.save(fname, dmap)
+        dmap2 = mx.nd.load(fname, mmap=True)
+        assert len(dmap2) == len(dmap)
+        for k, x in dmap.items():
+            y = dmap2[k]
+            assert x.stype == y.stype
+            assert x.dtype == y.dtype
+            assert np.sum(x.asnumpy() != y.asnumpy()) == 0
+        # writes to the mapped arrays are private to the process
+        y = dmap2['dense_0']
+        y[:] = 1
+        assert np.sum(dmap2['dense_0'].asnumpy() != 1) == 0
+        dmap3 = mx.nd.load(fname, mmap=True)
+        assert np.sum(dmap['dense_0'].asnumpy() != dmap3['dense_0'].asnumpy()) == 0
+        # legacy files are copied
+        path = os.path.dirname(os.path.realpath(__file__))
+        legacy_data = mx.nd.load(os.path.join(path, 'legacy_ndarray.v0'), mmap=True)
+        for x in legacy_data:
+            assert same(x.asnumpy(), mx.nd.arange(128).asnumpy())
+        del dmap2, dmap3, y
+
+
+@with_seed()
+def test_ndarray_indexed_saveload():
+    with TemporaryDirectory(prefix='test_indexed_saveload_') as tmpdir:
+        fname = os.path.join(tmpdir, 'indexed.params')
+        data = [random_ndarray(np.random.randint(1, 5)) for _ in range(10)]
+        data.append(mx.nd.arange(37, dtype='int8'))
+        data.append(mx.nd.sparse.zeros('row_sparse', (4, 3)))
+        data.append(mx.nd.array([[1, 0], [0, 2]]).tostype('csr'))
+        # list
+        mx.nd.save(fname, data, indexed=True)
+        for mmap in [False, True]:
+            data2 = mx.nd.load(fname, mmap=mmap)
+            assert len(data) == len(data2)
+            for x, y in zip(data, data2):
+                assert x.stype == y.stype and x.dtype == y.dtype
+                assert np.sum(x.asnumpy() != y.asnumpy()) == 0
+        # from a buffer, through MXNDArrayLoadFromBuffer
+        with open(fname, 'rb') as f:
+            buf = f.read()
+        data2 = mx.nd.load_frombuffer(buf)
+        assert len(data) == len(data2)
+        for x, y in zip(data, data2):
+            assert x.stype == y.stype and x.dtype == y.dtype
+            assert np.sum(x.asnumpy() != y.asnumpy()) == 0
+        assertRaises(mx.base.MXNetError, mx.nd.load_frombuffer, buf[:-10])
+        # dict, also loaded by name
+        dmap = {'ndarray xx %s' % i : x for i, x in enumerate(data)}
+        mx.nd.save(fname, dmap, indexed=True)
+        with open(fname, 'rb') as f:
+            buf = f.read()
+        for dmap2 in [mx.nd.load(fname), mx.nd.load_frombuffer(buf)]:
+            assert len(dmap2) == len(dmap)
+            for k, x in dmap.items():
+                assert np.sum(x.asnumpy() != dmap2[k].asnumpy()) == 0
+        keys = ['ndarray xx 11', 'ndarray xx 3']
+        subset = mx.nd.load(fname, keys=keys)
+        assert sorted(subset.keys()) == sorted(keys)
+        for k in keys:
+            assert subset[k].stype == dmap[k].stype
+            assert np.sum(subset[k].asnumpy() != dmap[k].asnumpy()) == 0
+        # the files in the old format are loaded by name as well
+        mx.nd.save(fname, dmap)
+        subset = mx.nd.load(fname, keys=keys)
+        for k in keys:
+            assert np.sum(subset[k].asnumpy() != dmap[k].asnumpy()) == 0
+        assertRaises(mx.MXNetError, mx.nd.load, fname, keys=['missing'])
+
+
+@with_seed()
+def test_ndarray_indexed_load_corrupted():
+    # header: magic, flags, header size, has names, number of entries
+    entry_pos = 5 * 8
+    # entry: name, stype, dtype, context, shape, offset of the payload
+    stype_pos = entry_pos + 8
+    dtype_pos = stype_pos + 4
+    shape_pos = dtype_pos + 4 + 8
+    offset_pos = shape_pos + 4 + 2 * 8
+    # sparse entry: ..., storage shape, aux types
+    aux_types_pos = offset_pos + 8 + 4 + 8
+    dense = mx.nd.arange(6).reshape((2, 3))
+    csr = mx.nd.array([[1, 0, 0], [0, 2, 0]]).tostype('csr')
+    corruptions = [
+        (dense, stype_pos, struct.pack('<i', 42)),
+        (dense, dtype_pos, struct.pack('<i', 99)),
+        (dense, shape_pos + 4, struct.pack('<q', 1 << 40)),
+        (dense, offset_pos, struct.pack('<Q', 1 << 40)),
+        (csr, aux_types_pos, struct.pack('<Q', 1)),
+    ]
+    with TemporaryDirectory(prefix='test_indexed_corrupted_') as tmpdir:
+        fname = os.path.join(tmpdir, 'indexed.params')
+        for arr, pos, value in corruptions:
+            mx.nd.save(fname, [arr], indexed=True)
+            with open(fname, 'rb') as f:
+                buf = bytearray(f.read())
+            buf[pos:pos + len(value)] = value
+            with open(fname, 'wb') as f:
+                f.write(buf)
+            assertRaises(mx.MXNetError, mx.nd.load, fname, mmap=True)
+            if pos != shape_pos + 4:
+                # the size of the streams is not known, the huge array would be allocated
+                assertRaises(mx.MXNetError, mx.nd.load, fname)
+                assertRaises(mx.MXNetError, mx.nd.load_frombuffer, bytes(buf))
+
+
 @with_seed()
 def test_buffer_load():
     nrepeat = 10
@@ -2535,6 +2535,47 @@ def test_reduce():
                           mx.symbol.norm, test_exclude=False, test_none_axis=test_none)
 
 
+@with_seed()
+@pytest.mark.parametrize('omp_threads', ['1', '4'])
+def test_argmax_argmin_long_axis_with_ties(omp_threads):
+    # a long reduced axis is split across the threads when there are fewer outputs than
+    # threads, the parts are merged in order so that the first of the tied extrema wins.
+    # The thread count is read once per process, so the reductions run in subprocesses
+    import subprocess
+    import sys
+    import tempfile
+    script = """
+import sys
+import mxnet as mx
+from mxnet import np, npx
+npx.set_np()
+out = []
+for x, axis in zip(mx.nd.load(sys.argv[1]), [1, 1, 0]):
+    x = x.as_np_ndarray()
+    out += [np.argmax(x, axis=axis).as_nd_ndarray(), np.argmin(x, axis=axis).as_nd_ndarray()]
+mx.nd.save(sys.argv[2], out)
+"""
+    length = 100000
+    data = []
+    for shape, axis in [((1, length), 1), ((2, length), 1), ((length, 2), 0)]:
+        x = np.random.randint(0, 50, size=shape).astype(np.float32)
+        # the extrema are tied across the parts of the split axis, but not in the first part
+        np.moveaxis(x, axis, -1)[..., [length // 8 * 3, length // 2 + 1, length - 1]] = 100
+        np.moveaxis(x, axis, -1)[..., [length // 4 + 7, length // 8 * 5, length - 2]] = -100
+        data.append((x, axis))
+    with tempfile.TemporaryDirectory() as tmpdir:
+        in_file = os.path.join(tmpdir, 'data.nd')
+        out_file = os.path.join(tmpdir, 'out.nd')
+        mx.nd.save(in_file, [mx.nd.array(x) for x, _ in data])
+        env = dict(os.environ, OMP_NUM_THREADS=omp_threads)
+        env.pop('MXNET_OMP_MAX_THREADS', None)
+        subprocess.check_call([sys.executable, '-c', script, in_file, out_file], env=env)
+        out = iter(mx.nd.load(out_file))
+    for x, axis in data:
+        assert_almost_equal(next(out).asnumpy(), np.argmax(x, axis=axis))
+        assert_almost_equal(next(out).asnumpy(), np.argmin(x, axis=axis))
+
+
 @with_seed()
 def test_broadcast():
     sample_num = 200
@@ -3580,6 +3621,23 @@ def test_layer_norm(enforce_safe_acc, dtype, forward_check_eps, backward_check_e
                                               finite_grad_check=finite_grad_check)
 
 
+@with_seed()
+def test_layer_norm_large_mean():
+    # the moments of a row with a large offset must not lose the variance
+    data = np.random.normal(1E4, 1, (16, 1000)).astype(np.float32)
+    gamma = np.ones((1000,), dtype=np.float32)
+    beta = np.zeros((1000,), dtype=np.float32)
+    out, mean, std = mx.nd.LayerNorm(mx.nd.array(data), mx.nd.array(gamma), mx.nd.array(beta),
+                                     output_mean_var=True)
+    data64 = data.astype(np.float64)
+    assert_almost_equal(mean.asnumpy().reshape(-1), data64.mean(axis=-1), rtol=1E-5, atol=1E-5)
+    assert_almost_equal(std.asnumpy().reshape(-1), np.sqrt(data64.var(axis=-1) + 1E-5),
+                        rtol=1E-3, atol=1E-3)
+    expected = (data64 - data64.mean(axis=-1, keepdims=True)) / \
+               np.sqrt(data64.var(axis=-1, keepdims=True) + 1E-5)
+    assert_almost_equal(out.asnumpy(), expected, rtol=1E-2, atol=1E-2)
+
+
 # Numpy Implementation of Sequence Ops
 def sequence_last_numpy(array, lengths, axis):
     # create new array of dims [batch, seqlen, ...]
@@ -4160,6 +4218,46 @@ def test_order():
                     is_ascend=True)])
 
 
+@with_seed()
+@pytest.mark.parametrize('omp_threads', ['1', '4'])
+def test_topk_long_rows_with_ties(omp_threads):
+    # long rows are selected in several chunks when there are fewer rows than threads,
+    # equal values keep their source order. The thread count is read once per process,
+    # so topk runs in subprocesses
+    import subprocess
+    import sys
+    import tempfile
+    script = """
+import sys
+import mxnet as mx
+data = mx.nd.load(sys.argv[1])
+out = []
+for x in data:
+    for k in [1, 10, 1000]:
+        for is_ascend in [True, False]:
+            out += mx.nd.topk(x, k=k, ret_typ='both', is_ascend=is_ascend, dtype='int64')
+mx.nd.save(sys.argv[2], out)
+"""
+    data = [np.random.randint(0, 50, size=shape).astype(np.float32)
+            for shape in [(1, 300000), (3, 70000)]]
+    with tempfile.TemporaryDirectory() as tmpdir:
+        in_file = os.path.join(tmpdir, 'data.nd')
+        out_file = os.path.join(tmpdir, 'out.nd')
+        mx.nd.save(in_file, [mx.nd.array(x) for x in data])
+        env = dict(os.environ, OMP_NUM_THREADS=omp_threads)
+        env.pop('MXNET_OMP_MAX_THREADS', None)
+        subprocess.check_call([sys.executable, '-c', script, in_file, out_file], env=env)
+        out = iter(mx.nd.load(out_file))
+    for x in data:
+        for k in [1, 10, 1000]:
+            for is_ascend in [True, False]:
+                key = x if is_ascend else -x
+                expected = np.argsort(key, axis=-1, kind='stable')[:, :k]
+                vals, inds = next(out), next(out)
+                assert_almost_equal(inds.asnumpy(), expected)
+                assert_almost_equal(vals.asnumpy(), np.take_along_axis(x, expected, axis=-1))
+
+
 @with_seed()
 def test_blockgrad():
     a = mx.sym.Variable('a')
@@ -7227,6 +7325,18 @@ def test_zero_size_min_max():
     pytest.raises(MXNetError, max)
 
 
+@with_seed()
+@mx.use_np_shape
+def test_zero_size_reduce_empty_output():
+    # the kept axis is empty, so there is nothing to reduce into
+    a = mx.nd.zeros(shape=(0, 3))
+    for op in [mx.nd.sum, mx.nd.max, mx.nd.min, mx.nd.prod, mx.nd.mean]:
+        assert op(a, axis=1).shape == (0,)
+        assert op(a, axis=1, keepdims=True).shape == (0, 1)
+    b = mx.nd.zeros(shape=(2, 0, 5))
+    assert mx.nd.sum(b, axis=(0, 2)).shape == (0,)
+
+
 @with_seed()
 def test_squeeze_op():
     def check_squeeze_op(shape, axis=None):
@@ -9009,6 +9119,56 @@ def test_multihead_attention_selfatt():
     for dtype in dtypes:
         check_multihead_attention_selfatt(dtype=dtype)
 
+@with_seed()
+def test_interleaved_selfatt():
+    def reference(qkv, valid_length, heads, causal):
+        seq_len, batch = qkv.shape[0], qkv.shape[1]
+        att = mx.nd.contrib.interleaved_matmul_selfatt_qk(qkv, heads=heads)
+        mask = np.ones((batch, seq_len, seq_len), dtype=np.float32)
+        if valid_length is not None:
+            mask *= np.arange(seq_len)[None, None, :] < valid_length[:, None, None]
+        if causal:
+            mask *= np.tril(np.ones((seq_len, seq_len), dtype=np.float32))[None]
+        mask = mx.nd.array(np.repeat(mask, heads, axis=0), ctx=mx.cpu())
+        att = mx.nd.softmax(att * mask - 1e18 * (1 - mask), axis=-1)
+        return mx.nd.contrib.interleaved_matmul_selfatt_valatt(qkv, att, heads=heads)
+
+    # a single attention batch splits the backward over the blocks of keys and queries
+    for seq_len, batch, heads, head_dim in [(1, 1, 1, 4), (37, 2, 3, 8), (300, 2, 2, 16),
+                                            (300, 1, 1, 16)]:
+        for causal in [False, True]:
+            for use_length, length_dtype in [(False, None), (True, np.int32),
+                                             (True, np.int64), (True, np.float32)]:
+                qkv_np = np.random.uniform(-1, 1, (seq_len, batch, 3 * heads * head_dim))
+                ograd = mx.nd.random.uniform(-1, 1, (seq_len, batch, heads * head_dim), ctx=mx.cpu())
+                valid_length = np.random.randint(1, seq_len + 1, (batch,)) if use_length else None
+                results = []
+                for fused in [True, False]:
+                    qkv = mx.nd.array(qkv_np, ctx=mx.cpu())
+                    qkv.attach_grad()
+                    with mx.autograd.record():
+                        if fused:
+                            args = [qkv]
+                            if use_length:
+                                args.append(mx.nd.array(valid_length, ctx=mx.cpu(), dtype=length_dtype))
+                            out = mx.nd.contrib.interleaved_selfatt(*args, heads=heads, causal=causal,
+                                                                    use_length=use_length)
+                        else:
+                            out = reference(qkv, valid_length, heads, causal)
+                    out.backward(ograd)
+                    results.append((out.asnumpy(), qkv.grad.asnumpy()))
+                assert_almost_equal(results[0][0], results[1][0], rtol=1e-4, atol=1e-5)
+                assert_almost_equal(results[0][1], results[1][1], rtol=1e-4, atol=1e-5)
+
+    # the type of valid_length is inferred when not given
+    sym = mx.sym.contrib.interleaved_selfatt(mx.sym.Variable('qkv'), mx.sym.Variable('valid_length'),
+                                             heads=2, use_length=True)
+    arg_types, out_types, _ = sym.infer_type(qkv=np.float32)
+    assert arg_types == [np.float32, np.int32]
+    assert out_types == [np.float32]
+    arg_types, _, _ = sym.infer_type(qkv=np.float32, valid_length=np.float16)
+    assert arg_types == [np.float32, np.float16]
+
 def check_multihead_attention_encdec(dtype):
     def convert_weight(F, k_weight, v_weight, num_heads):
         k_weight = F.reshape(k_weight, shape=(num_heads, -1, 0), reverse=True)
@@ -1805,6 +1805,54 @@ def test_sparse_embedding():
     for sparse_grad in sparse_grads:
         check_sparse_embedding(in_dim, out_dim, batch, densities, sparse_grad)
 
+@with_seed()
+@pytest.mark.parametrize('omp_threads', ['1', '4'])
+def test_sparse_embedding_grad_duplicate_indices(omp_threads):
+    ''' test row sparse embedding gradient with skewed, heavily repeated indices '''
+    # the indices are bucketed by the threads in ranges, a repeated row spans several of
+    # them. The thread count is read once per process, so the gradient is computed in
+    # subprocesses
+    import os
+    import subprocess
+    import sys
+    import tempfile
+    script = """
+import sys
+import mxnet as mx
+data, weight, ograd = mx.nd.load(sys.argv[1])
+weight.attach_grad(stype='row_sparse')
+with mx.autograd.record():
+    out = mx.nd.Embedding(data, weight, input_dim=weight.shape[0], output_dim=weight.shape[1],
+                          sparse_grad=True)
+out.backward(ograd)
+assert weight.grad.stype == 'row_sparse'
+mx.nd.save(sys.argv[2], [weight.grad.indices, weight.grad.data])
+"""
+    in_dim = 100000
+    out_dim = 7
+    batch = 5000
+    cases = [(np.random.zipf(1.2, size=batch) - 1) % in_dim,
+             # one row covers the ranges of all the threads
+             np.full(batch, 4321),
+             np.concatenate([np.full(batch // 2, 17), np.full(batch - batch // 2, in_dim - 1)])]
+    for np_data in cases:
+        np_weight = np.random.uniform(size=(in_dim, out_dim)).astype(np.float32)
+        np_ograd = np.random.uniform(-1, 1, (batch, out_dim)).astype(np.float32)
+        with tempfile.TemporaryDirectory() as tmpdir:
+            in_file = os.path.join(tmpdir, 'data.nd')
+            out_file = os.path.join(tmpdir, 'out.nd')
+            mx.nd.save(in_file, [mx.nd.array(np_data), mx.nd.array(np_weight),
+                                 mx.nd.array(np_ograd)])
+            env = dict(os.environ, OMP_NUM_THREADS=omp_threads)
+            env.pop('MXNET_OMP_MAX_THREADS', None)
+            subprocess.check_call([sys.executable, '-c', script, in_file, out_file], env=env)
+            indices, grad = mx.nd.load(out_file)
+        expected_idx = np.unique(np_data)
+        expected = np.zeros((in_dim, out_dim), dtype=np.float32)
+        np.add.at(expected, np_data, np_ograd)
+        assert_almost_equal(indices.asnumpy(), expected_idx)
+        assert_almost_equal(grad.asnumpy(), expected[expected_idx], rtol=1e-4, atol=1e-4)
+
 @with_seed()
 def test_sparse_broadcast_add_sub():
     def check_broadcast_add(mx_lhs, mx_rhs, np_lhs, np_rhs, dtype):